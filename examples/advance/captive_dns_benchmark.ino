@@ -0,0 +1,56 @@
+#include <Arduino.h>
+
+#include <ONEBIOT.h>
+#include <utils/captive/ONEBIOTCaptivePortal.h>
+
+/**
+ * Answer rate of the captive DNS responder. A canned query of a connectivity
+ * check host is turned into its answer again and again, without the radio, so
+ * only the work done per query is measured.
+ *
+ * One JSON line is printed per query type:
+ *   {"query":"A","queries":10000,"qps":412345,"us_per_query":2.43,"answer_bytes":65}
+ */
+
+const uint32_t QUERIES = 10000;
+
+// connectivitycheck.gstatic.com, recursion desired, type and class are filled in below
+const uint8_t QUERY[] = {
+    0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    17, 'c', 'o', 'n', 'n', 'e', 'c', 't', 'i', 'v', 'i', 't', 'y', 'c', 'h', 'e', 'c', 'k',
+    7, 'g', 's', 't', 'a', 't', 'i', 'c',
+    3, 'c', 'o', 'm', 0,
+    0x00, 0x00, 0x00, 0x01
+};
+
+ONEBIOTCaptiveDNS dns;
+uint8_t packet[ONEBIOT_CAPTIVE_DNS_PACKET_SIZE + 16];
+
+void measure(const char *name, uint8_t type) {
+    size_t size = 0;
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < QUERIES; i++) {
+        // the answer overwrites the query, as it does with a received packet
+        memcpy(packet, QUERY, sizeof(QUERY));
+        packet[sizeof(QUERY) - 3] = type;
+        size = dns.respond(packet, sizeof(QUERY), sizeof(packet));
+    }
+    uint32_t elapsed = max(micros() - start, (uint32_t) 1);
+
+    Serial.printf("{\"query\":\"%s\",\"queries\":%u,\"qps\":%u,\"us_per_query\":%.2f,\"answer_bytes\":%u}\n",
+        name, QUERIES, (uint32_t) ((uint64_t) QUERIES * 1000000 / elapsed), elapsed / (float) QUERIES, size);
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // formats the answer record, the socket itself is not used by respond()
+    dns.begin(IPAddress(192, 168, 4, 1));
+
+    measure("A", 1);
+    measure("AAAA", 28);
+    dns.stop();
+}
+
+void loop() {
+}
@@ -0,0 +1,335 @@
+#include <Arduino.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WiFi.h>
+#include <HTTPClient.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
+#include <ESP8266WiFi.h>
+#include <ESP8266HTTPClient.h>
+#endif
+
+#include <base64.h>
+#include <ArduinoJson.h>
+
+/**
+ * Load generator for the /cmd API, it runs on a second board. Flash the device
+ * under test with http_concurrency.ino, add the tracer build flags to see the
+ * allocation columns:
+ *   -DONEBIOT_ALLOC_TRACE -Wl,--wrap=malloc -Wl,--wrap=free -Wl,--wrap=realloc -Wl,--wrap=calloc
+ *
+ * Each phase replays the weighted request mix over CONCURRENCY parallel
+ * connections, one request per connection since the server answers with
+ * "Connection: close", and prints one JSON line, so a script on the host can grep the
+ * lines starting with '{' and compare them against a baseline:
+ *   {"phase":"auth","concurrency":4,"requests":2000,"errors":0,"limited":0,"rps":88.1,
+ *    "p50_us":41230,"p99_us":120480,"p999_us":160020,"allocs_per_request":6.4,"peak_heap":5312,"max_loop_latency_us":9800}
+ *
+ * The phase without credentials measures the rejection path, every request is answered by 401.
+ * test/host/test_cmd_load.cpp replays the same mix against a host build without any board,
+ * use it for the regression gate and this sketch for the numbers of the real radio and heap.
+ *
+ * The target sees this board as a single client of its admission control. For the
+ * throughput phases build it with a budget which never runs out, e.g.
+ *   -DONEBIOT_ADMISSION_RATE=1000 -DONEBIOT_ADMISSION_BURST=200
+ * With the default budget run the abuse phase only: every connection hammers
+ * /cmd/wifi/list, "limited" counts the 429 answers and max_loop_latency_us is the
+ * worst loop latency the target sampled meanwhile, it has to stay bounded.
+ */
+
+const char *WIFI_SSID = "YOUR_SSID";
+const char *WIFI_PASSWORD = "YOUR_PASSWORD";
+const char *TARGET_HOST = "192.168.1.50";
+const uint16_t TARGET_PORT = 80;
+const char *TARGET_USER = "admin";
+const char *TARGET_PASSWORD = "admin";
+
+const uint8_t CONCURRENCY = 4;
+const size_t REQUESTS_PER_PHASE = 2000;
+const uint32_t REQUEST_TIMEOUT = 5000;
+// sample interval of ONEBIOTStats on the target
+const uint32_t TARGET_STATS_INTERVAL = 10000;
+
+const bool RUN_THROUGHPUT = true;
+const bool RUN_ABUSE = false;
+
+struct BenchRoute {
+    const char *method;
+    const char *path;
+    const char *body;
+    uint8_t weight;
+};
+
+const BenchRoute ABUSE_ROUTE = {"GET", "/cmd/wifi/list", nullptr, 1};
+
+// the PATCH sets the value it already has after the first request, so the target does not write flash
+const BenchRoute ROUTES[] = {
+    {"GET", "/cmd/stats", nullptr, 40},
+    {"GET", "/cmd/option/client_name", nullptr, 25},
+    {"GET", "/cmd/wifi", nullptr, 20},
+    {"PATCH", "/cmd/config", "{\"client_name\":\"bench\"}", 15}
+};
+
+struct BenchConnection {
+    WiFiClient client;
+    bool busy = false;
+    bool abusive = false;
+    uint32_t started = 0;
+    char line[96];
+    uint8_t lineLength = 0;
+    bool inBody = false;
+    long remaining = 0;
+    int status = 0;
+};
+
+BenchConnection connections[CONCURRENCY];
+uint32_t latencies[REQUESTS_PER_PHASE];
+size_t completed = 0;
+size_t issued = 0;
+size_t errors = 0;
+size_t limited = 0;
+String authorization;
+
+const BenchRoute &pickRoute() {
+    uint16_t total = 0;
+    for (const BenchRoute &route : ROUTES) {
+        total += route.weight;
+    }
+
+    long ticket = random(total);
+    for (const BenchRoute &route : ROUTES) {
+        if (ticket < route.weight) {
+            return route;
+        }
+        ticket -= route.weight;
+    }
+    return ROUTES[0];
+}
+
+bool sendRequest(BenchConnection &connection) {
+    if (!connection.client.connect(TARGET_HOST, TARGET_PORT)) {
+        return false;
+    }
+    connection.client.setNoDelay(true);
+
+    const BenchRoute &route = connection.abusive ? ABUSE_ROUTE : pickRoute();
+    String request = String(route.method) + " " + route.path + " HTTP/1.1\r\nHost: " + TARGET_HOST + "\r\n";
+    if (authorization.length()) {
+        request += "Authorization: Basic " + authorization + "\r\n";
+    }
+    if (route.body != nullptr) {
+        request += "Content-Type: application/json\r\nContent-Length: " + String(strlen(route.body)) + "\r\n\r\n" + route.body;
+    } else {
+        request += "\r\n";
+    }
+
+    connection.busy = true;
+    connection.started = micros();
+    connection.lineLength = 0;
+    connection.inBody = false;
+    connection.remaining = 0;
+    connection.status = 0;
+    return connection.client.write((const uint8_t *) request.c_str(), request.length()) == request.length();
+}
+
+// The target closes every connection after its response, the next request opens a new one.
+void finish(BenchConnection &connection, bool success) {
+    connection.client.stop();
+    if (!success) {
+        errors++;
+    } else if (completed < REQUESTS_PER_PHASE) {
+        latencies[completed++] = micros() - connection.started;
+        limited += connection.status == 429;
+    }
+    connection.busy = false;
+}
+
+// Reads what arrived, a response ends after Content-Length bytes of body.
+void poll(BenchConnection &connection) {
+    while (connection.client.available()) {
+        int ch = connection.client.read();
+        if (ch < 0) {
+            break;
+        }
+
+        if (connection.inBody) {
+            if (--connection.remaining <= 0) {
+                finish(connection, connection.status > 0);
+                return;
+            }
+            continue;
+        }
+
+        if (ch != '\n') {
+            if (ch != '\r' && connection.lineLength < sizeof(connection.line) - 1) {
+                connection.line[connection.lineLength++] = ch;
+            }
+            continue;
+        }
+
+        connection.line[connection.lineLength] = '\0';
+        if (connection.lineLength == 0) {
+            connection.inBody = true;
+            if (connection.remaining <= 0) {
+                finish(connection, connection.status > 0);
+                return;
+            }
+        } else if (connection.status == 0 && strncmp(connection.line, "HTTP/1.", 7) == 0) {
+            connection.status = atoi(connection.line + 9);
+        } else if (strncasecmp(connection.line, "Content-Length:", 15) == 0) {
+            connection.remaining = atol(connection.line + 15);
+        }
+        connection.lineLength = 0;
+    }
+
+    if (!connection.client.connected() && !connection.client.available()) {
+        finish(connection, false);
+    } else if (micros() - connection.started > REQUEST_TIMEOUT * 1000UL) {
+        finish(connection, false);
+    }
+}
+
+int compareLatency(const void *a, const void *b) {
+    uint32_t left = *(const uint32_t *) a;
+    uint32_t right = *(const uint32_t *) b;
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+uint32_t percentile(float rank) {
+    if (completed == 0) {
+        return 0;
+    }
+    size_t index = (size_t) (rank * (completed - 1) + 0.5f);
+    return latencies[index];
+}
+
+// Sums the tracer counters of the /cmd routes on the target, false when the tracer is not compiled in.
+bool readAllocCounters(uint32_t &count, uint32_t &peak) {
+    WiFiClient client;
+    HTTPClient http;
+    String url = String("http://") + TARGET_HOST + ":" + TARGET_PORT + "/cmd/stats/alloc";
+    if (!http.begin(client, url)) {
+        return false;
+    }
+    http.setAuthorization(TARGET_USER, TARGET_PASSWORD);
+
+    bool success = false;
+    if (http.GET() == 200) {
+        DynamicJsonDocument response(4096);
+        if (!deserializeJson(response, http.getString()) && response["success"].as<bool>()) {
+            count = 0;
+            peak = 0;
+            for (JsonObject tag : response["data"]["tags"].as<JsonArray>()) {
+                if (strncmp(tag["tag"] | "", "/cmd", 4) != 0) {
+                    continue;
+                }
+                count += tag["count"].as<uint32_t>();
+                peak = max(peak, tag["peak"].as<uint32_t>());
+            }
+            success = true;
+        }
+    }
+    http.end();
+    return success;
+}
+
+// Worst loop latency of the target over the newest samples, the history aggregates them into one row.
+long readLoopLatency(uint32_t elapsed) {
+    WiFiClient client;
+    HTTPClient http;
+    String url = String("http://") + TARGET_HOST + ":" + TARGET_PORT + "/cmd/stats/history?agg=max&limit=1&step=" + String(elapsed / TARGET_STATS_INTERVAL + 1);
+    if (!http.begin(client, url)) {
+        return -1;
+    }
+    http.setAuthorization(TARGET_USER, TARGET_PASSWORD);
+
+    long latency = -1;
+    if (http.GET() == 200) {
+        DynamicJsonDocument response(1024);
+        if (!deserializeJson(response, http.getString()) && response["data"].size() == 1) {
+            latency = response["data"][0][5].as<long>();
+        }
+    }
+    http.end();
+    return latency;
+}
+
+void runPhase(const char *name, bool authenticated, bool abusive) {
+    authorization = authenticated ? base64::encode(String(TARGET_USER) + ":" + TARGET_PASSWORD) : String("");
+    completed = 0;
+    issued = 0;
+    errors = 0;
+    limited = 0;
+    for (BenchConnection &connection : connections) {
+        connection.abusive = abusive;
+    }
+
+    uint32_t allocsBefore = 0;
+    uint32_t peak = 0;
+    bool traced = readAllocCounters(allocsBefore, peak);
+
+    uint32_t start = millis();
+    while (completed < REQUESTS_PER_PHASE && errors < REQUESTS_PER_PHASE) {
+        for (BenchConnection &connection : connections) {
+            if (connection.busy) {
+                poll(connection);
+            } else if (issued < REQUESTS_PER_PHASE + errors) {
+                issued++;
+                if (!sendRequest(connection)) {
+                    finish(connection, false);
+                }
+            }
+        }
+        yield();
+    }
+    uint32_t elapsed = millis() - start;
+
+    for (BenchConnection &connection : connections) {
+        connection.client.stop();
+        connection.busy = false;
+    }
+
+    if (abusive) {
+        // the stats requests below need tokens of the same client
+        delay(5000);
+    }
+
+    uint32_t allocsAfter = 0;
+    traced = traced && readAllocCounters(allocsAfter, peak);
+    long loopLatency = readLoopLatency(elapsed);
+
+    qsort(latencies, completed, sizeof(latencies[0]), compareLatency);
+
+    char allocs[16] = "null";
+    char peakHeap[16] = "null";
+    if (traced && completed) {
+        // the two reads of /cmd/stats/alloc count themselves as well
+        snprintf(allocs, sizeof(allocs), "%.1f", (allocsAfter - allocsBefore) / (float) completed);
+        snprintf(peakHeap, sizeof(peakHeap), "%u", peak);
+    }
+
+    Serial.printf("{\"phase\":\"%s\",\"concurrency\":%u,\"requests\":%u,\"errors\":%u,\"limited\":%u,\"rps\":%.1f,"
+        "\"p50_us\":%u,\"p99_us\":%u,\"p999_us\":%u,\"allocs_per_request\":%s,\"peak_heap\":%s,\"max_loop_latency_us\":%ld}\n",
+        name, CONCURRENCY, completed, errors, limited, elapsed ? completed * 1000.0f / elapsed : 0.0f,
+        percentile(0.5f), percentile(0.99f), percentile(0.999f), allocs, peakHeap, loopLatency);
+}
+
+void setup() {
+    Serial.begin(115200);
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(100);
+    }
+    randomSeed(micros());
+
+    if (RUN_THROUGHPUT) {
+        runPhase("auth", true, false);
+        runPhase("no_auth", false, false);
+    }
+    if (RUN_ABUSE) {
+        runPhase("abuse", true, true);
+    }
+}
+
+void loop() {
+}
@@ -0,0 +1,41 @@
+#include <Arduino.h>
+
+#include <ONEBIOT.h>
+#include <utils/config/ONEBIOTConfig.h>
+#include <utils/request/ONEBIOTCmdRequestHandler.h>
+
+/**
+ * ESP32 only. The web server and the events channel run in a task pinned to
+ * core 0, loop() stays free for the sensor code on core 1. Restarts requested
+ * over HTTP are still carried out by obiApp.loop().
+ */
+
+ONEBIOTConfigAppConfig config;
+ONEBIOTConfig obiConfig(config);
+ONEBIOTApp obiApp(obiConfig);
+
+void setup() {
+    Serial.begin(115200);
+    ONEBIOT_SERIAL_HEADER_PRINT();
+    ONEBIOTLog::setOutput(&Serial);
+
+    obiConfig.setWiFiSsid("YOUR_SSID");
+    obiConfig.setWiFiPassword("YOUR_PASSWORD");
+    obiConfig.setWiFiEstablish(true);
+
+    obiApp.addRequestHandler(new ONEBIOTCmdRequestHandler(obiApp));
+    obiApp.start(false);
+    obiApp.startServerTask(0);
+}
+
+void loop() {
+    obiApp.loop();
+
+    // several fields change together or not at all, handlers never see half of it
+    ONEBIOTConfigAppConfig staged = obiConfig.getConfig();
+    if (staged.dns_name.isEmpty()) {
+        staged.dns_name = "sensor";
+        staged.dns_establish = true;
+        obiConfig.commit(staged);
+    }
+}
@@ -0,0 +1,113 @@
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+
+#include <ONEBIOT.h>
+#include <utils/config/ONEBIOTConfig.h>
+
+/**
+ * Measures config load/save, a static file read and a template walk on the chosen
+ * file system. Flash the sketch once with each backend to compare them.
+ * Both share the same flash partition, so switching formats it.
+ * test/host/test_fs runs the same measurements on the in-memory host backend.
+ */
+
+#define BENCHMARK_LITTLEFS
+
+#ifdef BENCHMARK_LITTLEFS
+FS &benchmarkFS = LittleFS;
+const char *benchmarkName = "LittleFS";
+#else
+FS &benchmarkFS = SPIFFS;
+const char *benchmarkName = "SPIFFS";
+#endif
+
+const int ITERATIONS = 50;
+const char *configFile = "/onebiot.json";
+const char *staticFile = "/static.txt";
+
+ONEBIOTConfigAppConfig config;
+ONEBIOTConfig obiConfig(config, configFile, benchmarkFS);
+ONEBIOTApp obiApp(obiConfig, benchmarkFS);
+
+void prepareFiles() {
+    obiConfig.setWiFiSsid("benchmark");
+    obiConfig.setWiFiPassword("benchmark-password");
+    obiConfig.setDnsName("benchmark");
+    obiConfig.save();
+
+    File file = benchmarkFS.open(staticFile, "w");
+    for (int i = 0; i < 64; i++) {
+        file.print("<p>%client_name% static content line of the benchmark file</p>\n");
+    }
+    file.close();
+}
+
+void benchmarkConfig() {
+    uint32_t start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        obiConfig.load();
+    }
+    uint32_t loadElapsed = micros() - start;
+
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        obiConfig.save();
+    }
+    uint32_t saveElapsed = micros() - start;
+
+    Serial.printf("[%s] config load: %u us, save: %u us\n", benchmarkName, loadElapsed / ITERATIONS, saveElapsed / ITERATIONS);
+}
+
+void benchmarkStatic() {
+    uint8_t buffer[256];
+    size_t total = 0;
+    uint32_t start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        File file = benchmarkFS.open(staticFile, "r");
+        while (file.available()) {
+            total += file.read(buffer, sizeof(buffer));
+        }
+        file.close();
+    }
+    uint32_t elapsed = micros() - start;
+
+    Serial.printf("[%s] static read: %u us (%u bytes)\n", benchmarkName, elapsed / ITERATIONS, total / ITERATIONS);
+}
+
+// same byte by byte walk as ONEBIOTRequestHandler::_sendAsTemplate without the network
+void benchmarkTemplate() {
+    size_t keys = 0;
+    uint32_t start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        File file = benchmarkFS.open(staticFile, "r");
+        int val;
+        while ((val = file.read()) != -1) {
+            if (val == '%') {
+                keys++;
+            }
+        }
+        file.close();
+    }
+    uint32_t elapsed = micros() - start;
+
+    Serial.printf("[%s] template walk: %u us (%u bookends)\n", benchmarkName, elapsed / ITERATIONS, keys / ITERATIONS);
+}
+
+void setup() {
+    Serial.begin(115200);
+    ONEBIOT_SERIAL_HEADER_PRINT();
+
+    if (!obiApp.mountFS()) {
+        Serial.printf("[%s] mounting failed\n", benchmarkName);
+        return;
+    }
+
+    prepareFiles();
+    benchmarkConfig();
+    benchmarkStatic();
+    benchmarkTemplate();
+}
+
+void loop() {
+}
@@ -19,11 +19,15 @@
 #include <TaskScheduler.h>
 #include <time.h>
 
+// log calls above ONEBIOT_LOG_LEVEL are not compiled, output goes to Serial from obiApp.loop().
+// The library sources are compiled on their own and never see a #define of the sketch,
+// pass the level as a build flag instead, e.g. build_flags = -DONEBIOT_LOG_LEVEL=3
+
 #include <ONEBIOT.h>
 #include <utils/config/ONEBIOTConfig.h>
 #include <utils/request/ONEBIOTCmdRequestHandler.h>
+#include <utils/request/ONEBIOTFsRequestHandler.h>
 
-#define DEBUG_SERIAL
 #define DEBUG_CONFIG
 
 // ######################## ONEBIOT APP CONFIG ########################
@@ -61,13 +65,7 @@ void testTaskCallBack() {
     int sec = timeinfo->tm_sec;
     int day_of_week = timeinfo->tm_wday;
 
-    Serial.println("[TIME] Y: " + String(year));
-    Serial.println("[TIME] m: " + String(month));
-    Serial.println("[TIME] d: " + String(day));
-    Serial.println("[TIME] H: " + String(hour));
-    Serial.println("[TIME] i: " + String(mins));
-    Serial.println("[TIME] s: " + String(sec));
-    Serial.println("[TIME] DoW: " + String(day_of_week));
+    ONEBIOT_LOG_INFO(APP, "%04d-%02d-%02d %02d:%02d:%02d DoW: %d", year, month, day, hour, mins, sec, day_of_week);
     
     digitalWrite(LED_BUILTIN, HIGH);
 }
@@ -77,18 +75,14 @@ void testTaskCallBack() {
 
 // when file system is ready
 void onMountFS() {
-    #ifdef DEBUG_SERIAL
-        Serial.println("[FIS] Filesystem (SPIFFS) has been loaded.");
-    #endif
+    ONEBIOT_LOG_INFO(FIS, "Filesystem (SPIFFS) has been loaded.");
 }
 
 // Callback occurres when config json file loaded.
 // This callback turning 1biotApp into AP or WiFi mode when SSID is empty and allows dns .local name
 // Default .local name is onebiot.local
 void onLoadSettings(String fileName) {
-    #ifdef DEBUG_SERIAL
-        Serial.println("[CNF] Configuration from file " + fileName + " has been loaded");
-    #endif
+    ONEBIOT_LOG_INFO(CNF, "Configuration from file %s has been loaded", fileName);
 
     if (obiConfig.getConfig().wifi_ssid.isEmpty()) { // or same user and password as default
         obiConfig.setApEstablish(true);
@@ -101,21 +95,17 @@ void onLoadSettings(String fileName) {
 
 // when config json file failed.
 void onLoadSettingsFailed(String fileName) {
-    #ifdef DEBUG_SERIAL
-        Serial.println("[CNF] Loading configuration of " + fileName + " failed!");
-    #endif
+    ONEBIOT_LOG_ERROR(CNF, "Loading configuration of %s failed!", fileName);
 }
 
 // on WiFi start. We adding system api accessible by http (http://[IP]/cmd/) for more information visit https://onebiot.github.com/CMDRequest
 void onWiFiBegin() {
-    #ifdef DEBUG_SERIAL
-        Serial.println("[WFC] WiFi connected");
-        Serial.print("[WFC] IP address: ");
-        Serial.println(WiFi.localIP());
-    #endif
+    ONEBIOT_LOG_INFO(WFC, "WiFi connected");
+    ONEBIOT_LOG_INFO(WFC, "IP address: %s", WiFi.localIP());
 
     // API
-    obiApp.addRequestHandler(new ONEBIOTCmdRequestHandler(obiApp.getConfig()));
+    obiApp.addRequestHandler(new ONEBIOTCmdRequestHandler(obiApp));
+    obiApp.addRequestHandler(new ONEBIOTFsRequestHandler(obiApp.getConfig()));
 
     // debug dowloading option file
     #ifdef DEBUG_CONFIG
@@ -125,26 +115,17 @@ void onWiFiBegin() {
 }
 
 void onWiFiFailed(String message) {
-    #ifdef DEBUG_SERIAL
-        Serial.println("[WFC] Could not connect to WiFi!");
-        if (!message.isEmpty()) {
-            Serial.println("[WFC] " + message);
-        }
-    #endif
+    ONEBIOT_LOG_ERROR(WFC, "Could not connect to WiFi! %s", message);
 }
 
 void onAPBegin () {
-    #ifdef DEBUG_SERIAL
-        Serial.print("[WAP] SSID: ");
-        Serial.println(WiFi.softAPSSID());
-        Serial.print("[WAP] IP address: ");
-        Serial.println(WiFi.softAPIP());
-        Serial.print("[WAP] MAC address: ");
-        Serial.println(WiFi.softAPmacAddress());
-    #endif
+    ONEBIOT_LOG_INFO(WAP, "SSID: %s", WiFi.softAPSSID());
+    ONEBIOT_LOG_INFO(WAP, "IP address: %s", WiFi.softAPIP());
+    ONEBIOT_LOG_INFO(WAP, "MAC address: %s", WiFi.softAPmacAddress());
 
     // API
-    obiApp.addRequestHandler(new ONEBIOTCmdRequestHandler(obiApp.getConfig()));
+    obiApp.addRequestHandler(new ONEBIOTCmdRequestHandler(obiApp));
+    obiApp.addRequestHandler(new ONEBIOTFsRequestHandler(obiApp.getConfig()));
 
     // WEB GUI
     // under construct
@@ -160,43 +141,31 @@ void onAPBegin () {
 }
 
 void onAPFailed (String message) {
-    #ifdef DEBUG_SERIAL
-        Serial.println("[WAP] Could not create an AP!");
-        if (!message.isEmpty()) {
-            Serial.println("[WAP] " + message);
-        }
-    #endif
+    ONEBIOT_LOG_ERROR(WAP, "Could not create an AP! %s", message);
 }
 
 void onDNSBegin() {
-    #ifdef DEBUG_SERIAL
-        Serial.println(String("[DNS] http://") + obiConfig.getDnsName() + String(".local started"));
-    #endif
+    ONEBIOT_LOG_INFO(DNS, "http://%s.local started", obiConfig.getDnsName());
 }
 
 void onDNSFailed () {
-    #ifdef DEBUG_SERIAL
-        Serial.println("[DNS] Error setting up DNS responder");
-    #endif
+    ONEBIOT_LOG_ERROR(DNS, "Error setting up DNS responder");
 }
 
 void onInitializeTime(time_t timestamp) {
-    #ifdef DEBUG_SERIAL
-        Serial.println("[OBI] Actual date and time is " + String(ctime(&timestamp)));
-    #endif
+    // ctime() ends with a new line
+    String date = ctime(&timestamp);
+    date.trim();
+    ONEBIOT_LOG_INFO(OBI, "Actual date and time is %s", date);
 }
 
 void onNeedRestart() {
-    #ifdef DEBUG_SERIAL
-        Serial.println("[OBI] Triggered restart from webserver");
-    #endif
+    ONEBIOT_LOG_INFO(OBI, "Triggered restart from webserver");
     obiApp.restart();
 }
 
 void onRestart() {
-    #ifdef DEBUG_SERIAL
-        Serial.println("[OBI] ESP8266 restarting now ...");
-    #endif
+    ONEBIOT_LOG_INFO(OBI, "ESP8266 restarting now ...");
 }
 
 // ######################## MAIN APP LOOP ########################
@@ -205,6 +174,7 @@ void setup() {
     pinMode(LED_BUILTIN , OUTPUT);
     digitalWrite(LED_BUILTIN, HIGH);
     ONEBIOT_SERIAL_HEADER_PRINT();
+    ONEBIOTLog::setOutput(&Serial);
 
     obiApp.start(true);
     if (obiApp.isWifiStarted()) {
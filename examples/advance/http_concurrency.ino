@@ -0,0 +1,36 @@
+#include <Arduino.h>
+
+#include <ONEBIOT.h>
+#include <utils/config/ONEBIOTConfig.h>
+#include <utils/request/ONEBIOTCmdRequestHandler.h>
+
+/**
+ * Target for comparing the HTTP backends under concurrent clients. Build it once
+ * as is and once with -DONEBIOT_HTTP_SYNC (build flag, the library has to see it),
+ * then run an HTTP load tool with several parallel connections against
+ * http://[IP]/cmd/stats and compare the p50/p99 latencies. Both answer with
+ * "Connection: close", so every request costs a new connection either way. Adding one client which
+ * sends its request byte by byte shows the difference best: the core server waits
+ * for it, the ONEBIOT one keeps serving the others.
+ */
+
+ONEBIOTConfigAppConfig config;
+ONEBIOTConfig obiConfig(config);
+ONEBIOTApp obiApp(obiConfig);
+
+void setup() {
+    Serial.begin(115200);
+    ONEBIOT_SERIAL_HEADER_PRINT();
+    ONEBIOTLog::setOutput(&Serial);
+
+    obiConfig.setWiFiSsid("YOUR_SSID");
+    obiConfig.setWiFiPassword("YOUR_PASSWORD");
+    obiConfig.setWiFiEstablish(true);
+
+    obiApp.addRequestHandler(new ONEBIOTCmdRequestHandler(obiApp));
+    obiApp.start(false);
+}
+
+void loop() {
+    obiApp.loop();
+}
@@ -0,0 +1,43 @@
+#include <Arduino.h>
+
+#include <ONEBIOTLite.h>
+#include <utils/config/ONEBIOTConfig.h>
+
+/**
+ * Sensor build with station WiFi and time only. Soft-AP, mDNS, the web server,
+ * SPIFFS and the stats history are not compiled in. Build it next to a sketch
+ * with ONEBIOT_SUBSYSTEMS_ALL, or with ONEBIOTApp, and compare the size reports
+ * of the linker to see what each subsystem costs.
+ */
+
+ONEBIOTConfigAppConfig config;
+ONEBIOTConfig obiConfig(config);
+ONEBIOTLiteApp<ONEBIOT_SUBSYSTEMS_SENSOR> obiApp(obiConfig);
+
+uint32_t lastReading = 0;
+
+void onWiFiBegin() {
+    Serial.print(F("Connected, IP "));
+    Serial.println(WiFi.localIP());
+}
+
+void setup() {
+    Serial.begin(115200);
+    ONEBIOTLog::setOutput(&Serial);
+
+    obiConfig.setWiFiSsid("YOUR_SSID");
+    obiConfig.setWiFiPassword("YOUR_PASSWORD");
+    obiConfig.setWiFiEstablish(true);
+
+    obiApp.start(false);
+    obiApp.initializeTime(3600, 3600, "pool.ntp.org", "time.nist.gov");
+}
+
+void loop() {
+    obiApp.loop();
+
+    if (millis() - lastReading >= 10000) {
+        lastReading = millis();
+        Serial.printf("%ld heap %u\n", (long) obiApp.updateTime(), ESP.getFreeHeap());
+    }
+}
@@ -0,0 +1,66 @@
+#include <Arduino.h>
+
+// the benchmark logs on the debug level from this sketch, the define reaches only
+// its own calls, the library sources need -DONEBIOT_LOG_LEVEL=4 as a build flag
+#define ONEBIOT_LOG_LEVEL 4 // ONEBIOT_LOG_LEVEL_DEBUG
+
+#include <ONEBIOT.h>
+
+/**
+ * Compares the cost of one log call made by the deferred ONEBIOTLog with
+ * the String concatenation sent straight to Serial.
+ */
+
+const int ITERATIONS = 1000;
+
+class NullPrint : public Print {
+    public:
+        size_t write(uint8_t) override {
+            return 1;
+        }
+};
+
+void benchmarkString() {
+    Serial.flush();
+    uint32_t heapBefore = ESP.getFreeHeap();
+    uint32_t start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        Serial.println("[WFC] Connecting error: #" + String(i) + " rssi " + String(WiFi.RSSI()));
+    }
+    uint32_t elapsed = micros() - start;
+    Serial.flush();
+
+    Serial.printf("String + Serial: %.2f us per call, heap %u -> %u\n", elapsed / (float) ITERATIONS, heapBefore, ESP.getFreeHeap());
+}
+
+void benchmarkDeferred() {
+    uint32_t heapBefore = ESP.getFreeHeap();
+    uint32_t start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        ONEBIOT_LOG_DEBUG(WFC, "Connecting error: #%d rssi %d", i, WiFi.RSSI());
+    }
+    uint32_t elapsed = micros() - start;
+
+    Serial.printf("ONEBIOTLog record: %.2f us per call, heap %u -> %u\n", elapsed / (float) ITERATIONS, heapBefore, ESP.getFreeHeap());
+}
+
+void benchmarkFormat() {
+    NullPrint nullOutput;
+    uint32_t start = micros();
+    ONEBIOTLog::printSince(0, nullOutput);
+    uint32_t elapsed = micros() - start;
+
+    Serial.printf("ONEBIOTLog formatting of the whole buffer: %u us\n", elapsed);
+}
+
+void setup() {
+    Serial.begin(115200);
+    ONEBIOT_SERIAL_HEADER_PRINT();
+
+    benchmarkString();
+    benchmarkDeferred();
+    benchmarkFormat();
+}
+
+void loop() {
+}
@@ -0,0 +1,45 @@
+#include <Arduino.h>
+
+#include <ONEBIOT.h>
+#include <utils/config/ONEBIOTConfig.h>
+
+ONEBIOTConfigAppConfig config;
+ONEBIOTConfig obiConfig(config);
+ONEBIOTApp obiApp(obiConfig);
+
+const uint32_t READING_INTERVAL = 1000;
+uint32_t lastReading = 0;
+
+void setup() {
+    Serial.begin(115200);
+    ONEBIOT_SERIAL_HEADER_PRINT();
+    ONEBIOTLog::setOutput(&Serial);
+
+    obiConfig.setWiFiSsid("YOUR_SSID");
+    obiConfig.setWiFiPassword("YOUR_PASSWORD");
+    obiConfig.setWiFiEstablish(true);
+
+    obiApp.start(false);
+
+    // messages published within 500 ms go out together, offline they are queued to flash
+    obiApp.getMqtt().begin("192.168.1.2", 1883, obiConfig.getClientName());
+    obiApp.getMqtt().setCredentials("YOUR_USER", "YOUR_PASSWORD");
+    obiApp.getMqtt().setFlushWindow(500);
+
+    // between readings the loop sleeps, a request waits 200 ms at most
+    obiApp.getIdle().setMode(ONEBIOT_IDLE_LIGHT);
+    obiApp.getIdle().setLatencyBound(200);
+}
+
+void loop() {
+    // the app does not know the timers of the sketch, the next reading ends the sleep
+    uint32_t elapsed = millis() - lastReading;
+    obiApp.getIdle().deadline(elapsed >= READING_INTERVAL ? 0 : READING_INTERVAL - elapsed);
+    obiApp.loop();
+
+    if (millis() - lastReading >= READING_INTERVAL) {
+        lastReading = millis();
+        obiApp.getMqtt().publish("onebiot/sensor/uptime", String(millis() / 1000));
+        obiApp.getMqtt().publish("onebiot/sensor/heap", String(ESP.getFreeHeap()));
+    }
+}
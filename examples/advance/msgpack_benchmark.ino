@@ -0,0 +1,96 @@
+#include <Arduino.h>
+
+#include <ONEBIOT.h>
+#include <utils/config/ONEBIOTConfig.h>
+#include <utils/request/ONEBIOTCmdRequestHandler.h>
+
+/**
+ * Payload size and serialization time of the /cmd responses as JSON and as
+ * MessagePack. The documents are built by the handler itself, one JSON line is
+ * printed per route:
+ *   {"route":"/cmd/stats","json_bytes":612,"msgpack_bytes":455,"json_us":1450,"msgpack_us":980}
+ * test/host/test_msgpack prints the same fields for the requests it sends on the host.
+ */
+
+const int ITERATIONS = 100;
+
+ONEBIOTConfigAppConfig config;
+ONEBIOTConfig obiConfig(config);
+ESP8266WebServer unusedServer(8080);
+
+class CountingPrint : public Print {
+    public:
+        size_t count = 0;
+        size_t write(uint8_t) override {
+            count++;
+            return 1;
+        }
+        size_t write(const uint8_t *buffer, size_t size) override {
+            count += size;
+            return size;
+        }
+};
+
+// the route callbacks are protected, a subclass reaches them without a request
+class BenchmarkHandler : public ONEBIOTCmdRequestHandler {
+    public:
+        BenchmarkHandler(ONEBIOTConfig config) : ONEBIOTCmdRequestHandler(config) {}
+
+        void run(const char *route, JsonDocument &response) {
+            CountingPrint json;
+            uint32_t start = micros();
+            for (int i = 0; i < ITERATIONS; i++) {
+                json.count = 0;
+                serializeJson(response, json);
+            }
+            uint32_t jsonTime = (micros() - start) / ITERATIONS;
+
+            CountingPrint msgPack;
+            start = micros();
+            for (int i = 0; i < ITERATIONS; i++) {
+                msgPack.count = 0;
+                serializeMsgPack(response, msgPack);
+            }
+            uint32_t msgPackTime = (micros() - start) / ITERATIONS;
+
+            Serial.printf("{\"route\":\"%s\",\"json_bytes\":%u,\"msgpack_bytes\":%u,\"json_us\":%u,\"msgpack_us\":%u}\n",
+                route, json.count, msgPack.count, jsonTime, msgPackTime);
+            response.clear();
+        }
+
+        void runAll() {
+            DynamicJsonDocument response(2048);
+            CMD_STATS_CALLBACK(response);
+            run("/cmd/stats", response);
+            CMD_STATS_ESP_CALLBACK(response);
+            run("/cmd/stats/esp", response);
+            CMD_STATS_CHIP_CALLBACK(response);
+            run("/cmd/stats/chip", response);
+            CMD_STATS_SPIFFS_CALLBACK(response);
+            run("/cmd/stats/spiffs", response);
+            CMD_WIFI_CALLBACK(response, unusedServer, HTTP_GET);
+            run("/cmd/wifi", response);
+            CMD_AP_CALLBACK(response, unusedServer, HTTP_GET);
+            run("/cmd/ap", response);
+            CMD_DNS_CALLBACK(response, unusedServer, HTTP_GET);
+            run("/cmd/dns", response);
+        }
+};
+
+void setup() {
+    Serial.begin(115200);
+    ONEBIOT_SERIAL_HEADER_PRINT();
+    obiConfig.getFileSystem().begin();
+
+    // connected and with the AP up, so /cmd/wifi and /cmd/ap answer with data
+    WiFi.mode(WIFI_AP_STA);
+    WiFi.softAP("ONEBIOT-benchmark");
+    WiFi.begin("YOUR_SSID", "YOUR_PASSWORD");
+    WiFi.waitForConnectResult();
+
+    BenchmarkHandler handler(obiConfig);
+    handler.runAll();
+}
+
+void loop() {
+}
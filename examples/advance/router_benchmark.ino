@@ -0,0 +1,81 @@
+#include <Arduino.h>
+
+#include <ONEBIOT.h>
+#include <utils/router/ONEBIOTRouter.h>
+
+/**
+ * Dispatch time of 100 routes by ONEBIOTRouter against the handler list of the
+ * core server, which asks every handler by canHandle() until one accepts. The
+ * routes do not fit the default pools, build with
+ *   -DONEBIOT_ROUTER_NODES=128 -DONEBIOT_ROUTER_ROUTES=112
+ *
+ * One JSON line is printed per probed uri:
+ *   {"uri":"/api/g9/r99","routes":100,"router_us":4.1,"list_us":52.7}
+ * test/host/test_router_benchmark runs the same probes on the host.
+ */
+
+const int ROUTES = 100;
+const int ITERATIONS = 1000;
+
+// a handler of one path, as ESP8266WebServer::on() registers them
+class PathHandler : public RequestHandler {
+    public:
+        PathHandler(const char *path) : _path(path) {}
+        bool canHandle(HTTPMethod method, String uri) override {
+            return method == HTTP_GET && uri == _path;
+        }
+        bool handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) override {
+            return true;
+        }
+    private:
+        const char *_path;
+};
+
+ONEBIOTRouter router;
+PathHandler *handlers[ROUTES];
+// patterns are not copied by the router
+char patterns[ROUTES][20];
+
+float routerTime(const String &uri) {
+    uint32_t start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        router.canHandle(HTTP_GET, uri);
+    }
+    return (micros() - start) / (float) ITERATIONS;
+}
+
+float listTime(const String &uri) {
+    uint32_t start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        for (RequestHandler *handler : handlers) {
+            if (handler->canHandle(HTTP_GET, uri)) {
+                break;
+            }
+        }
+    }
+    return (micros() - start) / (float) ITERATIONS;
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // ten groups of ten, like the /cmd routes below /cmd/stats
+    for (int i = 0; i < ROUTES; i++) {
+        snprintf(patterns[i], sizeof(patterns[i]), "/api/g%d/r%d", i / 10, i);
+        handlers[i] = new PathHandler(patterns[i]);
+        if (!router.on(patterns[i], ONEBIOT_ROUTE(HTTP_GET), handlers[i])) {
+            Serial.println(F("Router is full, see the build flags above"));
+            return;
+        }
+    }
+
+    const char *probes[] = {"/api/g0/r0", "/api/g5/r50", "/api/g9/r99", "/api/g9/missing"};
+    for (const char *probe : probes) {
+        String uri(probe);
+        Serial.printf("{\"uri\":\"%s\",\"routes\":%d,\"router_us\":%.2f,\"list_us\":%.2f}\n",
+            probe, ROUTES, routerTime(uri), listTime(uri));
+    }
+}
+
+void loop() {
+}
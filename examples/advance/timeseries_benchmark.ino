@@ -0,0 +1,80 @@
+#include <Arduino.h>
+#include <FS.h>
+
+#include <ONEBIOT.h>
+#include <utils/config/ONEBIOTConfig.h>
+#include <utils/request/ONEBIOTDataRequestHandler.h>
+#include <utils/timeseries/ONEBIOTTimeSeries.h>
+
+/**
+ * Measures append and range query throughput of the time series store on the
+ * mounted file system, then keeps recording the free heap once a second.
+ * The readings can be fetched with GET /cmd/data?from=&to=&step=
+ */
+
+const uint32_t BENCHMARK_RECORDS = 4000;
+
+ONEBIOTConfigAppConfig config;
+ONEBIOTConfig obiConfig(config);
+ONEBIOTApp obiApp(obiConfig);
+ONEBIOTTimeSeries series(obiApp.getFileSystem(), "/ts", 512);
+
+uint32_t timestamp = 0;
+unsigned long lastSample = 0;
+
+void benchmarkAppend() {
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < BENCHMARK_RECORDS; i++) {
+        series.append(++timestamp, i);
+    }
+    series.flush();
+    uint32_t elapsed = micros() - start;
+
+    Serial.printf("[TS] append: %u records in %u ms (%u records/s)\n", BENCHMARK_RECORDS, elapsed / 1000,
+        (uint32_t) (BENCHMARK_RECORDS * 1000000ULL / elapsed));
+}
+
+void benchmarkQuery(uint32_t from, uint32_t to) {
+    ONEBIOTTimeSeriesCursor cursor;
+    ONEBIOTTimeSeriesRecord record;
+    uint32_t count = 0;
+    uint32_t start = micros();
+    series.query(cursor, from, to);
+    while (series.next(cursor, record)) {
+        count++;
+    }
+    uint32_t elapsed = micros() - start;
+
+    Serial.printf("[TS] query %u..%u: %u records in %u us\n", from, to, count, elapsed);
+}
+
+void setup() {
+    Serial.begin(115200);
+    ONEBIOT_SERIAL_HEADER_PRINT();
+
+    obiApp.mountFS();
+    series.begin();
+    timestamp = series.getLastTimestamp();
+
+    benchmarkAppend();
+    // full scan, then a narrow window where the sparse index skips most of the reads
+    benchmarkQuery(0, UINT32_MAX);
+    benchmarkQuery(timestamp - 100, timestamp);
+    Serial.printf("[TS] %u records stored, %u..%u\n", series.size(), series.getFirstTimestamp(), series.getLastTimestamp());
+
+    obiConfig.setWiFiSsid("YOUR_SSID");
+    obiConfig.setWiFiPassword("YOUR_PASSWORD");
+    obiConfig.setWiFiEstablish(true);
+
+    obiApp.addRequestHandler(new ONEBIOTDataRequestHandler(obiApp.getConfig(), series));
+    obiApp.start(false);
+}
+
+void loop() {
+    obiApp.loop();
+
+    if (millis() - lastSample >= 1000) {
+        lastSample = millis();
+        series.append(++timestamp, ESP.getFreeHeap());
+    }
+}
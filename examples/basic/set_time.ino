@@ -13,7 +13,10 @@ ONEBIOTConfig obiConfig(config);
 ONEBIOTApp obiApp(obiConfig);
 
 void onInitializeTime(time_t timestamp) {
-    Serial.println("[OBI] Actual date and time is " + String(ctime(&timestamp)));
+    // ctime() ends with a new line
+    String date = ctime(&timestamp);
+    date.trim();
+    ONEBIOT_LOG_INFO(OBI, "Actual date and time is %s", date);
 }
 
 void updateTime() {
@@ -29,18 +32,13 @@ void updateTime() {
     int sec = timeinfo->tm_sec;
     int day_of_week = timeinfo->tm_wday;
 
-    Serial.println("[TIME] Y: " + String(year));
-    Serial.println("[TIME] m: " + String(month));
-    Serial.println("[TIME] d: " + String(day));
-    Serial.println("[TIME] H: " + String(hour));
-    Serial.println("[TIME] i: " + String(mins));
-    Serial.println("[TIME] s: " + String(sec));
-    Serial.println("[TIME] DoW: " + String(day_of_week));
+    ONEBIOT_LOG_INFO(APP, "%04d-%02d-%02d %02d:%02d:%02d DoW: %d", year, month, day, hour, mins, sec, day_of_week);
 }
 
 void setup() {
     Serial.begin(115200);
     ONEBIOT_SERIAL_HEADER_PRINT();
+    ONEBIOTLog::setOutput(&Serial);
 
     obiConfig.setWiFiSsid("YOUR_SSID");
     obiConfig.setWiFiPassword("YOUR_PASSWORD");
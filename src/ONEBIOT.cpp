@@ -8,7 +8,7 @@
 #ifdef ARDUINO_ARCH_ESP32
 #include <WiFi.h>
 #include <WebServer.h>
-#include <mDNS.h>
+#include <ESPmDNS.h>
 #elif defined(ARDUINO_ARCH_ESP8266) 
 #include <ESP8266WiFi.h>
 #include <ESP8266WebServer.h>
@@ -16,57 +16,67 @@
 #endif
 
 #include "ONEBIOT.h"
+#include "ONEBIOTCallbacks.h"
 #include "utils/config/ONEBIOTConfig.h"
+#include "utils/stats/ONEBIOTStats.h"
+#include "utils/trace/ONEBIOTAllocTrace.h"
+#include "utils/log/ONEBIOTLog.h"
+#include "utils/events/ONEBIOTEvents.h"
+#include "utils/mqtt/ONEBIOTMqtt.h"
+#include "utils/cache/ONEBIOTResponseCache.h"
+#ifdef ARDUINO_ARCH_ESP8266
+#include "utils/http/ONEBIOTHttpServer.h"
+#endif
 
 WiFiClient ONEBIOTWiFiClient;
 #ifdef ARDUINO_ARCH_ESP32
 WebServer server(80);
-#elif defined(ARDUINO_ARCH_ESP8266) 
+#elif defined(ONEBIOT_HTTP_SYNC)
+// -DONEBIOT_HTTP_SYNC keeps the core server, which serves one client at a time
 ESP8266WebServer server(80);
+#elif defined(ARDUINO_ARCH_ESP8266) 
+ONEBIOTHttpServer server(80);
 #endif
 
-// Callbacks definition
-
-__attribute__((weak)) void onMountFS(){}
-__attribute__((weak)) void onLoadSettings(String fileName){}
-__attribute__((weak)) void onLoadSettingsFailed(String fileName){}
-__attribute__((weak)) void onWiFiBegin(){}
-__attribute__((weak)) void onWiFiFailed(String message){}
-__attribute__((weak)) void onAPBegin(){}
-__attribute__((weak)) void onAPFailed(String message){}
-__attribute__((weak)) void onDNSBegin(){}
-__attribute__((weak)) void onDNSFailed(){}
-__attribute__((weak)) void onInitializeTime(time_t timestamp){}
-__attribute__((weak)) void onRestart(){}
+// request headers the handlers read, the server drops all others
+const char *ONEBIOT_COLLECTED_HEADERS[] = {"If-None-Match", "Accept", "Content-Type"};
 
 // print header with help
 void ONEBIOT_SERIAL_HEADER_PRINT() {
-    Serial.println("");
-    Serial.println("##################################");
-    Serial.println("### Onebiot ESP8266 - Settings ### ");
-    Serial.println("##################################");
-    Serial.println("");
-    Serial.println("# [OBI] - One Box of IOT");
-    Serial.println("# [FIS] - File System");
-    Serial.println("# [CNF] - Loading settings");
-    Serial.println("# [WFC] - WiFi Connection");
-    Serial.println("# [WAP] - AP Connection");
-    Serial.println("# [DNS] - mDNS service");
-    Serial.println("");
-    Serial.println("##################################");
-    Serial.println("");
+    Serial.println();
+    Serial.println(F("##################################"));
+    Serial.println(F("### Onebiot ESP8266 - Settings ### "));
+    Serial.println(F("##################################"));
+    Serial.println();
+    Serial.println(F("# [OBI] - One Box of IOT"));
+    Serial.println(F("# [FIS] - File System"));
+    Serial.println(F("# [CNF] - Loading settings"));
+    Serial.println(F("# [WFC] - WiFi Connection"));
+    Serial.println(F("# [WAP] - AP Connection"));
+    Serial.println(F("# [DNS] - mDNS service"));
+    Serial.println();
+    Serial.println(F("##################################"));
+    Serial.println();
 }
 
 // Class definition
 
-ONEBIOTApp::ONEBIOTApp(ONEBIOTConfig &config) : _config(config) {}
+ONEBIOTApp::ONEBIOTApp(ONEBIOTConfig &config) : _config(config), _fs(&config.getFileSystem()), _events(config), _mqtt(ONEBIOTWiFiClient, config.getFileSystem()), _cache(config), _captivePortal(_captiveDNS) {}
+
+ONEBIOTApp::ONEBIOTApp(ONEBIOTConfig &config, FS &fs) : _config(config), _fs(&fs), _events(config), _mqtt(ONEBIOTWiFiClient, fs), _cache(config), _captivePortal(_captiveDNS) {
+    _config.setFileSystem(fs);
+}
 
 ONEBIOTConfig ONEBIOTApp::getConfig() {
     return _config;
 }
 
+FS &ONEBIOTApp::getFileSystem() {
+    return *_fs;
+}
+
 bool ONEBIOTApp::mountFS() {
-    _spiffsStarted = SPIFFS.begin();    
+    _spiffsStarted = _fs->begin();
     return _spiffsStarted;
 }
 
@@ -83,6 +93,11 @@ bool ONEBIOTApp::couldEstablishMDNS() {
 }
 
 void ONEBIOTApp::start(bool enforceRestartWhenErrorOccured) {
+    // static facts are cached at boot, requests never hash the sketch again
+    ONEBIOTStats::chipInfo();
+
+    ONEBIOT_ALLOC_SCOPE(PSTR("start"));
+
     if (!_spiffsStarted && !mountFS() && enforceRestartWhenErrorOccured) {
         restart();
     } else if (_spiffsStarted) {
@@ -121,12 +136,16 @@ void ONEBIOTApp::start(bool enforceRestartWhenErrorOccured) {
         server.onNotFound([](){
             server.send(404, "text/plain", "The content you are looking for was not found.");
         });
+        server.collectHeaders(ONEBIOT_COLLECTED_HEADERS, sizeof(ONEBIOT_COLLECTED_HEADERS) / sizeof(ONEBIOT_COLLECTED_HEADERS[0]));
+        server.addHandler(&_router);
         server.begin();
         _webServerStarted = true;
     }
 }
 
 bool ONEBIOTApp::startWiFi() {
+    ONEBIOT_ALLOC_SCOPE(PSTR("wifi"));
+
     if (!couldEstablishWiFiConnection()) {
         onWiFiFailed("WiFi is off");
         return false;
@@ -165,6 +184,8 @@ void ONEBIOTApp::reconnectWiFi() {
 }
 
 bool ONEBIOTApp::startAP() {
+    ONEBIOT_ALLOC_SCOPE(PSTR("ap"));
+
     if (!couldEstablishWiFiAP()) {
         onAPFailed("Creating AP is off");
         _apStarted = false;
@@ -180,6 +201,11 @@ bool ONEBIOTApp::startAP() {
     if (!result) {
         onAPFailed("Creating AP failed");
     } else {
+        // every name resolves to the AP, the connectivity checks of the clients end on the device
+        _captiveDNS.begin(WiFi.softAPIP());
+        if (!_captivePortalRouted) {
+            _captivePortalRouted = _captivePortal.addRoutes(_router);
+        }
         onAPBegin();
     }
 
@@ -188,6 +214,8 @@ bool ONEBIOTApp::startAP() {
 }
 
 bool ONEBIOTApp::startMDNS(String hostName) {
+    ONEBIOT_ALLOC_SCOPE(PSTR("mdns"));
+
     if (!MDNS.begin(hostName)) {
         onDNSFailed();
         _dnsStarted = false;
@@ -206,7 +234,17 @@ bool ONEBIOTApp::startMDNS() {
 
 void ONEBIOTApp::addRequestHandler(ONEBIOTRequestHandler *handler) {
     if (couldEstablishWiFiConnection() || couldEstablishWiFiAP()) {
-        server.addHandler(handler);
+#ifdef ARDUINO_ARCH_ESP32
+        // the server task walks the router, it adds the handler between two requests
+        if (_serverTaskStarted) {
+            NewHandler added = {handler, nullptr};
+            if (!_newHandlers.push(added)) {
+                ONEBIOT_LOG_ERROR(WS, "Handler queue is full");
+            }
+            return;
+        }
+#endif
+        _router.addHandler(handler);
         if (!_establishWebServer) {
             _establishWebServer = true;
         }
@@ -215,7 +253,18 @@ void ONEBIOTApp::addRequestHandler(ONEBIOTRequestHandler *handler) {
 
 void ONEBIOTApp::addServeStatic(const char* uri) {
     if (couldEstablishWiFiConnection() || couldEstablishWiFiAP()) {
-        server.serveStatic(uri, SPIFFS, uri);
+#ifdef ARDUINO_ARCH_ESP32
+        // the router belongs to the server task, it gets its own copy of the uri
+        if (_serverTaskStarted) {
+            NewHandler added = {nullptr, strdup(uri)};
+            if (added.staticUri == nullptr || !_newHandlers.push(added)) {
+                free(added.staticUri);
+                ONEBIOT_LOG_ERROR(WS, "Handler queue is full");
+            }
+            return;
+        }
+#endif
+        _router.serveStatic(uri, *_fs, uri);
         if (!_establishWebServer) {
             _establishWebServer = true;
         }
@@ -237,17 +286,117 @@ time_t ONEBIOTApp::updateTime() {
 }
 
 void ONEBIOTApp::loop() {
+    _stats.loop();
+    ONEBIOTLog::loop();
+
     if (couldEstablishWiFiConnection()) {
         reconnectWiFi();
     }
 
-    if (_webServerStarted) {
+#ifdef ARDUINO_ARCH_ESP32
+    ONEBIOTAppEvent event;
+    while (_appEvents.pop(event)) {
+        _handleEvent(event);
+    }
+#endif
+
+    if (_webServerStarted && !_serverTaskStarted) {
+        ONEBIOT_ALLOC_SCOPE(PSTR("http"));
+        _cache.loop();
         server.handleClient();
+        _events.loop();
     }
 
+#ifdef ARDUINO_ARCH_ESP8266
+    // the ESP32 responder runs in its own task
     if (_dnsStarted) {
+        ONEBIOT_ALLOC_SCOPE(PSTR("mdns"));
         MDNS.update();
     }
+#endif
+
+    if (_captiveDNS.isRunning()) {
+        if (!(WiFi.getMode() & WIFI_AP)) {
+            _captiveDNS.stop();
+        } else if (_captiveDNS.loop() > 0) {
+            _idle.activity();
+        }
+    }
+
+    {
+        ONEBIOT_ALLOC_SCOPE(PSTR("mqtt"));
+        _mqtt.loop(WiFi.status() == WL_CONNECTED);
+    }
+
+    if (_idle.getMode() != ONEBIOT_IDLE_OFF) {
+        _reportIdle();
+        // loop_latency is the work of a pass, not the sleep after it
+        uint32_t sleepStart = micros();
+        _idle.loop();
+        _stats.excludeSleep(micros() - sleepStart);
+    }
+}
+
+// Work left behind by the pass keeps the loop awake, the rest bounds the next sleep.
+void ONEBIOTApp::_reportIdle() {
+    // records waiting for Serial are not traffic, they only keep the loop going
+    if (!ONEBIOTLog::isDrained()) {
+        _idle.deadline(0);
+    }
+    _idle.deadline(_stats.getIdleTime());
+
+    if (_webServerStarted && !_serverTaskStarted) {
+#if defined(ARDUINO_ARCH_ESP8266) && !defined(ONEBIOT_HTTP_SYNC)
+        bool serverIdle = server.isIdle();
+#else
+        bool serverIdle = !server.client().connected();
+#endif
+        if (!serverIdle) {
+            _idle.activity();
+        }
+        _idle.deadline(_events.getIdleTime());
+    }
+
+    if (_dnsStarted) {
+        _idle.deadline(ONEBIOT_IDLE_MDNS_INTERVAL);
+    }
+
+    // while WiFi is down the client does not run at all
+    if (WiFi.status() == WL_CONNECTED) {
+        _idle.deadline(_mqtt.getIdleTime());
+    }
+}
+
+ONEBIOTStats &ONEBIOTApp::getStats() {
+    return _stats;
+}
+
+void ONEBIOTApp::setStatsInterval(uint32_t interval) {
+    _stats.setInterval(interval);
+}
+
+ONEBIOTEvents &ONEBIOTApp::getEvents() {
+    return _events;
+}
+
+ONEBIOTMqtt &ONEBIOTApp::getMqtt() {
+    return _mqtt;
+}
+
+ONEBIOTResponseCache &ONEBIOTApp::getCache() {
+    return _cache;
+}
+
+ONEBIOTRouter &ONEBIOTApp::getRouter() {
+    return _router;
+}
+
+ONEBIOTIdle &ONEBIOTApp::getIdle() {
+    return _idle;
+}
+
+ONEBIOTCaptiveDNS &ONEBIOTApp::getCaptiveDNS() {
+    return _captiveDNS;
 }
 
 bool ONEBIOTApp::isSpiffsStarted() {
@@ -272,8 +421,74 @@ bool ONEBIOTApp::isWebserverStarted() {
 
 void ONEBIOTApp::restart() {
     onRestart();
+    _mqtt.persist();
+    ONEBIOTLog::flush();
     delay(100);
     ESP.restart();
 }
 
+void ONEBIOTApp::notify(ONEBIOTAppEvent event) {
+#ifdef ARDUINO_ARCH_ESP32
+    // user callbacks always run on the loop task
+    if (_serverTaskStarted && xTaskGetCurrentTaskHandle() == _serverTask) {
+        if (!_appEvents.push(event)) {
+            ONEBIOT_LOG_ERROR(OBI, "Event queue is full, event %u lost", event);
+        }
+        return;
+    }
+#endif
+    _handleEvent(event);
+}
+
+void ONEBIOTApp::_handleEvent(ONEBIOTAppEvent event) {
+    switch (event) {
+        case ONEBIOT_EVENT_RESTART:
+            restart();
+            break;
+        case ONEBIOT_EVENT_NEED_RESTART:
+            onNeedRestart();
+            break;
+    }
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+bool ONEBIOTApp::startServerTask(BaseType_t core) {
+    if (_serverTaskStarted || !_webServerStarted) {
+        return false;
+    }
+
+    // set before the task runs, loop() must not touch the server from now on
+    _serverTaskStarted = true;
+    if (xTaskCreatePinnedToCore(_serverTaskLoop, "onebiot-server", ONEBIOT_SERVER_TASK_STACK, this, ONEBIOT_SERVER_TASK_PRIORITY, &_serverTask, core) != pdPASS) {
+        _serverTaskStarted = false;
+        ONEBIOT_LOG_ERROR(OBI, "Server task could not be created");
+        return false;
+    }
+
+    ONEBIOT_LOG_INFO(OBI, "Server task runs on core %d", core);
+    return true;
+}
+
+void ONEBIOTApp::_serverTaskLoop(void *parameter) {
+    ONEBIOTApp *app = (ONEBIOTApp *) parameter;
+    NewHandler added;
+    for (;;) {
+        while (app->_newHandlers.pop(added)) {
+            if (added.handler != nullptr) {
+                app->_router.addHandler(added.handler);
+            } else {
+                app->_router.serveStatic(added.staticUri, *app->_fs, added.staticUri);
+                free(added.staticUri);
+            }
+        }
+
+        app->_cache.loop();
+        server.handleClient();
+        app->_events.loop();
+        // lets the idle task of the core feed its watchdog
+        vTaskDelay(1);
+    }
+}
+#endif
+
 #endif //ONEBIOT_CPP
@@ -9,14 +9,39 @@
 #include <ESP8266WebServer.h>
 #endif
 
+#include "utils/fs/ONEBIOTFS.h"
 #include "utils/config/ONEBIOTConfig.h"
 #include "utils/request/ONEBIOTRequestHandler.h"
+#include "utils/stats/ONEBIOTStats.h"
+#include "utils/log/ONEBIOTLog.h"
+#include "utils/events/ONEBIOTEvents.h"
+#include "utils/mqtt/ONEBIOTMqtt.h"
+#include "utils/cache/ONEBIOTResponseCache.h"
+#include "utils/sync/ONEBIOTSync.h"
+#include "utils/router/ONEBIOTRouter.h"
+#include "utils/power/ONEBIOTIdle.h"
+#include "utils/captive/ONEBIOTCaptivePortal.h"
+
+#ifndef ONEBIOT_SERVER_TASK_STACK
+#define ONEBIOT_SERVER_TASK_STACK 8192
+#endif
+
+#ifndef ONEBIOT_SERVER_TASK_PRIORITY
+#define ONEBIOT_SERVER_TASK_PRIORITY 1
+#endif
 
 void ONEBIOT_SERIAL_HEADER_PRINT();
 
+// requests of request handlers which the application loop carries out
+enum ONEBIOTAppEvent : uint8_t {
+    ONEBIOT_EVENT_RESTART,
+    ONEBIOT_EVENT_NEED_RESTART
+};
+
 class ONEBIOTApp {
     private:
         ONEBIOTConfig &_config;
+        FS *_fs;
         time_t INITIALIZE_TIMESTAMP = 1000000000;
         bool _spiffsStarted = false;
         bool _wifiStarted = false;
@@ -29,9 +54,38 @@ class ONEBIOTApp {
         bool _establishWebServer = false;
         bool _updateTime = false;
         time_t _timestamp;
+        ONEBIOTStats _stats;
+        ONEBIOTEvents _events;
+        ONEBIOTMqtt _mqtt;
+        ONEBIOTResponseCache _cache;
+        // the only handler of the server, the others are reached through it
+        ONEBIOTRouter _router;
+        ONEBIOTIdle _idle;
+        // provisioning clients find the device through them while the AP is up
+        ONEBIOTCaptiveDNS _captiveDNS;
+        ONEBIOTCaptivePortal _captivePortal;
+        bool _captivePortalRouted = false;
+        bool _serverTaskStarted = false;
+#ifdef ARDUINO_ARCH_ESP32
+        TaskHandle_t _serverTask = nullptr;
+        // server task -> loop task
+        ONEBIOTQueue<ONEBIOTAppEvent, 8> _appEvents;
+        // a handler or the uri of a static route (owned by the queue until the server task frees it)
+        struct NewHandler {
+            ONEBIOTRequestHandler *handler;
+            char *staticUri;
+        };
+        // loop task -> server task, routes added to the router while the server runs
+        ONEBIOTQueue<NewHandler, 8> _newHandlers;
+        static void _serverTaskLoop(void *parameter);
+#endif
+        void _handleEvent(ONEBIOTAppEvent event);
+        void _reportIdle();
     public:
         ONEBIOTApp(ONEBIOTConfig &config);
+        ONEBIOTApp(ONEBIOTConfig &config, FS &fs);
         ONEBIOTConfig getConfig();
+        FS &getFileSystem();
         bool mountFS();
         void establishWiFiConnection(bool establishWiFiConnection);
         bool couldEstablishWiFiConnection();
@@ -46,16 +100,33 @@ class ONEBIOTApp {
         bool startMDNS();
         bool startMDNS(String hostName);
         void addRequestHandler(ONEBIOTRequestHandler *handler);
+        // the file of the same path, a uri ending in "/" serves the whole directory below it
         void addServeStatic(const char* uri);
         void initializeTime(int timezone, int daylightOffset_sec, const char* server1, const char* server2);
         time_t updateTime();
         void loop();
+        ONEBIOTStats &getStats();
+        void setStatsInterval(uint32_t interval);
+        ONEBIOTEvents &getEvents();
+        ONEBIOTMqtt &getMqtt();
+        ONEBIOTResponseCache &getCache();
+        ONEBIOTRouter &getRouter();
+        // sleeps between loop passes once a mode is set, see ONEBIOTIdle
+        ONEBIOTIdle &getIdle();
+        ONEBIOTCaptiveDNS &getCaptiveDNS();
         bool isSpiffsStarted();
         bool isWifiStarted();
         bool isApStarted();
         bool isDnsStarted();
         bool isWebserverStarted();
         void restart();
+        // carried out right away, or by the next loop() when called from the server task
+        void notify(ONEBIOTAppEvent event);
+#ifdef ARDUINO_ARCH_ESP32
+        // moves the web server and the events channel to a task pinned to the core,
+        // loop() keeps WiFi, mDNS, MQTT and the events posted by handlers
+        bool startServerTask(BaseType_t core = 0);
+#endif
 };
 
 #endif //ONEBIOT_H
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef ONEBIOT_CALLBACKS_CPP
+#define ONEBIOT_CALLBACKS_CPP
+
+#include <Arduino.h>
+#include <time.h>
+
+#include "ONEBIOTCallbacks.h"
+
+// Callbacks definition
+// kept apart from ONEBIOT.cpp, so ONEBIOTLiteApp can call them without linking the full app
+
+__attribute__((weak)) void onMountFS(){}
+__attribute__((weak)) void onLoadSettings(String fileName){}
+__attribute__((weak)) void onLoadSettingsFailed(String fileName){}
+__attribute__((weak)) void onWiFiBegin(){}
+__attribute__((weak)) void onWiFiFailed(String message){}
+__attribute__((weak)) void onAPBegin(){}
+__attribute__((weak)) void onAPFailed(String message){}
+__attribute__((weak)) void onDNSBegin(){}
+__attribute__((weak)) void onDNSFailed(){}
+__attribute__((weak)) void onInitializeTime(time_t timestamp){}
+__attribute__((weak)) void onRestart(){}
+__attribute__((weak)) void onNeedRestart(){}
+
+#endif //ONEBIOT_CALLBACKS_CPP
@@ -0,0 +1,21 @@
+#ifndef ONEBIOT_CALLBACKS_H
+#define ONEBIOT_CALLBACKS_H
+
+#include <Arduino.h>
+#include <time.h>
+
+// Lifecycle callbacks, a sketch overrides the weak defaults by defining them.
+void onMountFS();
+void onLoadSettings(String fileName);
+void onLoadSettingsFailed(String fileName);
+void onWiFiBegin();
+void onWiFiFailed(String message);
+void onAPBegin();
+void onAPFailed(String message);
+void onDNSBegin();
+void onDNSFailed();
+void onInitializeTime(time_t timestamp);
+void onRestart();
+void onNeedRestart();
+
+#endif //ONEBIOT_CALLBACKS_H
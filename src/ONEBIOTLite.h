@@ -0,0 +1,298 @@
+#ifndef ONEBIOT_LITE_H
+#define ONEBIOT_LITE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <time.h>
+#include <type_traits>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WiFi.h>
+#include <WebServer.h>
+#include <ESPmDNS.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#include <ESP8266mDNS.h>
+#endif
+
+#include "ONEBIOTCallbacks.h"
+#include "utils/config/ONEBIOTConfig.h"
+#include "utils/request/ONEBIOTRequestHandler.h"
+#include "utils/stats/ONEBIOTStats.h"
+#include "utils/log/ONEBIOTLog.h"
+#ifdef ARDUINO_ARCH_ESP8266
+#include "utils/http/ONEBIOTHttpServer.h"
+#endif
+
+// subsystems of ONEBIOTLiteApp, combined into its template argument
+enum ONEBIOTSubsystem : uint16_t {
+    ONEBIOT_SUBSYSTEM_FS = 1 << 0,
+    ONEBIOT_SUBSYSTEM_WIFI = 1 << 1,
+    ONEBIOT_SUBSYSTEM_AP = 1 << 2,
+    ONEBIOT_SUBSYSTEM_MDNS = 1 << 3,
+    ONEBIOT_SUBSYSTEM_WEB_SERVER = 1 << 4,
+    ONEBIOT_SUBSYSTEM_TIME = 1 << 5,
+    ONEBIOT_SUBSYSTEM_STATS = 1 << 6
+};
+
+#define ONEBIOT_SUBSYSTEMS_SENSOR (ONEBIOT_SUBSYSTEM_WIFI | ONEBIOT_SUBSYSTEM_TIME)
+#define ONEBIOT_SUBSYSTEMS_ALL (ONEBIOT_SUBSYSTEM_FS | ONEBIOT_SUBSYSTEM_WIFI | ONEBIOT_SUBSYSTEM_AP | ONEBIOT_SUBSYSTEM_MDNS \
+    | ONEBIOT_SUBSYSTEM_WEB_SERVER | ONEBIOT_SUBSYSTEM_TIME | ONEBIOT_SUBSYSTEM_STATS)
+
+// storage of a subsystem, nothing at all when it is not selected
+template<bool Enabled, class T>
+struct ONEBIOTLiteMember {
+    T value;
+};
+
+template<class T>
+struct ONEBIOTLiteMember<false, T> {};
+
+/**
+ * ONEBIOTApp reduced to the subsystems of the template argument. Every subsystem
+ * is reached through an overload picked by a std::integral_constant, the overload of
+ * an unselected one is empty and its code is never instantiated: no per loop check,
+ * no strings, no web server or mDNS object and no stats history in the image.
+ *
+ *   ONEBIOTLiteApp<ONEBIOT_SUBSYSTEMS_SENSOR> app(config);
+ *
+ * Calling a method of an unselected subsystem fails to compile. ONEBIOTApp stays
+ * the full featured application with events, MQTT and the response cache, the
+ * /cmd handlers hold it, so a lite app serves own handlers only. ONEBIOT.h has to
+ * stay out of the sketch, its globals would be linked again.
+ */
+template<uint16_t Subsystems>
+class ONEBIOTLiteApp {
+    public:
+        typedef std::integral_constant<bool, (Subsystems & ONEBIOT_SUBSYSTEM_FS) != 0> HasFS;
+        typedef std::integral_constant<bool, (Subsystems & ONEBIOT_SUBSYSTEM_WIFI) != 0> HasWiFi;
+        typedef std::integral_constant<bool, (Subsystems & ONEBIOT_SUBSYSTEM_AP) != 0> HasAP;
+        typedef std::integral_constant<bool, (Subsystems & ONEBIOT_SUBSYSTEM_MDNS) != 0> HasMDNS;
+        typedef std::integral_constant<bool, (Subsystems & ONEBIOT_SUBSYSTEM_WEB_SERVER) != 0> HasWebServer;
+        typedef std::integral_constant<bool, (Subsystems & ONEBIOT_SUBSYSTEM_TIME) != 0> HasTime;
+        typedef std::integral_constant<bool, (Subsystems & ONEBIOT_SUBSYSTEM_STATS) != 0> HasStats;
+
+#ifdef ARDUINO_ARCH_ESP32
+        typedef WebServer Server;
+#elif defined(ONEBIOT_HTTP_SYNC)
+        typedef ESP8266WebServer Server;
+#else
+        typedef ONEBIOTHttpServer Server;
+#endif
+
+        ONEBIOTLiteApp(ONEBIOTConfig &config) : _config(config) {}
+
+        void start(bool enforceRestartWhenErrorOccured) {
+            bool failed = !_startFS(HasFS());
+            failed |= !_startNetwork(HasWiFi(), HasAP());
+            failed |= !_startMDNS(HasMDNS());
+            _startWebServer(HasWebServer());
+            if (failed && enforceRestartWhenErrorOccured) {
+                restart();
+            }
+        }
+
+        void loop() {
+            _loopStats(HasStats());
+            ONEBIOTLog::loop();
+            _loopWiFi(HasWiFi());
+            _loopWebServer(HasWebServer());
+            _loopMDNS(HasMDNS());
+        }
+
+        bool startWiFi() {
+            static_assert(HasWiFi::value, "ONEBIOT_SUBSYSTEM_WIFI is not selected");
+            if (!_config.getConfig().wifi_establish) {
+                onWiFiFailed(F("WiFi is off"));
+                return _setStarted(ONEBIOT_SUBSYSTEM_WIFI, false);
+            }
+
+            WiFi.mode(WIFI_STA);
+            WiFi.disconnect(true);
+            if (_config.getConfig().wifi_ssid.isEmpty()) {
+                onWiFiFailed(F("No SSID is available"));
+                return _setStarted(ONEBIOT_SUBSYSTEM_WIFI, false);
+            }
+
+            if (_config.getConfig().wifi_password.isEmpty()) {
+                WiFi.begin(_config.getConfig().wifi_ssid);
+            } else {
+                WiFi.begin(_config.getConfig().wifi_ssid, _config.getConfig().wifi_password);
+            }
+
+            if (WiFi.waitForConnectResult() != WL_CONNECTED) {
+                onWiFiFailed(String(F("Connecting error: #")) + String(WiFi.status()));
+                return _setStarted(ONEBIOT_SUBSYSTEM_WIFI, false);
+            }
+
+            onWiFiBegin();
+            return _setStarted(ONEBIOT_SUBSYSTEM_WIFI, true);
+        }
+
+        bool startAP() {
+            static_assert(HasAP::value, "ONEBIOT_SUBSYSTEM_AP is not selected");
+            if (!_config.getConfig().ap_establish) {
+                onAPFailed(F("Creating AP is off"));
+                return _setStarted(ONEBIOT_SUBSYSTEM_AP, false);
+            }
+
+            if (WiFi.status() == WL_CONNECTED) {
+                WiFi.disconnect();
+            }
+
+            WiFi.mode(WIFI_AP_STA);
+            bool result = WiFi.softAP(_config.getApSsid(), _config.getConfig().ap_password);
+            if (!result) {
+                onAPFailed(F("Creating AP failed"));
+            } else {
+                onAPBegin();
+            }
+            return _setStarted(ONEBIOT_SUBSYSTEM_AP, result);
+        }
+
+        bool startMDNS() {
+            static_assert(HasMDNS::value, "ONEBIOT_SUBSYSTEM_MDNS is not selected");
+            if (!MDNS.begin(_config.getDnsName())) {
+                onDNSFailed();
+                return _setStarted(ONEBIOT_SUBSYSTEM_MDNS, false);
+            }
+            MDNS.addService("http", "tcp", 80);
+
+            onDNSBegin();
+            return _setStarted(ONEBIOT_SUBSYSTEM_MDNS, true);
+        }
+
+        // the server is created by the first call, a build without the web server has none
+        static Server &getServer() {
+            static_assert(HasWebServer::value, "ONEBIOT_SUBSYSTEM_WEB_SERVER is not selected");
+            static Server server(80);
+            return server;
+        }
+
+        void addRequestHandler(ONEBIOTRequestHandler *handler) {
+            getServer().addHandler(handler);
+        }
+
+        void initializeTime(int timezone, int daylightOffset_sec, const char* server1, const char* server2) {
+            static_assert(HasTime::value, "ONEBIOT_SUBSYSTEM_TIME is not selected");
+            configTime(timezone, daylightOffset_sec, server1, server2);
+            time_t timestamp = 0;
+            while (timestamp < INITIALIZE_TIMESTAMP) {
+                timestamp = time(nullptr);
+                delay(500);
+            }
+            onInitializeTime(timestamp);
+        }
+
+        time_t updateTime() {
+            static_assert(HasTime::value, "ONEBIOT_SUBSYSTEM_TIME is not selected");
+            return time(nullptr);
+        }
+
+        ONEBIOTStats &getStats() {
+            static_assert(HasStats::value, "ONEBIOT_SUBSYSTEM_STATS is not selected");
+            return _stats.value;
+        }
+
+        ONEBIOTConfig &getConfig() {
+            return _config;
+        }
+
+        bool isStarted(ONEBIOTSubsystem subsystem) {
+            return (_started & subsystem) != 0;
+        }
+
+        void restart() {
+            onRestart();
+            ONEBIOTLog::flush();
+            delay(100);
+            ESP.restart();
+        }
+    private:
+        static const time_t INITIALIZE_TIMESTAMP = 1000000000;
+
+        ONEBIOTConfig &_config;
+        // one bit per started subsystem instead of a bool each
+        uint16_t _started = 0;
+        ONEBIOTLiteMember<HasStats::value, ONEBIOTStats> _stats;
+
+        bool _setStarted(ONEBIOTSubsystem subsystem, bool started) {
+            _started = started ? (_started | subsystem) : (_started & ~subsystem);
+            return started;
+        }
+
+        bool _startFS(std::false_type) { return true; }
+        bool _startFS(std::true_type) {
+            if (!_setStarted(ONEBIOT_SUBSYSTEM_FS, _config.getFileSystem().begin())) {
+                return false;
+            }
+            onMountFS();
+
+            if (_config.configExists()) {
+                if (_config.load()) {
+                    onLoadSettings(_config.getConfigFileName());
+                } else {
+                    onLoadSettingsFailed(_config.getConfigFileName());
+                }
+            }
+            return true;
+        }
+
+        // the AP comes up when the station is off or could not connect
+        template<class AP>
+        bool _startNetwork(std::false_type, AP ap) { return _startAP(ap); }
+        template<class AP>
+        bool _startNetwork(std::true_type, AP ap) {
+            if (_config.getConfig().wifi_establish && startWiFi()) {
+                return true;
+            }
+            bool apStarted = _startAP(ap);
+            return apStarted || !_config.getConfig().wifi_establish;
+        }
+
+        bool _startAP(std::false_type) { return true; }
+        bool _startAP(std::true_type) {
+            return !_config.getConfig().ap_establish || startAP();
+        }
+
+        bool _startMDNS(std::false_type) { return true; }
+        bool _startMDNS(std::true_type) {
+            return !_config.getConfig().dns_establish || startMDNS();
+        }
+
+        void _startWebServer(std::false_type) {}
+        void _startWebServer(std::true_type) {
+            getServer().begin();
+            _setStarted(ONEBIOT_SUBSYSTEM_WEB_SERVER, true);
+        }
+
+        void _loopStats(std::false_type) {}
+        void _loopStats(std::true_type) {
+            _stats.value.loop();
+        }
+
+        void _loopWiFi(std::false_type) {}
+        void _loopWiFi(std::true_type) {
+            if (isStarted(ONEBIOT_SUBSYSTEM_WIFI) && WiFi.status() != WL_CONNECTED) {
+                startWiFi();
+            }
+        }
+
+        void _loopWebServer(std::false_type) {}
+        void _loopWebServer(std::true_type) {
+            getServer().handleClient();
+        }
+
+        void _loopMDNS(std::false_type) {}
+        void _loopMDNS(std::true_type) {
+#ifdef ARDUINO_ARCH_ESP8266
+            // the ESP32 responder runs in its own task
+            if (isStarted(ONEBIOT_SUBSYSTEM_MDNS)) {
+                MDNS.update();
+            }
+#endif
+        }
+};
+
+#endif //ONEBIOT_LITE_H
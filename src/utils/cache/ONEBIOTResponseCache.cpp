@@ -0,0 +1,114 @@
+#ifndef ONEBIOT_RESPONSE_CACHE_CPP
+#define ONEBIOT_RESPONSE_CACHE_CPP
+
+#include <Arduino.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WiFi.h>
+#elif defined(ARDUINO_ARCH_ESP8266) 
+#include <ESP8266WiFi.h>
+#endif
+
+#include "utils/cache/ONEBIOTResponseCache.h"
+
+static uint32_t CACHE_HASH(uint32_t hash, const String &value) {
+    for (size_t i = 0; i < value.length(); i++) {
+        hash = (hash ^ (uint8_t) value[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+ONEBIOTResponseCache::ONEBIOTResponseCache(ONEBIOTConfig &config) : _config(config) {
+    // generations start over after a reboot, tags of the previous boot must not match
+#ifdef ARDUINO_ARCH_ESP32
+    _boot = esp_random();
+#else
+    _boot = RANDOM_REG32;
+#endif
+}
+
+void ONEBIOTResponseCache::loop() {
+    int status = WiFi.status();
+    int mode = WiFi.getMode();
+    int stations = WiFi.softAPgetStationNum();
+    if (status != _wifiStatus || mode != _wifiMode || stations != _stations) {
+        _wifiStatus = status;
+        _wifiMode = mode;
+        _stations = stations;
+        _networkGeneration++;
+    }
+}
+
+void ONEBIOTResponseCache::invalidate() {
+    _networkGeneration++;
+}
+
+// both counters only grow, so their sum changes whenever one of them does
+uint32_t ONEBIOTResponseCache::getGeneration() {
+    return _config.getGeneration() + _networkGeneration;
+}
+
+uint32_t ONEBIOTResponseCache::key(const String &uri, ESP8266WebServer &server) {
+    uint32_t hash = CACHE_HASH(2166136261UL, uri);
+    for (int i = 0; i < server.args(); i++) {
+        hash = CACHE_HASH(hash ^ '&', server.argName(i));
+        hash = CACHE_HASH(hash ^ '=', server.arg(i));
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+const String *ONEBIOTResponseCache::get(uint32_t key) {
+    uint32_t generation = getGeneration();
+    for (uint8_t i = 0; i < ONEBIOT_CACHE_ENTRIES; i++) {
+        Entry &entry = _entries[i];
+        if (entry.key == key && entry.generation == generation) {
+            entry.used = ++_clock;
+            _hits++;
+            return &entry.payload;
+        }
+    }
+    _misses++;
+    return nullptr;
+}
+
+// Takes the slot of the same key, a stale entry or the least recently used one.
+bool ONEBIOTResponseCache::put(uint32_t key, const String &payload) {
+    if (payload.length() > ONEBIOT_CACHE_PAYLOAD_SIZE) {
+        return false;
+    }
+
+    uint32_t generation = getGeneration();
+    Entry *slot = &_entries[0];
+    for (uint8_t i = 0; i < ONEBIOT_CACHE_ENTRIES; i++) {
+        Entry &entry = _entries[i];
+        if (entry.key == key || entry.key == 0 || entry.generation != generation) {
+            slot = &entry;
+            break;
+        }
+        if (entry.used < slot->used) {
+            slot = &entry;
+        }
+    }
+
+    slot->key = key;
+    slot->generation = generation;
+    slot->used = ++_clock;
+    slot->payload = payload;
+    return true;
+}
+
+String ONEBIOTResponseCache::etag(uint32_t key) {
+    char tag[29];
+    snprintf(tag, sizeof(tag), "\"%08x-%08x-%08x\"", _boot, key, getGeneration());
+    return String(tag);
+}
+
+uint32_t ONEBIOTResponseCache::getHits() {
+    return _hits;
+}
+
+uint32_t ONEBIOTResponseCache::getMisses() {
+    return _misses;
+}
+
+#endif //ONEBIOT_RESPONSE_CACHE_CPP
@@ -0,0 +1,58 @@
+#ifndef ONEBIOT_RESPONSE_CACHE_H
+#define ONEBIOT_RESPONSE_CACHE_H
+
+#include <Arduino.h>
+#include "utils/config/ONEBIOTConfig.h"
+#include "utils/request/ONEBIOTRequestHandler.h"
+
+#ifndef ONEBIOT_CACHE_ENTRIES
+#define ONEBIOT_CACHE_ENTRIES 6
+#endif
+
+// larger responses are never cached
+#ifndef ONEBIOT_CACHE_PAYLOAD_SIZE
+#define ONEBIOT_CACHE_PAYLOAD_SIZE 512
+#endif
+
+/**
+ * Serialized JSON of GET routes which only change with the config or the network
+ * state. An entry is valid for the generation it was stored in, the generation
+ * moves with every config change and every WiFi state transition seen by loop().
+ */
+class ONEBIOTResponseCache {
+    public:
+        ONEBIOTResponseCache(ONEBIOTConfig &config);
+        void loop();
+        // drops every entry, e.g. after a change loop() cannot see
+        void invalidate();
+        uint32_t getGeneration();
+        // route and arguments of the current request, never 0
+        uint32_t key(const String &uri, ESP8266WebServer &server);
+        // nullptr when the key is missing or stale
+        const String *get(uint32_t key);
+        bool put(uint32_t key, const String &payload);
+        // strong validator of the entry, unique across reboots
+        String etag(uint32_t key);
+        uint32_t getHits();
+        uint32_t getMisses();
+    private:
+        struct Entry {
+            uint32_t key = 0;
+            uint32_t generation = 0;
+            uint32_t used = 0;
+            String payload;
+        };
+
+        ONEBIOTConfig &_config;
+        Entry _entries[ONEBIOT_CACHE_ENTRIES];
+        uint32_t _networkGeneration = 0;
+        uint32_t _boot;
+        uint32_t _clock = 0;
+        uint32_t _hits = 0;
+        uint32_t _misses = 0;
+        int _wifiStatus = -1;
+        int _wifiMode = -1;
+        int _stations = -1;
+};
+
+#endif //ONEBIOT_RESPONSE_CACHE_H
@@ -0,0 +1,164 @@
+#ifndef ONEBIOT_CAPTIVE_PORTAL_CPP
+#define ONEBIOT_CAPTIVE_PORTAL_CPP
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include "utils/captive/ONEBIOTCaptivePortal.h"
+#include "utils/router/ONEBIOTRouter.h"
+#include "utils/log/ONEBIOTLog.h"
+
+static const uint16_t DNS_TYPE_A = 1;
+static const uint16_t DNS_TYPE_ANY = 255;
+static const uint16_t DNS_CLASS_IN = 1;
+
+// ID, flags of an authoritative answer without error, one question, one answer
+static const uint8_t DNS_ANSWER_HEADER[] = {0x00, 0x00, 0x84, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00};
+
+static const char CAPTIVE_ANDROID[] PROGMEM = "/generate_204";
+static const char CAPTIVE_ANDROID_GEN[] PROGMEM = "/gen_204";
+static const char CAPTIVE_APPLE[] PROGMEM = "/hotspot-detect.html";
+static const char CAPTIVE_APPLE_SUCCESS[] PROGMEM = "/library/test/success.html";
+static const char CAPTIVE_WINDOWS[] PROGMEM = "/connecttest.txt";
+static const char CAPTIVE_WINDOWS_NCSI[] PROGMEM = "/ncsi.txt";
+static const char CAPTIVE_WINDOWS_REDIRECT[] PROGMEM = "/redirect";
+static const char CAPTIVE_FIREFOX[] PROGMEM = "/canonical.html";
+static const char CAPTIVE_FIREFOX_SUCCESS[] PROGMEM = "/success.txt";
+
+bool ONEBIOTCaptiveDNS::begin(const IPAddress &ip, uint16_t port) {
+    // name as a pointer to the question, type A, class IN, TTL, 4 bytes of address
+    const uint8_t answer[ANSWER_SIZE] = {
+        0xC0, 0x0C, 0x00, DNS_TYPE_A, 0x00, DNS_CLASS_IN,
+        (uint8_t) (ONEBIOT_CAPTIVE_DNS_TTL >> 24), (uint8_t) (ONEBIOT_CAPTIVE_DNS_TTL >> 16),
+        (uint8_t) (ONEBIOT_CAPTIVE_DNS_TTL >> 8), (uint8_t) ONEBIOT_CAPTIVE_DNS_TTL,
+        0x00, 0x04, ip[0], ip[1], ip[2], ip[3]
+    };
+    memcpy(_answer, answer, ANSWER_SIZE);
+
+    stop();
+    _running = _udp.begin(port) == 1;
+    if (_running) {
+        ONEBIOT_LOG_INFO(DNS, "Captive DNS answers with %s", ip);
+    } else {
+        ONEBIOT_LOG_ERROR(DNS, "Captive DNS could not listen on port %u", port);
+    }
+    return _running;
+}
+
+void ONEBIOTCaptiveDNS::stop() {
+    if (_running) {
+        _udp.stop();
+        _running = false;
+    }
+}
+
+bool ONEBIOTCaptiveDNS::isRunning() {
+    return _running;
+}
+
+uint8_t ONEBIOTCaptiveDNS::loop() {
+    if (!_running) {
+        return 0;
+    }
+
+    uint8_t answered = 0;
+    for (uint8_t i = 0; i < ONEBIOT_CAPTIVE_DNS_QUERIES; i++) {
+        int length = _udp.parsePacket();
+        if (length <= 0) {
+            break;
+        }
+        // the next parsePacket() drops what was not read
+        if (length > ONEBIOT_CAPTIVE_DNS_PACKET_SIZE) {
+            _counters.dropped++;
+            continue;
+        }
+
+        _udp.read(_packet, length);
+        size_t size = respond(_packet, length, sizeof(_packet));
+        if (size == 0) {
+            continue;
+        }
+        _udp.beginPacket(_udp.remoteIP(), _udp.remotePort());
+        _udp.write(_packet, size);
+        _udp.endPacket();
+        answered++;
+    }
+    return answered;
+}
+
+size_t ONEBIOTCaptiveDNS::respond(uint8_t *packet, size_t length, size_t capacity) {
+    // a standard query (QR 0, opcode 0) with exactly one question
+    if (length < HEADER_SIZE || (packet[2] & 0xF8) != 0 || packet[4] != 0 || packet[5] != 1) {
+        _counters.dropped++;
+        return 0;
+    }
+
+    // labels of the name, a question never contains compression pointers
+    size_t position = HEADER_SIZE;
+    while (position < length && packet[position] != 0) {
+        if (packet[position] > 63) {
+            _counters.dropped++;
+            return 0;
+        }
+        position += packet[position] + 1;
+    }
+    // the terminating zero, type and class
+    position += 5;
+    if (position > length || position + ANSWER_SIZE > capacity) {
+        _counters.dropped++;
+        return 0;
+    }
+
+    uint16_t type = (packet[position - 4] << 8) | packet[position - 3];
+    uint16_t questionClass = (packet[position - 2] << 8) | packet[position - 1];
+    uint8_t recursionDesired = packet[2] & 0x01;
+
+    // additional records of the query (EDNS) are cut off with everything behind the question
+    memcpy(packet + 2, DNS_ANSWER_HEADER + 2, HEADER_SIZE - 2);
+    packet[2] |= recursionDesired;
+    if ((type != DNS_TYPE_A && type != DNS_TYPE_ANY) || questionClass != DNS_CLASS_IN) {
+        // no records of the type, the client falls back to A without waiting for a timeout
+        packet[7] = 0;
+        _counters.empty++;
+        return position;
+    }
+
+    memcpy(packet + position, _answer, ANSWER_SIZE);
+    _counters.answered++;
+    return position + ANSWER_SIZE;
+}
+
+const ONEBIOTCaptiveDNSCounters &ONEBIOTCaptiveDNS::getCounters() {
+    return _counters;
+}
+
+bool ONEBIOTCaptivePortal::addRoutes(ONEBIOTRouter &router) {
+    uint32_t get = ONEBIOT_ROUTE(HTTP_GET);
+    return router.on(CAPTIVE_ANDROID, get, this)
+        && router.on(CAPTIVE_ANDROID_GEN, get, this)
+        && router.on(CAPTIVE_APPLE, get, this)
+        && router.on(CAPTIVE_APPLE_SUCCESS, get, this)
+        && router.on(CAPTIVE_WINDOWS, get, this)
+        && router.on(CAPTIVE_WINDOWS_NCSI, get, this)
+        && router.on(CAPTIVE_WINDOWS_REDIRECT, get, this)
+        && router.on(CAPTIVE_FIREFOX, get, this)
+        && router.on(CAPTIVE_FIREFOX_SUCCESS, get, this);
+}
+
+// Any answer but the expected one tells the OS that the network has a login page.
+bool ONEBIOTCaptivePortal::handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) {
+    // the routes stay in the router, without the AP the request goes to the next one
+    if (!_dns.isRunning()) {
+        return false;
+    }
+
+    IPAddress ip = server.client().localIP();
+    char location[24];
+    snprintf_P(location, sizeof(location), PSTR("http://%u.%u.%u.%u/"), ip[0], ip[1], ip[2], ip[3]);
+
+    server.sendHeader("Location", location);
+    server.sendHeader("Cache-Control", "no-cache");
+    server.send(302, "text/plain", "");
+    return true;
+}
+
+#endif //ONEBIOT_CAPTIVE_PORTAL_CPP
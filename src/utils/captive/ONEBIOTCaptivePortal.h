@@ -0,0 +1,77 @@
+#ifndef ONEBIOT_CAPTIVE_PORTAL_H
+#define ONEBIOT_CAPTIVE_PORTAL_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <WiFiUdp.h>
+
+#include "utils/request/ONEBIOTRequestHandler.h"
+
+class ONEBIOTRouter;
+
+// queries up to this size are answered, the answer adds 16 bytes
+#ifndef ONEBIOT_CAPTIVE_DNS_PACKET_SIZE
+#define ONEBIOT_CAPTIVE_DNS_PACKET_SIZE 128
+#endif
+
+// short, so clients forget the AP address soon after provisioning
+#ifndef ONEBIOT_CAPTIVE_DNS_TTL
+#define ONEBIOT_CAPTIVE_DNS_TTL 60
+#endif
+
+// queries answered by one loop() pass, the rest waits in lwIP
+#ifndef ONEBIOT_CAPTIVE_DNS_QUERIES
+#define ONEBIOT_CAPTIVE_DNS_QUERIES 4
+#endif
+
+struct ONEBIOTCaptiveDNSCounters {
+    uint32_t answered = 0;
+    // AAAA and other types get an empty NOERROR answer
+    uint32_t empty = 0;
+    // malformed, oversized or not a standard query
+    uint32_t dropped = 0;
+};
+
+/**
+ * DNS responder of the provisioning AP, it resolves every name to the AP address.
+ * The answer record is formatted once by begin(), a query is answered in its own
+ * buffer: a constant header is copied over the query's one keeping its transaction
+ * ID, the question stays where it is and the answer record is appended.
+ */
+class ONEBIOTCaptiveDNS {
+    public:
+        bool begin(const IPAddress &ip, uint16_t port = 53);
+        void stop();
+        bool isRunning();
+        // answers the waiting queries, returns how many
+        uint8_t loop();
+        // turns the query in packet into its answer, returns its length or 0 to drop it
+        size_t respond(uint8_t *packet, size_t length, size_t capacity);
+        const ONEBIOTCaptiveDNSCounters &getCounters();
+    private:
+        static const size_t HEADER_SIZE = 12;
+        static const size_t ANSWER_SIZE = 16;
+
+        WiFiUDP _udp;
+        bool _running = false;
+        uint8_t _answer[ANSWER_SIZE];
+        uint8_t _packet[ONEBIOT_CAPTIVE_DNS_PACKET_SIZE + ANSWER_SIZE];
+        ONEBIOTCaptiveDNSCounters _counters;
+};
+
+/**
+ * Connectivity checks of Android, Apple, Windows and Firefox. While the captive
+ * DNS runs their hosts resolve to the AP, the checks are redirected to the root
+ * of the device, so the OS opens it as the login page of the network. Once the
+ * DNS is stopped the paths are passed on to the routes and files of the sketch.
+ */
+class ONEBIOTCaptivePortal : public RequestHandler {
+    public:
+        explicit ONEBIOTCaptivePortal(ONEBIOTCaptiveDNS &dns) : _dns(dns) {}
+        bool addRoutes(ONEBIOTRouter &router);
+        bool handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) override;
+    private:
+        ONEBIOTCaptiveDNS &_dns;
+};
+
+#endif //ONEBIOT_CAPTIVE_PORTAL_H
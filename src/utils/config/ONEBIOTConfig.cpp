@@ -12,24 +12,44 @@
 #endif
 
 #include "utils/config/ONEBIOTConfig.h"
+#include "utils/strings/ONEBIOTStrings.h"
 
-const char *DEFAULT_AP_SSID = "ONEBIOT.local";
-const char *ONEBIOT_DEFAULT_WS_NAME = "onebiot";
+const char SECURE_VALUE[] PROGMEM = "<secure_value>";
+static const char DEFAULT_AP_SSID[] PROGMEM = "ONEBIOT.local";
+static const char ONEBIOT_DEFAULT_WS_NAME[] PROGMEM = "onebiot";
 const int JSON_SETTINGS_BUFFER_SIZE = 512;
 
-ONEBIOTConfig::ONEBIOTConfig(ONEBIOTConfigAppConfig &config, String configFile) : _config(config), _configFile(configFile) {}
-ONEBIOTConfig::ONEBIOTConfig(ONEBIOTConfigAppConfig &config, const char *configFile) : _config(config), _configFile(String(configFile)) {}
-ONEBIOTConfig::ONEBIOTConfig(ONEBIOTConfigAppConfig &config) : _config(config), _configFile("") {}
+// one lock for the struct shared by every copy of ONEBIOTConfig
+static ONEBIOTMutex configMutex;
+
+ONEBIOTConfig::ONEBIOTConfig(ONEBIOTConfigAppConfig &config, String configFile) : _config(config), _configFile(configFile), _fs(&ONEBIOT_DEFAULT_FS) {}
+ONEBIOTConfig::ONEBIOTConfig(ONEBIOTConfigAppConfig &config, const char *configFile) : _config(config), _configFile(String(configFile)), _fs(&ONEBIOT_DEFAULT_FS) {}
+ONEBIOTConfig::ONEBIOTConfig(ONEBIOTConfigAppConfig &config) : _config(config), _configFile(""), _fs(&ONEBIOT_DEFAULT_FS) {}
+ONEBIOTConfig::ONEBIOTConfig(ONEBIOTConfigAppConfig &config, const char *configFile, FS &fs) : _config(config), _configFile(String(configFile)), _fs(&fs) {}
 
 ONEBIOTConfigAppConfig ONEBIOTConfig::getConfig() {
+    ONEBIOT_LOCK(configMutex);
     return _config;
 }
 
+// Replaces all fields at once. Fails when the config changed after the staged
+// copy was taken, so a concurrent change is never silently overwritten.
+bool ONEBIOTConfig::commit(const ONEBIOTConfigAppConfig &staged) {
+    ONEBIOT_LOCK(configMutex);
+    if (staged.generation != _config.generation) {
+        return false;
+    }
+    _config = staged;
+    _config.generation++;
+    return true;
+}
+
 bool ONEBIOTConfig::configExists() {
-    return SPIFFS.exists(_configFile);
+    return _fs->exists(_configFile);
 }
 
 String ONEBIOTConfig::getClientName() {
+    ONEBIOT_LOCK(configMutex);
     if (_config.client_name.isEmpty()) {
         // 1bio-12:34:56:78:90-12-c1
         String tempClientName = "1biot-" + WiFi.macAddress() + "-" + String(micros() & 0xff, 16);
@@ -39,122 +59,156 @@ String ONEBIOTConfig::getClientName() {
 }
 
 String ONEBIOTConfig::getDnsName() {
+    ONEBIOT_LOCK(configMutex);
     if (_config.dns_name.isEmpty()) {
-        return String(ONEBIOT_DEFAULT_WS_NAME);
+        return String(FPSTR(ONEBIOT_DEFAULT_WS_NAME));
     }
 
     return _config.dns_name;
 }
 
 String ONEBIOTConfig::getWiFiSsid() {
+    ONEBIOT_LOCK(configMutex);
     return _config.wifi_ssid;
 }
 
 String ONEBIOTConfig::getApSsid() {
+    ONEBIOT_LOCK(configMutex);
     if (_config.ap_ssid.isEmpty()) {
-        return String(DEFAULT_AP_SSID);
+        return String(FPSTR(DEFAULT_AP_SSID));
     }
     return _config.ap_ssid;
 }
 
 bool ONEBIOTConfig::setClientName(String clientName) {
+    ONEBIOT_LOCK(configMutex);
     if (clientName != _config.client_name) {
         _config.client_name = clientName;
+        _config.generation++;
         return true;
     }
     return false;
 }
 
 bool ONEBIOTConfig::setCredentialsUser(String credentialsUser) {
+    ONEBIOT_LOCK(configMutex);
     if (credentialsUser != _config.credentials_user) {
         _config.credentials_user = credentialsUser;
+        _config.generation++;
         return true;
     }
     return false;
 }
 
 bool ONEBIOTConfig::setCredentialsPassword(String credentialsPassword) {
+    ONEBIOT_LOCK(configMutex);
     if (String(credentialsPassword) != String(_config.credentials_password)) {
         _config.credentials_password = credentialsPassword;
+        _config.generation++;
         return true;
     }
     return false;
 }
 
 bool ONEBIOTConfig::setApSsid(String apSsid) {
+    ONEBIOT_LOCK(configMutex);
     if (apSsid != _config.ap_ssid) {
         _config.ap_ssid = apSsid;
+        _config.generation++;
         return true;
     }
     return false;
 }
 
 bool ONEBIOTConfig::setApPassword(String apPassword) {
+    ONEBIOT_LOCK(configMutex);
     if (apPassword != String(_config.ap_password)) {
         _config.ap_password = apPassword;
+        _config.generation++;
         return true;
     }
     return false;
 }
 
 bool ONEBIOTConfig::setApEstablish(bool apEstablish) {
+    ONEBIOT_LOCK(configMutex);
     if (apEstablish != _config.ap_establish) {
         _config.ap_establish = apEstablish;
+        _config.generation++;
         return true;
     }
     return false;
 }
 
 bool ONEBIOTConfig::setWiFiSsid(String wifiSsid) {
+    ONEBIOT_LOCK(configMutex);
     if (wifiSsid != _config.wifi_ssid) {
         _config.wifi_ssid = wifiSsid;
+        _config.generation++;
         return true;
     }
     return false;
 }
 
 bool ONEBIOTConfig::setWiFiPassword(String wifiPassword) {
+    ONEBIOT_LOCK(configMutex);
     if (wifiPassword != _config.wifi_password) {
         _config.wifi_password = wifiPassword;
+        _config.generation++;
         return true;
     }
     return false;
 }
 
 bool ONEBIOTConfig::setWiFiEstablish(bool wifiEstablish) {
+    ONEBIOT_LOCK(configMutex);
     if (wifiEstablish != _config.wifi_establish) {
         _config.wifi_establish = wifiEstablish;
+        _config.generation++;
         return true;
     }
     return false;
 }
 
 bool ONEBIOTConfig::setDnsName(String dnsName) {
+    ONEBIOT_LOCK(configMutex);
     if (dnsName != _config.dns_name) {
         _config.dns_name = dnsName;
+        _config.generation++;
         return true;
     }
     return false;
 }
 
 bool ONEBIOTConfig::setDnsEstablish(bool dnsEstablish) {
+    ONEBIOT_LOCK(configMutex);
     if (dnsEstablish != _config.dns_establish) {
         _config.dns_establish = dnsEstablish;
+        _config.generation++;
         return true;
     }
     return false;
 }
 
+void ONEBIOTConfig::setFileSystem(FS &fs) {
+    _fs = &fs;
+}
+
+FS &ONEBIOTConfig::getFileSystem() {
+    return *_fs;
+}
+
+uint32_t ONEBIOTConfig::getGeneration() {
+    ONEBIOT_LOCK(configMutex);
+    return _config.generation;
+}
+
 String ONEBIOTConfig::getConfigFileName() {
     return _configFile;
 }
 
 bool ONEBIOTConfig::load() {
-    if (!SPIFFS.exists(_configFile)) {
-        return false;
-    }
-
-    File configFile = SPIFFS.open(_configFile, "r");
+    File configFile = _fs->open(_configFile, "r");
     if (!configFile) {
         return false;
     }
@@ -165,28 +219,192 @@ bool ONEBIOTConfig::load() {
         return false;
     }
 
-    jsonToConfig(doc);
     configFile.close();
+
+    ONEBIOT_LOCK(configMutex);
+    jsonToConfig(doc);
+    _config.generation++;
     return true;
 }
 
-void ONEBIOTConfig::save() {
+bool ONEBIOTConfig::save() {
     StaticJsonDocument<JSON_SETTINGS_BUFFER_SIZE> root;
-    configToJson(root);
+    {
+        // only serializing needs the lock, the slow flash write runs without it
+        ONEBIOT_LOCK(configMutex);
+        configToJson(root);
+    }
     
-    if (SPIFFS.exists(_configFile)) {
-        SPIFFS.rename(_configFile, _configFile + ".bak");
+    // rename and remove fail on their own when there is nothing to move
+    String backupFile = _configFile + ".bak";
+    _fs->rename(_configFile, backupFile);
+
+    File configFile = _fs->open(_configFile, "w");
+    bool written = configFile && serializeJson(root, configFile) == measureJson(root);
+    if (configFile) {
+        configFile.close();
     }
 
-    File configFile = SPIFFS.open(_configFile, "w");
-    if (serializeJson(root, configFile) == 0) {
-        return;
+    if (!written) {
+        // the partial file goes away, the previous config is the one read on boot
+        _fs->remove(_configFile);
+        _fs->rename(backupFile, _configFile);
+        return false;
     }
 
-    configFile.close();
-    if (SPIFFS.exists(_configFile + ".bak")) {
-        SPIFFS.remove(_configFile + ".bak");
+    _fs->remove(backupFile);
+    return true;
+}
+
+// Only keys of the config schema survive deserialization of a patch,
+// everything else is skipped by the parser without allocating.
+void ONEBIOTConfig::patchFilter(JsonDocument& filter) {
+    filter["credentials_user"] = true;
+    filter["credentials_password"] = true;
+    filter["client_name"] = true;
+    filter["wifi_ssid"] = true;
+    filter["wifi_password"] = true;
+    filter["wifi_establish"] = true;
+    filter["ap_ssid"] = true;
+    filter["ap_password"] = true;
+    filter["ap_establish"] = true;
+    filter["dns_name"] = true;
+    filter["dns_establish"] = true;
+}
+
+// RFC 7396 merge patch over the whole config. Every field is validated into
+// a staged copy first, nothing is applied when any of them fails. The changed
+// fields are written into changes and stored with a single save(). The lock is
+// only held for the snapshot, the commit and while save() serializes, a change
+// made by another task in between fails the commit instead of being overwritten.
+bool ONEBIOTConfig::mergePatch(JsonObjectConst patch, JsonObject changes, bool &needRestart, String &error) {
+    ONEBIOTConfigAppConfig current = getConfig();
+    ONEBIOTConfigAppConfig staged = current;
+    needRestart = false;
+
+    if (!_patchString(patch, OBK(credentials_user), staged.credentials_user, 1, 64, false, error)
+        || !_patchString(patch, OBK(credentials_password), staged.credentials_password, 1, 64, false, error)
+        || !_patchString(patch, OBK(client_name), staged.client_name, 0, 64, true, error)
+        || !_patchString(patch, OBK(wifi_ssid), staged.wifi_ssid, 0, 32, true, error)
+        || !_patchString(patch, OBK(wifi_password), staged.wifi_password, 8, 63, true, error)
+        || !_patchBool(patch, OBK(wifi_establish), staged.wifi_establish, error)
+        || !_patchString(patch, OBK(ap_ssid), staged.ap_ssid, 0, 32, true, error)
+        || !_patchString(patch, OBK(ap_password), staged.ap_password, 8, 63, true, error)
+        || !_patchBool(patch, OBK(ap_establish), staged.ap_establish, error)
+        || !_patchString(patch, OBK(dns_name), staged.dns_name, 0, 63, true, error)
+        || !_patchBool(patch, OBK(dns_establish), staged.dns_establish, error)) {
+        return false;
+    }
+
+    _diffString(changes, OBK(credentials_user), current.credentials_user, staged.credentials_user, true);
+    _diffString(changes, OBK(credentials_password), current.credentials_password, staged.credentials_password, true);
+    _diffString(changes, OBK(client_name), current.client_name, staged.client_name, false);
+
+    needRestart |= _diffString(changes, OBK(wifi_ssid), current.wifi_ssid, staged.wifi_ssid, false);
+    needRestart |= _diffString(changes, OBK(wifi_password), current.wifi_password, staged.wifi_password, true);
+    needRestart |= _diffBool(changes, OBK(wifi_establish), current.wifi_establish, staged.wifi_establish);
+    needRestart |= _diffString(changes, OBK(ap_ssid), current.ap_ssid, staged.ap_ssid, false);
+    needRestart |= _diffString(changes, OBK(ap_password), current.ap_password, staged.ap_password, true);
+    needRestart |= _diffBool(changes, OBK(ap_establish), current.ap_establish, staged.ap_establish);
+    needRestart |= _diffString(changes, OBK(dns_name), current.dns_name, staged.dns_name, false);
+    needRestart |= _diffBool(changes, OBK(dns_establish), current.dns_establish, staged.dns_establish);
+
+    if (changes.size() == 0) {
+        return true;
+    }
+
+    if (!commit(staged)) {
+        changes.clear();
+        needRestart = false;
+        error = F("Configuration changed meanwhile, try again.");
+        return false;
+    }
+    if (!save()) {
+        // the previous values come back unless yet another change came in meanwhile
+        current.generation = staged.generation + 1;
+        commit(current);
+        changes.clear();
+        needRestart = false;
+        error = F("Saving configuration failed.");
+        return false;
+    }
+    return true;
+}
+
+bool ONEBIOTConfig::_patchString(JsonObjectConst patch, const __FlashStringHelper *key, String &value, size_t minLength, size_t maxLength, bool nullable, String &error) {
+    if (!patch.containsKey(key)) {
+        return true;
+    }
+
+    JsonVariantConst patchValue = patch[key];
+    if (patchValue.isNull()) {
+        if (!nullable) {
+            error = String(key) + F(" could not be removed.");
+            return false;
+        }
+        value = "";
+        return true;
+    }
+
+    if (!patchValue.is<const char*>()) {
+        error = String(key) + F(" has to be a string.");
+        return false;
+    }
+
+    String newValue = patchValue.as<const char*>();
+    if (newValue.length() > maxLength || (newValue.length() < minLength && !(nullable && newValue.isEmpty()))) {
+        error = String(key) + F(" has to be ") + String(minLength) + F(" - ") + String(maxLength) + F(" characters long.");
+        return false;
+    }
+
+    value = newValue;
+    return true;
+}
+
+bool ONEBIOTConfig::_patchBool(JsonObjectConst patch, const __FlashStringHelper *key, bool &value, String &error) {
+    if (!patch.containsKey(key)) {
+        return true;
     }
+
+    JsonVariantConst patchValue = patch[key];
+    if (patchValue.isNull()) {
+        value = false;
+    } else if (patchValue.is<bool>()) {
+        value = patchValue.as<bool>();
+    } else if (patchValue.is<int>() && (patchValue.as<int>() == 0 || patchValue.as<int>() == 1)) {
+        value = patchValue.as<int>() == 1;
+    } else {
+        error = String(key) + F(" has to be a boolean.");
+        return false;
+    }
+    return true;
+}
+
+bool ONEBIOTConfig::_diffString(JsonObject changes, const __FlashStringHelper *key, const String &from, const String &to, bool secure) {
+    if (from == to) {
+        return false;
+    }
+
+    JsonObject change = changes.createNestedObject(key);
+    if (secure) {
+        change[OBK(from)] = FPSTR(SECURE_VALUE);
+        change[OBK(to)] = FPSTR(SECURE_VALUE);
+    } else {
+        change[OBK(from)] = from;
+        change[OBK(to)] = to;
+    }
+    return true;
+}
+
+bool ONEBIOTConfig::_diffBool(JsonObject changes, const __FlashStringHelper *key, bool from, bool to) {
+    if (from == to) {
+        return false;
+    }
+
+    JsonObject change = changes.createNestedObject(key);
+    change[OBK(from)] = from;
+    change[OBK(to)] = to;
+    return true;
 }
 
 void ONEBIOTConfig::configToJson(JsonDocument& root) {
@@ -2,6 +2,10 @@
 #define ONEBIOT_CONFIG_H
 
 #include <ArduinoJson.h>
+#include "utils/fs/ONEBIOTFS.h"
+#include "utils/sync/ONEBIOTSync.h"
+
+extern const char SECURE_VALUE[] PROGMEM;
 
 struct ONEBIOTConfigAppConfig {
     String credentials_user;
@@ -15,6 +19,8 @@ struct ONEBIOTConfigAppConfig {
     bool ap_establish = false;
     String dns_name;
     bool dns_establish = false;
+    // bumped on every change, shared by all copies of ONEBIOTConfig
+    uint32_t generation = 0;
 };
 
 class ONEBIOTConfig {
@@ -22,7 +28,10 @@ class ONEBIOTConfig {
         ONEBIOTConfig(ONEBIOTConfigAppConfig &config, String configFile);
         ONEBIOTConfig(ONEBIOTConfigAppConfig &config, const char *configFile);
         ONEBIOTConfig(ONEBIOTConfigAppConfig &config);
+        ONEBIOTConfig(ONEBIOTConfigAppConfig &config, const char *configFile, FS &fs);
+        // consistent copy of all fields, change it and hand it to commit()
         ONEBIOTConfigAppConfig getConfig();
+        bool commit(const ONEBIOTConfigAppConfig &staged);
         String getClientName();
         String getWiFiSsid();
         String getApSsid();
@@ -44,15 +53,26 @@ class ONEBIOTConfig {
         bool setDnsName(String dnsName);
         bool setDnsEstablish(bool dnsEstablish);
         
+        void setFileSystem(FS &fs);
+        FS &getFileSystem();
+        uint32_t getGeneration();
         String getConfigFileName();
         bool load();
-        void save();
+        bool save();
+
+        void patchFilter(JsonDocument& filter);
+        bool mergePatch(JsonObjectConst patch, JsonObject changes, bool &needRestart, String &error);
     protected:
         void configToJson(JsonDocument& root);
         void jsonToConfig(JsonDocument& root);
+        bool _patchString(JsonObjectConst patch, const __FlashStringHelper *key, String &value, size_t minLength, size_t maxLength, bool nullable, String &error);
+        bool _patchBool(JsonObjectConst patch, const __FlashStringHelper *key, bool &value, String &error);
+        bool _diffString(JsonObject changes, const __FlashStringHelper *key, const String &from, const String &to, bool secure);
+        bool _diffBool(JsonObject changes, const __FlashStringHelper *key, bool from, bool to);
     private:
         ONEBIOTConfigAppConfig &_config;
         String _configFile;
+        FS *_fs;
 };
 
 #endif //ONEBIOT_CONFIG_H
\ No newline at end of file
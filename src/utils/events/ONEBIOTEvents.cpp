@@ -0,0 +1,160 @@
+#ifndef ONEBIOT_EVENTS_CPP
+#define ONEBIOT_EVENTS_CPP
+
+#include <Arduino.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WiFi.h>
+#elif defined(ARDUINO_ARCH_ESP8266) 
+#include <ESP8266WiFi.h>
+#endif
+
+#include "utils/events/ONEBIOTEvents.h"
+#include "utils/log/ONEBIOTLog.h"
+
+// smaller changes are not worth a message
+const uint32_t EVENTS_HEAP_THRESHOLD = 512;
+const int EVENTS_RSSI_THRESHOLD = 3;
+// comment line keeping idle connections open through proxies
+const uint32_t EVENTS_KEEP_ALIVE = 15000;
+
+static const char EVENTS_HEADER[] PROGMEM =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: keep-alive\r\n"
+    "Access-Control-Allow-Origin: *\r\n\r\n";
+
+bool ONEBIOTEvents::subscribe(WiFiClient client) {
+    for (size_t i = 0; i < ONEBIOT_EVENTS_SUBSCRIBERS; i++) {
+        Subscriber &subscriber = _subscribers[i];
+        if (subscriber.active && subscriber.client.connected()) {
+            continue;
+        }
+
+        subscriber.client = client;
+        subscriber.client.setNoDelay(true);
+#ifdef ARDUINO_ARCH_ESP32
+        subscriber.client.write((const uint8_t *) EVENTS_HEADER, strlen(EVENTS_HEADER));
+#else
+        subscriber.client.write_P(EVENTS_HEADER, strlen_P(EVENTS_HEADER));
+#endif
+        subscriber.active = true;
+        subscriber.needsSnapshot = true;
+        ONEBIOT_LOG_INFO(WS, "events subscriber %s connected", client.remoteIP());
+        return true;
+    }
+    return false;
+}
+
+void ONEBIOTEvents::setInterval(uint32_t interval) {
+    _interval = interval;
+}
+
+size_t ONEBIOTEvents::size() {
+    size_t count = 0;
+    for (size_t i = 0; i < ONEBIOT_EVENTS_SUBSCRIBERS; i++) {
+        if (_subscribers[i].active) {
+            count++;
+        }
+    }
+    return count;
+}
+
+uint32_t ONEBIOTEvents::getIdleTime() {
+    if (size() == 0) {
+        return UINT32_MAX;
+    }
+    uint32_t elapsed = millis() - _lastTickAt;
+    return elapsed >= _interval ? 0 : _interval - elapsed;
+}
+
+void ONEBIOTEvents::loop() {
+    if (millis() - _lastTickAt < _interval || size() == 0) {
+        return;
+    }
+    _lastTickAt = millis();
+
+    State current;
+    _read(current);
+
+    // the delta only carries values which moved enough, the others keep drifting against _last
+    char delta[96];
+    int length = 0;
+    if ((current.free_heap > _last.free_heap ? current.free_heap - _last.free_heap : _last.free_heap - current.free_heap) >= EVENTS_HEAP_THRESHOLD) {
+        length += snprintf(delta + length, sizeof(delta) - length, ",\"heap\":%u", (unsigned) current.free_heap);
+        _last.free_heap = current.free_heap;
+    }
+    if (abs(current.rssi - _last.rssi) >= EVENTS_RSSI_THRESHOLD) {
+        length += snprintf(delta + length, sizeof(delta) - length, ",\"rssi\":%d", current.rssi);
+        _last.rssi = current.rssi;
+    }
+    if (current.wifi_status != _last.wifi_status) {
+        length += snprintf(delta + length, sizeof(delta) - length, ",\"wifi\":%u", current.wifi_status);
+        _last.wifi_status = current.wifi_status;
+    }
+    if (current.config_generation != _last.config_generation) {
+        length += snprintf(delta + length, sizeof(delta) - length, ",\"config\":%u", (unsigned) current.config_generation);
+        _last.config_generation = current.config_generation;
+    }
+
+    char message[128];
+    int messageLength = 0;
+    if (length > 0) {
+        delta[0] = '{';
+        messageLength = snprintf(message, sizeof(message), "event: delta\ndata: %s}\n\n", delta);
+    }
+
+    char snapshot[128];
+    int snapshotLength = snprintf(snapshot, sizeof(snapshot), "event: snapshot\ndata: {\"heap\":%u,\"rssi\":%d,\"wifi\":%u,\"config\":%u}\n\n",
+        (unsigned) current.free_heap, current.rssi, current.wifi_status, (unsigned) current.config_generation);
+
+    bool keepAlive = messageLength == 0 && millis() - _lastSentAt >= EVENTS_KEEP_ALIVE;
+    for (size_t i = 0; i < ONEBIOT_EVENTS_SUBSCRIBERS; i++) {
+        Subscriber &subscriber = _subscribers[i];
+        if (!subscriber.active) {
+            continue;
+        }
+
+        if (!subscriber.client.connected()) {
+            _drop(subscriber);
+        } else if (subscriber.needsSnapshot) {
+            subscriber.needsSnapshot = !_write(subscriber, snapshot, snapshotLength);
+        } else if (messageLength > 0) {
+            _write(subscriber, message, messageLength);
+        } else if (keepAlive) {
+            _write(subscriber, ":\n\n", 3);
+        }
+    }
+
+    if (messageLength > 0 || keepAlive) {
+        _lastSentAt = millis();
+    }
+}
+
+void ONEBIOTEvents::_read(State &state) {
+    state.free_heap = ESP.getFreeHeap();
+    state.wifi_status = WiFi.status();
+    state.rssi = state.wifi_status == WL_CONNECTED ? WiFi.RSSI() : 0;
+    state.config_generation = _config.getGeneration();
+}
+
+// A subscriber which has not drained the previous messages is dropped, the loop never waits on it.
+bool ONEBIOTEvents::_write(Subscriber &subscriber, const char *message, size_t length) {
+    if ((size_t) subscriber.client.availableForWrite() < length) {
+        ONEBIOT_LOG_WARN(WS, "events subscriber %s is too slow, dropped", subscriber.client.remoteIP());
+        _drop(subscriber);
+        return false;
+    }
+
+    subscriber.client.write((const uint8_t *) message, length);
+    return true;
+}
+
+void ONEBIOTEvents::_drop(Subscriber &subscriber) {
+    subscriber.client.stop();
+    subscriber.active = false;
+    subscriber.needsSnapshot = false;
+}
+
+#endif //ONEBIOT_EVENTS_CPP
@@ -0,0 +1,59 @@
+#ifndef ONEBIOT_EVENTS_H
+#define ONEBIOT_EVENTS_H
+
+#include <Arduino.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WiFi.h>
+#elif defined(ARDUINO_ARCH_ESP8266) 
+#include <ESP8266WiFi.h>
+#endif
+
+#include "utils/config/ONEBIOTConfig.h"
+
+#ifndef ONEBIOT_EVENTS_SUBSCRIBERS
+#define ONEBIOT_EVENTS_SUBSCRIBERS 4
+#endif
+
+/**
+ * Server-Sent Events channel of /cmd/events. Subscribers keep their connection
+ * open, ONEBIOTApp::loop() pushes one coalesced update per interval containing
+ * only the values which moved since the previous one.
+ */
+class ONEBIOTEvents {
+    public:
+        ONEBIOTEvents(ONEBIOTConfig &config) : _config(config) {}
+        // takes over the connection of the current request, false when the table is full
+        bool subscribe(WiFiClient client);
+        void setInterval(uint32_t interval);
+        size_t size();
+        void loop();
+        // milliseconds until loop() pushes the next update
+        uint32_t getIdleTime();
+    private:
+        struct Subscriber {
+            WiFiClient client;
+            bool active = false;
+            bool needsSnapshot = false;
+        };
+
+        struct State {
+            uint32_t free_heap = 0;
+            int8_t rssi = 0;
+            uint8_t wifi_status = 0;
+            uint32_t config_generation = 0;
+        };
+
+        ONEBIOTConfig &_config;
+        Subscriber _subscribers[ONEBIOT_EVENTS_SUBSCRIBERS];
+        State _last;
+        uint32_t _interval = 1000;
+        uint32_t _lastTickAt = 0;
+        uint32_t _lastSentAt = 0;
+
+        void _read(State &state);
+        bool _write(Subscriber &subscriber, const char *message, size_t length);
+        void _drop(Subscriber &subscriber);
+};
+
+#endif //ONEBIOT_EVENTS_H
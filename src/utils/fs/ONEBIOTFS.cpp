@@ -0,0 +1,108 @@
+#ifndef ONEBIOT_FS_CPP
+#define ONEBIOT_FS_CPP
+
+#include <Arduino.h>
+#include <FS.h>
+#include "utils/fs/ONEBIOTFS.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+const char *FS_TRUNCATE_SUFFIX = ".cut";
+#endif
+
+void ONEBIOTFS::info(FS &fs, FSInfo &info) {
+#ifdef ARDUINO_ARCH_ESP32
+    (void) fs;
+    info.totalBytes = ONEBIOT_DEFAULT_FS.totalBytes();
+    info.usedBytes = ONEBIOT_DEFAULT_FS.usedBytes();
+    info.blockSize = 4096;
+    info.pageSize = 256;
+    info.maxOpenFiles = 10;
+    info.maxPathLength = 32;
+#else
+    fs.info(info);
+#endif
+}
+
+bool ONEBIOTFS::truncate(FS &fs, const String &path, size_t size) {
+#ifdef ARDUINO_ARCH_ESP32
+    File source = fs.open(path, "r");
+    if (!source) {
+        return false;
+    }
+    String copyPath = path + FS_TRUNCATE_SUFFIX;
+    File copy = fs.open(copyPath, "w");
+    if (!copy) {
+        return false;
+    }
+
+    uint8_t buffer[128];
+    size_t copied = 0;
+    while (copied < size) {
+        size_t length = source.read(buffer, min(sizeof(buffer), size - copied));
+        if (length == 0 || copy.write(buffer, length) != length) {
+            break;
+        }
+        copied += length;
+    }
+    source.close();
+    copy.close();
+
+    if (copied != size || !fs.remove(path) || !fs.rename(copyPath, path)) {
+        fs.remove(copyPath);
+        return false;
+    }
+    return true;
+#else
+    File file = fs.open(path, "r+");
+    if (!file) {
+        return false;
+    }
+    bool truncated = file.truncate(size);
+    file.close();
+    return truncated;
+#endif
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+ONEBIOTDir::ONEBIOTDir(FS &fs, const String &path) : _directory(fs.open(path)) {}
+
+bool ONEBIOTDir::next() {
+    if (!_directory || !_directory.isDirectory()) {
+        return false;
+    }
+    _file = _directory.openNextFile();
+    return (bool) _file;
+}
+
+String ONEBIOTDir::fileName() {
+    return _file.name();
+}
+
+size_t ONEBIOTDir::fileSize() {
+    return _file.size();
+}
+
+bool ONEBIOTDir::isDirectory() {
+    return _file.isDirectory();
+}
+#else
+ONEBIOTDir::ONEBIOTDir(FS &fs, const String &path) : _dir(fs.openDir(path)) {}
+
+bool ONEBIOTDir::next() {
+    return _dir.next();
+}
+
+String ONEBIOTDir::fileName() {
+    return _dir.fileName();
+}
+
+size_t ONEBIOTDir::fileSize() {
+    return _dir.fileSize();
+}
+
+bool ONEBIOTDir::isDirectory() {
+    return _dir.isDirectory();
+}
+#endif
+
+#endif //ONEBIOT_FS_CPP
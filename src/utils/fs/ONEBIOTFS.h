@@ -0,0 +1,61 @@
+#ifndef ONEBIOT_FS_H
+#define ONEBIOT_FS_H
+
+#include <FS.h>
+
+/**
+ * File system used when none is injected into ONEBIOTApp or ONEBIOTConfig.
+ * SPIFFS stays the default, build with -DONEBIOT_LITTLEFS to switch to LittleFS.
+ */
+#ifdef ONEBIOT_LITTLEFS
+#include <LittleFS.h>
+#define ONEBIOT_DEFAULT_FS LittleFS
+#else
+#ifdef ARDUINO_ARCH_ESP32
+#include <SPIFFS.h>
+#endif
+#define ONEBIOT_DEFAULT_FS SPIFFS
+#endif
+
+#ifdef ARDUINO_ARCH_ESP32
+// the ESP32 core has no FSInfo, ONEBIOTFS::info() fills the same fields
+struct FSInfo {
+    size_t totalBytes;
+    size_t usedBytes;
+    size_t blockSize;
+    size_t pageSize;
+    size_t maxOpenFiles;
+    size_t maxPathLength;
+};
+#endif
+
+/**
+ * The parts of the ESP8266 file system API the library uses which the ESP32
+ * core lacks, one implementation per core.
+ */
+class ONEBIOTFS {
+    public:
+        // on the ESP32 the totals come from the default file system, the FS interface has none
+        static void info(FS &fs, FSInfo &info);
+        // the ESP32 core has no File::truncate(), the file is replaced by a shortened copy
+        static bool truncate(FS &fs, const String &path, size_t size);
+};
+
+// Dir of the ESP8266 core, the ESP32 core walks a directory with File::openNextFile().
+class ONEBIOTDir {
+    public:
+        ONEBIOTDir(FS &fs, const String &path);
+        bool next();
+        String fileName();
+        size_t fileSize();
+        bool isDirectory();
+    private:
+#ifdef ARDUINO_ARCH_ESP32
+        File _directory;
+        File _file;
+#else
+        Dir _dir;
+#endif
+};
+
+#endif //ONEBIOT_FS_H
@@ -0,0 +1,156 @@
+#ifndef ONEBIOT_ADMISSION_CPP
+#define ONEBIOT_ADMISSION_CPP
+
+#include <Arduino.h>
+#include "utils/http/ONEBIOTAdmission.h"
+#include "utils/log/ONEBIOTLog.h"
+
+struct ONEBIOTAdmissionRouteCost {
+    char prefix[20];
+    uint8_t cost;
+};
+
+// first matching prefix wins, every other route costs one token
+static const ONEBIOTAdmissionRouteCost ADMISSION_ROUTE_COSTS[] PROGMEM = {
+    {"/cmd/wifi/list", 10},
+    {"/cmd/stats/history", 5},
+    {"/cmd/data", 5},
+    {"/cmd/stats", 3},
+    {"/cmd/log", 3}
+};
+
+static const char ADMISSION_TOO_MANY_REQUESTS[] PROGMEM =
+    "HTTP/1.1 429 Too Many Requests\r\n"
+    "Retry-After: 1\r\n"
+    "Connection: close\r\n"
+    "Content-Length: 0\r\n\r\n";
+
+// tokens are kept in thousandths, so a refill of RATE per second is RATE per millisecond
+struct ONEBIOTAdmissionClient {
+    uint32_t ip = 0;
+    uint32_t tokens = 0;
+    uint32_t refilledAt = 0;
+    uint32_t backoffUntil = 0;
+    uint8_t authFailures = 0;
+};
+
+static ONEBIOTAdmissionClient admissionClients[ONEBIOT_ADMISSION_CLIENTS];
+static ONEBIOTAdmissionCounters admissionCounters;
+
+static ONEBIOTAdmissionClient *admissionFind(uint32_t ip) {
+    for (size_t i = 0; i < ONEBIOT_ADMISSION_CLIENTS; i++) {
+        if (admissionClients[i].ip == ip) {
+            return &admissionClients[i];
+        }
+    }
+    return nullptr;
+}
+
+// A client which is backing off keeps its slot, unless every slot is backing off.
+static ONEBIOTAdmissionClient &admissionGet(uint32_t ip, uint32_t now) {
+    ONEBIOTAdmissionClient *client = admissionFind(ip);
+    if (client != nullptr) {
+        return *client;
+    }
+
+    bool clientBackingOff = false;
+    for (size_t i = 0; i < ONEBIOT_ADMISSION_CLIENTS; i++) {
+        ONEBIOTAdmissionClient &candidate = admissionClients[i];
+        if (candidate.ip == 0) {
+            client = &candidate;
+            admissionCounters.clients++;
+            break;
+        }
+        bool backingOff = (int32_t) (candidate.backoffUntil - now) > 0;
+        bool older = client != nullptr && (int32_t) (candidate.refilledAt - client->refilledAt) < 0;
+        if (client == nullptr || (clientBackingOff && !backingOff) || (backingOff == clientBackingOff && older)) {
+            client = &candidate;
+            clientBackingOff = backingOff;
+        }
+    }
+
+    *client = ONEBIOTAdmissionClient();
+    client->ip = ip;
+    client->tokens = ONEBIOT_ADMISSION_BURST * 1000;
+    client->refilledAt = now;
+    return *client;
+}
+
+uint8_t ONEBIOTAdmission::cost(const char *path, size_t length) {
+    for (const ONEBIOTAdmissionRouteCost &route : ADMISSION_ROUTE_COSTS) {
+        size_t prefixLength = strlen_P(route.prefix);
+        if (length >= prefixLength && strncmp_P(path, route.prefix, prefixLength) == 0) {
+            return pgm_read_byte(&route.cost);
+        }
+    }
+    return 1;
+}
+
+bool ONEBIOTAdmission::admit(const IPAddress &ip, uint8_t cost) {
+    uint32_t now = millis();
+    ONEBIOTAdmissionClient &client = admissionGet((uint32_t) ip, now);
+
+    if ((int32_t) (client.backoffUntil - now) > 0) {
+        admissionCounters.blocked++;
+        return false;
+    }
+
+    uint32_t capacity = ONEBIOT_ADMISSION_BURST * 1000;
+    uint32_t elapsed = now - client.refilledAt;
+    client.refilledAt = now;
+    client.tokens = elapsed >= capacity / ONEBIOT_ADMISSION_RATE ? capacity : min(capacity, client.tokens + elapsed * ONEBIOT_ADMISSION_RATE);
+
+    uint32_t price = (uint32_t) cost * 1000;
+    if (client.tokens < price) {
+        admissionCounters.limited++;
+        return false;
+    }
+
+    client.tokens -= price;
+    admissionCounters.admitted++;
+    return true;
+}
+
+bool ONEBIOTAdmission::isBackingOff(const IPAddress &ip) {
+    ONEBIOTAdmissionClient *client = admissionFind((uint32_t) ip);
+    return client != nullptr && (int32_t) (client->backoffUntil - millis()) > 0;
+}
+
+void ONEBIOTAdmission::authResult(const IPAddress &ip, bool success) {
+    uint32_t now = millis();
+    ONEBIOTAdmissionClient &client = admissionGet((uint32_t) ip, now);
+    if (success) {
+        client.authFailures = 0;
+        return;
+    }
+
+    admissionCounters.auth_failures++;
+    if (client.authFailures < UINT8_MAX) {
+        client.authFailures++;
+    }
+    if (client.authFailures <= ONEBIOT_ADMISSION_AUTH_FAILURES) {
+        return;
+    }
+
+    uint8_t doublings = client.authFailures - ONEBIOT_ADMISSION_AUTH_FAILURES - 1;
+    uint32_t backoff = doublings >= 16 ? ONEBIOT_ADMISSION_BACKOFF_MAX : min((uint32_t) ONEBIOT_ADMISSION_BACKOFF_MAX, (uint32_t) ONEBIOT_ADMISSION_BACKOFF << doublings);
+    client.backoffUntil = now + backoff;
+    ONEBIOT_LOG_WARN(WS, "%u failed logins from %s, backing off %u ms", client.authFailures, ip, backoff);
+}
+
+void ONEBIOTAdmission::getCounters(ONEBIOTAdmissionCounters &counters) {
+    counters = admissionCounters;
+}
+
+PGM_P ONEBIOTAdmission::tooManyRequests() {
+    return ADMISSION_TOO_MANY_REQUESTS;
+}
+
+void ONEBIOTAdmission::reset() {
+    for (size_t i = 0; i < ONEBIOT_ADMISSION_CLIENTS; i++) {
+        admissionClients[i] = ONEBIOTAdmissionClient();
+    }
+    admissionCounters = ONEBIOTAdmissionCounters();
+}
+
+#endif //ONEBIOT_ADMISSION_CPP
@@ -0,0 +1,63 @@
+#ifndef ONEBIOT_ADMISSION_H
+#define ONEBIOT_ADMISSION_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+// clients tracked at once, the one seen least recently makes room for a new one
+#ifndef ONEBIOT_ADMISSION_CLIENTS
+#define ONEBIOT_ADMISSION_CLIENTS 8
+#endif
+
+// tokens a client may spend at once and tokens refilled per second
+#ifndef ONEBIOT_ADMISSION_BURST
+#define ONEBIOT_ADMISSION_BURST 20
+#endif
+
+#ifndef ONEBIOT_ADMISSION_RATE
+#define ONEBIOT_ADMISSION_RATE 5
+#endif
+
+// failed logins which are free, every further one doubles the backoff
+#ifndef ONEBIOT_ADMISSION_AUTH_FAILURES
+#define ONEBIOT_ADMISSION_AUTH_FAILURES 3
+#endif
+
+#ifndef ONEBIOT_ADMISSION_BACKOFF
+#define ONEBIOT_ADMISSION_BACKOFF 500
+#endif
+
+#ifndef ONEBIOT_ADMISSION_BACKOFF_MAX
+#define ONEBIOT_ADMISSION_BACKOFF_MAX 60000
+#endif
+
+struct ONEBIOTAdmissionCounters {
+    uint32_t admitted = 0;
+    // requests answered with 429 because the bucket was empty
+    uint32_t limited = 0;
+    // requests answered with 429 while the client backs off after failed logins
+    uint32_t blocked = 0;
+    uint32_t auth_failures = 0;
+    uint8_t clients = 0;
+};
+
+/**
+ * Per client token buckets in front of the request handlers. Every request costs
+ * tokens by its route, a wifi scan many, a plain GET one. A client without enough
+ * tokens is not dispatched at all and gets a canned 429, the same happens during
+ * the backoff after repeated failed logins.
+ */
+class ONEBIOTAdmission {
+    public:
+        static uint8_t cost(const char *path, size_t length);
+        // takes the tokens, false when the request has to be refused
+        static bool admit(const IPAddress &ip, uint8_t cost);
+        // true while failed logins of the client are backed off, checked before credentials
+        static bool isBackingOff(const IPAddress &ip);
+        static void authResult(const IPAddress &ip, bool success);
+        static void getCounters(ONEBIOTAdmissionCounters &counters);
+        static PGM_P tooManyRequests();
+        static void reset();
+};
+
+#endif //ONEBIOT_ADMISSION_H
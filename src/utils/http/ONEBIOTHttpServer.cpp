@@ -0,0 +1,230 @@
+#ifndef ONEBIOT_HTTP_SERVER_CPP
+#define ONEBIOT_HTTP_SERVER_CPP
+
+// it reaches into the internals of the ESP8266 core server, the ESP32 build uses its WebServer
+#ifdef ARDUINO_ARCH_ESP8266
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#include "utils/http/ONEBIOTHttpServer.h"
+#include "utils/http/ONEBIOTAdmission.h"
+#include "utils/log/ONEBIOTLog.h"
+
+// heads are peeked one connection at a time, so a single scan buffer is shared
+static uint8_t httpHeadBuffer[ONEBIOT_HTTP_HEAD_SIZE];
+
+static const char *httpHeaderValue(const char *line, size_t length, const char *name) {
+    size_t nameLength = strlen(name);
+    if (length <= nameLength || line[nameLength] != ':' || strncasecmp(line, name, nameLength) != 0) {
+        return nullptr;
+    }
+
+    const char *value = line + nameLength + 1;
+    while (*value == ' ') {
+        value++;
+    }
+    return value;
+}
+
+void ONEBIOTHttpServer::handleClient() {
+    _accept();
+
+    // every connection makes progress, but only one request runs per call so the
+    // rest of the loop is never delayed by more than a single handler
+    Connection *ready = nullptr;
+    for (uint8_t i = 0; i < ONEBIOT_HTTP_CONNECTIONS; i++) {
+        uint8_t index = (_next + i) % ONEBIOT_HTTP_CONNECTIONS;
+        Connection &connection = _connections[index];
+        _poll(connection);
+        if (!ready && connection.state == READY) {
+            ready = &connection;
+            _next = (index + 1) % ONEBIOT_HTTP_CONNECTIONS;
+        }
+    }
+
+    if (ready) {
+        _dispatch(*ready);
+    }
+}
+
+uint8_t ONEBIOTHttpServer::getConnectionCount() {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < ONEBIOT_HTTP_CONNECTIONS; i++) {
+        count += _connections[i].state != FREE;
+    }
+    return count;
+}
+
+bool ONEBIOTHttpServer::isIdle() {
+    if (_server.hasClient()) {
+        return false;
+    }
+    for (uint8_t i = 0; i < ONEBIOT_HTTP_CONNECTIONS; i++) {
+        Connection &connection = _connections[i];
+        if (connection.state == READY || (connection.state == READING && connection.client.available() > 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A connection without a free slot stays in the accept queue.
+void ONEBIOTHttpServer::_accept() {
+    while (_server.hasClient()) {
+        Connection *slot = nullptr;
+        for (uint8_t i = 0; i < ONEBIOT_HTTP_CONNECTIONS; i++) {
+            if (_connections[i].state == FREE) {
+                slot = &_connections[i];
+                break;
+            }
+        }
+        if (!slot) {
+            return;
+        }
+
+        slot->client = _server.available();
+        slot->state = READING;
+        slot->since = millis();
+    }
+}
+
+void ONEBIOTHttpServer::_poll(Connection &connection) {
+    if (connection.state == FREE) {
+        return;
+    }
+
+    int available = connection.client.available();
+    if (available == 0 && !connection.client.connected()) {
+        _release(connection);
+        return;
+    }
+    if (connection.state == READY) {
+        return;
+    }
+
+    if (available == 0) {
+        if (millis() - connection.since > ONEBIOT_HTTP_REQUEST_TIMEOUT) {
+            _release(connection);
+        }
+        return;
+    }
+
+    if (connection.length == 0 && available != connection.scanned) {
+        connection.scanned = available;
+        size_t size = available < ONEBIOT_HTTP_HEAD_SIZE ? available : ONEBIOT_HTTP_HEAD_SIZE;
+        size = connection.client.peekBytes(httpHeadBuffer, size);
+        bool parsed = _parseHead(connection, size);
+        if (!parsed && size >= ONEBIOT_HTTP_HEAD_SIZE) {
+            _reject(connection, "431 Request Header Fields Too Large");
+            return;
+        }
+        if (parsed && connection.length == 0) {
+            _reject(connection, "413 Payload Too Large");
+            return;
+        }
+        if (parsed && !ONEBIOTAdmission::admit(connection.client.remoteIP(), connection.cost)) {
+            _refuse(connection);
+            return;
+        }
+    }
+
+    if (connection.length > 0 && (size_t) available >= connection.length) {
+        connection.state = READY;
+    } else if (millis() - connection.since > ONEBIOT_HTTP_REQUEST_TIMEOUT) {
+        _reject(connection, "408 Request Timeout");
+    }
+}
+
+// Looks for the end of the head in the peeked bytes and reads just enough of
+// it to know how much body follows. A body which is too large leaves length at 0.
+bool ONEBIOTHttpServer::_parseHead(Connection &connection, size_t size) {
+    const char *head = (const char *) httpHeadBuffer;
+    size_t end = 0;
+    for (size_t i = 3; i < size; i++) {
+        if (head[i] == '\n' && head[i - 1] == '\r' && head[i - 2] == '\n' && head[i - 3] == '\r') {
+            end = i + 1;
+            break;
+        }
+    }
+    if (end == 0) {
+        return false;
+    }
+
+    size_t contentLength = 0;
+    bool multipart = false;
+    for (size_t line = 0; line + 2 < end;) {
+        const char *eol = (const char *) memchr(head + line, '\n', end - line);
+        size_t length = eol - (head + line);
+        const char *value;
+        if (line == 0) {
+            const char *path = (const char *) memchr(head, ' ', length);
+            if (path != nullptr) {
+                path++;
+                const char *pathEnd = path;
+                while (pathEnd < eol && *pathEnd != ' ' && *pathEnd != '?') {
+                    pathEnd++;
+                }
+                connection.cost = ONEBIOTAdmission::cost(path, pathEnd - path);
+            }
+        } else if ((value = httpHeaderValue(head + line, length, "Content-Length"))) {
+            contentLength = strtoul(value, NULL, 10);
+        } else if ((value = httpHeaderValue(head + line, length, "Content-Type"))) {
+            multipart = strncasecmp(value, "multipart/form-data", 19) == 0;
+        }
+        line += length + 1;
+    }
+
+    if (end + contentLength <= ONEBIOT_HTTP_REQUEST_SIZE) {
+        connection.length = end + contentLength;
+    } else if (multipart) {
+        // the form parser reads uploads as they come, see ONEBIOT_HTTP_REQUEST_SIZE
+        connection.length = end;
+    }
+    return true;
+}
+
+// Runs the complete request through the regular ESP8266WebServer handling, the
+// connection is lent to it for the duration of one request only. The response
+// said "Connection: close", so the connection ends with it.
+void ONEBIOTHttpServer::_dispatch(Connection &connection) {
+    _currentClient = connection.client;
+    _currentStatus = HC_WAIT_READ;
+    _statusChange = millis();
+    ESP8266WebServer::handleClient();
+    _currentClient = WiFiClient();
+    _currentStatus = HC_NONE;
+    _release(connection);
+}
+
+void ONEBIOTHttpServer::_reject(Connection &connection, const char *status) {
+    ONEBIOT_LOG_WARN(WS, "%s from %s", status, connection.client.remoteIP());
+    connection.client.print("HTTP/1.1 ");
+    connection.client.print(status);
+    connection.client.print("\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+    connection.client.stop();
+    _release(connection);
+}
+
+// No log line and no handler, a refused client must not cost more than the canned answer.
+void ONEBIOTHttpServer::_refuse(Connection &connection) {
+    PGM_P response = ONEBIOTAdmission::tooManyRequests();
+    connection.client.write_P(response, strlen_P(response));
+    connection.client.stop();
+    _release(connection);
+}
+
+// Drops the reference only. A connection taken over by a handler, like an
+// events subscriber, stays open, every other one is closed by lwIP.
+void ONEBIOTHttpServer::_release(Connection &connection) {
+    connection.client = WiFiClient();
+    connection.state = FREE;
+    connection.since = 0;
+    connection.scanned = 0;
+    connection.length = 0;
+    connection.cost = 1;
+}
+
+#endif //ARDUINO_ARCH_ESP8266
+
+#endif //ONEBIOT_HTTP_SERVER_CPP
@@ -0,0 +1,85 @@
+#ifndef ONEBIOT_HTTP_SERVER_H
+#define ONEBIOT_HTTP_SERVER_H
+
+#ifdef ARDUINO_ARCH_ESP8266
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+
+// connections read in parallel, further ones wait in the accept queue
+#ifndef ONEBIOT_HTTP_CONNECTIONS
+#define ONEBIOT_HTTP_CONNECTIONS 4
+#endif
+
+// request line and headers have to fit, larger heads are answered with 431
+#ifndef ONEBIOT_HTTP_HEAD_SIZE
+#define ONEBIOT_HTTP_HEAD_SIZE 1024
+#endif
+
+// requests up to this size are complete before a handler runs, larger multipart
+// bodies (uploads) are handed over as soon as the head has arrived and read by the
+// core's form parser, which blocks the loop until it has them (at most HTTP_MAX_POST_WAIT
+// per stalled read), any other larger body is answered with 413
+#ifndef ONEBIOT_HTTP_REQUEST_SIZE
+#define ONEBIOT_HTTP_REQUEST_SIZE 2048
+#endif
+
+#ifndef ONEBIOT_HTTP_REQUEST_TIMEOUT
+#define ONEBIOT_HTTP_REQUEST_TIMEOUT 5000
+#endif
+
+/**
+ * ESP8266WebServer which reads several connections side by side. Every connection
+ * runs its own state machine over the bytes lwIP has already received and is
+ * handed to the regular request handling only once its request is complete,
+ * so a slow client never holds up the others. Registered handlers see the usual
+ * ESP8266WebServer and work unchanged. Requests over the budget of their client
+ * (ONEBIOTAdmission) are refused before they are read.
+ *
+ * Not covered: keep-alive, the core answers every request with "Connection: close"
+ * and a connection is released once its request has been served. Multipart uploads
+ * are streamed by the core's form parser inside one handleClient(), a slow upload
+ * holds up the other connections for as long as it takes.
+ */
+class ONEBIOTHttpServer : public ESP8266WebServer {
+    public:
+        ONEBIOTHttpServer(int port = 80) : ESP8266WebServer(port) {}
+        void handleClient();
+        uint8_t getConnectionCount();
+        // nothing to read or to accept, connections still sending their request may wait
+        bool isIdle();
+    private:
+        enum ConnectionState {
+            FREE,
+            READING,
+            READY
+        };
+
+        struct Connection {
+            WiFiClient client;
+            ConnectionState state = FREE;
+            unsigned long since = 0;
+            // available() of the last scan, the head is only scanned again when it grows
+            int scanned = 0;
+            // bytes which have to be received before dispatching, 0 while the head is incomplete
+            size_t length = 0;
+            // tokens the request costs the client, known once the head is parsed
+            uint8_t cost = 1;
+        };
+
+        Connection _connections[ONEBIOT_HTTP_CONNECTIONS];
+        uint8_t _next = 0;
+
+        void _accept();
+        void _poll(Connection &connection);
+        bool _parseHead(Connection &connection, size_t size);
+        void _dispatch(Connection &connection);
+        void _reject(Connection &connection, const char *status);
+        void _refuse(Connection &connection);
+        void _release(Connection &connection);
+};
+
+#endif //ARDUINO_ARCH_ESP8266
+
+#endif //ONEBIOT_HTTP_SERVER_H
@@ -0,0 +1,364 @@
+#ifndef ONEBIOT_LOG_CPP
+#define ONEBIOT_LOG_CPP
+
+#include <Arduino.h>
+
+#include "utils/log/ONEBIOTLog.h"
+#include "utils/sync/ONEBIOTSync.h"
+
+// Ring entry: [size][sequence:4][timestamp:4][format pointer][level][category][arguments]
+static const size_t LOG_HEADER_SIZE = 1 + 4 + 4 + sizeof(PGM_P) + 2;
+static const size_t LOG_ENTRY_SIZE = LOG_HEADER_SIZE + ONEBIOT_LOG_RECORD_SIZE;
+// the size of an entry and the length of a string argument are single bytes
+static_assert(LOG_ENTRY_SIZE <= 255, "ONEBIOT_LOG_RECORD_SIZE is too large for the one byte entry size");
+static_assert(LOG_ENTRY_SIZE <= ONEBIOT_LOG_BUFFER_SIZE, "ONEBIOT_LOG_BUFFER_SIZE cannot hold a single entry");
+static const char LOG_CATEGORIES[][4] PROGMEM = {"OBI", "FIS", "CNF", "WFC", "WAP", "DNS", "WS", "APP"};
+static const char LOG_LEVELS[] = {'-', 'E', 'W', 'I', 'D'};
+
+static uint8_t logBuffer[ONEBIOT_LOG_BUFFER_SIZE];
+static size_t logHead = 0;
+static size_t logTail = 0;
+static size_t logUsed = 0;
+static uint32_t logSequence = 0;
+static uint32_t logDrained = 0;
+static uint32_t logDropped = 0;
+static Print *logOutput = nullptr;
+// records may come from the server task while the loop task drains
+static ONEBIOTMutex logMutex;
+
+bool ONEBIOTLogRecord::_reserve(size_t size) {
+    return length + size <= ONEBIOT_LOG_RECORD_SIZE;
+}
+
+void ONEBIOTLogRecord::_addInteger(char type, uint32_t value) {
+    if (!_reserve(1 + sizeof(value))) {
+        return;
+    }
+    data[length++] = type;
+    memcpy(data + length, &value, sizeof(value));
+    length += sizeof(value);
+}
+
+void ONEBIOTLogRecord::_addLongInteger(char type, uint64_t value) {
+    if (!_reserve(1 + sizeof(value))) {
+        return;
+    }
+    data[length++] = type;
+    memcpy(data + length, &value, sizeof(value));
+    length += sizeof(value);
+}
+
+void ONEBIOTLogRecord::add(double value) {
+    float stored = value;
+    if (!_reserve(1 + sizeof(stored))) {
+        return;
+    }
+    data[length++] = 'f';
+    memcpy(data + length, &stored, sizeof(stored));
+    length += sizeof(stored);
+}
+
+void ONEBIOTLogRecord::add(const char *value) {
+    if (value == nullptr || !_reserve(2)) {
+        return;
+    }
+
+    size_t size = strnlen(value, ONEBIOT_LOG_RECORD_SIZE);
+    if (!_reserve(2 + size)) {
+        size = ONEBIOT_LOG_RECORD_SIZE - length - 2;
+    }
+    data[length++] = 's';
+    data[length++] = size;
+    memcpy(data + length, value, size);
+    length += size;
+}
+
+void ONEBIOTLogRecord::add(const __FlashStringHelper *value) {
+    PGM_P pointer = reinterpret_cast<PGM_P>(value);
+    if (!_reserve(1 + sizeof(pointer))) {
+        return;
+    }
+    data[length++] = 'P';
+    memcpy(data + length, &pointer, sizeof(pointer));
+    length += sizeof(pointer);
+}
+
+static void logWrite(size_t position, const uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        logBuffer[(position + i) % ONEBIOT_LOG_BUFFER_SIZE] = data[i];
+    }
+}
+
+static void logPeek(size_t position, uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        data[i] = logBuffer[(position + i) % ONEBIOT_LOG_BUFFER_SIZE];
+    }
+}
+
+void ONEBIOTLog::push(uint8_t level, ONEBIOTLogCategory category, PGM_P format, const ONEBIOTLogRecord &record) {
+    ONEBIOT_LOCK(logMutex);
+    uint8_t header[LOG_HEADER_SIZE];
+    uint32_t sequence = ++logSequence;
+    uint32_t timestamp = millis();
+    size_t size = LOG_HEADER_SIZE + record.length;
+
+    header[0] = size;
+    memcpy(header + 1, &sequence, 4);
+    memcpy(header + 5, &timestamp, 4);
+    memcpy(header + 9, &format, sizeof(PGM_P));
+    header[9 + sizeof(PGM_P)] = level;
+    header[10 + sizeof(PGM_P)] = category;
+
+    // the oldest entries make room, whether they were drained or not
+    while (ONEBIOT_LOG_BUFFER_SIZE - logUsed < size) {
+        // only the size and the sequence, the arguments stay in the ring
+        uint8_t oldest[5];
+        logPeek(logTail, oldest, sizeof(oldest));
+        uint32_t oldestSequence;
+        memcpy(&oldestSequence, oldest + 1, 4);
+        if (logOutput != nullptr && oldestSequence > logDrained) {
+            logDropped++;
+            logDrained = oldestSequence;
+        }
+
+        logTail = (logTail + oldest[0]) % ONEBIOT_LOG_BUFFER_SIZE;
+        logUsed -= oldest[0];
+    }
+
+    logWrite(logHead, header, LOG_HEADER_SIZE);
+    logWrite(logHead + LOG_HEADER_SIZE, record.data, record.length);
+    logHead = (logHead + size) % ONEBIOT_LOG_BUFFER_SIZE;
+    logUsed += size;
+}
+
+void ONEBIOTLog::setOutput(Print *output) {
+    logOutput = output;
+}
+
+void ONEBIOTLog::loop() {
+    _drain(ONEBIOT_LOG_DRAIN_RECORDS);
+}
+
+void ONEBIOTLog::flush() {
+    _drain(SIZE_MAX);
+}
+
+void ONEBIOTLog::_drain(size_t records) {
+    ONEBIOT_LOCK(logMutex);
+    if (logOutput == nullptr || logDrained == logSequence) {
+        return;
+    }
+
+    uint8_t entry[LOG_ENTRY_SIZE];
+    char line[160];
+    size_t drained = 0;
+    size_t position = logTail;
+    size_t remaining = logUsed;
+    while (remaining > 0 && drained < records) {
+        size_t size = _read(position, entry);
+        position = (position + size) % ONEBIOT_LOG_BUFFER_SIZE;
+        remaining -= size;
+
+        uint32_t sequence;
+        memcpy(&sequence, entry + 1, 4);
+        if (sequence <= logDrained) {
+            continue;
+        }
+
+        _format(entry, line, sizeof(line));
+        logOutput->println(line);
+        logDrained = sequence;
+        drained++;
+    }
+}
+
+// Lines are formatted into a chunk under the lock and written without it, a slow
+// client must not hold up the tasks which log meanwhile. Every chunk starts over
+// from the tail, so records evicted in between are simply skipped. Records logged
+// after the call started are left for the next one, the response has an end.
+uint32_t ONEBIOTLog::printSince(uint32_t since, Print &output) {
+    uint8_t entry[LOG_ENTRY_SIZE];
+    char line[160];
+    char chunk[512];
+    uint32_t last = since;
+    uint32_t end;
+    {
+        ONEBIOT_LOCK(logMutex);
+        end = logSequence;
+    }
+    while (true) {
+        size_t used = 0;
+        {
+            ONEBIOT_LOCK(logMutex);
+            size_t position = logTail;
+            size_t remaining = logUsed;
+            while (remaining > 0) {
+                size_t size = _read(position, entry);
+                position = (position + size) % ONEBIOT_LOG_BUFFER_SIZE;
+                remaining -= size;
+
+                uint32_t sequence;
+                memcpy(&sequence, entry + 1, 4);
+                if (sequence <= last) {
+                    continue;
+                } else if (sequence > end) {
+                    break;
+                }
+
+                size_t length = _format(entry, line, sizeof(line));
+                if (used + length + 2 > sizeof(chunk)) {
+                    break;
+                }
+                memcpy(chunk + used, line, length);
+                memcpy(chunk + used + length, "\r\n", 2);
+                used += length + 2;
+                last = sequence;
+            }
+        }
+        if (used == 0) {
+            return last;
+        }
+        output.write((const uint8_t *) chunk, used);
+    }
+}
+
+uint32_t ONEBIOTLog::getSequence() {
+    return logSequence;
+}
+
+bool ONEBIOTLog::isDrained() {
+    ONEBIOT_LOCK(logMutex);
+    return logOutput == nullptr || logDrained == logSequence;
+}
+
+uint32_t ONEBIOTLog::getDropped() {
+    return logDropped;
+}
+
+// Copies the entry at position out of the ring, returns its size.
+size_t ONEBIOTLog::_read(size_t position, uint8_t *entry) {
+    size_t size = logBuffer[position];
+    for (size_t i = 0; i < size; i++) {
+        entry[i] = logBuffer[(position + i) % ONEBIOT_LOG_BUFFER_SIZE];
+    }
+    return size;
+}
+
+// Renders "<sequence> <timestamp> <level> [<category>] <message>" into line.
+size_t ONEBIOTLog::_format(const uint8_t *entry, char *line, size_t size) {
+    uint32_t sequence;
+    uint32_t timestamp;
+    PGM_P format;
+    memcpy(&sequence, entry + 1, 4);
+    memcpy(&timestamp, entry + 5, 4);
+    memcpy(&format, entry + 9, sizeof(PGM_P));
+    uint8_t level = entry[9 + sizeof(PGM_P)];
+    uint8_t category = entry[10 + sizeof(PGM_P)];
+
+    char categoryName[4] = "???";
+    if (category < sizeof(LOG_CATEGORIES) / sizeof(LOG_CATEGORIES[0])) {
+        memcpy_P(categoryName, LOG_CATEGORIES[category], sizeof(categoryName));
+    }
+
+    int length = snprintf(line, size, "%u %u %c [%s] ", (unsigned) sequence, (unsigned) timestamp,
+        LOG_LEVELS[level <= ONEBIOT_LOG_LEVEL_DEBUG ? level : 0], categoryName);
+    size_t position = length < 0 ? 0 : length;
+
+    const uint8_t *argument = entry + LOG_HEADER_SIZE;
+    const uint8_t *end = entry + entry[0];
+    char spec[16];
+    char ch;
+    while (position + 1 < size && (ch = pgm_read_byte(format++)) != '\0') {
+        if (ch != '%') {
+            line[position++] = ch;
+            continue;
+        }
+
+        // collect flags and width, length modifiers are dropped, the record knows the type
+        size_t specLength = 0;
+        spec[specLength++] = '%';
+        while ((ch = pgm_read_byte(format)) != '\0' && strchr("-+ #0123456789.lhzjt", ch) != nullptr) {
+            if (strchr("lhzjt", ch) == nullptr && specLength < sizeof(spec) - 4) {
+                spec[specLength++] = ch;
+            }
+            format++;
+        }
+        if (ch == '\0') {
+            break;
+        }
+        format++;
+
+        if (ch == '%') {
+            line[position++] = '%';
+            continue;
+        }
+
+        int written = 0;
+        size_t available = size - position;
+        if (argument >= end) {
+            written = snprintf(line + position, available, "<?>");
+        } else if (*argument == 's' || *argument == 'P' || *argument == 'a') {
+            char text[ONEBIOT_LOG_RECORD_SIZE];
+            if (*argument == 's') {
+                memcpy(text, argument + 2, argument[1]);
+                text[argument[1]] = '\0';
+                argument += 2 + argument[1];
+            } else if (*argument == 'P') {
+                PGM_P pointer;
+                memcpy(&pointer, argument + 1, sizeof(pointer));
+                strncpy_P(text, pointer, sizeof(text) - 1);
+                text[sizeof(text) - 1] = '\0';
+                argument += 1 + sizeof(pointer);
+            } else {
+                uint32_t address;
+                memcpy(&address, argument + 1, 4);
+                snprintf(text, sizeof(text), "%u.%u.%u.%u", address & 0xff, (address >> 8) & 0xff, (address >> 16) & 0xff, address >> 24);
+                argument += 5;
+            }
+            spec[specLength++] = 's';
+            spec[specLength] = '\0';
+            written = snprintf(line + position, available, spec, text);
+        } else if (*argument == 'f') {
+            float value;
+            memcpy(&value, argument + 1, sizeof(value));
+            argument += 1 + sizeof(value);
+            spec[specLength++] = strchr("eEfgG", ch) != nullptr ? ch : 'f';
+            spec[specLength] = '\0';
+            written = snprintf(line + position, available, spec, (double) value);
+        } else if (*argument == 'l' || *argument == 'L') {
+            uint64_t value;
+            bool isSigned = *argument == 'l';
+            memcpy(&value, argument + 1, sizeof(value));
+            argument += 1 + sizeof(value);
+            spec[specLength++] = 'l';
+            spec[specLength++] = 'l';
+            spec[specLength++] = strchr("xXo", ch) != nullptr ? ch : (isSigned ? 'd' : 'u');
+            spec[specLength] = '\0';
+            written = isSigned
+                ? snprintf(line + position, available, spec, (long long) value)
+                : snprintf(line + position, available, spec, (unsigned long long) value);
+        } else {
+            uint32_t value;
+            bool isSigned = *argument == 'i';
+            memcpy(&value, argument + 1, sizeof(value));
+            argument += 1 + sizeof(value);
+            if (ch != 'c') {
+                spec[specLength++] = 'l';
+            }
+            spec[specLength++] = strchr("xXoc", ch) != nullptr ? ch : (isSigned ? 'd' : 'u');
+            spec[specLength] = '\0';
+            written = isSigned
+                ? snprintf(line + position, available, spec, (long) (int32_t) value)
+                : snprintf(line + position, available, spec, (unsigned long) value);
+        }
+
+        if (written > 0) {
+            position += (size_t) written < available ? written : available - 1;
+        }
+    }
+
+    line[position] = '\0';
+    return position;
+}
+
+#endif //ONEBIOT_LOG_CPP
@@ -0,0 +1,138 @@
+#ifndef ONEBIOT_LOG_H
+#define ONEBIOT_LOG_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+/**
+ * Deferred-format logger. A log call only copies the flash pointer of its format
+ * string and the binary arguments into a ring buffer, the text is rendered later
+ * by ONEBIOTApp::loop() for Serial or on demand by /cmd/log.
+ *
+ *   ONEBIOT_LOG_INFO(WFC, "IP address: %s", WiFi.localIP());
+ *
+ * Calls above ONEBIOT_LOG_LEVEL are not compiled at all.
+ */
+
+#define ONEBIOT_LOG_LEVEL_NONE 0
+#define ONEBIOT_LOG_LEVEL_ERROR 1
+#define ONEBIOT_LOG_LEVEL_WARN 2
+#define ONEBIOT_LOG_LEVEL_INFO 3
+#define ONEBIOT_LOG_LEVEL_DEBUG 4
+
+#ifndef ONEBIOT_LOG_LEVEL
+#define ONEBIOT_LOG_LEVEL ONEBIOT_LOG_LEVEL_INFO
+#endif
+
+#ifndef ONEBIOT_LOG_BUFFER_SIZE
+#define ONEBIOT_LOG_BUFFER_SIZE 1024
+#endif
+
+// binary arguments of one record, strings are truncated to fit
+#ifndef ONEBIOT_LOG_RECORD_SIZE
+#define ONEBIOT_LOG_RECORD_SIZE 64
+#endif
+
+// records written to the output by one ONEBIOTApp::loop() pass
+#ifndef ONEBIOT_LOG_DRAIN_RECORDS
+#define ONEBIOT_LOG_DRAIN_RECORDS 2
+#endif
+
+enum ONEBIOTLogCategory : uint8_t {
+    ONEBIOT_LOG_OBI, // One Box of IOT
+    ONEBIOT_LOG_FIS, // File System
+    ONEBIOT_LOG_CNF, // Loading settings
+    ONEBIOT_LOG_WFC, // WiFi Connection
+    ONEBIOT_LOG_WAP, // AP Connection
+    ONEBIOT_LOG_DNS, // mDNS service
+    ONEBIOT_LOG_WS,  // Web server
+    ONEBIOT_LOG_APP  // Sketch
+};
+
+class ONEBIOTLogRecord {
+    public:
+        uint8_t data[ONEBIOT_LOG_RECORD_SIZE];
+        uint8_t length = 0;
+
+        void add(int value) { _addInteger('i', value); }
+        void add(long value) { _addInteger('i', value); }
+        void add(short value) { _addInteger('i', value); }
+        void add(char value) { _addInteger('i', value); }
+        void add(signed char value) { _addInteger('i', value); }
+        void add(bool value) { _addInteger('i', value); }
+        void add(unsigned int value) { _addInteger('u', value); }
+        void add(unsigned long value) { _addInteger('u', value); }
+        void add(unsigned short value) { _addInteger('u', value); }
+        void add(unsigned char value) { _addInteger('u', value); }
+        void add(long long value) { _addLongInteger('l', value); }
+        void add(unsigned long long value) { _addLongInteger('L', value); }
+        void add(double value);
+        void add(const char *value);
+        void add(const String &value) { add(value.c_str()); }
+        void add(const __FlashStringHelper *value);
+        void add(const IPAddress &value) { _addInteger('a', (uint32_t) value); }
+    private:
+        void _addInteger(char type, uint32_t value);
+        void _addLongInteger(char type, uint64_t value);
+        bool _reserve(size_t size);
+};
+
+class ONEBIOTLog {
+    public:
+        template<typename... Args>
+        static void log(uint8_t level, ONEBIOTLogCategory category, PGM_P format, const Args&... args) {
+            ONEBIOTLogRecord record;
+            _add(record, args...);
+            push(level, category, format, record);
+        }
+
+        static void push(uint8_t level, ONEBIOTLogCategory category, PGM_P format, const ONEBIOTLogRecord &record);
+        // Serial (or any other Print) the loop drain writes to, nullptr disables it
+        static void setOutput(Print *output);
+        static void loop();
+        // drains everything left, used before a restart
+        static void flush();
+        // writes every record newer than since, returns the sequence of the last one
+        static uint32_t printSince(uint32_t since, Print &output);
+        static uint32_t getSequence();
+        // false while records wait for the output
+        static bool isDrained();
+        static uint32_t getDropped();
+    private:
+        static void _drain(size_t records);
+        static size_t _read(size_t position, uint8_t *entry);
+        static size_t _format(const uint8_t *entry, char *line, size_t size);
+        static void _add(ONEBIOTLogRecord &) {}
+
+        template<typename T, typename... Args>
+        static void _add(ONEBIOTLogRecord &record, const T &value, const Args&... args) {
+            record.add(value);
+            _add(record, args...);
+        }
+};
+
+#if ONEBIOT_LOG_LEVEL >= ONEBIOT_LOG_LEVEL_ERROR
+#define ONEBIOT_LOG_ERROR(category, format, ...) ONEBIOTLog::log(ONEBIOT_LOG_LEVEL_ERROR, ONEBIOT_LOG_##category, PSTR(format), ##__VA_ARGS__)
+#else
+#define ONEBIOT_LOG_ERROR(category, format, ...) do {} while (0)
+#endif
+
+#if ONEBIOT_LOG_LEVEL >= ONEBIOT_LOG_LEVEL_WARN
+#define ONEBIOT_LOG_WARN(category, format, ...) ONEBIOTLog::log(ONEBIOT_LOG_LEVEL_WARN, ONEBIOT_LOG_##category, PSTR(format), ##__VA_ARGS__)
+#else
+#define ONEBIOT_LOG_WARN(category, format, ...) do {} while (0)
+#endif
+
+#if ONEBIOT_LOG_LEVEL >= ONEBIOT_LOG_LEVEL_INFO
+#define ONEBIOT_LOG_INFO(category, format, ...) ONEBIOTLog::log(ONEBIOT_LOG_LEVEL_INFO, ONEBIOT_LOG_##category, PSTR(format), ##__VA_ARGS__)
+#else
+#define ONEBIOT_LOG_INFO(category, format, ...) do {} while (0)
+#endif
+
+#if ONEBIOT_LOG_LEVEL >= ONEBIOT_LOG_LEVEL_DEBUG
+#define ONEBIOT_LOG_DEBUG(category, format, ...) ONEBIOTLog::log(ONEBIOT_LOG_LEVEL_DEBUG, ONEBIOT_LOG_##category, PSTR(format), ##__VA_ARGS__)
+#else
+#define ONEBIOT_LOG_DEBUG(category, format, ...) do {} while (0)
+#endif
+
+#endif //ONEBIOT_LOG_H
@@ -0,0 +1,554 @@
+#ifndef ONEBIOT_MQTT_CPP
+#define ONEBIOT_MQTT_CPP
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "utils/mqtt/ONEBIOTMqtt.h"
+#include "utils/fs/ONEBIOTFS.h"
+#include "utils/log/ONEBIOTLog.h"
+#include "utils/sync/ONEBIOTSync.h"
+
+const char *MQTT_SPOOL_FILE = "/mqtt.queue";
+const uint32_t MQTT_RECONNECT_INTERVAL = 5000;
+const uint32_t MQTT_CONNECT_TIMEOUT = 5000;
+// a PUBACK which does not arrive in time means a dead connection, everything unacknowledged is resent
+const uint32_t MQTT_ACK_TIMEOUT = 10000;
+// [topic length:1][payload length:2][topic][payload], the same in RAM and in the queue file
+const size_t MQTT_RECORD_HEADER = 3;
+
+// guards the counters copy, written by the loop task and read by the server task
+static ONEBIOTMutex mqttMutex;
+
+void ONEBIOTMqtt::begin(const char *host, uint16_t port, String clientId) {
+    _host = host;
+    _port = port;
+    _clientId = clientId;
+}
+
+void ONEBIOTMqtt::setCredentials(const char *user, const char *password) {
+    _user = user;
+    _password = password;
+}
+
+void ONEBIOTMqtt::setFileSystem(FS &fs) {
+    _fs = &fs;
+    _spoolLoaded = false;
+}
+
+void ONEBIOTMqtt::setFlushWindow(uint32_t flushWindow) {
+    _flushWindow = flushWindow;
+}
+
+bool ONEBIOTMqtt::publish(const char *topic, const String &payload) {
+    return publish(topic, payload.c_str());
+}
+
+bool ONEBIOTMqtt::publish(const char *topic, const char *payload) {
+    bool queued = _enqueue(topic, payload);
+    _publishCounters();
+    return queued;
+}
+
+bool ONEBIOTMqtt::_enqueue(const char *topic, const char *payload) {
+    size_t topicLength = strlen(topic);
+    size_t payloadLength = strlen(payload);
+    size_t size = MQTT_RECORD_HEADER + topicLength + payloadLength;
+    if (topicLength == 0 || topicLength > 255 || topicLength + payloadLength > ONEBIOT_MQTT_MESSAGE_SIZE) {
+        _dropped++;
+        return false;
+    }
+
+    if (ONEBIOT_MQTT_BUFFER_SIZE - _used < size && (_state == CONNECTED || !_spoolBuffer())) {
+        _dropped++;
+        return false;
+    }
+
+    if (_used == _pending) {
+        _firstQueuedAt = millis();
+    }
+
+    uint8_t header[MQTT_RECORD_HEADER] = {(uint8_t) topicLength, (uint8_t) (payloadLength & 0xff), (uint8_t) (payloadLength >> 8)};
+    const uint8_t *parts[] = {header, (const uint8_t *) topic, (const uint8_t *) payload};
+    size_t lengths[] = {MQTT_RECORD_HEADER, topicLength, payloadLength};
+    for (int part = 0; part < 3; part++) {
+        for (size_t i = 0; i < lengths[part]; i++) {
+            _buffer[_head] = parts[part][i];
+            _head = (_head + 1) % ONEBIOT_MQTT_BUFFER_SIZE;
+        }
+    }
+    _used += size;
+    _queued++;
+    return true;
+}
+
+void ONEBIOTMqtt::loop(bool networkConnected) {
+    _loop(networkConnected);
+    _publishCounters();
+}
+
+void ONEBIOTMqtt::_loop(bool networkConnected) {
+    if (_host.isEmpty()) {
+        return;
+    }
+
+    _loadSpool();
+
+    if (!networkConnected) {
+        if (_state != DISCONNECTED) {
+            _disconnect();
+        }
+        return;
+    }
+
+    if (_state == DISCONNECTED) {
+        if (millis() - _stateAt >= MQTT_RECONNECT_INTERVAL || _stateAt == 0) {
+            _connect();
+        }
+        return;
+    }
+
+    if (!_client.connected()) {
+        ONEBIOT_LOG_WARN(OBI, "MQTT connection lost");
+        _disconnect();
+        return;
+    }
+
+    _receive();
+    if (_state == CONNECTING) {
+        if (millis() - _stateAt > MQTT_CONNECT_TIMEOUT) {
+            ONEBIOT_LOG_WARN(OBI, "MQTT broker did not answer CONNECT");
+            _disconnect();
+        }
+        return;
+    }
+
+    if (_state != CONNECTED) {
+        return;
+    }
+
+    if (_inflightCount > 0 && millis() - _inflight[0].sent_at > MQTT_ACK_TIMEOUT) {
+        ONEBIOT_LOG_WARN(OBI, "MQTT PUBACK timeout");
+        _disconnect();
+        return;
+    }
+
+    _flush();
+
+    if (millis() - _lastPacketAt >= (uint32_t) _keepAlive * 500) {
+        uint8_t ping[] = {0xC0, 0x00};
+        _client.write(ping, sizeof(ping));
+        _lastPacketAt = millis();
+    }
+}
+
+void ONEBIOTMqtt::_loadSpool() {
+    if (!_spoolLoaded) {
+        File spool = _fs->open(MQTT_SPOOL_FILE, "r");
+        _spoolSize = spool ? spool.size() : 0;
+        _spoolAcked = 0;
+        _spoolSent = 0;
+        _spoolLoaded = true;
+    }
+}
+
+void ONEBIOTMqtt::persist() {
+    if (_host.isEmpty()) {
+        return;
+    }
+
+    _loadSpool();
+    if (_state != DISCONNECTED) {
+        _disconnect();
+    } else {
+        _spoolBuffer();
+    }
+    _publishCounters();
+}
+
+static uint32_t mqttRemaining(uint32_t since, uint32_t interval) {
+    uint32_t elapsed = millis() - since;
+    return elapsed >= interval ? 0 : interval - elapsed;
+}
+
+uint32_t ONEBIOTMqtt::getIdleTime() {
+    if (_host.isEmpty()) {
+        return UINT32_MAX;
+    }
+    if (_state == DISCONNECTED) {
+        return _stateAt == 0 ? 0 : mqttRemaining(_stateAt, MQTT_RECONNECT_INTERVAL);
+    }
+    if (_client.available()) {
+        return 0;
+    }
+    if (_state == CONNECTING) {
+        return mqttRemaining(_stateAt, MQTT_CONNECT_TIMEOUT);
+    }
+
+    uint32_t idle = mqttRemaining(_lastPacketAt, (uint32_t) _keepAlive * 500);
+    if (_inflightCount > 0) {
+        idle = min(idle, mqttRemaining(_inflight[0].sent_at, MQTT_ACK_TIMEOUT));
+    }
+    // a full inflight window waits for PUBACKs, not for the flush window
+    if (_inflightCount < ONEBIOT_MQTT_INFLIGHT) {
+        if (_spoolSent < _spoolSize) {
+            return 0;
+        } else if (_used > _pending) {
+            idle = min(idle, _used >= ONEBIOT_MQTT_BUFFER_SIZE * 3 / 4 ? 0 : mqttRemaining(_firstQueuedAt, _flushWindow));
+        }
+    }
+    return idle;
+}
+
+bool ONEBIOTMqtt::isConnected() {
+    return _state == CONNECTED;
+}
+
+size_t ONEBIOTMqtt::getQueueDepth() {
+    return _queued;
+}
+
+size_t ONEBIOTMqtt::getSpoolSize() {
+    return _spoolSize - _spoolAcked;
+}
+
+uint32_t ONEBIOTMqtt::getDropped() {
+    return _dropped;
+}
+
+uint32_t ONEBIOTMqtt::getLastLatency() {
+    return _lastLatency;
+}
+
+uint32_t ONEBIOTMqtt::getMaxLatency() {
+    return _maxLatency;
+}
+
+void ONEBIOTMqtt::getCounters(ONEBIOTMqttCounters &counters) {
+    ONEBIOT_LOCK(mqttMutex);
+    counters = _counters;
+}
+
+void ONEBIOTMqtt::_publishCounters() {
+    ONEBIOT_LOCK(mqttMutex);
+    _counters.connected = isConnected();
+    _counters.queue_depth = getQueueDepth();
+    _counters.spool_bytes = getSpoolSize();
+    _counters.dropped = _dropped;
+    _counters.last_latency = _lastLatency;
+    _counters.max_latency = _maxLatency;
+}
+
+void ONEBIOTMqtt::_connect() {
+    _stateAt = millis();
+    if (!_client.connect(_host.c_str(), _port)) {
+        return;
+    }
+
+    bool credentials = !_user.isEmpty();
+    size_t remaining = 10 + 2 + _clientId.length();
+    if (credentials) {
+        remaining += 2 + _user.length() + 2 + _password.length();
+    }
+
+    uint8_t packet[256];
+    if (remaining + 5 > sizeof(packet)) {
+        ONEBIOT_LOG_ERROR(OBI, "MQTT client id or credentials are too long");
+        _client.stop();
+        return;
+    }
+
+    size_t length = 0;
+    packet[length++] = 0x10;
+    length += _writeLength(packet + length, remaining);
+    length += _writeString(packet + length, "MQTT");
+    packet[length++] = 0x04;                                 // protocol level 3.1.1
+    packet[length++] = credentials ? 0xC2 : 0x02;            // clean session (+ user and password)
+    packet[length++] = _keepAlive >> 8;
+    packet[length++] = _keepAlive & 0xff;
+    length += _writeString(packet + length, _clientId);
+    if (credentials) {
+        length += _writeString(packet + length, _user);
+        length += _writeString(packet + length, _password);
+    }
+
+    _client.write(packet, length);
+    _state = CONNECTING;
+    _stateAt = millis();
+}
+
+void ONEBIOTMqtt::_disconnect() {
+    _client.stop();
+    _state = DISCONNECTED;
+    _stateAt = millis();
+    _incomingHeader = 0;
+
+    // nothing unacknowledged is lost, it goes out again after reconnecting
+    _inflightCount = 0;
+    _sent = _tail;
+    _pending = 0;
+    _spoolSent = _spoolAcked;
+    // and survives a restart while the broker is away
+    _spoolBuffer();
+}
+
+// Bytes are taken as they come, a packet is handled only once all of it has arrived.
+void ONEBIOTMqtt::_receive() {
+    int value;
+    while ((value = _client.read()) >= 0) {
+        if (_incomingHeader == 0) {
+            _incomingType = value >> 4;
+            _incomingHeader = 1;
+            _incomingLength = 0;
+            _incomingRead = 0;
+            _incomingBody = false;
+            continue;
+        }
+
+        if (!_incomingBody) {
+            _incomingLength |= (value & 0x7f) << (7 * (_incomingHeader - 1));
+            _incomingHeader++;
+            if (value & 0x80) {
+                if (_incomingHeader == 5) {
+                    ONEBIOT_LOG_ERROR(OBI, "MQTT packet length is malformed");
+                    _disconnect();
+                    return;
+                }
+                continue;
+            }
+            _incomingBody = true;
+        } else {
+            if (_incomingRead < sizeof(_incomingData)) {
+                _incomingData[_incomingRead] = value;
+            }
+            _incomingRead++;
+        }
+
+        if (_incomingRead == _incomingLength) {
+            _incomingHeader = 0;
+            if (!_handlePacket()) {
+                return;
+            }
+        }
+    }
+}
+
+bool ONEBIOTMqtt::_handlePacket() {
+    if (_incomingLength < sizeof(_incomingData)) {
+        memset(_incomingData + _incomingLength, 0, sizeof(_incomingData) - _incomingLength);
+    }
+
+    if (_incomingType == 2) {            // CONNACK
+        if (_incomingData[1] != 0) {
+            ONEBIOT_LOG_ERROR(OBI, "MQTT connection refused: %u", _incomingData[1]);
+            _disconnect();
+            return false;
+        }
+        ONEBIOT_LOG_INFO(OBI, "MQTT connected to %s", _host);
+        _state = CONNECTED;
+        _lastPacketAt = millis();
+    } else if (_incomingType == 4) {     // PUBACK
+        _acknowledge((_incomingData[0] << 8) | _incomingData[1]);
+    }
+    return true;
+}
+
+// The queue file is older than anything in RAM, it has to be sent out first.
+void ONEBIOTMqtt::_flush() {
+    if (_spoolSent < _spoolSize && !_flushSpool()) {
+        return;
+    }
+    if (_spoolSent < _spoolSize) {
+        return;
+    }
+
+    size_t unsent = _used - _pending;
+    if (unsent == 0 || (millis() - _firstQueuedAt < _flushWindow && _used < ONEBIOT_MQTT_BUFFER_SIZE * 3 / 4)) {
+        return;
+    }
+
+    uint8_t message[MQTT_RECORD_HEADER + ONEBIOT_MQTT_MESSAGE_SIZE];
+    while (_used > _pending && _inflightCount < ONEBIOT_MQTT_INFLIGHT) {
+        size_t size = _readRing(_sent, message);
+        size_t end = (_sent + size) % ONEBIOT_MQTT_BUFFER_SIZE;
+        if (!_sendMessage(message, false, end)) {
+            return;
+        }
+        _sent = end;
+        _pending += size;
+    }
+}
+
+bool ONEBIOTMqtt::_flushSpool() {
+    File spool = _fs->open(MQTT_SPOOL_FILE, "r");
+    if (!spool || !spool.seek(_spoolSent)) {
+        // the file is gone, nothing to recover
+        _spoolSize = _spoolAcked = _spoolSent = 0;
+        return true;
+    }
+
+    uint8_t message[MQTT_RECORD_HEADER + ONEBIOT_MQTT_MESSAGE_SIZE];
+    while (_spoolSent < _spoolSize && _inflightCount < ONEBIOT_MQTT_INFLIGHT) {
+        if (spool.read(message, MQTT_RECORD_HEADER) != MQTT_RECORD_HEADER) {
+            break;
+        }
+
+        size_t length = message[0] + (message[1] | (message[2] << 8));
+        if (length > ONEBIOT_MQTT_MESSAGE_SIZE) {
+            break;
+        }
+        // File::read() returns an int, negative on an error
+        int read = spool.read(message + MQTT_RECORD_HEADER, length);
+        if (read < 0 || (size_t) read != length) {
+            break;
+        }
+
+        uint32_t end = _spoolSent + MQTT_RECORD_HEADER + length;
+        if (!_sendMessage(message, true, end)) {
+            return false;
+        }
+        _spoolSent = end;
+    }
+
+    if (_spoolSent < _spoolSize && _inflightCount < ONEBIOT_MQTT_INFLIGHT) {
+        ONEBIOT_LOG_ERROR(OBI, "MQTT queue file is damaged, dropped");
+        _fs->remove(MQTT_SPOOL_FILE);
+        _spoolSize = _spoolAcked = _spoolSent = 0;
+    }
+    return true;
+}
+
+bool ONEBIOTMqtt::_sendMessage(const uint8_t *message, bool spooled, uint32_t end) {
+    size_t topicLength = message[0];
+    size_t payloadLength = message[1] | (message[2] << 8);
+    uint16_t packetId = _nextPacketId++;
+    if (_nextPacketId == 0) {
+        _nextPacketId = 1;
+    }
+
+    uint8_t header[5 + 2 + 255 + 2];
+    size_t length = 0;
+    header[length++] = 0x32;    // PUBLISH, QoS 1
+    length += _writeLength(header + length, 2 + topicLength + 2 + payloadLength);
+    header[length++] = topicLength >> 8;
+    header[length++] = topicLength & 0xff;
+    memcpy(header + length, message + MQTT_RECORD_HEADER, topicLength);
+    length += topicLength;
+    header[length++] = packetId >> 8;
+    header[length++] = packetId & 0xff;
+
+    if (_client.write(header, length) != length
+        || _client.write(message + MQTT_RECORD_HEADER + topicLength, payloadLength) != payloadLength) {
+        _disconnect();
+        return false;
+    }
+
+    Inflight &inflight = _inflight[_inflightCount++];
+    inflight.packet_id = packetId;
+    inflight.spooled = spooled;
+    inflight.end = end;
+    inflight.sent_at = millis();
+    _lastPacketAt = inflight.sent_at;
+    return true;
+}
+
+// Brokers acknowledge QoS 1 in order, so everything up to the matching packet is done.
+void ONEBIOTMqtt::_acknowledge(uint16_t packetId) {
+    size_t index = 0;
+    while (index < _inflightCount && _inflight[index].packet_id != packetId) {
+        index++;
+    }
+    if (index == _inflightCount) {
+        return;
+    }
+
+    for (size_t i = 0; i <= index; i++) {
+        Inflight &inflight = _inflight[i];
+        if (inflight.spooled) {
+            _spoolAcked = _spoolSize > 0 ? inflight.end : 0;
+        } else {
+            size_t size = (inflight.end + ONEBIOT_MQTT_BUFFER_SIZE - _tail) % ONEBIOT_MQTT_BUFFER_SIZE;
+            _tail = inflight.end;
+            _used -= size;
+            _pending -= size;
+            _queued--;
+        }
+    }
+
+    _lastLatency = millis() - _inflight[index].sent_at;
+    if (_lastLatency > _maxLatency) {
+        _maxLatency = _lastLatency;
+    }
+
+    _inflightCount -= index + 1;
+    memmove(_inflight, _inflight + index + 1, _inflightCount * sizeof(Inflight));
+
+    if (_spoolSize > 0 && _spoolAcked == _spoolSize) {
+        _fs->remove(MQTT_SPOOL_FILE);
+        _spoolSize = _spoolAcked = _spoolSent = 0;
+    }
+}
+
+// Appends the whole RAM queue to the queue file in one write, used only while offline.
+bool ONEBIOTMqtt::_spoolBuffer() {
+    if (_used == 0 || _spoolSize + _used > ONEBIOT_MQTT_SPOOL_SIZE) {
+        return false;
+    }
+
+    File spool = _fs->open(MQTT_SPOOL_FILE, "a");
+    if (!spool) {
+        return false;
+    }
+
+    size_t first = _tail + _used <= ONEBIOT_MQTT_BUFFER_SIZE ? _used : ONEBIOT_MQTT_BUFFER_SIZE - _tail;
+    size_t written = spool.write(_buffer + _tail, first);
+    if (first < _used) {
+        written += spool.write(_buffer, _used - first);
+    }
+
+    if (written != _used) {
+        // keep the RAM copy, a partially written record would break the file
+        spool.close();
+        ONEBIOTFS::truncate(*_fs, MQTT_SPOOL_FILE, _spoolSize);
+        ONEBIOT_LOG_ERROR(OBI, "MQTT queue file is full");
+        return false;
+    }
+    spool.close();
+
+    ONEBIOT_LOG_INFO(OBI, "MQTT offline, %u messages queued to flash", _queued);
+    _spoolSize += written;
+    _tail = _sent = _head = 0;
+    _used = _pending = _queued = 0;
+    return true;
+}
+
+size_t ONEBIOTMqtt::_readRing(size_t position, uint8_t *message) {
+    for (size_t i = 0; i < MQTT_RECORD_HEADER; i++) {
+        message[i] = _buffer[(position + i) % ONEBIOT_MQTT_BUFFER_SIZE];
+    }
+
+    size_t size = MQTT_RECORD_HEADER + message[0] + (message[1] | (message[2] << 8));
+    for (size_t i = MQTT_RECORD_HEADER; i < size; i++) {
+        message[i] = _buffer[(position + i) % ONEBIOT_MQTT_BUFFER_SIZE];
+    }
+    return size;
+}
+
+size_t ONEBIOTMqtt::_writeLength(uint8_t *packet, size_t length) {
+    size_t written = 0;
+    do {
+        uint8_t digit = length % 128;
+        length /= 128;
+        packet[written++] = length > 0 ? digit | 0x80 : digit;
+    } while (length > 0);
+    return written;
+}
+
+size_t ONEBIOTMqtt::_writeString(uint8_t *packet, const String &value) {
+    packet[0] = value.length() >> 8;
+    packet[1] = value.length() & 0xff;
+    memcpy(packet + 2, value.c_str(), value.length());
+    return 2 + value.length();
+}
+
+#endif //ONEBIOT_MQTT_CPP
@@ -0,0 +1,144 @@
+#ifndef ONEBIOT_MQTT_H
+#define ONEBIOT_MQTT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <FS.h>
+
+// RAM queue of messages waiting for a flush or for their PUBACK
+#ifndef ONEBIOT_MQTT_BUFFER_SIZE
+#define ONEBIOT_MQTT_BUFFER_SIZE 1024
+#endif
+
+// topic + payload of one message
+#ifndef ONEBIOT_MQTT_MESSAGE_SIZE
+#define ONEBIOT_MQTT_MESSAGE_SIZE 256
+#endif
+
+// QoS 1 publishes sent without waiting for their PUBACK
+#ifndef ONEBIOT_MQTT_INFLIGHT
+#define ONEBIOT_MQTT_INFLIGHT 8
+#endif
+
+// upper bound of the offline queue file
+#ifndef ONEBIOT_MQTT_SPOOL_SIZE
+#define ONEBIOT_MQTT_SPOOL_SIZE 16384
+#endif
+
+// what /cmd/mqtt reports, copied from the publisher after every call which changes it
+struct ONEBIOTMqttCounters {
+    bool connected = false;
+    uint32_t queue_depth = 0;
+    uint32_t spool_bytes = 0;
+    uint32_t dropped = 0;
+    uint32_t last_latency = 0;
+    uint32_t max_latency = 0;
+};
+
+/**
+ * Minimal MQTT 3.1.1 telemetry publisher. Messages are collected for a flush window
+ * and published with QoS 1 back to back, PUBACKs are matched as they come.
+ * While the broker is unreachable full RAM batches are appended to a queue file,
+ * which is drained first after reconnecting. A lost connection or persist() moves
+ * whatever is left in RAM to the file as well.
+ */
+class ONEBIOTMqtt {
+    public:
+        ONEBIOTMqtt(Client &client, FS &fs) : _client(client), _fs(&fs) {}
+        void begin(const char *host, uint16_t port, String clientId);
+        void setCredentials(const char *user, const char *password);
+        void setFileSystem(FS &fs);
+        void setFlushWindow(uint32_t flushWindow);
+        bool publish(const char *topic, const char *payload);
+        bool publish(const char *topic, const String &payload);
+        void loop(bool networkConnected);
+        // closes the connection and writes the RAM queue to the queue file, called before a restart
+        void persist();
+        // milliseconds until loop() has to send something or times out, 0 when data has arrived
+        uint32_t getIdleTime();
+
+        bool isConnected();
+        size_t getQueueDepth();
+        size_t getSpoolSize();
+        uint32_t getDropped();
+        uint32_t getLastLatency();
+        uint32_t getMaxLatency();
+        // a copy taken under a lock, the server task may read it while the loop publishes
+        void getCounters(ONEBIOTMqttCounters &counters);
+    private:
+        enum State : uint8_t {
+            DISCONNECTED,
+            CONNECTING,
+            CONNECTED
+        };
+
+        struct Inflight {
+            uint16_t packet_id;
+            bool spooled;
+            uint32_t end;      // ring or file position behind the message
+            uint32_t sent_at;
+        };
+
+        Client &_client;
+        FS *_fs;
+        String _host;
+        uint16_t _port = 1883;
+        String _clientId;
+        String _user;
+        String _password;
+        State _state = DISCONNECTED;
+        uint32_t _stateAt = 0;
+        uint32_t _lastPacketAt = 0;
+        uint32_t _flushWindow = 500;
+        uint16_t _keepAlive = 30;
+        uint16_t _nextPacketId = 1;
+
+        uint8_t _buffer[ONEBIOT_MQTT_BUFFER_SIZE];
+        size_t _tail = 0;       // oldest message not acknowledged yet
+        size_t _sent = 0;       // first message not sent yet
+        size_t _head = 0;       // where the next message is written
+        size_t _used = 0;
+        size_t _pending = 0;    // bytes between _tail and _sent
+        size_t _queued = 0;     // messages between _tail and _head
+        uint32_t _firstQueuedAt = 0;
+
+        uint32_t _spoolSize = 0;
+        uint32_t _spoolAcked = 0;
+        uint32_t _spoolSent = 0;
+        bool _spoolLoaded = false;
+
+        // the packet being received, it may arrive over several loop passes
+        uint8_t _incomingType = 0;
+        uint8_t _incomingData[2];
+        size_t _incomingHeader = 0;     // fixed header bytes read, 0 while waiting for the next packet
+        size_t _incomingLength = 0;     // remaining length of the packet
+        size_t _incomingRead = 0;       // bytes of the remaining length read
+        bool _incomingBody = false;
+
+        Inflight _inflight[ONEBIOT_MQTT_INFLIGHT];
+        size_t _inflightCount = 0;
+
+        uint32_t _dropped = 0;
+        uint32_t _lastLatency = 0;
+        uint32_t _maxLatency = 0;
+        ONEBIOTMqttCounters _counters;
+
+        bool _enqueue(const char *topic, const char *payload);
+        void _loop(bool networkConnected);
+        void _publishCounters();
+        void _loadSpool();
+        void _connect();
+        void _disconnect();
+        void _receive();
+        bool _handlePacket();
+        void _flush();
+        bool _flushSpool();
+        bool _sendMessage(const uint8_t *message, bool spooled, uint32_t end);
+        bool _spoolBuffer();
+        void _acknowledge(uint16_t packetId);
+        size_t _readRing(size_t position, uint8_t *message);
+        size_t _writeLength(uint8_t *packet, size_t length);
+        size_t _writeString(uint8_t *packet, const String &value);
+};
+
+#endif //ONEBIOT_MQTT_H
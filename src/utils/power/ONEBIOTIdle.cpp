@@ -0,0 +1,134 @@
+#ifndef ONEBIOT_IDLE_CPP
+#define ONEBIOT_IDLE_CPP
+
+#include <Arduino.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WiFi.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
+#include <ESP8266WiFi.h>
+#endif
+
+#include "utils/power/ONEBIOTIdle.h"
+#include "utils/log/ONEBIOTLog.h"
+#include "utils/sync/ONEBIOTSync.h"
+
+// the counters are written by the loop task and read by the server task
+static ONEBIOTMutex idleMutex;
+
+void ONEBIOTIdle::setMode(ONEBIOTIdleMode mode) {
+    _mode = mode;
+    _sleepLength = ONEBIOT_IDLE_MIN_SLEEP;
+    _wake = AWAKE;
+    {
+        ONEBIOT_LOCK(idleMutex);
+        _since = millis();
+        _counters = ONEBIOTIdleCounters();
+    }
+    _applySleepMode();
+}
+
+ONEBIOTIdleMode ONEBIOTIdle::getMode() {
+    return _mode;
+}
+
+void ONEBIOTIdle::setLatencyBound(uint32_t latencyBound) {
+    _latencyBound = max(latencyBound, (uint32_t) ONEBIOT_IDLE_MIN_SLEEP);
+}
+
+uint32_t ONEBIOTIdle::getLatencyBound() {
+    return _latencyBound;
+}
+
+void ONEBIOTIdle::activity() {
+    _active = true;
+}
+
+void ONEBIOTIdle::deadline(uint32_t ms) {
+    _deadline = min(_deadline, ms);
+}
+
+void ONEBIOTIdle::loop() {
+    bool active = _active;
+    uint32_t deadline = _deadline;
+    _active = false;
+    _deadline = UINT32_MAX;
+
+    if (_mode == ONEBIOT_IDLE_OFF) {
+        return;
+    }
+
+    {
+        ONEBIOT_LOCK(idleMutex);
+        _counters.passes++;
+        if (_wake != AWAKE) {
+            if (active) {
+                _counters.wake_network++;
+            } else if (_wake == DEADLINE) {
+                _counters.wake_deadline++;
+            } else {
+                _counters.wake_latency++;
+            }
+        }
+        if (!active) {
+            _counters.idle_passes++;
+        }
+    }
+    _wake = AWAKE;
+
+    if (active) {
+        _sleepLength = ONEBIOT_IDLE_MIN_SLEEP;
+        return;
+    }
+
+    uint32_t length = min(_sleepLength, _latencyBound);
+    WakeReason wake = LATENCY;
+    if (deadline <= length) {
+        length = deadline;
+        wake = DEADLINE;
+    }
+    if (length == 0) {
+        return;
+    }
+
+    uint32_t start = millis();
+    delay(length);
+    {
+        ONEBIOT_LOCK(idleMutex);
+        _counters.slept += millis() - start;
+        _counters.sleeps++;
+    }
+    _wake = wake;
+    _sleepLength = min(_sleepLength * 2, _latencyBound);
+}
+
+uint8_t ONEBIOTIdle::getIdleRatio() {
+    ONEBIOT_LOCK(idleMutex);
+    uint32_t elapsed = millis() - _since;
+    if (_mode == ONEBIOT_IDLE_OFF || elapsed == 0) {
+        return 0;
+    }
+    return min((uint64_t) _counters.slept * 100 / elapsed, (uint64_t) 100);
+}
+
+void ONEBIOTIdle::getCounters(ONEBIOTIdleCounters &counters) {
+    ONEBIOT_LOCK(idleMutex);
+    counters = _counters;
+}
+
+// Both cores run modem sleep by default, only light sleep has to be switched on. The
+// ESP32 core is built without automatic light sleep, there it stays in modem sleep.
+void ONEBIOTIdle::_applySleepMode() {
+#ifdef ARDUINO_ARCH_ESP8266
+    WiFi.setSleepMode(_mode == ONEBIOT_IDLE_LIGHT ? WIFI_LIGHT_SLEEP : WIFI_MODEM_SLEEP);
+    if (_mode == ONEBIOT_IDLE_LIGHT && WiFi.getMode() != WIFI_STA) {
+        ONEBIOT_LOG_WARN(OBI, "Light sleep needs the station mode, the AP keeps the chip awake");
+    }
+#else
+    if (_mode != ONEBIOT_IDLE_OFF) {
+        WiFi.setSleep(true);
+    }
+#endif
+}
+
+#endif //ONEBIOT_IDLE_CPP
@@ -0,0 +1,86 @@
+#ifndef ONEBIOT_IDLE_H
+#define ONEBIOT_IDLE_H
+
+#include <Arduino.h>
+
+// longest a request or packet waits for the sleeping loop, setLatencyBound() changes it
+#ifndef ONEBIOT_IDLE_LATENCY_BOUND
+#define ONEBIOT_IDLE_LATENCY_BOUND 100
+#endif
+
+// first sleep after a busy pass, every further idle pass sleeps twice as long
+#ifndef ONEBIOT_IDLE_MIN_SLEEP
+#define ONEBIOT_IDLE_MIN_SLEEP 2
+#endif
+
+// mDNS announces and answers from update(), it is called at least this often
+#ifndef ONEBIOT_IDLE_MDNS_INTERVAL
+#define ONEBIOT_IDLE_MDNS_INTERVAL 1000
+#endif
+
+enum ONEBIOTIdleMode : uint8_t {
+    // the loop runs as fast as the sketch calls it
+    ONEBIOT_IDLE_OFF,
+    ONEBIOT_IDLE_MODEM,
+    ONEBIOT_IDLE_LIGHT
+};
+
+struct ONEBIOTIdleCounters {
+    uint32_t passes = 0;
+    uint32_t idle_passes = 0;
+    uint32_t sleeps = 0;
+    uint32_t slept = 0;         // ms
+    // what ended a sleep: a deadline of the app, the latency bound, or work which
+    // was waiting for the next pass (a request, a packet)
+    uint32_t wake_deadline = 0;
+    uint32_t wake_latency = 0;
+    uint32_t wake_network = 0;
+};
+
+/**
+ * Idle governor of ONEBIOTApp::loop(). A pass nothing reported activity() for is
+ * idle, the loop then sleeps until the nearest deadline() of the app or for the
+ * latency bound, whatever comes first. Sleeps start short after a busy pass and
+ * double while the loop stays idle, so a burst of requests is not slowed down.
+ *
+ * The loop sleeps in delay(), meanwhile the SDK powers the radio down between
+ * beacons (modem sleep) or suspends the CPU as well (light sleep, ESP8266 in
+ * station mode only). Packets arriving meanwhile wait in lwIP for the next pass.
+ */
+class ONEBIOTIdle {
+    public:
+        void setMode(ONEBIOTIdleMode mode);
+        ONEBIOTIdleMode getMode();
+        void setLatencyBound(uint32_t latencyBound);
+        uint32_t getLatencyBound();
+        // the pass did work, the loop does not sleep after it
+        void activity();
+        // the next sleep ends within ms at the latest
+        void deadline(uint32_t ms);
+        // ends the pass, sleeps when it was idle
+        void loop();
+        // percent of the time asleep since the mode was set
+        uint8_t getIdleRatio();
+        // a copy taken under a lock, the server task may read it while the loop counts
+        void getCounters(ONEBIOTIdleCounters &counters);
+    private:
+        enum WakeReason : uint8_t {
+            AWAKE,
+            DEADLINE,
+            LATENCY
+        };
+
+        ONEBIOTIdleMode _mode = ONEBIOT_IDLE_OFF;
+        uint32_t _latencyBound = ONEBIOT_IDLE_LATENCY_BOUND;
+        uint32_t _sleepLength = ONEBIOT_IDLE_MIN_SLEEP;
+        uint32_t _deadline = UINT32_MAX;
+        bool _active = false;
+        // why the last sleep ended, settled by the pass after it
+        WakeReason _wake = AWAKE;
+        uint32_t _since = 0;
+        ONEBIOTIdleCounters _counters;
+
+        void _applySleepMode();
+};
+
+#endif //ONEBIOT_IDLE_H
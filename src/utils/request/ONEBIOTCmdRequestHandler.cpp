@@ -1,51 +1,112 @@
 #ifndef CMD_REQUEST_CPP
 #define CMD_REQUEST_CPP
 
+#include <WiFiUdp.h>
+#include <StreamString.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WiFi.h>
+#include <WebServer.h>
+#include <Update.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
 #include <ESP8266WiFi.h>
 #include <ESP8266WebServer.h>
+#include <Updater.h>
+#endif
+
 #include "utils/request/ONEBIOTCmdRequestHandler.h"
 #include "utils/request/ONEBIOTRequestHandler.h"
 #include "utils/config/ONEBIOTConfig.h"
+#include "utils/fs/ONEBIOTFS.h"
+#include "utils/stats/ONEBIOTStats.h"
+#include "utils/trace/ONEBIOTAllocTrace.h"
+#include "utils/log/ONEBIOTLog.h"
+#include "utils/strings/ONEBIOTStrings.h"
+#include "utils/http/ONEBIOTAdmission.h"
+#include "utils/router/ONEBIOTRouter.h"
+#include "ONEBIOT.h"
+#include "ONEBIOTCallbacks.h"
+
+static const char UNKNOWN_VALUE[] PROGMEM = "<unknown_value>";
+static const char CONTENT_TYPE_MSGPACK[] PROGMEM = "application/msgpack";
+
+// ArduinoJson has no CBOR serializer, clients asking for CBOR only get JSON
+static bool isMsgPack(const String &mediaType) {
+    return strstr_P(mediaType.c_str(), CONTENT_TYPE_MSGPACK) != nullptr || mediaType.indexOf(F("application/x-msgpack")) >= 0;
+}
 
-const char *SECURE_VALUE = "<secure_value>";
-const char *UNKNOWN_VALUE = "<unknown_value>";
-
-const char *CMD_CREDENTIALS = "/cmd/credentials";
-const char *CMD_WIFI = "/cmd/wifi";
-const char *CMD_WIFI_LIST = "/cmd/wifi/list";
-const char *CMD_AP = "/cmd/ap";
-const char *CMD_DNS = "/cmd/dns";
-const char *CMD_STATS = "/cmd/stats";
-const char *CMD_STATS_ESP = "/cmd/stats/esp";
-const char *CMD_STATS_SPIFFS = "/cmd/stats/spiffs";
-const char *CMD_OPTION = "/cmd/option/";
-const char *CMD_RESET = "/cmd/reset";
+// snprintf returns the length it would have written, never send more than the buffer holds
+static size_t cmdWritten(int length, size_t size) {
+    if (length < 0) {
+        return 0;
+    }
+    return (size_t) length < size ? length : size - 1;
+}
 
-__attribute__((weak)) void onNeedRestart(){}
+const char CMD_CREDENTIALS[] PROGMEM = "/cmd/credentials";
+const char CMD_WIFI[] PROGMEM = "/cmd/wifi";
+const char CMD_WIFI_LIST[] PROGMEM = "/cmd/wifi/list";
+const char CMD_AP[] PROGMEM = "/cmd/ap";
+const char CMD_DNS[] PROGMEM = "/cmd/dns";
+const char CMD_CONFIG[] PROGMEM = "/cmd/config";
+const char CMD_STATS[] PROGMEM = "/cmd/stats";
+const char CMD_STATS_ESP[] PROGMEM = "/cmd/stats/esp";
+const char CMD_STATS_CHIP[] PROGMEM = "/cmd/stats/chip";
+const char CMD_STATS_SPIFFS[] PROGMEM = "/cmd/stats/spiffs";
+const char CMD_STATS_HISTORY[] PROGMEM = "/cmd/stats/history";
+const char CMD_STATS_ALLOC[] PROGMEM = "/cmd/stats/alloc";
+const char CMD_LOG[] PROGMEM = "/cmd/log";
+const char CMD_OTA[] PROGMEM = "/cmd/ota";
+const char CMD_EVENTS[] PROGMEM = "/cmd/events";
+const char CMD_MQTT[] PROGMEM = "/cmd/mqtt";
+const char CMD_OPTION[] PROGMEM = "/cmd/option/";
+const char CMD_OPTION_ROUTE[] PROGMEM = "/cmd/option/:name";
+static const char CMD_OPTION_NAME[] PROGMEM = "name";
+const char CMD_RESET[] PROGMEM = "/cmd/reset";
+
+__attribute__((weak)) void onOTAProgress(size_t written){}
+
+ONEBIOTCmdRequestHandler::ONEBIOTCmdRequestHandler(ONEBIOTApp &app) : ONEBIOTRequestHandler(app.getConfig()), _app(&app) {}
 
 bool ONEBIOTCmdRequestHandler::canHandle(HTTPMethod method, String uri) {
-    if (uri == CMD_WIFI_LIST && method == HTTP_GET) {
+    if (ONEBIOTStrings::equals(uri, CMD_WIFI_LIST) && method == HTTP_GET) {
+        return true;
+    } else if (ONEBIOTStrings::equals(uri, CMD_STATS) && method == HTTP_GET) {
+        return true;
+    } else if (ONEBIOTStrings::equals(uri, CMD_STATS_ESP) && method == HTTP_GET) {
+        return true;
+    } else if (ONEBIOTStrings::equals(uri, CMD_STATS_CHIP) && method == HTTP_GET) {
+        return true;
+    } else if (ONEBIOTStrings::equals(uri, CMD_STATS_SPIFFS) && method == HTTP_GET) {
+        return true;
+    } else if (ONEBIOTStrings::equals(uri, CMD_STATS_HISTORY) && method == HTTP_GET) {
         return true;
-    } else if (uri == CMD_STATS && method == HTTP_GET) {
+    } else if (ONEBIOTStrings::equals(uri, CMD_STATS_ALLOC) && method == HTTP_GET) {
         return true;
-    } else if (uri == CMD_STATS_ESP && method == HTTP_GET) {
+    } else if (ONEBIOTStrings::equals(uri, CMD_LOG) && method == HTTP_GET) {
         return true;
-    } else if (uri == CMD_STATS_SPIFFS && method == HTTP_GET) {
+    } else if (ONEBIOTStrings::equals(uri, CMD_OTA) && (method == HTTP_GET || method == HTTP_POST)) {
         return true;
-    } else if (uri == CMD_CREDENTIALS && method == HTTP_POST) {
+    } else if (ONEBIOTStrings::equals(uri, CMD_EVENTS) && method == HTTP_GET) {
         return true;
-    } else if (uri == CMD_RESET && method == HTTP_POST) {
+    } else if (ONEBIOTStrings::equals(uri, CMD_MQTT) && method == HTTP_GET) {
         return true;
-    } else if (uri == CMD_WIFI && (method == HTTP_GET || method == HTTP_POST)) {
+    } else if (ONEBIOTStrings::equals(uri, CMD_CREDENTIALS) && method == HTTP_POST) {
         return true;
-    } else if (uri == CMD_AP && (method == HTTP_GET || method == HTTP_POST)) {
+    } else if (ONEBIOTStrings::equals(uri, CMD_RESET) && method == HTTP_POST) {
         return true;
-    } else if (uri == CMD_DNS && (method == HTTP_GET || method == HTTP_POST)) {
+    } else if (ONEBIOTStrings::equals(uri, CMD_WIFI) && (method == HTTP_GET || method == HTTP_POST)) {
+        return true;
+    } else if (ONEBIOTStrings::equals(uri, CMD_AP) && (method == HTTP_GET || method == HTTP_POST)) {
+        return true;
+    } else if (ONEBIOTStrings::equals(uri, CMD_DNS) && (method == HTTP_GET || method == HTTP_POST)) {
+        return true;
+    } else if (ONEBIOTStrings::equals(uri, CMD_CONFIG) && method == HTTP_PATCH) {
         return true;
     }
 
-    if (uri.indexOf("/cmd/option/") == 0 && (method == HTTP_GET)) {
-        _optionParam = uri.substring(12);
+    if (ONEBIOTStrings::startsWith(uri, CMD_OPTION) && (method == HTTP_GET)) {
+        _optionParam = uri.substring(strlen_P(CMD_OPTION));
         if (_optionParam.isEmpty()) {
             return false;
         }
@@ -54,44 +115,126 @@ bool ONEBIOTCmdRequestHandler::canHandle(HTTPMethod method, String uri) {
     return false;
 }
 
+bool ONEBIOTCmdRequestHandler::addRoutes(ONEBIOTRouter &router) {
+    uint32_t get = ONEBIOT_ROUTE(HTTP_GET);
+    uint32_t post = ONEBIOT_ROUTE(HTTP_POST);
+    return router.on(CMD_WIFI_LIST, get, this)
+        && router.on(CMD_STATS, get, this)
+        && router.on(CMD_STATS_ESP, get, this)
+        && router.on(CMD_STATS_CHIP, get, this)
+        && router.on(CMD_STATS_SPIFFS, get, this)
+        && router.on(CMD_STATS_HISTORY, get, this)
+        && router.on(CMD_STATS_ALLOC, get, this)
+        && router.on(CMD_LOG, get, this)
+        && router.on(CMD_OTA, get | post, this)
+        && router.on(CMD_EVENTS, get, this)
+        && router.on(CMD_MQTT, get, this)
+        && router.on(CMD_CREDENTIALS, post, this)
+        && router.on(CMD_RESET, post, this)
+        && router.on(CMD_WIFI, get | post, this)
+        && router.on(CMD_AP, get | post, this)
+        && router.on(CMD_DNS, get | post, this)
+        && router.on(CMD_CONFIG, ONEBIOT_ROUTE(HTTP_PATCH), this)
+        && router.on(CMD_OPTION_ROUTE, get, this);
+}
+
 bool ONEBIOTCmdRequestHandler::handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) {
+    ONEBIOT_ALLOC_SCOPE(_routeTag(requestUri));
+
     if (!ONEBIOTRequestHandler::_authenticate(server)) {
         ONEBIOTRequestHandler::_sendUnauthorizeResponse(server);
         return true;
     }
 
+    if (ONEBIOTStrings::equals(requestUri, CMD_STATS_HISTORY) && requestMethod == HTTP_GET) {
+        return CMD_STATS_HISTORY_CALLBACK(server);
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_LOG) && requestMethod == HTTP_GET) {
+        return CMD_LOG_CALLBACK(server);
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_EVENTS) && requestMethod == HTTP_GET) {
+        return CMD_EVENTS_CALLBACK(server);
+    }
+
+    // only the JSON form is cached
+    bool msgPack = isMsgPack(server.header(F("Accept")));
+    uint32_t cacheKey = msgPack ? 0 : _cacheKey(server, requestMethod, requestUri);
+    if (cacheKey && _sendCached(server, cacheKey)) {
+        return true;
+    }
+
+    // the core server keeps the body as a C string, which cuts a MessagePack body at
+    // its first zero byte (the integer 0, a map16 or str16 length), only responses use it
+    if (requestMethod != HTTP_GET && isMsgPack(server.header(F("Content-Type")))) {
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+        server.send_P(415, "application/json", PSTR("{\"success\":false,\"message\":\"Send the body as JSON or as a form.\"}"));
+        return true;
+    }
+
     bool needRestart = false;
+    bool restartNow = false;
     __payload = String("");
     DynamicJsonDocument response(2048);
 
-    if (requestUri == CMD_WIFI_LIST && requestMethod == HTTP_GET) {
+    if (ONEBIOTStrings::equals(requestUri, CMD_WIFI_LIST) && requestMethod == HTTP_GET) {
         CMD_WIFI_LIST_CALLBACK(response, server, requestMethod);
-    } else if (requestUri == CMD_STATS && requestMethod == HTTP_GET) {
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_STATS) && requestMethod == HTTP_GET) {
         CMD_STATS_CALLBACK(response);
-    } else if (requestUri == CMD_STATS_ESP && requestMethod == HTTP_GET) {
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_STATS_ESP) && requestMethod == HTTP_GET) {
         CMD_STATS_ESP_CALLBACK(response);
-    } else if (requestUri == CMD_STATS_SPIFFS && requestMethod == HTTP_GET) {
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_STATS_CHIP) && requestMethod == HTTP_GET) {
+        CMD_STATS_CHIP_CALLBACK(response);
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_STATS_SPIFFS) && requestMethod == HTTP_GET) {
         CMD_STATS_SPIFFS_CALLBACK(response);
-    } else if (requestUri == CMD_CREDENTIALS && requestMethod == HTTP_POST) {
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_STATS_ALLOC) && requestMethod == HTTP_GET) {
+        CMD_STATS_ALLOC_CALLBACK(response);
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_CREDENTIALS) && requestMethod == HTTP_POST) {
         CMD_CREDENTIALS_CALLBACK(response, server, requestMethod);
-    }  else if (requestUri == CMD_RESET && requestMethod == HTTP_POST) {
+    }  else if (ONEBIOTStrings::equals(requestUri, CMD_RESET) && requestMethod == HTTP_POST) {
         CMD_RESET_CALLBACK(response);
         needRestart = true;
-    } else if (requestUri == CMD_WIFI && (requestMethod == HTTP_GET || requestMethod == HTTP_POST)) {
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_WIFI) && (requestMethod == HTTP_GET || requestMethod == HTTP_POST)) {
         CMD_WIFI_CALLBACK(response, server, requestMethod);
-    } else if (requestUri == CMD_AP && (requestMethod == HTTP_GET || requestMethod == HTTP_POST)) {
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_AP) && (requestMethod == HTTP_GET || requestMethod == HTTP_POST)) {
         CMD_AP_CALLBACK(response, server, requestMethod);
-    } else if (requestUri == CMD_DNS && (requestMethod == HTTP_GET || requestMethod == HTTP_POST)) {
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_DNS) && (requestMethod == HTTP_GET || requestMethod == HTTP_POST)) {
         CMD_DNS_CALLBACK(response, server, requestMethod);
-    } else if (requestUri.indexOf("/cmd/option/") == 0 && (requestMethod == HTTP_GET)) {
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_CONFIG) && requestMethod == HTTP_PATCH) {
+        CMD_CONFIG_CALLBACK(response, server, requestMethod);
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_MQTT) && requestMethod == HTTP_GET) {
+        CMD_MQTT_CALLBACK(response);
+    } else if (ONEBIOTStrings::equals(requestUri, CMD_OTA) && (requestMethod == HTTP_GET || requestMethod == HTTP_POST)) {
+        CMD_OTA_CALLBACK(response, requestMethod);
+        restartNow = requestMethod == HTTP_POST && response[OBK(success)].as<bool>();
+    } else if (ONEBIOTStrings::startsWith(requestUri, CMD_OPTION) && (requestMethod == HTTP_GET)) {
+        // canHandle() sets it when the handler is added to the server directly
+        if (_router != nullptr) {
+            _optionParam = _router->pathArg(CMD_OPTION_NAME);
+        }
         CMD_OPTION_CALLBACK(response);
     }
 
     if (response.size()) {
         server.sendHeader("Access-Control-Allow-Origin", "*");
-        serializeJson(response, __payload);
-        server.send(200, "application/json", __payload);    
-        if (needRestart) {
+        server.sendHeader("Vary", "Accept");
+        if (msgPack) {
+            _sendMsgPack(server, response);
+        } else {
+            serializeJson(response, __payload);
+            String etag;
+            if (cacheKey && _app->getCache().put(cacheKey, __payload)) {
+                etag = _app->getCache().etag(cacheKey);
+                server.sendHeader("ETag", etag);
+                server.sendHeader("Cache-Control", "no-cache");
+            }
+            // the entry had been evicted, the copy of the client is still the current one
+            if (etag.length() && server.header("If-None-Match") == etag) {
+                server.send(304, "application/json", "");
+            } else {
+                server.send(200, "application/json", __payload);
+            }
+        }
+        if (_app != nullptr && (needRestart || restartNow)) {
+            _app->notify(restartNow ? ONEBIOT_EVENT_RESTART : ONEBIOT_EVENT_NEED_RESTART);
+        } else if (needRestart || restartNow) {
             onNeedRestart();
         }
         return true;
@@ -100,62 +243,158 @@ bool ONEBIOTCmdRequestHandler::handle(ESP8266WebServer& server, HTTPMethod reque
     return false;
 }
 
+bool ONEBIOTCmdRequestHandler::canUpload(String uri) {
+    return ONEBIOTStrings::equals(uri, CMD_OTA);
+}
+
+// Firmware arrives as a multipart upload to POST /cmd/ota?md5=<hex digest>. The Updater
+// collects the chunks into flash sector sized blocks and hashes them on the fly,
+// the image is accepted only when the digest matches.
+void ONEBIOTCmdRequestHandler::upload(ESP8266WebServer& server, String requestUri, HTTPUpload& upload) {
+    if (upload.status == UPLOAD_FILE_START) {
+        _otaAuthorized = ONEBIOTRequestHandler::_authenticate(server);
+        _otaRunning = false;
+        _otaWritten = 0;
+        _otaError = "";
+        if (!_otaAuthorized) {
+            return;
+        }
+
+        if (server.arg("md5").length() != 32) {
+            _otaError = F("Missing MD5 digest of the firmware.");
+            return;
+        }
+
+#ifdef ARDUINO_ARCH_ESP8266
+        WiFiUDP::stopAll();
+#endif
+        uint32_t maxSketchSpace = (ESP.getFreeSketchSpace() - 0x1000) & 0xFFFFF000;
+        if (!Update.begin(maxSketchSpace, U_FLASH) || !Update.setMD5(server.arg("md5").c_str())) {
+            StreamString error;
+            Update.printError(error);
+            _otaError = error;
+            return;
+        }
+
+        _otaRunning = true;
+        ONEBIOT_LOG_INFO(OBI, "OTA update started: %s", upload.filename);
+    } else if (upload.status == UPLOAD_FILE_WRITE && _otaRunning) {
+        if (Update.write(upload.buf, upload.currentSize) != upload.currentSize) {
+            StreamString error;
+            Update.printError(error);
+            _otaError = error;
+            _otaRunning = false;
+            Update.end();
+            return;
+        }
+
+        // report roughly every 64 kB
+        if ((_otaWritten >> 16) != ((_otaWritten + upload.currentSize) >> 16)) {
+            ONEBIOT_LOG_INFO(OBI, "OTA update written %u bytes", _otaWritten + upload.currentSize);
+        }
+        _otaWritten += upload.currentSize;
+        onOTAProgress(_otaWritten);
+    } else if (upload.status == UPLOAD_FILE_END && _otaRunning) {
+        _otaRunning = false;
+        if (!Update.end(true)) {
+            StreamString error;
+            Update.printError(error);
+            _otaError = error;
+            ONEBIOT_LOG_ERROR(OBI, "OTA update failed: %s", _otaError);
+            return;
+        }
+        ONEBIOT_LOG_INFO(OBI, "OTA update finished, %u bytes verified", _otaWritten);
+    } else if (upload.status == UPLOAD_FILE_ABORTED && _otaRunning) {
+        _otaRunning = false;
+        _otaError = F("Upload aborted.");
+        Update.end();
+        ONEBIOT_LOG_ERROR(OBI, "OTA update aborted after %u bytes", _otaWritten);
+    }
+}
+
+bool ONEBIOTCmdRequestHandler::CMD_OTA_CALLBACK(JsonDocument& response, HTTPMethod requestMethod) {
+    if (requestMethod == HTTP_GET) {
+        response[OBK(success)] = true;
+        JsonObject data = response.createNestedObject(OBK(data));
+        data[F("running")] = _otaRunning;
+        data[F("written")] = _otaWritten;
+        data[F("error")] = _otaError;
+        return true;
+    }
+
+    if (_otaError.length() || !Update.isFinished()) {
+        response[OBK(success)] = false;
+        response[OBK(message)] = _otaError.length() ? _otaError : String(F("No firmware has been uploaded."));
+        return true;
+    }
+
+    response[OBK(success)] = true;
+    response[OBK(message)] = F("Firmware updated. Device restarting.");
+    response[F("written")] = _otaWritten;
+    return true;
+}
+
 bool ONEBIOTCmdRequestHandler::CMD_RESET_CALLBACK(JsonDocument& response) {
-    response["success"] = true;
-    response["message"] = "Device restarting";
+    response[OBK(success)] = true;
+    response[OBK(message)] = F("Device restarting");
     return true;
 }
 
 bool ONEBIOTCmdRequestHandler::CMD_CREDENTIALS_CALLBACK(JsonDocument& response, ESP8266WebServer& server, HTTPMethod requestMethod) {
     if (requestMethod != HTTP_POST) {
-        response["success"] = false;
-        response["message"] = "Invalid request.";
-    } else if (server.arg("credentials_user").isEmpty() || server.arg("credentials_password").isEmpty()) {
-        response["success"] = false;
-        response["message"] = "User and password are empty. Operation is not allowed.";
+        response[OBK(success)] = false;
+        response[OBK(message)] = F("Invalid request.");
+    } else if (server.arg(OBK(credentials_user)).isEmpty() || server.arg(OBK(credentials_password)).isEmpty()) {
+        response[OBK(success)] = false;
+        response[OBK(message)] = F("User and password are empty. Operation is not allowed.");
     } else {
-        bool changedUser = _config.setCredentialsUser(server.arg("credentials_user"));
-        bool changedPassword = _config.setCredentialsPassword(server.arg("credentials_password"));
+        bool changedUser = _config.setCredentialsUser(server.arg(OBK(credentials_user)));
+        bool changedPassword = _config.setCredentialsPassword(server.arg(OBK(credentials_password)));
         if (changedUser || changedPassword) {
             _config.save();
         }
         
-        response["success"] = true;
-        response["message"] = "Credentials has been changed.";
+        response[OBK(success)] = true;
+        response[OBK(message)] = F("Credentials has been changed.");
     }
     return true;
 }
 
 bool ONEBIOTCmdRequestHandler::CMD_WIFI_LIST_CALLBACK(JsonDocument& response, ESP8266WebServer& server, HTTPMethod requestMethod) {
     if (requestMethod == HTTP_GET) {
-        int scanCount = WiFi.scanNetworks();
+        // a synchronous scan would stall the server for seconds, the client polls instead,
+        // results are handed out once and the next request asks for a fresh scan
+        int scanCount = WiFi.scanComplete();
+        if (scanCount == WIFI_SCAN_FAILED) {
+            scanCount = WiFi.scanNetworks(true);
+        }
         if (scanCount == WIFI_SCAN_RUNNING) {
-            response["success"] = false;
-            response["message"] = "Scanning...";
+            response[OBK(success)] = false;
+            response[OBK(message)] = F("Scanning...");
         } else if (scanCount == WIFI_SCAN_FAILED) {
-            response["success"] = false;
-            response["message"] = "Scanning failed.";
+            response[OBK(success)] = false;
+            response[OBK(message)] = F("Scanning failed.");
         } else if (scanCount) {
-            response["success"] = true;
+            response[OBK(success)] = true;
 
-            JsonArray data = response.createNestedArray("data");
-            for (int i = 0; i < 5; ++i) { // max 5 wifis :-)
+            JsonArray data = response.createNestedArray(OBK(data));
+            for (int i = 0; i < scanCount && i < 5; ++i) { // max 5 wifis :-)
                 JsonObject network = data.createNestedObject();
-                network["ssid"] = WiFi.SSID(i);
-                network["encryption"] = WiFi.encryptionType(i);
-                network["rssi"] = WiFi.RSSI(i);
-                network["bssid"] = WiFi.BSSIDstr(i);
-                network["channel"] = WiFi.channel(i);
-                network["isHidden"] = WiFi.isHidden(i);
+                network[OBK(ssid)] = WiFi.SSID(i);
+                network[F("encryption")] = WiFi.encryptionType(i);
+                network[OBK(rssi)] = WiFi.RSSI(i);
+                network[OBK(bssid)] = WiFi.BSSIDstr(i);
+                network[OBK(channel)] = WiFi.channel(i);
+                network[F("isHidden")] = WiFi.isHidden(i);
             }
 
             WiFi.scanDelete();
-            if (WiFi.scanComplete() == WIFI_SCAN_FAILED) {
-                WiFi.scanNetworks(true);
-            }
         } else {
-            response["success"] = false;
-            response["message"] = "No WiFi networks founds.";
+            response[OBK(success)] = false;
+            response[OBK(message)] = F("No WiFi networks founds.");
+            // the client polls on, the next answer comes from a new scan
+            WiFi.scanDelete();
+            WiFi.scanNetworks(true);
         }
         return true;
     }
@@ -165,18 +404,18 @@ bool ONEBIOTCmdRequestHandler::CMD_WIFI_LIST_CALLBACK(JsonDocument& response, ES
 bool ONEBIOTCmdRequestHandler::CMD_WIFI_CALLBACK(JsonDocument& response, ESP8266WebServer& server, HTTPMethod requestMethod) {
     if (requestMethod == HTTP_GET) {
         if (WiFi.status() == WL_CONNECTED) {
-            response["success"] = true;
-            JsonObject data = response.createNestedObject("data");
-            data["ssid"] = WiFi.SSID();
-            data["rssi"] = WiFi.RSSI();
-            data["bssid"] = WiFi.BSSIDstr();
-            data["channel"] = WiFi.channel();
-            data["local_ip"] = WiFi.localIP().toString();
-            data["dns_ip"] = WiFi.dnsIP().toString();
-            data["gateway_ip"] = WiFi.gatewayIP().toString();
+            response[OBK(success)] = true;
+            JsonObject data = response.createNestedObject(OBK(data));
+            data[OBK(ssid)] = WiFi.SSID();
+            data[OBK(rssi)] = WiFi.RSSI();
+            data[OBK(bssid)] = WiFi.BSSIDstr();
+            data[OBK(channel)] = WiFi.channel();
+            data[F("local_ip")] = WiFi.localIP().toString();
+            data[F("dns_ip")] = WiFi.dnsIP().toString();
+            data[F("gateway_ip")] = WiFi.gatewayIP().toString();
         } else {
-            response["success"] = false;
-            response["message"] = "ESP is disconnected from the WiFi";
+            response[OBK(success)] = false;
+            response[OBK(message)] = F("ESP is disconnected from the WiFi");
         }
 
         return true;
@@ -185,13 +424,13 @@ bool ONEBIOTCmdRequestHandler::CMD_WIFI_CALLBACK(JsonDocument& response, ESP8266
             return false;
         }
 
-        _config.setWiFiSsid(server.arg("wifi_ssid"));
-        _config.setWiFiPassword(server.arg("wifi_password"));
-        _config.setWiFiEstablish(server.arg("wifi_establish"));
+        _config.setWiFiSsid(server.arg(OBK(wifi_ssid)));
+        _config.setWiFiPassword(server.arg(OBK(wifi_password)));
+        _config.setWiFiEstablish(server.arg(OBK(wifi_establish)));
         _config.save();
 
-        response["success"] = true;
-        response["message"] = "WiFi settings saved. Please restart the ESP.";
+        response[OBK(success)] = true;
+        response[OBK(message)] = F("WiFi settings saved. Please restart the ESP.");
         return true;
     }
     return false;
@@ -200,16 +439,16 @@ bool ONEBIOTCmdRequestHandler::CMD_WIFI_CALLBACK(JsonDocument& response, ESP8266
 bool ONEBIOTCmdRequestHandler::CMD_AP_CALLBACK(JsonDocument& response, ESP8266WebServer& server, HTTPMethod requestMethod) {
     if (requestMethod == HTTP_GET) {
         if (WiFi.getMode() == WIFI_AP_STA) {
-            response["success"] = true;
-            JsonObject data = response.createNestedObject("data");
-            data["ssid"] = WiFi.softAPSSID();
-            data["psk"] = WiFi.softAPPSK();
-            data["ip"] = WiFi.softAPIP().toString();
-            data["mac_address"] = WiFi.softAPmacAddress();
-            data["station_num"] = WiFi.softAPgetStationNum();
+            response[OBK(success)] = true;
+            JsonObject data = response.createNestedObject(OBK(data));
+            data[OBK(ssid)] = WiFi.softAPSSID();
+            data[F("psk")] = WiFi.softAPPSK();
+            data[F("ip")] = WiFi.softAPIP().toString();
+            data[F("mac_address")] = WiFi.softAPmacAddress();
+            data[F("station_num")] = WiFi.softAPgetStationNum();
         } else {
-            response["success"] = false;
-            response["message"] = "ESP has disconected AP";
+            response[OBK(success)] = false;
+            response[OBK(message)] = F("ESP has disconected AP");
         }
         return true;
     } else if (requestMethod == HTTP_POST) {
@@ -217,13 +456,13 @@ bool ONEBIOTCmdRequestHandler::CMD_AP_CALLBACK(JsonDocument& response, ESP8266We
             return false;
         }
 
-        _config.setApSsid(server.arg("ap_ssid"));
-        _config.setApPassword(server.arg("ap_password"));
-        _config.setApEstablish(server.arg("ap_establish"));
+        _config.setApSsid(server.arg(OBK(ap_ssid)));
+        _config.setApPassword(server.arg(OBK(ap_password)));
+        _config.setApEstablish(server.arg(OBK(ap_establish)));
         _config.save();
 
-        response["success"] = true;
-        response["message"] = "AP settings saved. Please restart the ESP.";
+        response[OBK(success)] = true;
+        response[OBK(message)] = F("AP settings saved. Please restart the ESP.");
         return true;
     }
     return false;
@@ -231,136 +470,429 @@ bool ONEBIOTCmdRequestHandler::CMD_AP_CALLBACK(JsonDocument& response, ESP8266We
 
 bool ONEBIOTCmdRequestHandler::CMD_DNS_CALLBACK(JsonDocument& response, ESP8266WebServer& server, HTTPMethod requestMethod) {
     if (requestMethod == HTTP_GET) {
-        response["success"] = true;
-        JsonObject data = response.createNestedObject("data");
-        data["name"] = _config.getDnsName();
-        data["local_name"] = _config.getDnsName() + String(".local");
+        response[OBK(success)] = true;
+        JsonObject data = response.createNestedObject(OBK(data));
+        data[OBK(name)] = _config.getDnsName();
+        data[F("local_name")] = _config.getDnsName() + String(".local");
         return true;
     } else if (requestMethod == HTTP_POST) {
         if (server.args() == 0) {
             return false;
         }
 
-        _config.setDnsName(server.arg("dns_name"));
-        _config.setApEstablish(server.arg("dns_establish"));
+        _config.setDnsName(server.arg(OBK(dns_name)));
+        _config.setDnsEstablish(server.arg(OBK(dns_establish)));
         _config.save();
 
-        response["success"] = true;
-        response["message"] = "DNS settings saved. Please restart the ESP.";
+        response[OBK(success)] = true;
+        response[OBK(message)] = F("DNS settings saved. Please restart the ESP.");
         return true;
     }
     return false;
 }
 
+bool ONEBIOTCmdRequestHandler::CMD_CONFIG_CALLBACK(JsonDocument& response, ESP8266WebServer& server, HTTPMethod requestMethod) {
+    if (requestMethod != HTTP_PATCH) {
+        return false;
+    }
+
+    // one slot per key of patchFilter(), a slot is bigger on 64 bit hosts than on the ESP
+    StaticJsonDocument<JSON_OBJECT_SIZE(11)> filter;
+    _config.patchFilter(filter);
+
+    DynamicJsonDocument patch(1024);
+    DeserializationError error = deserializeJson(patch, server.arg("plain"), DeserializationOption::Filter(filter));
+    if (error || !patch.is<JsonObject>()) {
+        response[OBK(success)] = false;
+        response[OBK(message)] = F("Invalid merge patch.");
+        return true;
+    }
+
+    bool needRestart = false;
+    String message;
+    JsonObject changes = response.createNestedObject(F("changes"));
+    if (!_config.mergePatch(patch.as<JsonObjectConst>(), changes, needRestart, message)) {
+        response.remove(F("changes"));
+        response[OBK(success)] = false;
+        response[OBK(message)] = message;
+        return true;
+    }
+
+    response[OBK(success)] = true;
+    response[F("need_restart")] = needRestart;
+    response[OBK(message)] = changes.size() ? F("Configuration saved.") : F("Nothing to change.");
+    return true;
+}
+
 bool ONEBIOTCmdRequestHandler::CMD_STATS_CALLBACK(JsonDocument& response) {
-    response["success"] = true;
-    
-    FSInfo fs_info;
-    SPIFFS.info(fs_info);
-
-    JsonObject data = response.createNestedObject("data");
-    data["spiffs_total_bytes"] = fs_info.totalBytes;
-    data["spiffs_used_bytes"] = fs_info.usedBytes;
-    data["spiffs_block_size"] = fs_info.blockSize;
-    data["spiffs_page_size"] = fs_info.pageSize;
-    data["spiffs_max_open_files"] = fs_info.maxOpenFiles;
-    data["spiffs_max_path_length"] = fs_info.maxPathLength;
-    
-    data["esp_free_heap"] = ESP.getFreeHeap();
-    data["esp_heap_fragmentation"] = ESP.getHeapFragmentation();
-    data["esp_max_free_block_size"] = ESP.getMaxFreeBlockSize();
-    data["esp_chip_id"] = ESP.getChipId();
-    data["esp_core_version"] = ESP.getCoreVersion();
-    data["esp_sdk_version"] = ESP.getSdkVersion();
-    data["esp_cpu_freq"] = ESP.getCpuFreqMHz();
-    data["esp_sketch_size"] = ESP.getSketchSize();
-    data["esp_free_sketch_space"] = ESP.getFreeSketchSpace();
-    data["esp_sketch_md5"] = ESP.getSketchMD5();
-    data["esp_flash_chip_id"] = ESP.getFlashChipId();
-    data["esp_flash_chip_size"] = ESP.getFlashChipSize();
-    data["esp_flash_chip_real_size"] = ESP.getFlashChipRealSize();
+    response[OBK(success)] = true;
+
+    JsonObject data = response.createNestedObject(OBK(data));
+    _spiffsStatsToJson(data);
+    _espStatsToJson(data);
+    _admissionStatsToJson(data);
+    _idleStatsToJson(data);
 
     return true;
 }
 
 bool ONEBIOTCmdRequestHandler::CMD_STATS_ESP_CALLBACK(JsonDocument& response) {
-    response["success"] = true;
-
-    JsonObject data = response.createNestedObject("data");
-    data["esp_free_heap"] = ESP.getFreeHeap();
-    data["esp_heap_fragmentation"] = ESP.getHeapFragmentation();
-    data["esp_max_free_block_size"] = ESP.getMaxFreeBlockSize();
-    data["esp_chip_id"] = ESP.getChipId();
-    data["esp_core_version"] = ESP.getCoreVersion();
-    data["esp_sdk_version"] = ESP.getSdkVersion();
-    data["esp_cpu_freq"] = ESP.getCpuFreqMHz();
-    data["esp_sketch_size"] = ESP.getSketchSize();
-    data["esp_free_sketch_space"] = ESP.getFreeSketchSpace();
-    data["esp_sketch_md5"] = ESP.getSketchMD5();
-    data["esp_flash_chip_id"] = ESP.getFlashChipId();
-    data["esp_flash_chip_size"] = ESP.getFlashChipSize();
-    data["esp_flash_chip_real_size"] = ESP.getFlashChipRealSize();
+    response[OBK(success)] = true;
+
+    JsonObject data = response.createNestedObject(OBK(data));
+    _espStatsToJson(data);
+
+    return true;
+}
+
+bool ONEBIOTCmdRequestHandler::CMD_STATS_CHIP_CALLBACK(JsonDocument& response) {
+    response[OBK(success)] = true;
+
+    JsonObject data = response.createNestedObject(OBK(data));
+    _chipInfoToJson(data);
 
     return true;
 }
 
 bool ONEBIOTCmdRequestHandler::CMD_STATS_SPIFFS_CALLBACK(JsonDocument& response) {
-    response["success"] = true;
+    response[OBK(success)] = true;
 
-    FSInfo fs_info;
-    SPIFFS.info(fs_info);
-    
-    JsonObject data = response.createNestedObject("data");
-    data["spiffs_total_bytes"] = fs_info.totalBytes;
-    data["spiffs_used_bytes"] = fs_info.usedBytes;
-    data["spiffs_block_size"] = fs_info.blockSize;
-    data["spiffs_page_size"] = fs_info.pageSize;
-    data["spiffs_max_open_files"] = fs_info.maxOpenFiles;
-    data["spiffs_max_path_length"] = fs_info.maxPathLength;
+    JsonObject data = response.createNestedObject(OBK(data));
+    _spiffsStatsToJson(data);
+
+    return true;
+}
+
+// Streams the sampled series row by row, so the history never needs a JsonDocument.
+// step=N aggregates N samples into one row by agg=avg|min|max, limit=N keeps the newest N rows.
+bool ONEBIOTCmdRequestHandler::CMD_STATS_HISTORY_CALLBACK(ESP8266WebServer& server) {
+    server.sendHeader("Access-Control-Allow-Origin", "*");
+    if (_app == nullptr) {
+        server.send_P(200, "application/json", PSTR("{\"success\":false,\"message\":\"Stats history is not available.\"}"));
+        return true;
+    }
+
+#ifdef ONEBIOT_THREAD_SAFE
+    // the loop task keeps sampling while the rows are sent, they come from a copy
+    ONEBIOTStats stats;
+    _app->getStats().snapshot(stats);
+#else
+    ONEBIOTStats &stats = _app->getStats();
+#endif
+    long stepArg = server.hasArg("step") ? server.arg("step").toInt() : 1;
+    size_t step = stepArg < 1 ? 1 : stepArg;
+    size_t rows = (stats.size() + step - 1) / step;
+    long limitArg = server.hasArg("limit") ? server.arg("limit").toInt() : rows;
+    size_t limit = limitArg < 0 ? 0 : limitArg;
+    size_t skipRows = rows > limit ? rows - limit : 0;
+    String agg = server.hasArg("agg") ? server.arg("agg") : String("avg");
+    if (agg != "avg" && agg != "min" && agg != "max") {
+        server.send_P(400, "application/json", PSTR("{\"success\":false,\"message\":\"agg has to be avg, min or max.\"}"));
+        return true;
+    }
+
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+
+    char buffer[256];
+    int length = snprintf_P(buffer, sizeof(buffer),
+        PSTR("{\"success\":true,\"interval\":%u,\"step\":%u,\"agg\":\"%s\","
+        "\"fields\":[\"timestamp\",\"free_heap\",\"heap_fragmentation\",\"max_free_block_size\",\"rssi\",\"loop_latency\"],\"data\":["),
+        (unsigned) stats.getInterval(), (unsigned) step, agg.c_str());
+    server.sendContent(buffer, cmdWritten(length, sizeof(buffer)));
+
+    ONEBIOTStatsSample sample;
+    stats.rewind(sample);
+
+    size_t row = 0;
+    size_t inRow = 0;
+    int64_t sum[5] = {0, 0, 0, 0, 0};
+    int32_t result[5];
+    size_t used = 0;
+    for (size_t i = 0; stats.next(i, sample); i++) {
+        int32_t values[5] = {(int32_t) sample.free_heap, sample.heap_fragmentation, (int32_t) sample.max_free_block_size, sample.rssi, (int32_t) sample.loop_latency};
+        for (int f = 0; f < 5; f++) {
+            if (inRow == 0) {
+                sum[f] = values[f];
+                result[f] = values[f];
+            } else {
+                sum[f] += values[f];
+                if (agg == "min" && values[f] < result[f]) {
+                    result[f] = values[f];
+                } else if (agg == "max" && values[f] > result[f]) {
+                    result[f] = values[f];
+                }
+            }
+        }
+        inRow++;
+
+        if (inRow < step && i + 1 < stats.size()) {
+            continue;
+        }
+
+        if (row >= skipRows) {
+            if (agg != "min" && agg != "max") {
+                for (int f = 0; f < 5; f++) {
+                    result[f] = (int32_t) (sum[f] / (int64_t) inRow);
+                }
+            }
+
+            if (used > sizeof(buffer) - 80) {
+                server.sendContent(buffer, used);
+                used = 0;
+            }
+            length = snprintf_P(buffer + used, sizeof(buffer) - used, PSTR("%s[%u,%d,%d,%d,%d,%d]"),
+                row > skipRows ? "," : "", (unsigned) sample.timestamp, result[0], result[1], result[2], result[3], result[4]);
+            used += cmdWritten(length, sizeof(buffer) - used);
+        }
+        row++;
+        inRow = 0;
+    }
 
+    server.sendContent(buffer, used);
+    server.sendContent("]}");
+    server.sendContent("");
     return true;
 }
+
+bool ONEBIOTCmdRequestHandler::CMD_STATS_ALLOC_CALLBACK(JsonDocument& response) {
+#ifdef ONEBIOT_ALLOC_TRACE
+    response[OBK(success)] = true;
+
+    JsonObject data = response.createNestedObject(OBK(data));
+    data[F("untracked")] = ONEBIOTAllocTrace::untracked();
+    JsonArray tags = data.createNestedArray(F("tags"));
+
+    ONEBIOTAllocTraceCounters counters;
+    for (size_t i = 0; ONEBIOTAllocTrace::get(i, counters); i++) {
+        JsonObject tag = tags.createNestedObject();
+        tag[F("tag")] = FPSTR(counters.tag);
+        tag[F("count")] = counters.count;
+        tag[F("frees")] = counters.frees;
+        tag[F("bytes")] = counters.bytes;
+        tag[F("live")] = counters.live;
+        tag[F("peak")] = counters.peak;
+    }
+#else
+    response[OBK(success)] = false;
+    response[OBK(message)] = F("Allocation tracer is not compiled in.");
+#endif
+    return true;
+}
+
+// Only GET routes which depend on nothing but the config and the network state.
+uint32_t ONEBIOTCmdRequestHandler::_cacheKey(ESP8266WebServer& server, HTTPMethod requestMethod, const String &uri) {
+    if (_app == nullptr || requestMethod != HTTP_GET) {
+        return 0;
+    }
+    if (ONEBIOTStrings::equals(uri, CMD_AP) || ONEBIOTStrings::equals(uri, CMD_DNS) || ONEBIOTStrings::equals(uri, CMD_STATS_CHIP) || ONEBIOTStrings::startsWith(uri, CMD_OPTION)) {
+        return _app->getCache().key(uri, server);
+    }
+    return 0;
+}
+
+bool ONEBIOTCmdRequestHandler::_sendCached(ESP8266WebServer& server, uint32_t key) {
+    ONEBIOTResponseCache &cache = _app->getCache();
+    const String *payload = cache.get(key);
+    if (payload == nullptr) {
+        return false;
+    }
+
+    String etag = cache.etag(key);
+    server.sendHeader("Access-Control-Allow-Origin", "*");
+    server.sendHeader("Vary", "Accept");
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Cache-Control", "no-cache");
+    if (server.header("If-None-Match") == etag) {
+        server.send(304, "application/json", "");
+    } else {
+        server.send(200, "application/json", *payload);
+    }
+    return true;
+}
+
+// The length is known up front, so the binary form goes out in pieces without a String copy.
+void ONEBIOTCmdRequestHandler::_sendMsgPack(ESP8266WebServer& server, JsonDocument& response) {
+    server.setContentLength(measureMsgPack(response));
+    server.send_P(200, CONTENT_TYPE_MSGPACK, "", 0);
+
+    ONEBIOTContentPrint content(server);
+    serializeMsgPack(response, content);
+    content.send();
+}
+
+// Route constants are used as tags, so every request of a route shares one counter.
+PGM_P ONEBIOTCmdRequestHandler::_routeTag(const String &uri) {
+    PGM_P routes[] = {
+        CMD_CREDENTIALS, CMD_WIFI, CMD_WIFI_LIST, CMD_AP, CMD_DNS, CMD_CONFIG,
+        CMD_STATS, CMD_STATS_ESP, CMD_STATS_CHIP, CMD_STATS_SPIFFS, CMD_STATS_HISTORY, CMD_STATS_ALLOC, CMD_LOG, CMD_OTA, CMD_EVENTS, CMD_MQTT, CMD_RESET
+    };
+    for (PGM_P route : routes) {
+        if (ONEBIOTStrings::equals(uri, route)) {
+            return route;
+        }
+    }
+    return CMD_OPTION;
+}
+
+// Streams the log records newer than since= as text lines, X-Log-Sequence is the cursor for the next call.
+bool ONEBIOTCmdRequestHandler::CMD_LOG_CALLBACK(ESP8266WebServer& server) {
+    uint32_t since = server.hasArg("since") ? strtoul(server.arg("since").c_str(), nullptr, 10) : 0;
+
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.sendHeader("Access-Control-Allow-Origin", "*");
+    server.sendHeader("Cache-Control", "no-cache");
+    server.sendHeader("X-Log-Sequence", String(ONEBIOTLog::getSequence()));
+    server.sendHeader("X-Log-Dropped", String(ONEBIOTLog::getDropped()));
+    server.send(200, "text/plain", "");
+
+    ONEBIOTContentPrint content(server);
+    ONEBIOTLog::printSince(since, content);
+    content.send();
+    server.sendContent("");
+    return true;
+}
+
+bool ONEBIOTCmdRequestHandler::CMD_MQTT_CALLBACK(JsonDocument& response) {
+    if (_app == nullptr) {
+        response[OBK(success)] = false;
+        response[OBK(message)] = F("MQTT is not available.");
+        return true;
+    }
+
+    ONEBIOTMqttCounters counters;
+    _app->getMqtt().getCounters(counters);
+    response[OBK(success)] = true;
+    JsonObject data = response.createNestedObject(OBK(data));
+    data[F("connected")] = counters.connected;
+    data[F("queue_depth")] = counters.queue_depth;
+    data[F("spool_bytes")] = counters.spool_bytes;
+    data[F("dropped")] = counters.dropped;
+    data[F("last_latency")] = counters.last_latency;
+    data[F("max_latency")] = counters.max_latency;
+    return true;
+}
+
+// The connection stays open, ONEBIOTApp::loop() pushes the updates from now on.
+bool ONEBIOTCmdRequestHandler::CMD_EVENTS_CALLBACK(ESP8266WebServer& server) {
+    server.sendHeader("Access-Control-Allow-Origin", "*");
+    if (_app == nullptr) {
+        server.send_P(200, "application/json", PSTR("{\"success\":false,\"message\":\"Events are not available.\"}"));
+    } else if (!_app->getEvents().subscribe(server.client())) {
+        server.send_P(503, "application/json", PSTR("{\"success\":false,\"message\":\"Too many subscribers.\"}"));
+    }
+    return true;
+}
+
+void ONEBIOTCmdRequestHandler::_espStatsToJson(JsonObject data) {
+    ONEBIOTStatsSample heap;
+    ONEBIOTStats::readHeap(heap);
+
+    data[F("esp_free_heap")] = heap.free_heap;
+    data[F("esp_heap_fragmentation")] = heap.heap_fragmentation;
+    data[F("esp_max_free_block_size")] = heap.max_free_block_size;
+    _chipInfoToJson(data);
+}
+
+void ONEBIOTCmdRequestHandler::_chipInfoToJson(JsonObject data) {
+    const ONEBIOTStatsChipInfo &info = ONEBIOTStats::chipInfo();
+
+    data[F("esp_chip_id")] = info.chip_id;
+    data[F("esp_core_version")] = info.core_version.c_str();
+    data[F("esp_sdk_version")] = info.sdk_version.c_str();
+    data[F("esp_cpu_freq")] = info.cpu_freq;
+    data[F("esp_sketch_size")] = info.sketch_size;
+    data[F("esp_free_sketch_space")] = info.free_sketch_space;
+    data[F("esp_sketch_md5")] = info.sketch_md5.c_str();
+    data[F("esp_flash_chip_id")] = info.flash_chip_id;
+    data[F("esp_flash_chip_size")] = info.flash_chip_size;
+    data[F("esp_flash_chip_real_size")] = info.flash_chip_real_size;
+}
+
+void ONEBIOTCmdRequestHandler::_spiffsStatsToJson(JsonObject data) {
+    FSInfo fs_info;
+    ONEBIOTFS::info(_config.getFileSystem(), fs_info);
+
+    data[F("spiffs_total_bytes")] = fs_info.totalBytes;
+    data[F("spiffs_used_bytes")] = fs_info.usedBytes;
+    data[F("spiffs_block_size")] = fs_info.blockSize;
+    data[F("spiffs_page_size")] = fs_info.pageSize;
+    data[F("spiffs_max_open_files")] = fs_info.maxOpenFiles;
+    data[F("spiffs_max_path_length")] = fs_info.maxPathLength;
+}
+
+void ONEBIOTCmdRequestHandler::_admissionStatsToJson(JsonObject data) {
+    ONEBIOTAdmissionCounters counters;
+    ONEBIOTAdmission::getCounters(counters);
+
+    data[F("admission_admitted")] = counters.admitted;
+    data[F("admission_limited")] = counters.limited;
+    data[F("admission_blocked")] = counters.blocked;
+    data[F("admission_auth_failures")] = counters.auth_failures;
+    data[F("admission_clients")] = counters.clients;
+}
+
+void ONEBIOTCmdRequestHandler::_idleStatsToJson(JsonObject data) {
+    if (_app == nullptr) {
+        return;
+    }
+
+    ONEBIOTIdle &idle = _app->getIdle();
+    ONEBIOTIdleCounters counters;
+    idle.getCounters(counters);
+    data[F("idle_mode")] = (uint8_t) idle.getMode();
+    data[F("idle_latency_bound")] = idle.getLatencyBound();
+    data[F("idle_ratio")] = idle.getIdleRatio();
+    data[F("idle_loop_passes")] = counters.passes;
+    data[F("idle_passes")] = counters.idle_passes;
+    data[F("idle_sleeps")] = counters.sleeps;
+    data[F("idle_slept")] = counters.slept;
+    data[F("idle_wake_deadline")] = counters.wake_deadline;
+    data[F("idle_wake_latency")] = counters.wake_latency;
+    data[F("idle_wake_network")] = counters.wake_network;
+}
+
 bool ONEBIOTCmdRequestHandler::CMD_OPTION_CALLBACK(JsonDocument& response) {
-    if (_optionParam == "client_name") {
-        response["success"] = true;
-        JsonObject data = response.createNestedObject("data");
-        data["name"] = _optionParam;
-        data["value"] = _config.getClientName();
-    } else if (_optionParam == "credentials_user") {
-        response["success"] = true;
-        JsonObject data = response.createNestedObject("data");
-        data["name"] = _optionParam;
-        data["value"] = SECURE_VALUE;
-    } else if (_optionParam == "credentials_password") {
-        response["success"] = true;
-        JsonObject data = response.createNestedObject("data");
-        data["name"] = _optionParam;
-        data["value"] = SECURE_VALUE;
-    } else if (_optionParam == "ap_ssid") {
-        response["success"] = true;
-        JsonObject data = response.createNestedObject("data");
-        data["name"] = _optionParam;
-        data["value"] = _config.getConfig().ap_ssid;
-    } else if (_optionParam == "ap_password") {
-        response["success"] = true;
-        JsonObject data = response.createNestedObject("data");
-        data["name"] = _optionParam;
-        data["value"] = SECURE_VALUE;
-    } else if (_optionParam == "wifi_ssid") {
-        response["success"] = true;
-        JsonObject data = response.createNestedObject("data");
-        data["name"] = _optionParam;
-        data["value"] = _config.getConfig().wifi_ssid;
-    } else if (_optionParam == "wifi_password") {
-        response["success"] = true;
-        JsonObject data = response.createNestedObject("data");
-        data["name"] = _optionParam;
-        data["value"] = SECURE_VALUE;
+    if (ONEBIOTStrings::equals(_optionParam, ONEBIOT_KEY_client_name)) {
+        response[OBK(success)] = true;
+        JsonObject data = response.createNestedObject(OBK(data));
+        data[OBK(name)] = _optionParam;
+        data[OBK(value)] = _config.getClientName();
+    } else if (ONEBIOTStrings::equals(_optionParam, ONEBIOT_KEY_credentials_user)) {
+        response[OBK(success)] = true;
+        JsonObject data = response.createNestedObject(OBK(data));
+        data[OBK(name)] = _optionParam;
+        data[OBK(value)] = FPSTR(SECURE_VALUE);
+    } else if (ONEBIOTStrings::equals(_optionParam, ONEBIOT_KEY_credentials_password)) {
+        response[OBK(success)] = true;
+        JsonObject data = response.createNestedObject(OBK(data));
+        data[OBK(name)] = _optionParam;
+        data[OBK(value)] = FPSTR(SECURE_VALUE);
+    } else if (ONEBIOTStrings::equals(_optionParam, ONEBIOT_KEY_ap_ssid)) {
+        response[OBK(success)] = true;
+        JsonObject data = response.createNestedObject(OBK(data));
+        data[OBK(name)] = _optionParam;
+        data[OBK(value)] = _config.getConfig().ap_ssid;
+    } else if (ONEBIOTStrings::equals(_optionParam, ONEBIOT_KEY_ap_password)) {
+        response[OBK(success)] = true;
+        JsonObject data = response.createNestedObject(OBK(data));
+        data[OBK(name)] = _optionParam;
+        data[OBK(value)] = FPSTR(SECURE_VALUE);
+    } else if (ONEBIOTStrings::equals(_optionParam, ONEBIOT_KEY_wifi_ssid)) {
+        response[OBK(success)] = true;
+        JsonObject data = response.createNestedObject(OBK(data));
+        data[OBK(name)] = _optionParam;
+        data[OBK(value)] = _config.getConfig().wifi_ssid;
+    } else if (ONEBIOTStrings::equals(_optionParam, ONEBIOT_KEY_wifi_password)) {
+        response[OBK(success)] = true;
+        JsonObject data = response.createNestedObject(OBK(data));
+        data[OBK(name)] = _optionParam;
+        data[OBK(value)] = FPSTR(SECURE_VALUE);
     } else {
-        response["success"] = false;
-        JsonObject data = response.createNestedObject("data");
-        data["name"] = _optionParam;
-        data["value"] = UNKNOWN_VALUE;
+        response[OBK(success)] = false;
+        JsonObject data = response.createNestedObject(OBK(data));
+        data[OBK(name)] = _optionParam;
+        data[OBK(value)] = FPSTR(UNKNOWN_VALUE);
     }
     return true;   
 }
@@ -2,16 +2,28 @@
 #define CMD_REQUEST_H
 
 #include <ArduinoJson.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WebServer.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
 #include <ESP8266WebServer.h>
+#endif
+
 #include "utils/config/ONEBIOTConfig.h"
 #include "utils/request/ONEBIOTRequestHandler.h"
 
+class ONEBIOTApp;
+
 class ONEBIOTCmdRequestHandler : public ONEBIOTRequestHandler {
     public:
         ONEBIOTCmdRequestHandler(ONEBIOTConfig config) : ONEBIOTRequestHandler(config) {}
+        ONEBIOTCmdRequestHandler(ONEBIOTApp &app);
         bool canHandle(HTTPMethod method, String uri) override;
+        bool addRoutes(ONEBIOTRouter &router) override;
 
         bool handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) override;
+        bool canUpload(String uri) override;
+        void upload(ESP8266WebServer& server, String requestUri, HTTPUpload& upload) override;
     protected:
         bool CMD_RESET_CALLBACK(JsonDocument& response);
         bool CMD_WIFI_LIST_CALLBACK(JsonDocument& response, ESP8266WebServer& server, HTTPMethod requestMethod);
@@ -19,12 +31,34 @@ class ONEBIOTCmdRequestHandler : public ONEBIOTRequestHandler {
         bool CMD_CREDENTIALS_CALLBACK(JsonDocument& response, ESP8266WebServer& server, HTTPMethod requestMethod);
         bool CMD_AP_CALLBACK(JsonDocument& response, ESP8266WebServer& server, HTTPMethod requestMethod);
         bool CMD_DNS_CALLBACK(JsonDocument& response, ESP8266WebServer& server, HTTPMethod requestMethod);
+        bool CMD_CONFIG_CALLBACK(JsonDocument& response, ESP8266WebServer& server, HTTPMethod requestMethod);
         bool CMD_STATS_CALLBACK(JsonDocument& response);
         bool CMD_STATS_ESP_CALLBACK(JsonDocument& response);
+        bool CMD_STATS_CHIP_CALLBACK(JsonDocument& response);
         bool CMD_STATS_SPIFFS_CALLBACK(JsonDocument& response);
+        bool CMD_STATS_HISTORY_CALLBACK(ESP8266WebServer& server);
+        bool CMD_STATS_ALLOC_CALLBACK(JsonDocument& response);
+        bool CMD_LOG_CALLBACK(ESP8266WebServer& server);
+        bool CMD_EVENTS_CALLBACK(ESP8266WebServer& server);
+        bool CMD_MQTT_CALLBACK(JsonDocument& response);
         bool CMD_OPTION_CALLBACK(JsonDocument& response);
+        bool CMD_OTA_CALLBACK(JsonDocument& response, HTTPMethod requestMethod);
+        ONEBIOTApp *_app = nullptr;
     private:
+        void _espStatsToJson(JsonObject data);
+        void _chipInfoToJson(JsonObject data);
+        void _spiffsStatsToJson(JsonObject data);
+        void _admissionStatsToJson(JsonObject data);
+        void _idleStatsToJson(JsonObject data);
+        PGM_P _routeTag(const String &uri);
+        uint32_t _cacheKey(ESP8266WebServer& server, HTTPMethod requestMethod, const String &uri);
+        bool _sendCached(ESP8266WebServer& server, uint32_t key);
+        void _sendMsgPack(ESP8266WebServer& server, JsonDocument& response);
         String _optionParam;
+        bool _otaAuthorized = false;
+        bool _otaRunning = false;
+        size_t _otaWritten = 0;
+        String _otaError;
         String __payload;
 };
 
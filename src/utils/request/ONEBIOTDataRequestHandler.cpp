@@ -0,0 +1,112 @@
+#ifndef DATA_REQUEST_CPP
+#define DATA_REQUEST_CPP
+
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WebServer.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
+#include <ESP8266WebServer.h>
+#endif
+
+#include "utils/request/ONEBIOTDataRequestHandler.h"
+#include "utils/request/ONEBIOTRequestHandler.h"
+#include "utils/timeseries/ONEBIOTTimeSeries.h"
+#include "utils/router/ONEBIOTRouter.h"
+
+const char *CMD_DATA = "/cmd/data";
+
+bool ONEBIOTDataRequestHandler::canHandle(HTTPMethod method, String uri) {
+    return uri == CMD_DATA && method == HTTP_GET;
+}
+
+bool ONEBIOTDataRequestHandler::addRoutes(ONEBIOTRouter &router) {
+    return router.on(CMD_DATA, ONEBIOT_ROUTE(HTTP_GET), this);
+}
+
+bool ONEBIOTDataRequestHandler::handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) {
+    if (!ONEBIOTRequestHandler::_authenticate(server)) {
+        ONEBIOTRequestHandler::_sendUnauthorizeResponse(server);
+        return true;
+    }
+
+    if (requestUri == CMD_DATA && requestMethod == HTTP_GET) {
+        return CMD_DATA_CALLBACK(server);
+    }
+    return false;
+}
+
+// Streams the records between from= and to= (unix seconds, both inclusive).
+// Without step= every record is sent as [time,value], with it the records are
+// folded into buckets of step seconds sent as [start,avg,min,max,count].
+bool ONEBIOTDataRequestHandler::CMD_DATA_CALLBACK(ESP8266WebServer& server) {
+    uint32_t from = server.hasArg("from") ? strtoul(server.arg("from").c_str(), NULL, 10) : 0;
+    uint32_t to = server.hasArg("to") ? strtoul(server.arg("to").c_str(), NULL, 10) : UINT32_MAX;
+    uint32_t step = server.hasArg("step") ? strtoul(server.arg("step").c_str(), NULL, 10) : 0;
+
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.sendHeader("Access-Control-Allow-Origin", "*");
+    server.send(200, "application/json", "");
+
+    ONEBIOTContentPrint content(server);
+    content.print("{\"success\":true,\"step\":");
+    content.print(step);
+    content.print(",\"data\":[");
+
+    ONEBIOTTimeSeriesCursor cursor;
+    ONEBIOTTimeSeriesRecord record;
+    _series.query(cursor, from, to);
+
+    bool first = true;
+    uint32_t bucket = 0;
+    uint32_t count = 0;
+    float sum = 0, min = 0, max = 0;
+    while (true) {
+        bool hasRecord = _series.next(cursor, record);
+        uint32_t recordBucket = hasRecord && step ? from + (record.timestamp - from) / step * step : 0;
+
+        if (step && count > 0 && (!hasRecord || recordBucket != bucket)) {
+            content.print(first ? "[" : ",[");
+            content.print(bucket);
+            content.print(',');
+            content.print(sum / count, 3);
+            content.print(',');
+            content.print(min, 3);
+            content.print(',');
+            content.print(max, 3);
+            content.print(',');
+            content.print(count);
+            content.print(']');
+            first = false;
+            count = 0;
+        }
+
+        if (!hasRecord) {
+            break;
+        }
+
+        if (!step) {
+            content.print(first ? "[" : ",[");
+            content.print(record.timestamp);
+            content.print(',');
+            content.print(record.value, 3);
+            content.print(']');
+            first = false;
+        } else if (count == 0) {
+            bucket = recordBucket;
+            count = 1;
+            sum = min = max = record.value;
+        } else {
+            count++;
+            sum += record.value;
+            min = record.value < min ? record.value : min;
+            max = record.value > max ? record.value : max;
+        }
+    }
+
+    content.print("]}");
+    content.send();
+    server.sendContent("");
+    return true;
+}
+
+#endif //DATA_REQUEST_CPP
@@ -0,0 +1,27 @@
+#ifndef DATA_REQUEST_H
+#define DATA_REQUEST_H
+
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WebServer.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
+#include <ESP8266WebServer.h>
+#endif
+
+#include "utils/config/ONEBIOTConfig.h"
+#include "utils/request/ONEBIOTRequestHandler.h"
+#include "utils/timeseries/ONEBIOTTimeSeries.h"
+
+class ONEBIOTDataRequestHandler : public ONEBIOTRequestHandler {
+    public:
+        ONEBIOTDataRequestHandler(ONEBIOTConfig config, ONEBIOTTimeSeries &series) : ONEBIOTRequestHandler(config), _series(series) {}
+        bool canHandle(HTTPMethod method, String uri) override;
+        bool addRoutes(ONEBIOTRouter &router) override;
+        bool handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) override;
+    protected:
+        bool CMD_DATA_CALLBACK(ESP8266WebServer& server);
+    private:
+        ONEBIOTTimeSeries &_series;
+};
+
+#endif //DATA_REQUEST_H
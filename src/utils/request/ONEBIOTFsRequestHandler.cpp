@@ -0,0 +1,282 @@
+#ifndef FS_REQUEST_CPP
+#define FS_REQUEST_CPP
+
+#include <FS.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WebServer.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
+#include <ESP8266WebServer.h>
+#endif
+
+#include "utils/request/ONEBIOTFsRequestHandler.h"
+#include "utils/request/ONEBIOTRequestHandler.h"
+#include "utils/config/ONEBIOTConfig.h"
+#include "utils/fs/ONEBIOTFS.h"
+#include "utils/log/ONEBIOTLog.h"
+#include "utils/router/ONEBIOTRouter.h"
+
+const char *CMD_FS_LIST = "/cmd/fs/list";
+const char *CMD_FS_DOWNLOAD = "/cmd/fs/download";
+const char *CMD_FS_UPLOAD = "/cmd/fs/upload";
+const char *CMD_FS_DELETE = "/cmd/fs/delete";
+const char *CMD_FS_RENAME = "/cmd/fs/rename";
+const char *FS_UPLOAD_SUFFIX = ".tmp";
+const char *FS_BACKUP_SUFFIX = ".bak";
+
+// entries of one /cmd/fs/list page when no limit= is given
+const int FS_LIST_DEFAULT_LIMIT = 20;
+
+bool ONEBIOTFsRequestHandler::canHandle(HTTPMethod method, String uri) {
+    if (uri == CMD_FS_LIST && method == HTTP_GET) {
+        return true;
+    } else if (uri == CMD_FS_DOWNLOAD && method == HTTP_GET) {
+        return true;
+    } else if (uri == CMD_FS_UPLOAD && method == HTTP_POST) {
+        return true;
+    } else if (uri == CMD_FS_DELETE && method == HTTP_POST) {
+        return true;
+    } else if (uri == CMD_FS_RENAME && method == HTTP_POST) {
+        return true;
+    }
+    return false;
+}
+
+bool ONEBIOTFsRequestHandler::addRoutes(ONEBIOTRouter &router) {
+    return router.on(CMD_FS_LIST, ONEBIOT_ROUTE(HTTP_GET), this)
+        && router.on(CMD_FS_DOWNLOAD, ONEBIOT_ROUTE(HTTP_GET), this)
+        && router.on(CMD_FS_UPLOAD, ONEBIOT_ROUTE(HTTP_POST), this)
+        && router.on(CMD_FS_DELETE, ONEBIOT_ROUTE(HTTP_POST), this)
+        && router.on(CMD_FS_RENAME, ONEBIOT_ROUTE(HTTP_POST), this);
+}
+
+bool ONEBIOTFsRequestHandler::handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) {
+    if (!ONEBIOTRequestHandler::_authenticate(server)) {
+        ONEBIOTRequestHandler::_sendUnauthorizeResponse(server);
+        return true;
+    }
+
+    if (requestUri == CMD_FS_LIST && requestMethod == HTTP_GET) {
+        return CMD_FS_LIST_CALLBACK(server);
+    }
+
+    __payload = String("");
+    DynamicJsonDocument response(256);
+
+    if (requestUri == CMD_FS_DOWNLOAD && requestMethod == HTTP_GET) {
+        if (CMD_FS_DOWNLOAD_CALLBACK(response, server)) {
+            return true;
+        }
+    } else if (requestUri == CMD_FS_UPLOAD && requestMethod == HTTP_POST) {
+        CMD_FS_UPLOAD_CALLBACK(response);
+    } else if (requestUri == CMD_FS_DELETE && requestMethod == HTTP_POST) {
+        CMD_FS_DELETE_CALLBACK(response, server);
+    } else if (requestUri == CMD_FS_RENAME && requestMethod == HTTP_POST) {
+        CMD_FS_RENAME_CALLBACK(response, server);
+    }
+
+    if (response.size()) {
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+        serializeJson(response, __payload);
+        server.send(200, "application/json", __payload);
+        return true;
+    }
+
+    return false;
+}
+
+bool ONEBIOTFsRequestHandler::canUpload(String uri) {
+    return uri == CMD_FS_UPLOAD;
+}
+
+// Chunks are appended to "<path>.tmp" as they arrive and the finished file is moved
+// into place, a broken upload never replaces the previous version of the file.
+void ONEBIOTFsRequestHandler::upload(ESP8266WebServer& server, String requestUri, HTTPUpload& upload) {
+    FS &fs = _config.getFileSystem();
+
+    if (upload.status == UPLOAD_FILE_START) {
+        _uploadAuthorized = ONEBIOTRequestHandler::_authenticate(server);
+        _uploadPath = server.hasArg("path") ? server.arg("path") : String("/") + upload.filename;
+        _uploadError = "";
+        _uploadWritten = 0;
+        if (!_uploadAuthorized) {
+            return;
+        }
+
+        if (!_isValidPath(_uploadPath + FS_UPLOAD_SUFFIX)) {
+            _uploadError = "Invalid path.";
+            return;
+        }
+
+        _uploadFile = fs.open(_uploadPath + FS_UPLOAD_SUFFIX, "w");
+        if (!_uploadFile) {
+            _uploadError = "Could not create the file.";
+        }
+    } else if (upload.status == UPLOAD_FILE_WRITE && _uploadFile) {
+        if (!_hasSpaceFor(upload.currentSize)) {
+            _uploadError = "Not enough free space.";
+        } else if (_uploadFile.write(upload.buf, upload.currentSize) != upload.currentSize) {
+            _uploadError = "Writing the file failed.";
+        } else {
+            _uploadWritten += upload.currentSize;
+            return;
+        }
+
+        _uploadFile.close();
+        fs.remove(_uploadPath + FS_UPLOAD_SUFFIX);
+    } else if (upload.status == UPLOAD_FILE_END && _uploadFile) {
+        _uploadFile.close();
+        // the previous version steps aside and comes back when the new one cannot take its place
+        String backupPath = _uploadPath + FS_BACKUP_SUFFIX;
+        fs.remove(backupPath);
+        bool replacing = fs.rename(_uploadPath, backupPath);
+        if (!fs.rename(_uploadPath + FS_UPLOAD_SUFFIX, _uploadPath)) {
+            if (replacing) {
+                fs.rename(backupPath, _uploadPath);
+            }
+            _uploadError = String("Moving the file into place failed, the upload is kept as ") + _uploadPath + FS_UPLOAD_SUFFIX + ".";
+            return;
+        }
+        fs.remove(backupPath);
+        ONEBIOT_LOG_INFO(FIS, "Uploaded %s (%u bytes)", _uploadPath, _uploadWritten);
+    } else if (upload.status == UPLOAD_FILE_ABORTED && _uploadFile) {
+        _uploadFile.close();
+        fs.remove(_uploadPath + FS_UPLOAD_SUFFIX);
+        _uploadError = "Upload aborted.";
+    }
+}
+
+// Streams one page of the directory, every entry is serialized on its own.
+// offset= and limit= select the page, "next" is the offset of the following one or null.
+bool ONEBIOTFsRequestHandler::CMD_FS_LIST_CALLBACK(ESP8266WebServer& server) {
+    String path = server.hasArg("path") ? server.arg("path") : String("/");
+    long offset = server.hasArg("offset") ? server.arg("offset").toInt() : 0;
+    long limit = server.hasArg("limit") ? server.arg("limit").toInt() : FS_LIST_DEFAULT_LIMIT;
+    offset = offset < 0 ? 0 : offset;
+    limit = limit < 1 ? FS_LIST_DEFAULT_LIMIT : limit;
+
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.sendHeader("Access-Control-Allow-Origin", "*");
+    server.send(200, "application/json", "");
+
+    ONEBIOTContentPrint content(server);
+    content.print("{\"success\":true,\"offset\":");
+    content.print(offset);
+    content.print(",\"data\":[");
+
+    ONEBIOTDir dir(_config.getFileSystem(), path);
+    long index = 0;
+    bool hasNext = false;
+    StaticJsonDocument<128> entry;
+    while (dir.next()) {
+        if (index < offset) {
+            index++;
+            continue;
+        }
+        if (index >= offset + limit) {
+            hasNext = true;
+            break;
+        }
+
+        entry.clear();
+        entry["name"] = dir.fileName();
+        entry["size"] = dir.fileSize();
+        entry["directory"] = dir.isDirectory();
+        if (index > offset) {
+            content.print(',');
+        }
+        serializeJson(entry, content);
+        index++;
+    }
+
+    content.print("],\"next\":");
+    if (hasNext) {
+        content.print(index);
+    } else {
+        content.print("null");
+    }
+    content.print('}');
+    content.send();
+    server.sendContent("");
+    return true;
+}
+
+bool ONEBIOTFsRequestHandler::CMD_FS_DOWNLOAD_CALLBACK(JsonDocument& response, ESP8266WebServer& server) {
+    String path = server.arg("path");
+    File file;
+    if (_isValidPath(path)) {
+        file = _config.getFileSystem().open(path, "r");
+    }
+
+    if (!file || file.isDirectory()) {
+        response["success"] = false;
+        response["message"] = "File not found.";
+        return false;
+    }
+
+    server.sendHeader("Access-Control-Allow-Origin", "*");
+    server.sendHeader("Content-Disposition", "attachment");
+    server.streamFile(file, "application/octet-stream");
+    file.close();
+    return true;
+}
+
+bool ONEBIOTFsRequestHandler::CMD_FS_UPLOAD_CALLBACK(JsonDocument& response) {
+    if (_uploadError.length()) {
+        response["success"] = false;
+        response["message"] = _uploadError;
+    } else if (_uploadWritten == 0 && !_config.getFileSystem().exists(_uploadPath)) {
+        response["success"] = false;
+        response["message"] = "No file has been uploaded.";
+    } else {
+        response["success"] = true;
+        JsonObject data = response.createNestedObject("data");
+        data["name"] = _uploadPath;
+        data["size"] = _uploadWritten;
+    }
+
+    _uploadPath = "";
+    _uploadError = "";
+    _uploadWritten = 0;
+    return true;
+}
+
+bool ONEBIOTFsRequestHandler::CMD_FS_DELETE_CALLBACK(JsonDocument& response, ESP8266WebServer& server) {
+    String path = server.arg("path");
+    if (!_isValidPath(path) || !_config.getFileSystem().remove(path)) {
+        response["success"] = false;
+        response["message"] = "File could not be deleted.";
+    } else {
+        response["success"] = true;
+        response["message"] = "File has been deleted.";
+    }
+    return true;
+}
+
+bool ONEBIOTFsRequestHandler::CMD_FS_RENAME_CALLBACK(JsonDocument& response, ESP8266WebServer& server) {
+    String from = server.arg("from");
+    String to = server.arg("to");
+    if (!_isValidPath(from) || !_isValidPath(to) || !_config.getFileSystem().rename(from, to)) {
+        response["success"] = false;
+        response["message"] = "File could not be renamed.";
+    } else {
+        response["success"] = true;
+        response["message"] = "File has been renamed.";
+    }
+    return true;
+}
+
+bool ONEBIOTFsRequestHandler::_isValidPath(const String &path) {
+    FSInfo fs_info;
+    ONEBIOTFS::info(_config.getFileSystem(), fs_info);
+    return path.startsWith("/") && path.indexOf("..") == -1 && path.length() < fs_info.maxPathLength;
+}
+
+// Keeps one block in reserve, the file system needs it for its own metadata.
+bool ONEBIOTFsRequestHandler::_hasSpaceFor(size_t size) {
+    FSInfo fs_info;
+    ONEBIOTFS::info(_config.getFileSystem(), fs_info);
+    return fs_info.usedBytes + size + fs_info.blockSize <= fs_info.totalBytes;
+}
+
+#endif //FS_REQUEST_CPP
@@ -0,0 +1,41 @@
+#ifndef FS_REQUEST_H
+#define FS_REQUEST_H
+
+#include <ArduinoJson.h>
+#include <FS.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WebServer.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
+#include <ESP8266WebServer.h>
+#endif
+
+#include "utils/config/ONEBIOTConfig.h"
+#include "utils/request/ONEBIOTRequestHandler.h"
+
+class ONEBIOTFsRequestHandler : public ONEBIOTRequestHandler {
+    public:
+        ONEBIOTFsRequestHandler(ONEBIOTConfig config) : ONEBIOTRequestHandler(config) {}
+        bool canHandle(HTTPMethod method, String uri) override;
+        bool addRoutes(ONEBIOTRouter &router) override;
+        bool handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) override;
+        bool canUpload(String uri) override;
+        void upload(ESP8266WebServer& server, String requestUri, HTTPUpload& upload) override;
+    protected:
+        bool CMD_FS_LIST_CALLBACK(ESP8266WebServer& server);
+        bool CMD_FS_DOWNLOAD_CALLBACK(JsonDocument& response, ESP8266WebServer& server);
+        bool CMD_FS_UPLOAD_CALLBACK(JsonDocument& response);
+        bool CMD_FS_DELETE_CALLBACK(JsonDocument& response, ESP8266WebServer& server);
+        bool CMD_FS_RENAME_CALLBACK(JsonDocument& response, ESP8266WebServer& server);
+        bool _isValidPath(const String &path);
+        bool _hasSpaceFor(size_t size);
+    private:
+        File _uploadFile;
+        String _uploadPath;
+        String _uploadError;
+        size_t _uploadWritten = 0;
+        bool _uploadAuthorized = false;
+        String __payload;
+};
+
+#endif //FS_REQUEST_H
@@ -2,10 +2,40 @@
 #define ONEBIOT_REQUEST_CPP
 
 #include <utils/request/ONEBIOTRequestHandler.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WebServer.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
 #include <ESP8266WebServer.h>
+#endif
+
+#include "utils/log/ONEBIOTLog.h"
+#include "utils/http/ONEBIOTAdmission.h"
 
 __attribute__((weak)) String processor(String &key){return key;}
 
+size_t ONEBIOTContentPrint::write(uint8_t data) {
+    _buffer[_length++] = data;
+    if (_length == sizeof(_buffer)) {
+        send();
+    }
+    return 1;
+}
+
+size_t ONEBIOTContentPrint::write(const uint8_t *buffer, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        write(buffer[i]);
+    }
+    return size;
+}
+
+void ONEBIOTContentPrint::send() {
+    if (_length > 0) {
+        _server.sendContent(_buffer, _length);
+        _length = 0;
+    }
+}
+
 ONEBIOTRequestHandler::ONEBIOTRequestHandler(ONEBIOTConfig config) : _config(config) {}
 
 bool ONEBIOTRequestHandler::canHandle(HTTPMethod method, String uri) {
@@ -16,8 +46,22 @@ bool ONEBIOTRequestHandler::handle(ESP8266WebServer& server, HTTPMethod requestM
     return false;
 }
 
+bool ONEBIOTRequestHandler::addRoutes(ONEBIOTRouter &router) {
+    return true;
+}
+
 bool ONEBIOTRequestHandler::_authenticate(ESP8266WebServer& server) {
-    return server.authenticate(_config.getConfig().credentials_user.c_str(), _config.getConfig().credentials_password.c_str());
+    IPAddress ip = server.client().remoteIP();
+    if (ONEBIOTAdmission::isBackingOff(ip)) {
+        return false;
+    }
+
+    bool success = server.authenticate(_config.getConfig().credentials_user.c_str(), _config.getConfig().credentials_password.c_str());
+    // a request without credentials is the browser asking for the login dialog, not a failed login
+    if (success || server.hasHeader(F("Authorization"))) {
+        ONEBIOTAdmission::authResult(ip, success);
+    }
+    return success;
 }
 
 void ONEBIOTRequestHandler::_sendUnauthorizeResponse(ESP8266WebServer& server) {
@@ -26,12 +70,7 @@ void ONEBIOTRequestHandler::_sendUnauthorizeResponse(ESP8266WebServer& server) {
 
 bool ONEBIOTRequestHandler::_sendAsTemplate(String fileName, String contentType, ESP8266WebServer &server) {
     // Open file.
-    if(!SPIFFS.exists(fileName)) {
-        // callback fuckup
-        return false;
-    }
-
-    File file = SPIFFS.open(fileName, "r");
+    File file = _config.getFileSystem().open(fileName, "r");
     if (!file) {
         // callback fuckup
         return false;
@@ -100,9 +139,14 @@ bool ONEBIOTRequestHandler::_sendAsTemplate(String fileName, String contentType,
 }
 
 void ONEBIOTRequestHandler::reset() {
-    Serial.println("[WS] restarting the ESP ...");
+    ONEBIOT_LOG_INFO(WS, "restarting the ESP ...");
+    ONEBIOTLog::flush();
     delay(2000);
+#ifdef ARDUINO_ARCH_ESP32
+    ESP.restart();
+#else
     ESP.reset();
+#endif
 }
 
 #endif //ONEBIOT_REQUEST_CPP
\ No newline at end of file
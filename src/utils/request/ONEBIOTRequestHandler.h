@@ -3,24 +3,46 @@
 
 #ifdef ARDUINO_ARCH_ESP32
 #include <WebServer.h>
+// the handlers are written against the ESP8266 name, the ESP32 server has the same interface
+typedef WebServer ESP8266WebServer;
 #elif defined(ARDUINO_ARCH_ESP8266) 
 #include <ESP8266WebServer.h>
 #endif
 
 #include "utils/config/ONEBIOTConfig.h"
 
+class ONEBIOTRouter;
+
+// Print adapter streaming into a chunked response in blocks of 128 bytes.
+class ONEBIOTContentPrint : public Print {
+    public:
+        ONEBIOTContentPrint(ESP8266WebServer &server) : _server(server) {}
+        size_t write(uint8_t data) override;
+        size_t write(const uint8_t *buffer, size_t size) override;
+        void send();
+    private:
+        ESP8266WebServer &_server;
+        char _buffer[128];
+        size_t _length = 0;
+};
+
 class ONEBIOTRequestHandler : public RequestHandler {
     public:
         ONEBIOTRequestHandler(ONEBIOTConfig config);
         bool canHandle(HTTPMethod method, String uri) override;
         bool handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) override;
+        // routes of the handler for ONEBIOTRouter, false when one of them could not be added
+        virtual bool addRoutes(ONEBIOTRouter &router);
     protected:
         ONEBIOTConfig _config;
+        // dispatches to the handler, nullptr when it was added to the server directly
+        ONEBIOTRouter *_router = nullptr;
         char _bookend = '%';
         bool _authenticate(ESP8266WebServer& server);
         void _sendUnauthorizeResponse(ESP8266WebServer& server);
         bool _sendAsTemplate(String fileName, String contentType, ESP8266WebServer &server);
         void reset();
+        friend class ONEBIOTRouter;
 };
 
 #endif //ONEBIOT_REQUEST_H
\ No newline at end of file
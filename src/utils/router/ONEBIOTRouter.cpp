@@ -0,0 +1,360 @@
+#ifndef ONEBIOT_ROUTER_CPP
+#define ONEBIOT_ROUTER_CPP
+
+#include <Arduino.h>
+#include <FS.h>
+#include "utils/router/ONEBIOTRouter.h"
+#include "utils/request/ONEBIOTRequestHandler.h"
+#include "utils/log/ONEBIOTLog.h"
+#include "utils/http/ONEBIOTAdmission.h"
+
+static_assert(ONEBIOT_ROUTER_NODES < 255 && ONEBIOT_ROUTER_ROUTES < 255, "Router indexes are 8 bit");
+
+struct ONEBIOTRouterContentType {
+    char extension[6];
+    char type[24];
+};
+
+// everything else goes out as application/octet-stream
+static const ONEBIOTRouterContentType ROUTER_CONTENT_TYPES[] PROGMEM = {
+    {".html", "text/html"},
+    {".htm", "text/html"},
+    {".css", "text/css"},
+    {".js", "application/javascript"},
+    {".json", "application/json"},
+    {".txt", "text/plain"},
+    {".png", "image/png"},
+    {".jpg", "image/jpeg"},
+    {".ico", "image/x-icon"},
+    {".svg", "image/svg+xml"}
+};
+
+// both sides may be in flash
+static bool routerEquals(PGM_P left, PGM_P right, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (pgm_read_byte(left + i) != pgm_read_byte(right + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static String routerContentType(const char *path) {
+    const char *extension = strrchr(path, '.');
+    if (extension != nullptr) {
+        for (const ONEBIOTRouterContentType &contentType : ROUTER_CONTENT_TYPES) {
+            if (strcmp_P(extension, contentType.extension) == 0) {
+                return String(FPSTR(contentType.type));
+            }
+        }
+    }
+    return F("application/octet-stream");
+}
+
+void ONEBIOTRouter::addHandler(ONEBIOTRequestHandler *handler) {
+    handler->_router = this;
+    uint8_t routes = _routeCount;
+    // a handler missing a route is asked by canHandle() as well
+    if (!handler->addRoutes(*this) || _routeCount == routes) {
+        _addFallback(handler);
+    }
+}
+
+bool ONEBIOTRouter::on(PGM_P pattern, uint32_t methods, RequestHandler *handler) {
+    return _add(pattern, methods, handler, nullptr);
+}
+
+bool ONEBIOTRouter::serveStatic(const char *uri, FS &fs, const char *path) {
+    char *pattern = strdup(uri);
+    char *file = strcmp(uri, path) == 0 ? pattern : strdup(path);
+    if (pattern == nullptr || file == nullptr) {
+        free(pattern);
+        if (file != pattern) {
+            free(file);
+        }
+        ONEBIOT_LOG_ERROR(WS, "No memory for static route");
+        return false;
+    }
+
+    _fs = &fs;
+    // a failed _add() keeps no node pointing into the copies
+    if (!_add(pattern, ONEBIOT_ROUTE(HTTP_GET), nullptr, file)) {
+        if (file != pattern) {
+            free(file);
+        }
+        free(pattern);
+        return false;
+    }
+    _routes[_routeCount - 1].prefix = pattern[strlen(pattern) - 1] == '/';
+    return true;
+}
+
+String ONEBIOTRouter::pathArg(PGM_P name) {
+    for (uint8_t i = 0; i < _paramCount; i++) {
+        const Node &node = _nodes[_params[i].node];
+        // the segment is ":name"
+        if (routerEquals(node.segment + 1, name, node.length - 1) && pgm_read_byte(name + node.length - 1) == '\0') {
+            return _uri.substring(_params[i].offset, _params[i].offset + _params[i].length);
+        }
+    }
+    return String();
+}
+
+uint8_t ONEBIOTRouter::getNodeCount() {
+    return _nodeCount;
+}
+
+uint8_t ONEBIOTRouter::getRouteCount() {
+    return _routeCount;
+}
+
+bool ONEBIOTRouter::canHandle(HTTPMethod method, String uri) {
+    _uri = uri;
+    _declined = nullptr;
+    return _find(method);
+}
+
+bool ONEBIOTRouter::_find(HTTPMethod method) {
+    _matched = NONE;
+    _prefixEnd = _uri.length();
+    _current = nullptr;
+    _paramCount = 0;
+
+    // the cores define HTTP_ANY outside of the mask, a request never has it
+    uint32_t mask = (uint32_t) method < 32 ? ONEBIOT_ROUTE(method) : 0;
+    if (_uri.length() && _uri[0] == '/' && _match(0, _uri.c_str() + 1, mask, 0)) {
+        _current = _routes[_matched].handler;
+        return true;
+    }
+
+    for (RequestHandler *handler = _fallback; handler != nullptr; handler = handler->next()) {
+        if (handler->canHandle(method, _uri)) {
+            _current = handler;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ONEBIOTRouter::canUpload(String uri) {
+    return _current != nullptr && _current->canUpload(uri);
+}
+
+bool ONEBIOTRouter::handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) {
+#if !defined(ARDUINO_ARCH_ESP8266) || defined(ONEBIOT_HTTP_SYNC)
+    // ONEBIOTHttpServer refuses a client over its budget before reading the request,
+    // behind the core servers the router is the first place to see it
+    if (!ONEBIOTAdmission::admit(server.client().remoteIP(), ONEBIOTAdmission::cost(requestUri.c_str(), requestUri.length()))) {
+        server.sendHeader("Retry-After", "1");
+        server.send(429, "text/plain", "");
+        return true;
+    }
+#endif
+    if (_current != nullptr) {
+        if (_current->handle(server, requestMethod, requestUri)) {
+            return true;
+        } else if (_matched == NONE) {
+            return false;
+        }
+        // a routed handler passed the request on, the next match gets it, once
+        _declined = _current;
+        _find(requestMethod);
+        if (_current != nullptr) {
+            return _current->handle(server, requestMethod, requestUri);
+        }
+    }
+    if (_matched != NONE) {
+        return _serveStatic(server, _routes[_matched]);
+    }
+    return false;
+}
+
+void ONEBIOTRouter::upload(ESP8266WebServer& server, String requestUri, HTTPUpload& upload) {
+    if (_current != nullptr) {
+        _current->upload(server, requestUri, upload);
+    }
+}
+
+bool ONEBIOTRouter::_add(PGM_P pattern, uint32_t methods, RequestHandler *handler, const char *path) {
+    if (pgm_read_byte(pattern) != '/') {
+        ONEBIOT_LOG_ERROR(WS, "Route has to start with /");
+        return false;
+    }
+    if (_routeCount == ONEBIOT_ROUTER_ROUTES) {
+        ONEBIOT_LOG_ERROR(WS, "Router is full, raise ONEBIOT_ROUTER_ROUTES");
+        return false;
+    }
+
+    uint8_t node = 0;
+    // the nodes of this pattern are appended as one chain below an existing node
+    uint8_t first = _nodeCount;
+    uint8_t firstParent = NONE;
+    PGM_P segment = pattern + 1;
+    for (;;) {
+        uint8_t length = 0;
+        char ch;
+        while ((ch = pgm_read_byte(segment + length)) != '\0' && ch != '/') {
+            length++;
+        }
+
+        uint8_t parent = node;
+        node = _child(node, segment, length);
+        if (node == NONE) {
+            // the nodes added so far point into the pattern, take them back
+            if (firstParent != NONE) {
+                _nodes[firstParent].child = _nodes[first].sibling;
+                for (uint8_t i = first; i < _nodeCount; i++) {
+                    _nodes[i] = Node();
+                }
+                _nodeCount = first;
+            }
+            ONEBIOT_LOG_ERROR(WS, "Router is full, raise ONEBIOT_ROUTER_NODES");
+            return false;
+        }
+        if (node == first) {
+            firstParent = parent;
+        }
+        if (ch == '\0') {
+            break;
+        }
+        segment += length + 1;
+    }
+
+    Route &route = _routes[_routeCount];
+    route.handler = handler;
+    route.path = path;
+    route.methods = methods;
+
+    // routes of one path are tried in the order they were added
+    uint8_t *last = &_nodes[node].route;
+    while (*last != NONE) {
+        last = &_routes[*last].next;
+    }
+    *last = _routeCount++;
+    return true;
+}
+
+void ONEBIOTRouter::_addFallback(RequestHandler *handler) {
+    handler->next(nullptr);
+    if (_lastFallback == nullptr) {
+        _fallback = handler;
+    } else {
+        _lastFallback->next(handler);
+    }
+    _lastFallback = handler;
+}
+
+uint8_t ONEBIOTRouter::_child(uint8_t parent, PGM_P segment, uint8_t length) {
+    for (uint8_t child = _nodes[parent].child; child != NONE; child = _nodes[child].sibling) {
+        if (_nodes[child].length == length && routerEquals(_nodes[child].segment, segment, length)) {
+            return child;
+        }
+    }
+
+    if (_nodeCount == ONEBIOT_ROUTER_NODES) {
+        return NONE;
+    }
+
+    Node &node = _nodes[_nodeCount];
+    node.segment = segment;
+    node.length = length;
+    node.param = length > 1 && pgm_read_byte(segment) == ':';
+    node.sibling = _nodes[parent].child;
+    _nodes[parent].child = _nodeCount;
+    return _nodeCount++;
+}
+
+// Static segments of a level are tried first, a parameter only when none of them leads to a route
+// and a directory route last, so the deepest directory serves what no other route matches.
+bool ONEBIOTRouter::_match(uint8_t node, const char *segment, uint32_t method, uint8_t params) {
+    const char *end = strchr(segment, '/');
+    if (end == nullptr) {
+        end = segment + strlen(segment);
+    }
+    size_t length = end - segment;
+
+    for (uint8_t child = _nodes[node].child; child != NONE; child = _nodes[child].sibling) {
+        const Node &candidate = _nodes[child];
+        if (candidate.param || candidate.length != length || strncmp_P(segment, candidate.segment, length) != 0) {
+            continue;
+        }
+        if (*end == '\0' ? _matchEnd(child, method, params) : _match(child, end + 1, method, params)) {
+            return true;
+        }
+    }
+
+    if (length > 0 && params < ONEBIOT_ROUTER_PARAMS) {
+        for (uint8_t child = _nodes[node].child; child != NONE; child = _nodes[child].sibling) {
+            if (!_nodes[child].param) {
+                continue;
+            }
+            _params[params].node = child;
+            _params[params].offset = segment - _uri.c_str();
+            _params[params].length = length;
+            if (*end == '\0' ? _matchEnd(child, method, params + 1) : _match(child, end + 1, method, params + 1)) {
+                return true;
+            }
+        }
+    }
+    return _matchPrefix(node, segment, method, params);
+}
+
+bool ONEBIOTRouter::_matchEnd(uint8_t node, uint32_t method, uint8_t params) {
+    for (uint8_t route = _nodes[node].route; route != NONE; route = _routes[route].next) {
+        if ((_routes[route].methods & method) && (_declined == nullptr || _routes[route].handler != _declined)) {
+            _matched = route;
+            _paramCount = params;
+            return true;
+        }
+    }
+    return false;
+}
+
+// The route of a directory "/web/" hangs at the empty segment after "web".
+bool ONEBIOTRouter::_matchPrefix(uint8_t node, const char *segment, uint32_t method, uint8_t params) {
+    for (uint8_t child = _nodes[node].child; child != NONE; child = _nodes[child].sibling) {
+        if (_nodes[child].length != 0) {
+            continue;
+        }
+        for (uint8_t route = _nodes[child].route; route != NONE; route = _routes[route].next) {
+            if (_routes[route].prefix && (_routes[route].methods & method) && (_declined == nullptr || _routes[route].handler != _declined)) {
+                _matched = route;
+                _paramCount = params;
+                _prefixEnd = segment - _uri.c_str();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Opens the file and falls back to its ".gz" variant, one open() each and no exists().
+bool ONEBIOTRouter::_serveStatic(ESP8266WebServer& server, const Route &route) {
+    String fileName(route.path);
+    if (route.prefix) {
+        const char *rest = _uri.c_str() + _prefixEnd;
+        if (strstr(rest, "..") != nullptr) {
+            return false;
+        }
+        if (!fileName.endsWith("/")) {
+            fileName += '/';
+        }
+        fileName += rest;
+        if (fileName.endsWith("/")) {
+            fileName += F("index.htm");
+        }
+    }
+
+    File file = _fs->open(fileName, "r");
+    if (!file || file.isDirectory()) {
+        file = _fs->open(fileName + F(".gz"), "r");
+        if (!file) {
+            return false;
+        }
+    }
+    server.streamFile(file, routerContentType(fileName.c_str()));
+    file.close();
+    return true;
+}
+
+#endif //ONEBIOT_ROUTER_CPP
@@ -0,0 +1,127 @@
+#ifndef ONEBIOT_ROUTER_H
+#define ONEBIOT_ROUTER_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WebServer.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
+#include <ESP8266WebServer.h>
+#endif
+
+#include "utils/request/ONEBIOTRequestHandler.h"
+
+// path segments of all routes together, one node per distinct segment of a level,
+// the handlers of the library and the captive portal take 39 nodes and 33 routes
+#ifndef ONEBIOT_ROUTER_NODES
+#define ONEBIOT_ROUTER_NODES 48
+#endif
+
+// registered routes, a path with several methods of different handlers takes one each
+#ifndef ONEBIOT_ROUTER_ROUTES
+#define ONEBIOT_ROUTER_ROUTES 40
+#endif
+
+// :name segments captured by one request
+#ifndef ONEBIOT_ROUTER_PARAMS
+#define ONEBIOT_ROUTER_PARAMS 4
+#endif
+
+// HTTPMethod values differ between the cores, the mask takes the value as bit index
+#define ONEBIOT_ROUTE(method) (1UL << (method))
+#define ONEBIOT_ROUTE_ANY 0xFFFFFFFFUL
+
+/**
+ * The single handler of the web server. Routes of all request handlers and the
+ * static files are compiled into a trie of path segments, a request walks the
+ * trie once instead of asking every handler by canHandle(). A ":name" segment
+ * matches any non empty segment and is captured for pathArg(), a static segment
+ * wins over it on the same level.
+ *
+ *   router.on(PSTR("/cmd/option/:name"), ONEBIOT_ROUTE(HTTP_GET), handler);
+ *
+ * Patterns are not copied, they have to live as long as the router (PROGMEM
+ * constants or literals). Handlers declaring no route are asked by canHandle()
+ * in the order they were added when the trie has no match, so handlers of
+ * sketches keep working unchanged. A routed handler returning false from
+ * handle() passes the request on, it is matched once more without that handler.
+ */
+class ONEBIOTRouter : public RequestHandler {
+    public:
+        // registers the routes of the handler, or keeps it for canHandle() when it declares none
+        void addHandler(ONEBIOTRequestHandler *handler);
+        bool on(PGM_P pattern, uint32_t methods, RequestHandler *handler);
+        // GET of the uri streams the file, its ".gz" variant when only that one exists,
+        // both strings are copied like the core server does. A uri ending in "/" serves
+        // the directory: "/web/app.js" is path + "app.js", "/web/" is path + "index.htm"
+        bool serveStatic(const char *uri, FS &fs, const char *path);
+        // segment captured by ":name" of the matched route, empty when there is none
+        String pathArg(PGM_P name);
+        uint8_t getNodeCount();
+        uint8_t getRouteCount();
+
+        bool canHandle(HTTPMethod method, String uri) override;
+        bool canUpload(String uri) override;
+        bool handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) override;
+        void upload(ESP8266WebServer& server, String requestUri, HTTPUpload& upload) override;
+    private:
+        static const uint8_t NONE = 0xFF;
+
+        struct Node {
+            // into the pattern, not terminated
+            PGM_P segment = nullptr;
+            uint8_t length = 0;
+            bool param = false;
+            uint8_t child = NONE;
+            uint8_t sibling = NONE;
+            uint8_t route = NONE;
+        };
+
+        struct Route {
+            RequestHandler *handler = nullptr;
+            // file of a static route, handler is nullptr then
+            const char *path = nullptr;
+            // static route of a directory, matches every path below it
+            bool prefix = false;
+            uint32_t methods = 0;
+            uint8_t next = NONE;
+        };
+
+        struct Param {
+            uint8_t node;
+            uint16_t offset;
+            uint16_t length;
+        };
+
+        Node _nodes[ONEBIOT_ROUTER_NODES];
+        Route _routes[ONEBIOT_ROUTER_ROUTES];
+        uint8_t _nodeCount = 1;
+        uint8_t _routeCount = 0;
+        // handlers without routes, chained by RequestHandler::next()
+        RequestHandler *_fallback = nullptr;
+        RequestHandler *_lastFallback = nullptr;
+        FS *_fs = nullptr;
+
+        // state of the request being handled
+        String _uri;
+        uint8_t _matched = NONE;
+        // where the part below a matched directory route starts in _uri
+        uint16_t _prefixEnd = 0;
+        RequestHandler *_current = nullptr;
+        // routed handler that passed the request on, its routes are skipped
+        RequestHandler *_declined = nullptr;
+        Param _params[ONEBIOT_ROUTER_PARAMS];
+        uint8_t _paramCount = 0;
+
+        bool _add(PGM_P pattern, uint32_t methods, RequestHandler *handler, const char *path);
+        void _addFallback(RequestHandler *handler);
+        bool _find(HTTPMethod method);
+        uint8_t _child(uint8_t parent, PGM_P segment, uint8_t length);
+        bool _match(uint8_t node, const char *segment, uint32_t method, uint8_t params);
+        bool _matchEnd(uint8_t node, uint32_t method, uint8_t params);
+        bool _matchPrefix(uint8_t node, const char *segment, uint32_t method, uint8_t params);
+        bool _serveStatic(ESP8266WebServer& server, const Route &route);
+};
+
+#endif //ONEBIOT_ROUTER_H
@@ -0,0 +1,180 @@
+#ifndef ONEBIOT_STATS_CPP
+#define ONEBIOT_STATS_CPP
+
+#include <Arduino.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <WiFi.h>
+#elif defined(ARDUINO_ARCH_ESP8266) 
+#include <ESP8266WiFi.h>
+#endif
+
+#include "utils/stats/ONEBIOTStats.h"
+#include "utils/sync/ONEBIOTSync.h"
+
+// the history is written by the loop task and read by the server task
+static ONEBIOTMutex statsMutex;
+
+template<typename T>
+static T clampDelta(int32_t value, int32_t min, int32_t max) {
+    if (value < min) {
+        return (T) min;
+    } else if (value > max) {
+        return (T) max;
+    }
+    return (T) value;
+}
+
+const ONEBIOTStatsChipInfo &ONEBIOTStats::chipInfo() {
+    static ONEBIOTStatsChipInfo info;
+    static bool loaded = false;
+    if (loaded) {
+        return info;
+    }
+
+#ifdef ARDUINO_ARCH_ESP32
+    info.chip_id = (uint32_t) ESP.getEfuseMac();
+    info.flash_chip_real_size = ESP.getFlashChipSize();
+#elif defined(ARDUINO_ARCH_ESP8266) 
+    info.chip_id = ESP.getChipId();
+    info.core_version = ESP.getCoreVersion();
+    info.flash_chip_id = ESP.getFlashChipId();
+    info.flash_chip_real_size = ESP.getFlashChipRealSize();
+#endif
+    info.sdk_version = ESP.getSdkVersion();
+    info.cpu_freq = ESP.getCpuFreqMHz();
+    info.sketch_size = ESP.getSketchSize();
+    info.free_sketch_space = ESP.getFreeSketchSpace();
+    // hashes the whole sketch, that is why it is read only once
+    info.sketch_md5 = ESP.getSketchMD5();
+    info.flash_chip_size = ESP.getFlashChipSize();
+
+    loaded = true;
+    return info;
+}
+
+void ONEBIOTStats::readHeap(ONEBIOTStatsSample &sample) {
+#ifdef ARDUINO_ARCH_ESP32
+    sample.free_heap = ESP.getFreeHeap();
+    sample.max_free_block_size = ESP.getMaxAllocHeap();
+    sample.heap_fragmentation = sample.free_heap ? 100 - (sample.max_free_block_size * 100) / sample.free_heap : 0;
+#elif defined(ARDUINO_ARCH_ESP8266) 
+    sample.free_heap = ESP.getFreeHeap();
+    sample.max_free_block_size = ESP.getMaxFreeBlockSize();
+    sample.heap_fragmentation = ESP.getHeapFragmentation();
+#endif
+}
+
+void ONEBIOTStats::setInterval(uint32_t interval) {
+    _interval = interval;
+}
+
+uint32_t ONEBIOTStats::getInterval() {
+    return _interval;
+}
+
+void ONEBIOTStats::loop() {
+    uint32_t now = micros();
+    if (_lastLoopAt != 0 && now - _lastLoopAt > _maxLoopLatency) {
+        _maxLoopLatency = now - _lastLoopAt;
+    }
+    _lastLoopAt = now;
+
+    if (_interval == 0 || millis() - _lastSampleAt < _interval) {
+        return;
+    }
+
+    sample();
+}
+
+void ONEBIOTStats::excludeSleep(uint32_t us) {
+    _lastLoopAt += us;
+}
+
+uint32_t ONEBIOTStats::getIdleTime() {
+    if (_interval == 0) {
+        return UINT32_MAX;
+    }
+    uint32_t elapsed = millis() - _lastSampleAt;
+    return elapsed >= _interval ? 0 : _interval - elapsed;
+}
+
+void ONEBIOTStats::sample() {
+    ONEBIOTStatsSample current;
+    readHeap(current);
+    current.timestamp = millis();
+    current.rssi = WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0;
+    current.loop_latency = _maxLoopLatency;
+
+    _lastSampleAt = current.timestamp;
+    _maxLoopLatency = 0;
+
+    ONEBIOT_LOCK(statsMutex);
+    Delta delta;
+    if (_size == 0) {
+        // the very first sample becomes the base, its own record is empty
+        _base = current;
+        _base.free_heap &= ~3u;
+        _base.max_free_block_size &= ~3u;
+        _base.loop_latency = 0;
+        _last = _base;
+        delta = {0, 0, 0, 0, 0, 0};
+    } else {
+        delta.elapsed = clampDelta<uint16_t>((current.timestamp - _last.timestamp + 50) / 100, 0, UINT16_MAX);
+        delta.free_heap = clampDelta<int16_t>((int32_t) (current.free_heap / 4) - (int32_t) (_last.free_heap / 4), INT16_MIN, INT16_MAX);
+        delta.max_free_block = clampDelta<int16_t>((int32_t) (current.max_free_block_size / 4) - (int32_t) (_last.max_free_block_size / 4), INT16_MIN, INT16_MAX);
+        delta.heap_fragmentation = clampDelta<int8_t>((int32_t) current.heap_fragmentation - _last.heap_fragmentation, INT8_MIN, INT8_MAX);
+        delta.rssi = clampDelta<int8_t>((int32_t) current.rssi - _last.rssi, INT8_MIN, INT8_MAX);
+    }
+    delta.loop_latency = clampDelta<uint16_t>((current.loop_latency + 50) / 100, 0, UINT16_MAX);
+
+    // encoder works against the decoded value, so clamping never accumulates an error
+    _apply(_last, delta);
+
+    if (_size == ONEBIOT_STATS_HISTORY_SIZE) {
+        _apply(_base, _history[_head]);
+    } else {
+        _size++;
+    }
+    _history[_head] = delta;
+    _head = (_head + 1) % ONEBIOT_STATS_HISTORY_SIZE;
+}
+
+size_t ONEBIOTStats::size() {
+    return _size;
+}
+
+void ONEBIOTStats::rewind(ONEBIOTStatsSample &sample) {
+    sample = _base;
+}
+
+bool ONEBIOTStats::next(size_t index, ONEBIOTStatsSample &sample) {
+    if (index >= _size) {
+        return false;
+    }
+
+    size_t oldest = (_head + ONEBIOT_STATS_HISTORY_SIZE - _size) % ONEBIOT_STATS_HISTORY_SIZE;
+    _apply(sample, _history[(oldest + index) % ONEBIOT_STATS_HISTORY_SIZE]);
+    return true;
+}
+
+void ONEBIOTStats::snapshot(ONEBIOTStats &copy) {
+    ONEBIOT_LOCK(statsMutex);
+    memcpy(copy._history, _history, sizeof(_history));
+    copy._head = _head;
+    copy._size = _size;
+    copy._base = _base;
+    copy._last = _last;
+    copy._interval = _interval;
+}
+
+void ONEBIOTStats::_apply(ONEBIOTStatsSample &sample, const Delta &delta) {
+    sample.timestamp += (uint32_t) delta.elapsed * 100;
+    sample.free_heap = (uint32_t) ((int32_t) sample.free_heap + delta.free_heap * 4);
+    sample.max_free_block_size = (uint32_t) ((int32_t) sample.max_free_block_size + delta.max_free_block * 4);
+    sample.heap_fragmentation = (uint8_t) (sample.heap_fragmentation + delta.heap_fragmentation);
+    sample.rssi = (int8_t) (sample.rssi + delta.rssi);
+    sample.loop_latency = (uint32_t) delta.loop_latency * 100;
+}
+
+#endif //ONEBIOT_STATS_CPP
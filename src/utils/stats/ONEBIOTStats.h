@@ -0,0 +1,80 @@
+#ifndef ONEBIOT_STATS_H
+#define ONEBIOT_STATS_H
+
+#include <Arduino.h>
+
+#ifndef ONEBIOT_STATS_HISTORY_SIZE
+#define ONEBIOT_STATS_HISTORY_SIZE 60
+#endif
+
+// Facts which never change while the sketch is running, read once at boot.
+struct ONEBIOTStatsChipInfo {
+    uint32_t chip_id = 0;
+    String core_version;
+    String sdk_version;
+    uint8_t cpu_freq = 0;
+    uint32_t sketch_size = 0;
+    uint32_t free_sketch_space = 0;
+    String sketch_md5;
+    uint32_t flash_chip_id = 0;
+    uint32_t flash_chip_size = 0;
+    uint32_t flash_chip_real_size = 0;
+};
+
+struct ONEBIOTStatsSample {
+    uint32_t timestamp = 0;
+    uint32_t free_heap = 0;
+    uint8_t heap_fragmentation = 0;
+    uint32_t max_free_block_size = 0;
+    int8_t rssi = 0;
+    uint32_t loop_latency = 0;
+};
+
+class ONEBIOTStats {
+    public:
+        static const ONEBIOTStatsChipInfo &chipInfo();
+        static void readHeap(ONEBIOTStatsSample &sample);
+
+        void setInterval(uint32_t interval);
+        uint32_t getInterval();
+        void loop();
+        // the loop slept for us microseconds since loop(), the latency leaves them out
+        void excludeSleep(uint32_t us);
+        // milliseconds until loop() takes the next sample
+        uint32_t getIdleTime();
+        void sample();
+        size_t size();
+        // samples are decoded one after another from the oldest (index 0):
+        // rewind(sample); for (size_t i = 0; next(i, sample); i++) { ... }
+        void rewind(ONEBIOTStatsSample &sample);
+        bool next(size_t index, ONEBIOTStatsSample &sample);
+        // copies the history under a lock, another task reads the copy while sample() goes on
+        void snapshot(ONEBIOTStats &copy);
+    private:
+        // one sample packed into 10 bytes, each field relative to the previous one
+        struct Delta {
+            uint16_t elapsed;       // 100 ms units
+            int16_t free_heap;      // 4 byte units
+            int16_t max_free_block; // 4 byte units
+            int8_t heap_fragmentation;
+            int8_t rssi;
+            uint16_t loop_latency;  // 100 us units, absolute
+        };
+
+        Delta _history[ONEBIOT_STATS_HISTORY_SIZE];
+        size_t _head = 0;
+        size_t _size = 0;
+        // decoded value of the sample preceding the oldest one in history
+        ONEBIOTStatsSample _base;
+        // decoded value of the newest sample, the encoder works against it
+        ONEBIOTStatsSample _last;
+
+        uint32_t _interval = 10000;
+        uint32_t _lastSampleAt = 0;
+        uint32_t _lastLoopAt = 0;
+        uint32_t _maxLoopLatency = 0;
+
+        void _apply(ONEBIOTStatsSample &sample, const Delta &delta);
+};
+
+#endif //ONEBIOT_STATS_H
@@ -0,0 +1,10 @@
+#ifndef ONEBIOT_STRINGS_CPP
+#define ONEBIOT_STRINGS_CPP
+
+#include "utils/strings/ONEBIOTStrings.h"
+
+#define ONEBIOT_KEY_DEFINE(key) const char ONEBIOT_KEY_##key[] PROGMEM = #key;
+ONEBIOT_KEYS(ONEBIOT_KEY_DEFINE)
+#undef ONEBIOT_KEY_DEFINE
+
+#endif //ONEBIOT_STRINGS_CPP
@@ -0,0 +1,56 @@
+#ifndef ONEBIOT_STRINGS_H
+#define ONEBIOT_STRINGS_H
+
+#include <Arduino.h>
+
+/**
+ * JSON keys shared by the request handlers and the config, interned once in flash.
+ * OBK(success) is the key "success" as a flash string for ArduinoJson and String.
+ *
+ * ArduinoJson copies flash keys into the document pool while RAM literals are kept
+ * by pointer, documents with a tight fixed size (the config file, the patch filter)
+ * therefore keep their literal keys.
+ */
+#define ONEBIOT_KEYS(X) \
+    X(success) \
+    X(message) \
+    X(data) \
+    X(name) \
+    X(value) \
+    X(from) \
+    X(to) \
+    X(ssid) \
+    X(rssi) \
+    X(bssid) \
+    X(channel) \
+    X(credentials_user) \
+    X(credentials_password) \
+    X(client_name) \
+    X(wifi_ssid) \
+    X(wifi_password) \
+    X(wifi_establish) \
+    X(ap_ssid) \
+    X(ap_password) \
+    X(ap_establish) \
+    X(dns_name) \
+    X(dns_establish)
+
+#define ONEBIOT_KEY_DECLARE(key) extern const char ONEBIOT_KEY_##key[] PROGMEM;
+ONEBIOT_KEYS(ONEBIOT_KEY_DECLARE)
+#undef ONEBIOT_KEY_DECLARE
+
+#define OBK(key) FPSTR(ONEBIOT_KEY_##key)
+
+class ONEBIOTStrings {
+    public:
+        // String has no flash overloads on every core, these read the flash side with the _P functions
+        static bool equals(const String &value, PGM_P flash) {
+            return strcmp_P(value.c_str(), flash) == 0;
+        }
+
+        static bool startsWith(const String &value, PGM_P flash) {
+            return strncmp_P(value.c_str(), flash, strlen_P(flash)) == 0;
+        }
+};
+
+#endif //ONEBIOT_STRINGS_H
@@ -0,0 +1,60 @@
+#ifndef ONEBIOT_SYNC_H
+#define ONEBIOT_SYNC_H
+
+#include <stddef.h>
+#include <atomic>
+
+// On ESP32 the web server can run in its own task (ONEBIOTApp::startServerTask()),
+// state shared with the loop task is guarded then. Single threaded builds get no-ops.
+#if defined(ARDUINO_ARCH_ESP32) && !defined(ONEBIOT_THREAD_SAFE)
+#define ONEBIOT_THREAD_SAFE
+#endif
+
+#ifdef ONEBIOT_THREAD_SAFE
+#include <mutex>
+typedef std::recursive_mutex ONEBIOTMutex;
+#define ONEBIOT_LOCK(mutex) std::lock_guard<std::recursive_mutex> onebiotLock(mutex)
+#else
+struct ONEBIOTMutex {};
+#define ONEBIOT_LOCK(mutex) (void) (mutex)
+#endif
+
+/**
+ * Lock-free ring for exactly one producer and one consumer task. Only the producer
+ * moves _head and only the consumer moves _tail, the release store of an index
+ * publishes the slot written before it.
+ */
+template <typename T, size_t N>
+class ONEBIOTQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "ONEBIOTQueue size has to be a power of two");
+    public:
+        bool push(const T &item) {
+            size_t head = _head.load(std::memory_order_relaxed);
+            if (head - _tail.load(std::memory_order_acquire) == N) {
+                return false;
+            }
+            _items[head & (N - 1)] = item;
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T &item) {
+            size_t tail = _tail.load(std::memory_order_relaxed);
+            if (_head.load(std::memory_order_acquire) == tail) {
+                return false;
+            }
+            item = _items[tail & (N - 1)];
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t size() {
+            return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+        }
+    private:
+        T _items[N];
+        std::atomic<size_t> _head{0};
+        std::atomic<size_t> _tail{0};
+};
+
+#endif //ONEBIOT_SYNC_H
@@ -0,0 +1,239 @@
+#ifndef ONEBIOT_TIME_SERIES_CPP
+#define ONEBIOT_TIME_SERIES_CPP
+
+#include <Arduino.h>
+#include <FS.h>
+#include "utils/timeseries/ONEBIOTTimeSeries.h"
+#include "utils/fs/ONEBIOTFS.h"
+#include "utils/log/ONEBIOTLog.h"
+
+const size_t TS_RECORD_SIZE = sizeof(ONEBIOTTimeSeriesRecord);
+
+ONEBIOTTimeSeries::ONEBIOTTimeSeries(FS &fs, const char *directory, uint32_t segmentRecords) : _fs(fs), _directory(directory) {
+    _segmentRecords = segmentRecords < ONEBIOT_TS_INDEX_ENTRIES ? ONEBIOT_TS_INDEX_ENTRIES : segmentRecords;
+    _stride = (_segmentRecords + ONEBIOT_TS_INDEX_ENTRIES - 1) / ONEBIOT_TS_INDEX_ENTRIES;
+    memset(_segments, 0, sizeof(_segments));
+}
+
+bool ONEBIOTTimeSeries::begin() {
+    _current = 0;
+    _lastTimestamp = 0;
+    _pendingCount = 0;
+    memset(_segments, 0, sizeof(_segments));
+
+    for (uint8_t i = 0; i < ONEBIOT_TS_SEGMENTS; i++) {
+        File file = _fs.open(_segmentPath(i), "r");
+        if (!file) {
+            continue;
+        }
+
+        Segment &segment = _segments[i];
+        uint32_t count = file.size() / TS_RECORD_SIZE;
+        count = count > _segmentRecords ? _segmentRecords : count;
+        ONEBIOTTimeSeriesRecord record;
+        for (uint32_t position = 0; position < count; position += _stride) {
+            if (!file.seek(position * TS_RECORD_SIZE) || file.read((uint8_t *) &record, TS_RECORD_SIZE) != TS_RECORD_SIZE) {
+                count = position;
+                break;
+            }
+            _indexRecord(segment, position, record.timestamp);
+        }
+        if (count > 0 && file.seek((count - 1) * TS_RECORD_SIZE) && file.read((uint8_t *) &record, TS_RECORD_SIZE) == TS_RECORD_SIZE) {
+            segment.last = record.timestamp;
+            segment.count = count;
+        }
+        size_t expected = segment.count * TS_RECORD_SIZE;
+        bool torn = file.size() != expected;
+        file.close();
+
+        // a record cut off by a reset would shift every later append
+        if (torn) {
+            ONEBIOTFS::truncate(_fs, _segmentPath(i), expected);
+        }
+
+        if (segment.count > 0 && segment.last >= _lastTimestamp) {
+            _lastTimestamp = segment.last;
+            _current = i;
+        }
+    }
+
+    ONEBIOT_LOG_INFO(FIS, "Time series %s holds %u records", _directory, size());
+    return true;
+}
+
+bool ONEBIOTTimeSeries::append(uint32_t timestamp, float value) {
+    if (timestamp < _lastTimestamp) {
+        return false;
+    }
+
+    _pending[_pendingCount].timestamp = timestamp;
+    _pending[_pendingCount].value = value;
+    _pendingCount++;
+    _lastTimestamp = timestamp;
+    return _pendingCount < ONEBIOT_TS_WRITE_BUFFER || flush();
+}
+
+// Appends the buffered records, moving on to the next segment and dropping
+// its old contents whenever the current one is full.
+bool ONEBIOTTimeSeries::flush() {
+    size_t written = 0;
+    while (written < _pendingCount) {
+        if (_segments[_current].count >= _segmentRecords) {
+            _current = (_current + 1) % ONEBIOT_TS_SEGMENTS;
+            _fs.remove(_segmentPath(_current));
+            memset(&_segments[_current], 0, sizeof(Segment));
+        }
+
+        Segment &segment = _segments[_current];
+        size_t count = _pendingCount - written;
+        count = count > _segmentRecords - segment.count ? _segmentRecords - segment.count : count;
+
+        File file = _fs.open(_segmentPath(_current), "a");
+        if (!file) {
+            ONEBIOT_LOG_ERROR(FIS, "Could not open segment %u", _current);
+            break;
+        }
+        size_t size = count * TS_RECORD_SIZE;
+        if (file.write((const uint8_t *) &_pending[written], size) != size) {
+            file.close();
+            ONEBIOTFS::truncate(_fs, _segmentPath(_current), segment.count * TS_RECORD_SIZE);
+            ONEBIOT_LOG_ERROR(FIS, "Writing segment %u failed", _current);
+            break;
+        }
+        file.close();
+
+        for (size_t i = 0; i < count; i++) {
+            _indexRecord(segment, segment.count + i, _pending[written + i].timestamp);
+        }
+        segment.count += count;
+        segment.last = _pending[written + count - 1].timestamp;
+        written += count;
+    }
+
+    // keep whatever could not be written for the next attempt
+    if (written > 0 && written < _pendingCount) {
+        memmove(_pending, &_pending[written], (_pendingCount - written) * TS_RECORD_SIZE);
+    }
+    _pendingCount -= written;
+    // the flash keeps failing, give up the oldest record so append() has room
+    if (_pendingCount >= ONEBIOT_TS_WRITE_BUFFER) {
+        _pendingCount--;
+        memmove(_pending, &_pending[1], _pendingCount * TS_RECORD_SIZE);
+    }
+    return _pendingCount == 0;
+}
+
+void ONEBIOTTimeSeries::query(ONEBIOTTimeSeriesCursor &cursor, uint32_t from, uint32_t to) {
+    // the buffered records are the newest ones, only a range reaching them needs the write now
+    if (_pendingCount > 0 && from <= to && _pending[0].timestamp <= to && _pending[_pendingCount - 1].timestamp >= from) {
+        flush();
+    }
+    if (cursor._file) {
+        cursor._file.close();
+    }
+    cursor._from = from;
+    cursor._to = to;
+    cursor._ordinal = 0;
+    cursor._count = 0;
+    cursor._position = 0;
+    cursor._done = from > to;
+}
+
+bool ONEBIOTTimeSeries::next(ONEBIOTTimeSeriesCursor &cursor, ONEBIOTTimeSeriesRecord &record) {
+    while (!cursor._done) {
+        if (!cursor._file && !_openSegment(cursor)) {
+            cursor._done = true;
+            break;
+        }
+
+        if (cursor._position >= cursor._count) {
+            int read = cursor._file.read((uint8_t *) cursor._buffer, sizeof(cursor._buffer));
+            cursor._count = read > 0 ? read / TS_RECORD_SIZE : 0;
+            cursor._position = 0;
+            if (cursor._count == 0) {
+                cursor._file.close();
+                cursor._ordinal++;
+                continue;
+            }
+        }
+
+        record = cursor._buffer[cursor._position++];
+        if (record.timestamp > cursor._to) {
+            cursor._file.close();
+            cursor._done = true;
+        } else if (record.timestamp >= cursor._from) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t ONEBIOTTimeSeries::size() {
+    uint32_t total = _pendingCount;
+    for (uint8_t i = 0; i < ONEBIOT_TS_SEGMENTS; i++) {
+        total += _segments[i].count;
+    }
+    return total;
+}
+
+uint32_t ONEBIOTTimeSeries::getFirstTimestamp() {
+    for (uint8_t ordinal = 0; ordinal < ONEBIOT_TS_SEGMENTS; ordinal++) {
+        Segment &segment = _segments[(_current + 1 + ordinal) % ONEBIOT_TS_SEGMENTS];
+        if (segment.count > 0) {
+            return segment.first;
+        }
+    }
+    return _pendingCount > 0 ? _pending[0].timestamp : 0;
+}
+
+uint32_t ONEBIOTTimeSeries::getLastTimestamp() {
+    return _lastTimestamp;
+}
+
+String ONEBIOTTimeSeries::_segmentPath(uint8_t segment) {
+    return _directory + "/" + segment + ".seg";
+}
+
+void ONEBIOTTimeSeries::_indexRecord(Segment &segment, uint32_t position, uint32_t timestamp) {
+    if (position == 0) {
+        segment.first = timestamp;
+    }
+    if (position % _stride == 0 && position / _stride < ONEBIOT_TS_INDEX_ENTRIES) {
+        segment.index[position / _stride] = timestamp;
+    }
+}
+
+// Segments are visited oldest first, the one after the current segment is the
+// oldest. The sparse index gives the last indexed record before "from", so a run
+// of records sharing the timestamp "from" is read from its start.
+bool ONEBIOTTimeSeries::_openSegment(ONEBIOTTimeSeriesCursor &cursor) {
+    for (; cursor._ordinal < ONEBIOT_TS_SEGMENTS; cursor._ordinal++) {
+        uint8_t i = (_current + 1 + cursor._ordinal) % ONEBIOT_TS_SEGMENTS;
+        Segment &segment = _segments[i];
+        if (segment.count == 0 || segment.last < cursor._from) {
+            continue;
+        }
+        if (segment.first > cursor._to) {
+            return false;
+        }
+
+        uint32_t entry = 0;
+        uint32_t entries = (segment.count + _stride - 1) / _stride;
+        while (entry + 1 < entries && segment.index[entry + 1] < cursor._from) {
+            entry++;
+        }
+
+        cursor._file = _fs.open(_segmentPath(i), "r");
+        if (!cursor._file || !cursor._file.seek(entry * _stride * TS_RECORD_SIZE)) {
+            ONEBIOT_LOG_ERROR(FIS, "Could not read segment %u", i);
+            cursor._file.close();
+            continue;
+        }
+        cursor._count = 0;
+        cursor._position = 0;
+        return true;
+    }
+    return false;
+}
+
+#endif //ONEBIOT_TIME_SERIES_CPP
@@ -0,0 +1,85 @@
+#ifndef ONEBIOT_TIME_SERIES_H
+#define ONEBIOT_TIME_SERIES_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+// segment files reused round-robin, the oldest one is reclaimed when all are full
+#ifndef ONEBIOT_TS_SEGMENTS
+#define ONEBIOT_TS_SEGMENTS 8
+#endif
+
+// sparse index entries kept in RAM for every segment
+#ifndef ONEBIOT_TS_INDEX_ENTRIES
+#define ONEBIOT_TS_INDEX_ENTRIES 16
+#endif
+
+// records collected in RAM before one append to flash
+#ifndef ONEBIOT_TS_WRITE_BUFFER
+#define ONEBIOT_TS_WRITE_BUFFER 16
+#endif
+
+struct ONEBIOTTimeSeriesRecord {
+    uint32_t timestamp;
+    float value;
+};
+
+class ONEBIOTTimeSeriesCursor {
+    friend class ONEBIOTTimeSeries;
+    private:
+        uint32_t _from = 0;
+        uint32_t _to = 0;
+        uint8_t _ordinal = 0;
+        bool _done = true;
+        File _file;
+        ONEBIOTTimeSeriesRecord _buffer[16];
+        uint8_t _count = 0;
+        uint8_t _position = 0;
+};
+
+/**
+ * Log-structured store of (timestamp, value) records on the file system.
+ * Records are appended to fixed-size segment files, each segment keeps its time
+ * range and every n-th timestamp in RAM, so a range read seeks close to the start.
+ *
+ *   ONEBIOTTimeSeriesCursor cursor;
+ *   store.query(cursor, from, to);
+ *   while (store.next(cursor, record)) { ... }
+ */
+class ONEBIOTTimeSeries {
+    public:
+        ONEBIOTTimeSeries(FS &fs, const char *directory, uint32_t segmentRecords = 1024);
+        // rebuilds the index from the segment files, call it after the file system is mounted
+        bool begin();
+        // timestamps have to be non-decreasing
+        bool append(uint32_t timestamp, float value);
+        bool flush();
+        void query(ONEBIOTTimeSeriesCursor &cursor, uint32_t from, uint32_t to);
+        bool next(ONEBIOTTimeSeriesCursor &cursor, ONEBIOTTimeSeriesRecord &record);
+        uint32_t size();
+        uint32_t getFirstTimestamp();
+        uint32_t getLastTimestamp();
+    private:
+        struct Segment {
+            uint32_t count;
+            uint32_t first;
+            uint32_t last;
+            uint32_t index[ONEBIOT_TS_INDEX_ENTRIES];
+        };
+
+        FS &_fs;
+        String _directory;
+        uint32_t _segmentRecords;
+        uint32_t _stride;
+        Segment _segments[ONEBIOT_TS_SEGMENTS];
+        uint8_t _current = 0;
+        uint32_t _lastTimestamp = 0;
+        ONEBIOTTimeSeriesRecord _pending[ONEBIOT_TS_WRITE_BUFFER];
+        size_t _pendingCount = 0;
+
+        String _segmentPath(uint8_t segment);
+        void _indexRecord(Segment &segment, uint32_t position, uint32_t timestamp);
+        bool _openSegment(ONEBIOTTimeSeriesCursor &cursor);
+};
+
+#endif //ONEBIOT_TIME_SERIES_H
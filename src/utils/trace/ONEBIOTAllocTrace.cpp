@@ -0,0 +1,226 @@
+#ifndef ONEBIOT_ALLOC_TRACE_CPP
+#define ONEBIOT_ALLOC_TRACE_CPP
+
+#include "utils/trace/ONEBIOTAllocTrace.h"
+
+#ifdef ONEBIOT_ALLOC_TRACE
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <pgmspace.h>
+#else
+#define strncpy_P strncpy
+#define strcmp_P strcmp
+#define PROGMEM
+#endif
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <freertos/FreeRTOS.h>
+static portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+#define ONEBIOT_ALLOC_TRACE_LOCK() portENTER_CRITICAL(&traceMux)
+#define ONEBIOT_ALLOC_TRACE_UNLOCK() portEXIT_CRITICAL(&traceMux)
+#else
+// ESP8266 and the host build allocate from a single thread only
+#define ONEBIOT_ALLOC_TRACE_LOCK()
+#define ONEBIOT_ALLOC_TRACE_UNLOCK()
+#endif
+
+// The tracer must never allocate itself, everything lives in static tables.
+// Live allocations are kept in an open addressing table instead of a header
+// in front of each block, so pointers allocated before or around the wrappers
+// are simply not found on free.
+struct ONEBIOTAllocTraceSlot {
+    uintptr_t ptr;
+    uint32_t size;
+    uint8_t tag;
+};
+
+static ONEBIOTAllocTraceSlot traceSlots[ONEBIOT_ALLOC_TRACE_SLOTS];
+static ONEBIOTAllocTraceCounters traceCounters[ONEBIOT_ALLOC_TRACE_TAGS];
+static const char TRACE_UNTAGGED[] PROGMEM = "untagged";
+static size_t traceTagCount = 1; // 0 is reserved for allocations outside of any scope
+static uint8_t traceCurrentTag = 0;
+static uint32_t traceUntracked = 0;
+
+static size_t traceHome(uintptr_t ptr) {
+    return (size_t) (((uint32_t) (ptr >> 3) * 2654435761u) % ONEBIOT_ALLOC_TRACE_SLOTS);
+}
+
+const char *ONEBIOTAllocTrace::setTag(const char *tag) {
+    const char *previous = traceCounters[traceCurrentTag].tag;
+
+    uint8_t index = 0;
+    if (tag != nullptr) {
+        for (size_t i = 1; i < traceTagCount; i++) {
+            if (traceCounters[i].tag == tag) {
+                index = i;
+                break;
+            }
+        }
+
+        // both sides live in flash, so one of them is compared from a copy
+        if (index == 0) {
+            char name[32];
+            strncpy_P(name, tag, sizeof(name) - 1);
+            name[sizeof(name) - 1] = '\0';
+            for (size_t i = 1; i < traceTagCount; i++) {
+                if (strcmp_P(name, traceCounters[i].tag) == 0) {
+                    index = i;
+                    break;
+                }
+            }
+        }
+
+        if (index == 0 && traceTagCount < ONEBIOT_ALLOC_TRACE_TAGS) {
+            index = traceTagCount++;
+            traceCounters[index].tag = tag;
+        }
+    }
+
+    traceCurrentTag = index;
+    return previous;
+}
+
+size_t ONEBIOTAllocTrace::size() {
+    return traceTagCount;
+}
+
+bool ONEBIOTAllocTrace::get(size_t index, ONEBIOTAllocTraceCounters &counters) {
+    if (index >= traceTagCount) {
+        return false;
+    }
+
+    ONEBIOT_ALLOC_TRACE_LOCK();
+    counters = traceCounters[index];
+    ONEBIOT_ALLOC_TRACE_UNLOCK();
+    if (counters.tag == nullptr) {
+        counters.tag = TRACE_UNTAGGED;
+    }
+    return true;
+}
+
+uint32_t ONEBIOTAllocTrace::untracked() {
+    return traceUntracked;
+}
+
+void ONEBIOTAllocTrace::reset() {
+    ONEBIOT_ALLOC_TRACE_LOCK();
+    for (size_t i = 0; i < traceTagCount; i++) {
+        traceCounters[i].count = 0;
+        traceCounters[i].frees = 0;
+        traceCounters[i].bytes = 0;
+        traceCounters[i].peak = traceCounters[i].live;
+    }
+    traceUntracked = 0;
+    ONEBIOT_ALLOC_TRACE_UNLOCK();
+}
+
+void ONEBIOTAllocTrace::onAlloc(void *ptr, size_t size) {
+    ONEBIOT_ALLOC_TRACE_LOCK();
+    ONEBIOTAllocTraceCounters &counters = traceCounters[traceCurrentTag];
+    counters.count++;
+    counters.bytes += size;
+
+    size_t index = traceHome((uintptr_t) ptr);
+    for (size_t probe = 0; probe < ONEBIOT_ALLOC_TRACE_SLOTS; probe++) {
+        if (traceSlots[index].ptr == 0) {
+            traceSlots[index].ptr = (uintptr_t) ptr;
+            traceSlots[index].size = size;
+            traceSlots[index].tag = traceCurrentTag;
+
+            counters.live += size;
+            if (counters.live > counters.peak) {
+                counters.peak = counters.live;
+            }
+            ONEBIOT_ALLOC_TRACE_UNLOCK();
+            return;
+        }
+        index = (index + 1) % ONEBIOT_ALLOC_TRACE_SLOTS;
+    }
+
+    traceUntracked++;
+    ONEBIOT_ALLOC_TRACE_UNLOCK();
+}
+
+void ONEBIOTAllocTrace::onFree(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    ONEBIOT_ALLOC_TRACE_LOCK();
+    size_t index = traceHome((uintptr_t) ptr);
+    size_t probe = 0;
+    while (traceSlots[index].ptr != (uintptr_t) ptr) {
+        if (traceSlots[index].ptr == 0 || ++probe == ONEBIOT_ALLOC_TRACE_SLOTS) {
+            ONEBIOT_ALLOC_TRACE_UNLOCK();
+            return;
+        }
+        index = (index + 1) % ONEBIOT_ALLOC_TRACE_SLOTS;
+    }
+
+    ONEBIOTAllocTraceCounters &counters = traceCounters[traceSlots[index].tag];
+    counters.frees++;
+    counters.live -= traceSlots[index].size;
+
+    // backward shift deletion keeps the probe chains without tombstones,
+    // a full table has no empty slot to stop at, one lap is enough then
+    size_t hole = index;
+    size_t next = (hole + 1) % ONEBIOT_ALLOC_TRACE_SLOTS;
+    while (next != index && traceSlots[next].ptr != 0) {
+        size_t home = traceHome(traceSlots[next].ptr);
+        bool movable = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (movable) {
+            traceSlots[hole] = traceSlots[next];
+            hole = next;
+        }
+        next = (next + 1) % ONEBIOT_ALLOC_TRACE_SLOTS;
+    }
+    traceSlots[hole].ptr = 0;
+    ONEBIOT_ALLOC_TRACE_UNLOCK();
+}
+
+extern "C" {
+    void *__real_malloc(size_t size);
+    void *__real_calloc(size_t count, size_t size);
+    void *__real_realloc(void *ptr, size_t size);
+    void __real_free(void *ptr);
+
+    void *__wrap_malloc(size_t size) {
+        void *ptr = __real_malloc(size);
+        if (ptr != nullptr) {
+            ONEBIOTAllocTrace::onAlloc(ptr, size);
+        }
+        return ptr;
+    }
+
+    void *__wrap_calloc(size_t count, size_t size) {
+        void *ptr = __real_calloc(count, size);
+        if (ptr != nullptr) {
+            ONEBIOTAllocTrace::onAlloc(ptr, count * size);
+        }
+        return ptr;
+    }
+
+    void *__wrap_realloc(void *ptr, size_t size) {
+        void *result = __real_realloc(ptr, size);
+        // a failed realloc keeps the original block untouched
+        if (result != nullptr || size == 0) {
+            ONEBIOTAllocTrace::onFree(ptr);
+            if (result != nullptr) {
+                ONEBIOTAllocTrace::onAlloc(result, size);
+            }
+        }
+        return result;
+    }
+
+    void __wrap_free(void *ptr) {
+        ONEBIOTAllocTrace::onFree(ptr);
+        __real_free(ptr);
+    }
+}
+
+#endif //ONEBIOT_ALLOC_TRACE
+
+#endif //ONEBIOT_ALLOC_TRACE_CPP
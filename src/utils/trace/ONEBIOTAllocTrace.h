@@ -0,0 +1,66 @@
+#ifndef ONEBIOT_ALLOC_TRACE_H
+#define ONEBIOT_ALLOC_TRACE_H
+
+/**
+ * Opt-in heap allocation tracer. Every malloc/calloc/realloc/free is attributed
+ * to the active tag (a /cmd route or a lifecycle phase of ONEBIOTApp).
+ *
+ * Enable it with build flags, the tracer is not compiled at all otherwise:
+ *   -DONEBIOT_ALLOC_TRACE
+ *   -Wl,--wrap=malloc -Wl,--wrap=free -Wl,--wrap=realloc -Wl,--wrap=calloc
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ONEBIOT_ALLOC_TRACE
+
+#ifndef ONEBIOT_ALLOC_TRACE_TAGS
+#define ONEBIOT_ALLOC_TRACE_TAGS 16
+#endif
+
+// number of live allocations which could be tracked at once
+#ifndef ONEBIOT_ALLOC_TRACE_SLOTS
+#define ONEBIOT_ALLOC_TRACE_SLOTS 256
+#endif
+
+struct ONEBIOTAllocTraceCounters {
+    const char *tag = nullptr;
+    uint32_t count = 0;
+    uint32_t frees = 0;
+    uint32_t bytes = 0;
+    uint32_t live = 0;
+    uint32_t peak = 0;
+};
+
+class ONEBIOTAllocTrace {
+    public:
+        // tags are flash strings compared by pointer first, so pass PSTR() literals or route constants
+        static const char *setTag(const char *tag);
+        static size_t size();
+        static bool get(size_t index, ONEBIOTAllocTraceCounters &counters);
+        // allocations which did not fit into the slot table
+        static uint32_t untracked();
+        static void reset();
+
+        static void onAlloc(void *ptr, size_t size);
+        static void onFree(void *ptr);
+};
+
+class ONEBIOTAllocTraceScope {
+    public:
+        ONEBIOTAllocTraceScope(const char *tag) : _previous(ONEBIOTAllocTrace::setTag(tag)) {}
+        ~ONEBIOTAllocTraceScope() { ONEBIOTAllocTrace::setTag(_previous); }
+    private:
+        const char *_previous;
+};
+
+#define ONEBIOT_ALLOC_SCOPE(tag) ONEBIOTAllocTraceScope onebiotAllocScope_(tag)
+
+#else
+
+#define ONEBIOT_ALLOC_SCOPE(tag)
+
+#endif //ONEBIOT_ALLOC_TRACE
+
+#endif //ONEBIOT_ALLOC_TRACE_H
@@ -0,0 +1,31 @@
+#ifndef ONEBIOT_CHECK_H
+#define ONEBIOT_CHECK_H
+
+#include <stdio.h>
+
+/**
+ * Minimal assertions of the host tests, a failed check is reported and the
+ * test goes on, CHECK_DONE() turns the failures into the exit code for ctest.
+ */
+
+static int checkFailures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+        checkFailures++; \
+    } \
+} while (0)
+
+#define CHECK_EQUAL(expected, actual) do { \
+    long long checkExpected = (long long) (expected); \
+    long long checkActual = (long long) (actual); \
+    if (checkExpected != checkActual) { \
+        fprintf(stderr, "%s:%d: CHECK_EQUAL(%s, %s) failed, %lld != %lld\n", __FILE__, __LINE__, #expected, #actual, checkExpected, checkActual); \
+        checkFailures++; \
+    } \
+} while (0)
+
+#define CHECK_DONE() return checkFailures == 0 ? 0 : 1
+
+#endif //ONEBIOT_CHECK_H
@@ -0,0 +1,68 @@
+#ifndef ONEBIOT_HOST_HTTP_H
+#define ONEBIOT_HOST_HTTP_H
+
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+
+/**
+ * Client side of the tests, reads what the library wrote to the other end of
+ * a hostSocketPair() or a real connection and takes the HTTP response apart.
+ */
+
+// everything that arrives until the peer is quiet for quietMs
+inline std::string httpRead(int fd, int quietMs = 50) {
+    std::string data;
+    char buffer[1024];
+    pollfd ready = {fd, POLLIN, 0};
+    while (poll(&ready, 1, quietMs) > 0) {
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+        data.append(buffer, length);
+    }
+    return data;
+}
+
+inline int httpStatus(const std::string &response) {
+    return response.compare(0, 7, "HTTP/1.") == 0 ? atoi(response.c_str() + 9) : 0;
+}
+
+// value of a response header, empty when it is missing
+inline std::string httpHeader(const std::string &response, const std::string &name) {
+    size_t end = response.find("\r\n\r\n");
+    size_t position = response.find("\r\n" + name + ": ");
+    if (position == std::string::npos || position > end) {
+        return std::string();
+    }
+    position += name.length() + 4;
+    return response.substr(position, response.find("\r\n", position) - position);
+}
+
+// body of the response, chunked transfer encoding is taken apart
+inline std::string httpBody(const std::string &response) {
+    size_t position = response.find("\r\n\r\n");
+    if (position == std::string::npos) {
+        return std::string();
+    }
+    position += 4;
+    if (httpHeader(response, "Transfer-Encoding") != "chunked") {
+        return response.substr(position);
+    }
+
+    std::string body;
+    while (position < response.length()) {
+        size_t size = strtoul(response.c_str() + position, nullptr, 16);
+        position = response.find("\r\n", position);
+        if (size == 0 || position == std::string::npos) {
+            break;
+        }
+        body.append(response, position + 2, size);
+        position += 2 + size + 2;
+    }
+    return body;
+}
+
+#endif //ONEBIOT_HOST_HTTP_H
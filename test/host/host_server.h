@@ -0,0 +1,72 @@
+#ifndef ONEBIOT_HOST_SERVER_H
+#define ONEBIOT_HOST_SERVER_H
+
+#include <string>
+#include <thread>
+#include <ESP8266WebServer.h>
+#include "host_http.h"
+
+/**
+ * ESP8266WebServer fed through a socket pair instead of a listening socket,
+ * a test writes the raw request and gets the raw response back.
+ */
+class HostServer : public ESP8266WebServer {
+    public:
+        HostServer() {
+            // the headers ONEBIOTApp::start() asks the server to keep
+            static const char *headers[] = {"If-None-Match", "Accept", "Content-Type"};
+            collectHeaders(headers, 3);
+        }
+
+        // hands the connection to the server as if it had just been accepted
+        void attach(WiFiClient client) {
+            _currentClient = client;
+            _currentStatus = HC_WAIT_READ;
+            _statusChange = millis();
+        }
+
+        std::string request(const std::string &raw, IPAddress remote = IPAddress(192, 168, 4, 2)) {
+            int peer;
+            attach(hostSocketPair(peer, remote));
+            // a request bigger than the socket buffer is written while the server reads
+            std::thread writer([&raw, peer]() {
+                size_t sent = 0;
+                while (sent < raw.length()) {
+                    ssize_t length = ::write(peer, raw.data() + sent, raw.length() - sent);
+                    if (length <= 0) {
+                        break;
+                    }
+                    sent += length;
+                }
+            });
+            // the core keeps polling until the request line arrives
+            do {
+                handleClient();
+            } while (_currentStatus == HC_WAIT_READ);
+            writer.join();
+            _currentClient.stop();
+            _currentStatus = HC_NONE;
+            std::string response = httpRead(peer);
+            ::close(peer);
+            return response;
+        }
+};
+
+// the credentials the tests set, admin:secret
+static const char HOST_AUTHORIZATION[] = "Authorization: Basic YWRtaW46c2VjcmV0\r\n";
+
+inline std::string multipartRequest(const std::string &target, const std::string &filename, const std::string &content, bool authorized = true) {
+    std::string boundary = "----onebiot";
+    std::string body = "--" + boundary + "\r\n"
+        "Content-Disposition: form-data; name=\"file\"; filename=\"" + filename + "\"\r\n"
+        "Content-Type: application/octet-stream\r\n\r\n"
+        + content + "\r\n--" + boundary + "--\r\n";
+    return "POST " + target + " HTTP/1.1\r\n"
+        "Host: onebiot.local\r\n"
+        + (authorized ? HOST_AUTHORIZATION : "")
+        + "Content-Type: multipart/form-data; boundary=" + boundary + "\r\n"
+        "Content-Length: " + std::to_string(body.length()) + "\r\n\r\n"
+        + body;
+}
+
+#endif //ONEBIOT_HOST_SERVER_H
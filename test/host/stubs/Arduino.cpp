@@ -0,0 +1,255 @@
+#include <chrono>
+#include <random>
+#include <thread>
+#include <stdio.h>
+#include <unistd.h>
+#include "Arduino.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+int hostRestartCount = 0;
+
+static bool hostFrozen = false;
+static unsigned long long hostFrozenMicros = 0;
+static uint32_t hostFreeHeap = 40000;
+static std::mt19937 hostRandom;
+
+static unsigned long long hostRealMicros() {
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static unsigned long long hostMicros() {
+    return hostFrozen ? hostFrozenMicros : hostRealMicros();
+}
+
+unsigned long millis() {
+    return (unsigned long) (uint32_t) (hostMicros() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long) (uint32_t) hostMicros();
+}
+
+void delay(unsigned long ms) {
+    if (hostFrozen) {
+        hostFrozenMicros += ms * 1000ULL;
+    } else if (ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    } else {
+        std::this_thread::yield();
+    }
+}
+
+void delayMicroseconds(unsigned int us) {
+    if (hostFrozen) {
+        hostFrozenMicros += us;
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    }
+}
+
+void yield() {
+    if (!hostFrozen) {
+        std::this_thread::yield();
+    }
+}
+
+long random(long max) {
+    return max > 0 ? (long) (hostRandom() % (unsigned long) max) : 0;
+}
+
+long random(long min, long max) {
+    return max > min ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed) {
+    hostRandom.seed(seed);
+}
+
+void configTime(int, int, const char *, const char *, const char *) {}
+
+void hostClockFreeze() {
+    if (!hostFrozen) {
+        hostFrozenMicros = hostRealMicros();
+        hostFrozen = true;
+    }
+}
+
+void hostClockAdvance(unsigned long us) {
+    hostFrozenMicros += us;
+}
+
+void hostSetFreeHeap(uint32_t bytes) {
+    hostFreeHeap = bytes;
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return hostFreeHeap;
+}
+
+void EspClass::getHeapStats(uint32_t *free, uint16_t *max, uint8_t *fragmentation) {
+    if (free) *free = hostFreeHeap;
+    if (max) *max = hostFreeHeap > 0xffff ? 0xffff : hostFreeHeap;
+    if (fragmentation) *fragmentation = 0;
+}
+
+void EspClass::restart() {
+    hostRestartCount++;
+}
+
+size_t HardwareSerial::write(uint8_t data) {
+    return fwrite(&data, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+    return fwrite(buffer, 1, size, stdout);
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+    size_t written = 0;
+    while (size-- && write(*buffer++)) {
+        written++;
+    }
+    return written;
+}
+
+static size_t hostPrintf(Print &print, const char *format, va_list arguments) {
+    char buffer[256];
+    va_list copy;
+    va_copy(copy, arguments);
+    int length = vsnprintf(buffer, sizeof(buffer), format, copy);
+    va_end(copy);
+    if (length < 0) {
+        return 0;
+    }
+    if ((size_t) length < sizeof(buffer)) {
+        return print.write((const uint8_t *) buffer, length);
+    }
+
+    char *large = (char *) malloc(length + 1);
+    if (large == nullptr) {
+        return 0;
+    }
+    vsnprintf(large, length + 1, format, arguments);
+    size_t written = print.write((const uint8_t *) large, length);
+    free(large);
+    return written;
+}
+
+size_t Print::printf(const char *format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    size_t written = hostPrintf(*this, format, arguments);
+    va_end(arguments);
+    return written;
+}
+
+size_t Print::printf_P(PGM_P format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    size_t written = hostPrintf(*this, format, arguments);
+    va_end(arguments);
+    return written;
+}
+
+int Stream::read(uint8_t *buffer, size_t size) {
+    int count = 0;
+    int data;
+    while ((size_t) count < size && (data = read()) >= 0) {
+        buffer[count++] = data;
+    }
+    return count;
+}
+
+int Stream::timedRead() {
+    unsigned long start = millis();
+    do {
+        int data = read();
+        if (data >= 0) {
+            return data;
+        }
+        yield();
+    } while (millis() - start < _timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int data = timedRead();
+        if (data < 0) {
+            break;
+        }
+        buffer[count++] = (char) data;
+    }
+    return count;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int data = timedRead();
+        if (data < 0 || data == terminator) {
+            break;
+        }
+        buffer[count++] = (char) data;
+    }
+    return count;
+}
+
+String Stream::readString() {
+    String result;
+    int data;
+    while ((data = timedRead()) >= 0) {
+        result += (char) data;
+    }
+    return result;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String result;
+    int data;
+    while ((data = timedRead()) >= 0 && data != terminator) {
+        result += (char) data;
+    }
+    return result;
+}
+
+IPAddress::IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth) {
+    uint8_t *bytes = (uint8_t *) &_address;
+    bytes[0] = first;
+    bytes[1] = second;
+    bytes[2] = third;
+    bytes[3] = fourth;
+}
+
+IPAddress::IPAddress(const uint8_t *address) {
+    memcpy(&_address, address, 4);
+}
+
+bool IPAddress::fromString(const char *address) {
+    unsigned int parts[4];
+    char end;
+    if (sscanf(address, "%u.%u.%u.%u%c", &parts[0], &parts[1], &parts[2], &parts[3], &end) != 4) {
+        return false;
+    }
+    for (int i = 0; i < 4; i++) {
+        if (parts[i] > 255) {
+            return false;
+        }
+    }
+    *this = IPAddress(parts[0], parts[1], parts[2], parts[3]);
+    return true;
+}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    const uint8_t *bytes = (const uint8_t *) &_address;
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+    return String(buffer);
+}
+
+size_t IPAddress::printTo(Print &print) const {
+    return print.print(toString());
+}
@@ -0,0 +1,104 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+/**
+ * Stand-in for the ESP8266 Arduino core on Linux. Just enough of the core API
+ * for the library modules under test, backed by the host: the heap is malloc,
+ * sockets are POSIX sockets and file systems live in memory.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <functional>
+
+#include "pgmspace.h"
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+
+using std::min;
+using std::max;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define LED_BUILTIN 2
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+// hardware random number register of the ESP8266
+#define RANDOM_REG32 ((uint32_t) random(0x7fffffff))
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return LOW; }
+
+void configTime(int timezone, int daylightOffset, const char *server1, const char *server2 = nullptr, const char *server3 = nullptr);
+
+class HardwareSerial : public Stream {
+    public:
+        void begin(unsigned long) {}
+        int available() override { return 0; }
+        int read() override { return -1; }
+        int peek() override { return -1; }
+        size_t write(uint8_t data) override;
+        size_t write(const uint8_t *buffer, size_t size) override;
+        int availableForWrite() override { return 256; }
+        using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+    public:
+        uint32_t getFreeHeap();
+        uint8_t getHeapFragmentation() { return 0; }
+        uint32_t getMaxFreeBlockSize() { return getFreeHeap(); }
+        void getHeapStats(uint32_t *free, uint16_t *max, uint8_t *fragmentation);
+        uint32_t getChipId() { return 0x00c0ffee; }
+        String getCoreVersion() { return F("host"); }
+        const char *getSdkVersion() { return "host"; }
+        uint8_t getCpuFreqMHz() { return 80; }
+        uint32_t getSketchSize() { return 400000; }
+        uint32_t getFreeSketchSpace() { return 1 << 20; }
+        String getSketchMD5() { return F("00000000000000000000000000000000"); }
+        uint32_t getFlashChipId() { return 0x1640ef; }
+        uint32_t getFlashChipSize() { return 4 << 20; }
+        uint32_t getFlashChipRealSize() { return 4 << 20; }
+        String getResetReason() { return F("host"); }
+        uint32_t getCycleCount() { return (uint32_t) micros() * 80; }
+        void restart();
+        void reset() { restart(); }
+        void deepSleep(uint64_t) {}
+};
+
+extern EspClass ESP;
+
+// --- host only, the tests steer the stand-in through these ---
+
+// millis() and micros() follow the real time until a test freezes the clock,
+// then only delay() and hostClockAdvance() move it
+void hostClockFreeze();
+void hostClockAdvance(unsigned long us);
+// what ESP.getFreeHeap() reports
+void hostSetFreeHeap(uint32_t bytes);
+// ESP.restart() only counts, the test process goes on
+extern int hostRestartCount;
+
+#endif //HOST_ARDUINO_H
@@ -0,0 +1,600 @@
+#include "ESP8266WebServer.h"
+
+static const String hostEmptyString;
+
+class HostFunctionRequestHandler : public RequestHandler {
+    public:
+        HostFunctionRequestHandler(ESP8266WebServer::THandlerFunction fn, ESP8266WebServer::THandlerFunction ufn, const String &uri, HTTPMethod method)
+            : _fn(fn), _ufn(ufn), _uri(uri), _method(method) {}
+        bool canHandle(HTTPMethod requestMethod, String requestUri) override {
+            return (_method == HTTP_ANY || _method == requestMethod) && requestUri == _uri;
+        }
+        bool canUpload(String requestUri) override {
+            return _ufn && canHandle(HTTP_POST, requestUri);
+        }
+        bool handle(ESP8266WebServer &, HTTPMethod requestMethod, String requestUri) override {
+            if (!canHandle(requestMethod, requestUri)) {
+                return false;
+            }
+            _fn();
+            return true;
+        }
+        void upload(ESP8266WebServer &, String requestUri, HTTPUpload &) override {
+            if (canUpload(requestUri)) {
+                _ufn();
+            }
+        }
+    private:
+        ESP8266WebServer::THandlerFunction _fn;
+        ESP8266WebServer::THandlerFunction _ufn;
+        String _uri;
+        HTTPMethod _method;
+};
+
+static String hostBase64(const String &text) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    String result;
+    const uint8_t *data = (const uint8_t *) text.c_str();
+    size_t length = text.length();
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t block = data[i] << 16;
+        if (i + 1 < length) block |= data[i + 1] << 8;
+        if (i + 2 < length) block |= data[i + 2];
+        result += alphabet[(block >> 18) & 63];
+        result += alphabet[(block >> 12) & 63];
+        result += i + 1 < length ? alphabet[(block >> 6) & 63] : '=';
+        result += i + 2 < length ? alphabet[block & 63] : '=';
+    }
+    return result;
+}
+
+ESP8266WebServer::~ESP8266WebServer() {
+    _server.close();
+}
+
+void ESP8266WebServer::handleClient() {
+    if (_currentStatus == HC_NONE) {
+        WiFiClient client = _server.available();
+        if (!client) {
+            return;
+        }
+        _currentClient = client;
+        _currentStatus = HC_WAIT_READ;
+        _statusChange = millis();
+    }
+
+    bool keepCurrentClient = false;
+    bool callYield = false;
+    if (_currentClient.connected() || _currentClient.available()) {
+        switch (_currentStatus) {
+            case HC_NONE:
+                break;
+            case HC_WAIT_READ:
+                if (_currentClient.available()) {
+                    if (_parseRequest(_currentClient)) {
+                        _currentClient.setTimeout(HTTP_MAX_SEND_WAIT);
+                        _contentLength = CONTENT_LENGTH_NOT_SET;
+                        _handleRequest();
+                        if (_currentClient.connected()) {
+                            _currentStatus = HC_WAIT_CLOSE;
+                            _statusChange = millis();
+                            keepCurrentClient = true;
+                        }
+                    }
+                } else {
+                    if (millis() - _statusChange <= HTTP_MAX_DATA_WAIT) {
+                        keepCurrentClient = true;
+                    }
+                    callYield = true;
+                }
+                break;
+            case HC_WAIT_CLOSE:
+                if (millis() - _statusChange <= HTTP_MAX_CLOSE_WAIT) {
+                    keepCurrentClient = true;
+                    callYield = true;
+                }
+                break;
+        }
+    }
+
+    if (!keepCurrentClient) {
+        _currentClient = WiFiClient();
+        _currentStatus = HC_NONE;
+        _currentUpload.reset();
+    }
+    if (callYield) {
+        yield();
+    }
+}
+
+bool ESP8266WebServer::authenticate(const char *user, const char *password) {
+    String authorization = header(F("Authorization"));
+    if (!authorization.startsWith(F("Basic"))) {
+        return false;
+    }
+    authorization = authorization.substring(6);
+    authorization.trim();
+    return authorization == hostBase64(String(user) + ':' + password);
+}
+
+void ESP8266WebServer::requestAuthentication(HTTPAuthMethod, const char *realm, const String &authFailMsg) {
+    sendHeader(F("WWW-Authenticate"), String(F("Basic realm=\"")) + (realm ? realm : "Login Required") + '"');
+    send(401, "text/html", authFailMsg);
+}
+
+void ESP8266WebServer::on(const String &uri, HTTPMethod method, THandlerFunction fn) {
+    on(uri, method, fn, _fileUploadHandler);
+}
+
+void ESP8266WebServer::on(const String &uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn) {
+    _ownedHandlers.emplace_back(new HostFunctionRequestHandler(fn, ufn, uri, method));
+    addHandler(_ownedHandlers.back().get());
+}
+
+void ESP8266WebServer::addHandler(RequestHandler *handler) {
+    if (!_lastHandler) {
+        _firstHandler = handler;
+    } else {
+        _lastHandler->next(handler);
+    }
+    _lastHandler = handler;
+}
+
+const String &ESP8266WebServer::arg(const String &name) const {
+    for (const RequestArgument &argument : _currentArgs) {
+        if (argument.key == name) {
+            return argument.value;
+        }
+    }
+    return hostEmptyString;
+}
+
+const String &ESP8266WebServer::arg(int i) const {
+    return i >= 0 && i < args() ? _currentArgs[i].value : hostEmptyString;
+}
+
+const String &ESP8266WebServer::argName(int i) const {
+    return i >= 0 && i < args() ? _currentArgs[i].key : hostEmptyString;
+}
+
+bool ESP8266WebServer::hasArg(const String &name) const {
+    for (const RequestArgument &argument : _currentArgs) {
+        if (argument.key == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ESP8266WebServer::collectHeaders(const char *headerKeys[], const size_t headerKeysCount) {
+    _currentHeaders.clear();
+    _currentHeaders.push_back({String(F("Authorization")), String()});
+    for (size_t i = 0; i < headerKeysCount; i++) {
+        _currentHeaders.push_back({String(headerKeys[i]), String()});
+    }
+}
+
+const String &ESP8266WebServer::header(const String &name) const {
+    for (const RequestArgument &current : _currentHeaders) {
+        if (current.key.equalsIgnoreCase(name)) {
+            return current.value;
+        }
+    }
+    return hostEmptyString;
+}
+
+const String &ESP8266WebServer::header(int i) const {
+    return i >= 0 && i < headers() ? _currentHeaders[i].value : hostEmptyString;
+}
+
+const String &ESP8266WebServer::headerName(int i) const {
+    return i >= 0 && i < headers() ? _currentHeaders[i].key : hostEmptyString;
+}
+
+bool ESP8266WebServer::hasHeader(const String &name) const {
+    return header(name).length() > 0;
+}
+
+void ESP8266WebServer::send(int code, const char *content_type, const String &content) {
+    String header;
+    _prepareHeader(header, code, content_type, content.length());
+    _currentClientWrite(header.c_str(), header.length());
+    if (content.length()) {
+        sendContent(content);
+    }
+}
+
+void ESP8266WebServer::send(int code, const char *content_type, const char *content, size_t contentLength) {
+    String header;
+    _prepareHeader(header, code, content_type, contentLength);
+    _currentClientWrite(header.c_str(), header.length());
+    if (contentLength) {
+        sendContent(content, contentLength);
+    }
+}
+
+void ESP8266WebServer::sendHeader(const String &name, const String &value, bool first) {
+    String headerLine = name + F(": ") + value + F("\r\n");
+    if (first) {
+        _responseHeaders = headerLine + _responseHeaders;
+    } else {
+        _responseHeaders += headerLine;
+    }
+}
+
+void ESP8266WebServer::sendContent(const char *content, size_t size) {
+    if (_chunked) {
+        char chunkSize[11];
+        snprintf(chunkSize, sizeof(chunkSize), "%zx\r\n", size);
+        _currentClientWrite(chunkSize, strlen(chunkSize));
+    }
+    _currentClientWrite(content, size);
+    if (_chunked) {
+        _currentClientWrite("\r\n", 2);
+        if (size == 0) {
+            _chunked = false;
+        }
+    }
+}
+
+String ESP8266WebServer::urlDecode(const String &text) {
+    String decoded;
+    for (size_t i = 0; i < text.length(); i++) {
+        char ch = text[i];
+        if (ch == '+') {
+            decoded += ' ';
+        } else if (ch == '%' && i + 2 < text.length()) {
+            char hex[3] = {text[i + 1], text[i + 2], 0};
+            decoded += (char) strtol(hex, nullptr, 16);
+            i += 2;
+        } else {
+            decoded += ch;
+        }
+    }
+    return decoded;
+}
+
+String ESP8266WebServer::responseCodeToString(int code) {
+    switch (code) {
+        case 200: return F("OK");
+        case 204: return F("No Content");
+        case 301: return F("Moved Permanently");
+        case 302: return F("Found");
+        case 304: return F("Not Modified");
+        case 400: return F("Bad Request");
+        case 401: return F("Unauthorized");
+        case 403: return F("Forbidden");
+        case 404: return F("Not Found");
+        case 405: return F("Method Not Allowed");
+        case 408: return F("Request Time-out");
+        case 413: return F("Request Entity Too Large");
+        case 429: return F("Too Many Requests");
+        case 500: return F("Internal Server Error");
+        case 503: return F("Service Unavailable");
+        default: return F("");
+    }
+}
+
+bool ESP8266WebServer::_parseRequest(WiFiClient &client) {
+    String request = client.readStringUntil('\r');
+    client.readStringUntil('\n');
+    for (RequestArgument &current : _currentHeaders) {
+        current.value = String();
+    }
+
+    // GET /path?search HTTP/1.1
+    int addressStart = request.indexOf(' ');
+    int addressEnd = request.indexOf(' ', addressStart + 1);
+    if (addressStart == -1 || addressEnd == -1) {
+        return false;
+    }
+    String methodName = request.substring(0, addressStart);
+    String url = request.substring(addressStart + 1, addressEnd);
+    _currentVersion = atoi(request.substring(addressEnd + 8).c_str());
+    String search;
+    int hasSearch = url.indexOf('?');
+    if (hasSearch != -1) {
+        search = url.substring(hasSearch + 1);
+        url = url.substring(0, hasSearch);
+    }
+    _currentUri = url;
+    _chunked = false;
+
+    HTTPMethod method = HTTP_GET;
+    if (methodName == "HEAD") method = HTTP_HEAD;
+    else if (methodName == "POST") method = HTTP_POST;
+    else if (methodName == "DELETE") method = HTTP_DELETE;
+    else if (methodName == "OPTIONS") method = HTTP_OPTIONS;
+    else if (methodName == "PUT") method = HTTP_PUT;
+    else if (methodName == "PATCH") method = HTTP_PATCH;
+    _currentMethod = method;
+
+    RequestHandler *handler;
+    for (handler = _firstHandler; handler; handler = handler->next()) {
+        if (handler->canHandle(_currentMethod, _currentUri)) {
+            break;
+        }
+    }
+    _currentHandler = handler;
+
+    String boundary;
+    bool isForm = false;
+    bool isEncoded = false;
+    uint32_t contentLength = 0;
+    for (;;) {
+        request = client.readStringUntil('\r');
+        client.readStringUntil('\n');
+        if (request.isEmpty()) {
+            break;
+        }
+        int divider = request.indexOf(':');
+        if (divider == -1) {
+            break;
+        }
+        String name = request.substring(0, divider);
+        String value = request.substring(divider + 1);
+        value.trim();
+        _collectHeader(name.c_str(), value.c_str());
+        if (name.equalsIgnoreCase(F("Content-Type"))) {
+            if (value.startsWith(F("application/x-www-form-urlencoded"))) {
+                isEncoded = true;
+            } else if (value.startsWith(F("multipart/"))) {
+                boundary = value.substring(value.indexOf('=') + 1);
+                boundary.replace("\"", "");
+                isForm = true;
+            }
+        } else if (name.equalsIgnoreCase(F("Content-Length"))) {
+            contentLength = value.toInt();
+        } else if (name.equalsIgnoreCase(F("Host"))) {
+            _hostHeader = value;
+        }
+    }
+
+    _currentArgs.clear();
+    if (method == HTTP_POST || method == HTTP_PUT || method == HTTP_PATCH || method == HTTP_DELETE) {
+        String plain;
+        if (!isForm && contentLength) {
+            // the core reads the whole body into one heap buffer
+            char *buffer = (char *) malloc(contentLength + 1);
+            if (buffer == nullptr) {
+                return false;
+            }
+            client.setTimeout(HTTP_MAX_POST_WAIT);
+            size_t length = client.readBytes(buffer, contentLength);
+            buffer[length] = '\0';
+            plain = String(buffer, length);
+            free(buffer);
+            if (length < contentLength) {
+                return false;
+            }
+        }
+        if (isEncoded) {
+            if (search.length()) {
+                search += '&';
+            }
+            search += plain;
+        }
+        _parseArguments(search);
+        if (!isForm) {
+            if (contentLength) {
+                _currentArgs.push_back({String(F("plain")), plain});
+            }
+        } else if (!_parseForm(client, boundary, contentLength)) {
+            return false;
+        }
+    } else {
+        _parseArguments(search);
+    }
+    return true;
+}
+
+void ESP8266WebServer::_parseArguments(const String &data) {
+    if (data.length() == 0) {
+        return;
+    }
+    size_t position = 0;
+    while (position <= data.length()) {
+        int end = data.indexOf('&', position);
+        if (end < 0) {
+            end = data.length();
+        }
+        String pair = data.substring(position, end);
+        if (pair.length()) {
+            int equal = pair.indexOf('=');
+            if (equal < 0) {
+                _currentArgs.push_back({urlDecode(pair), String()});
+            } else {
+                _currentArgs.push_back({urlDecode(pair.substring(0, equal)), urlDecode(pair.substring(equal + 1))});
+            }
+        }
+        position = end + 1;
+    }
+}
+
+void ESP8266WebServer::_uploadWriteByte(uint8_t data) {
+    if (_currentUpload->currentSize == HTTP_UPLOAD_BUFLEN) {
+        if (_currentHandler && _currentHandler->canUpload(_currentUri)) {
+            _currentHandler->upload(*this, _currentUri, *_currentUpload);
+        }
+        _currentUpload->totalSize += _currentUpload->currentSize;
+        _currentUpload->currentSize = 0;
+    }
+    _currentUpload->buf[_currentUpload->currentSize++] = data;
+}
+
+// multipart/form-data, files are handed to the handler in HTTP_UPLOAD_BUFLEN blocks
+bool ESP8266WebServer::_parseForm(WiFiClient &client, const String &boundary, uint32_t) {
+    client.setTimeout(HTTP_MAX_DATA_WAIT);
+    String line = client.readStringUntil('\r');
+    client.readStringUntil('\n');
+    if (line != String("--") + boundary) {
+        return false;
+    }
+
+    String delimiter = String("\r\n--") + boundary;
+    for (;;) {
+        String name;
+        String filename;
+        String type = F("text/plain");
+        for (;;) {
+            line = client.readStringUntil('\r');
+            client.readStringUntil('\n');
+            if (line.isEmpty()) {
+                break;
+            }
+            if (line.startsWith(F("Content-Disposition"))) {
+                int start = line.indexOf(F("name=\""));
+                if (start >= 0) {
+                    name = line.substring(start + 6, line.indexOf('"', start + 6));
+                }
+                start = line.indexOf(F("filename=\""));
+                if (start >= 0) {
+                    filename = line.substring(start + 10, line.indexOf('"', start + 10));
+                }
+            } else if (line.startsWith(F("Content-Type"))) {
+                type = line.substring(line.indexOf(':') + 1);
+                type.trim();
+            }
+        }
+
+        bool isFile = filename.length() > 0;
+        String value;
+        if (isFile) {
+            _currentUpload.reset(new HTTPUpload());
+            _currentUpload->status = UPLOAD_FILE_START;
+            _currentUpload->name = name;
+            _currentUpload->filename = filename;
+            _currentUpload->type = type;
+            _currentUpload->totalSize = 0;
+            _currentUpload->currentSize = 0;
+            _currentUpload->contentLength = 0;
+            if (_currentHandler && _currentHandler->canUpload(_currentUri)) {
+                _currentHandler->upload(*this, _currentUri, *_currentUpload);
+            }
+            _currentUpload->status = UPLOAD_FILE_WRITE;
+        }
+
+        // the delimiter is matched byte by byte, a partial match is data after all
+        size_t matched = 0;
+        bool found = false;
+        uint8_t data;
+        while (client.readBytes(&data, 1) == 1) {
+            if ((char) data == delimiter[matched]) {
+                if (++matched == delimiter.length()) {
+                    found = true;
+                    break;
+                }
+                continue;
+            }
+            for (size_t i = 0; i < matched; i++) {
+                isFile ? _uploadWriteByte(delimiter[i]) : (void) (value += delimiter[i]);
+            }
+            matched = 0;
+            if ((char) data == delimiter[0]) {
+                matched = 1;
+                continue;
+            }
+            isFile ? _uploadWriteByte(data) : (void) (value += (char) data);
+        }
+
+        if (!found) {
+            if (isFile) {
+                _currentUpload->status = UPLOAD_FILE_ABORTED;
+                if (_currentHandler && _currentHandler->canUpload(_currentUri)) {
+                    _currentHandler->upload(*this, _currentUri, *_currentUpload);
+                }
+            }
+            return false;
+        }
+
+        if (isFile) {
+            if (_currentHandler && _currentHandler->canUpload(_currentUri)) {
+                _currentHandler->upload(*this, _currentUri, *_currentUpload);
+            }
+            _currentUpload->totalSize += _currentUpload->currentSize;
+            _currentUpload->currentSize = 0;
+            _currentUpload->status = UPLOAD_FILE_END;
+            if (_currentHandler && _currentHandler->canUpload(_currentUri)) {
+                _currentHandler->upload(*this, _currentUri, *_currentUpload);
+            }
+        } else {
+            _currentArgs.push_back({name, value});
+        }
+
+        // "--" after the delimiter ends the form, a line break starts the next part
+        char tail[2];
+        if (client.readBytes(tail, 2) != 2) {
+            return false;
+        }
+        if (tail[0] == '-' && tail[1] == '-') {
+            client.readStringUntil('\n');
+            return true;
+        }
+    }
+}
+
+void ESP8266WebServer::_handleRequest() {
+    bool handled = false;
+    if (_currentHandler) {
+        handled = _currentHandler->handle(*this, _currentMethod, _currentUri);
+    }
+    if (!handled && _notFoundHandler) {
+        _notFoundHandler();
+        handled = true;
+    }
+    if (!handled) {
+        send(404, "text/html", String(F("Not found: ")) + _currentUri);
+        handled = true;
+    }
+    if (handled) {
+        _finalizeResponse();
+    }
+    _currentUri = "";
+}
+
+void ESP8266WebServer::_finalizeResponse() {
+    if (_chunked) {
+        sendContent(hostEmptyString);
+    }
+}
+
+void ESP8266WebServer::_prepareHeader(String &response, int code, const char *content_type, size_t contentLength) {
+    response = String(F("HTTP/1.")) + String(_currentVersion) + ' ';
+    response += String(code);
+    response += ' ';
+    response += responseCodeToString(code);
+    response += "\r\n";
+
+    sendHeader(F("Content-Type"), content_type ? content_type : "text/html", true);
+    if (_contentLength == CONTENT_LENGTH_NOT_SET) {
+        sendHeader(F("Content-Length"), String(contentLength));
+    } else if (_contentLength != CONTENT_LENGTH_UNKNOWN) {
+        sendHeader(F("Content-Length"), String(_contentLength));
+    } else if (_currentVersion) {
+        _chunked = true;
+        sendHeader(F("Accept-Ranges"), F("none"));
+        sendHeader(F("Transfer-Encoding"), F("chunked"));
+    }
+    // the 2.x cores close every connection after the response
+    sendHeader(F("Connection"), F("close"));
+
+    response += _responseHeaders;
+    response += "\r\n";
+    _responseHeaders = "";
+}
+
+void ESP8266WebServer::_streamFileCore(const size_t fileSize, const String &fileName, const String &contentType, const int code) {
+    setContentLength(fileSize);
+    if (fileName.endsWith(F(".gz")) && contentType != "application/x-gzip" && contentType != "application/octet-stream") {
+        sendHeader(F("Content-Encoding"), F("gzip"));
+    }
+    send(code, contentType, hostEmptyString);
+}
+
+void ESP8266WebServer::_collectHeader(const char *name, const char *value) {
+    for (RequestArgument &current : _currentHeaders) {
+        if (current.key.equalsIgnoreCase(name)) {
+            current.value = value;
+        }
+    }
+}
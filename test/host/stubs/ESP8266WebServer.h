@@ -0,0 +1,174 @@
+#ifndef HOST_ESP8266WEBSERVER_H
+#define HOST_ESP8266WEBSERVER_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+#include "FS.h"
+
+/**
+ * ESP8266WebServer as the 2.x cores have it, one request per handleClient()
+ * call, "Connection: close" on every response and the protected state the
+ * library reaches into. Parsing follows the core closely, so a handler sees
+ * the same args, headers and upload callbacks as on the device.
+ */
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+enum HTTPClientStatus { HC_NONE, HC_WAIT_READ, HC_WAIT_CLOSE };
+enum HTTPAuthMethod { BASIC_AUTH, DIGEST_AUTH };
+
+#define HTTP_DOWNLOAD_UNIT_SIZE 1460
+#define HTTP_UPLOAD_BUFLEN 2048
+#define HTTP_MAX_DATA_WAIT 5000
+#define HTTP_MAX_POST_WAIT 5000
+#define HTTP_MAX_SEND_WAIT 5000
+#define HTTP_MAX_CLOSE_WAIT 2000
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+#define CONTENT_LENGTH_NOT_SET ((size_t) -2)
+
+struct HTTPUpload {
+    HTTPUploadStatus status;
+    String filename;
+    String name;
+    String type;
+    size_t totalSize;
+    size_t currentSize;
+    size_t contentLength;
+    uint8_t buf[HTTP_UPLOAD_BUFLEN + 1];
+};
+
+class ESP8266WebServer;
+
+class RequestHandler {
+    public:
+        virtual ~RequestHandler() {}
+        virtual bool canHandle(HTTPMethod method, String uri) { (void) method; (void) uri; return false; }
+        virtual bool canUpload(String uri) { (void) uri; return false; }
+        virtual bool handle(ESP8266WebServer &server, HTTPMethod requestMethod, String requestUri) { (void) server; (void) requestMethod; (void) requestUri; return false; }
+        virtual void upload(ESP8266WebServer &server, String requestUri, HTTPUpload &upload) { (void) server; (void) requestUri; (void) upload; }
+        RequestHandler *next() { return _next; }
+        void next(RequestHandler *handler) { _next = handler; }
+    private:
+        RequestHandler *_next = nullptr;
+};
+
+class ESP8266WebServer {
+    public:
+        typedef std::function<void(void)> THandlerFunction;
+
+        ESP8266WebServer(int port = 80) : _server(port) {}
+        virtual ~ESP8266WebServer();
+
+        void begin() { _currentStatus = HC_NONE; _server.begin(); }
+        void begin(uint16_t port) { _currentStatus = HC_NONE; _server.begin(port); }
+        void handleClient();
+        void close() { _server.close(); }
+        void stop() { close(); }
+
+        bool authenticate(const char *user, const char *password);
+        void requestAuthentication(HTTPAuthMethod mode = BASIC_AUTH, const char *realm = nullptr, const String &authFailMsg = String(""));
+
+        void on(const String &uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+        void on(const String &uri, HTTPMethod method, THandlerFunction fn);
+        void on(const String &uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
+        void addHandler(RequestHandler *handler);
+        void onNotFound(THandlerFunction fn) { _notFoundHandler = fn; }
+        void onFileUpload(THandlerFunction fn) { _fileUploadHandler = fn; }
+
+        const String &uri() const { return _currentUri; }
+        HTTPMethod method() const { return _currentMethod; }
+        WiFiClient &client() { return _currentClient; }
+        HTTPUpload &upload() { return *_currentUpload; }
+
+        const String &arg(const String &name) const;
+        const String &arg(int i) const;
+        const String &argName(int i) const;
+        int args() const { return (int) _currentArgs.size(); }
+        bool hasArg(const String &name) const;
+        void collectHeaders(const char *headerKeys[], const size_t headerKeysCount);
+        const String &header(const String &name) const;
+        const String &header(int i) const;
+        const String &headerName(int i) const;
+        int headers() const { return (int) _currentHeaders.size(); }
+        bool hasHeader(const String &name) const;
+        const String &hostHeader() const { return _hostHeader; }
+
+        void send(int code, const char *content_type = nullptr, const String &content = String(""));
+        void send(int code, char *content_type, const String &content) { send(code, (const char *) content_type, content); }
+        void send(int code, const String &content_type, const String &content) { send(code, content_type.c_str(), content); }
+        void send(int code, const char *content_type, const char *content) { send(code, content_type, content, strlen(content)); }
+        void send(int code, const char *content_type, const char *content, size_t contentLength);
+        void send_P(int code, PGM_P content_type, PGM_P content) { send(code, content_type, content); }
+        void send_P(int code, PGM_P content_type, PGM_P content, size_t contentLength) { send(code, content_type, content, contentLength); }
+
+        void setContentLength(const size_t contentLength) { _contentLength = contentLength; }
+        void sendHeader(const String &name, const String &value, bool first = false);
+        void sendContent(const String &content) { sendContent(content.c_str(), content.length()); }
+        void sendContent(const char *content) { sendContent(content, strlen(content)); }
+        void sendContent(const char *content, size_t size);
+        void sendContent_P(PGM_P content) { sendContent(content); }
+        void sendContent_P(PGM_P content, size_t size) { sendContent(content, size); }
+
+        template <typename T>
+        size_t streamFile(T &file, const String &contentType, const int code = 200) {
+            _streamFileCore(file.size(), file.name(), contentType, code);
+            uint8_t buffer[HTTP_DOWNLOAD_UNIT_SIZE];
+            size_t sent = 0;
+            int length;
+            while ((length = file.read(buffer, sizeof(buffer))) > 0) {
+                sent += _currentClient.write(buffer, length);
+            }
+            return sent;
+        }
+
+        static String urlDecode(const String &text);
+        static String responseCodeToString(int code);
+
+        // --- host only ---
+        uint16_t hostPort() const { return _server.hostPort(); }
+    protected:
+        struct RequestArgument {
+            String key;
+            String value;
+        };
+
+        bool _parseRequest(WiFiClient &client);
+        void _parseArguments(const String &data);
+        bool _parseForm(WiFiClient &client, const String &boundary, uint32_t length);
+        void _uploadWriteByte(uint8_t data);
+        void _handleRequest();
+        void _finalizeResponse();
+        void _prepareHeader(String &response, int code, const char *content_type, size_t contentLength);
+        void _streamFileCore(const size_t fileSize, const String &fileName, const String &contentType, const int code);
+        void _currentClientWrite(const char *data, size_t length) { _currentClient.write((const uint8_t *) data, length); }
+        void _collectHeader(const char *name, const char *value);
+
+        WiFiServer _server;
+        WiFiClient _currentClient;
+        HTTPMethod _currentMethod = HTTP_ANY;
+        String _currentUri;
+        uint8_t _currentVersion = 1;
+        HTTPClientStatus _currentStatus = HC_NONE;
+        unsigned long _statusChange = 0;
+
+        RequestHandler *_currentHandler = nullptr;
+        RequestHandler *_firstHandler = nullptr;
+        RequestHandler *_lastHandler = nullptr;
+        std::vector<std::unique_ptr<RequestHandler>> _ownedHandlers;
+        THandlerFunction _notFoundHandler;
+        THandlerFunction _fileUploadHandler;
+
+        std::vector<RequestArgument> _currentArgs;
+        std::unique_ptr<HTTPUpload> _currentUpload;
+        std::vector<RequestArgument> _currentHeaders;
+        size_t _contentLength = CONTENT_LENGTH_NOT_SET;
+        bool _chunked = false;
+        String _responseHeaders;
+        String _hostHeader;
+};
+
+#endif //HOST_ESP8266WEBSERVER_H
@@ -0,0 +1,303 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/sockios.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "ESP8266WiFi.h"
+#include "ESP8266mDNS.h"
+
+ESP8266WiFiClass WiFi;
+MDNSResponder MDNS;
+
+struct HostSocket {
+    int fd;
+    IPAddress remote;
+    uint16_t remotePort = 0;
+    int writeLimit = -1;
+
+    explicit HostSocket(int fd) : fd(fd) {}
+    ~HostSocket() {
+        close();
+    }
+    void close() {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+};
+
+static std::shared_ptr<HostSocket> hostAdopt(int fd) {
+    std::shared_ptr<HostSocket> socket = std::make_shared<HostSocket>(fd);
+    sockaddr_in address;
+    socklen_t length = sizeof(address);
+    if (getpeername(fd, (sockaddr *) &address, &length) == 0 && address.sin_family == AF_INET) {
+        socket->remote = IPAddress((uint32_t) address.sin_addr.s_addr);
+        socket->remotePort = ntohs(address.sin_port);
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return socket;
+}
+
+WiFiClient hostSocketPair(int &peer, IPAddress remote) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        peer = -1;
+        return WiFiClient();
+    }
+    peer = fds[1];
+    std::shared_ptr<HostSocket> socket = std::make_shared<HostSocket>(fds[0]);
+    socket->remote = remote;
+    socket->remotePort = 50000;
+    return WiFiClient(socket);
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return 0;
+    }
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = (uint32_t) ip;
+    if (::connect(fd, (sockaddr *) &address, sizeof(address)) != 0) {
+        ::close(fd);
+        return 0;
+    }
+    _socket = hostAdopt(fd);
+    return 1;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+    IPAddress ip;
+    if (strcmp(host, "localhost") == 0) {
+        ip = IPAddress(127, 0, 0, 1);
+    } else if (!ip.fromString(host)) {
+        return 0;
+    }
+    return connect(ip, port);
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size) {
+    if (!_socket || _socket->fd < 0) {
+        return 0;
+    }
+    // blocks until everything is handed to the socket or the timeout passes, like the core
+    size_t written = 0;
+    unsigned long start = millis();
+    while (written < size) {
+        ssize_t sent = send(_socket->fd, buffer + written, size - written, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent > 0) {
+            written += sent;
+            continue;
+        }
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            break;
+        }
+        if (millis() - start > _timeout) {
+            break;
+        }
+        pollfd descriptor = {_socket->fd, POLLOUT, 0};
+        poll(&descriptor, 1, 10);
+    }
+    return written;
+}
+
+int WiFiClient::available() {
+    if (!_socket || _socket->fd < 0) {
+        return 0;
+    }
+    int count = 0;
+    if (ioctl(_socket->fd, FIONREAD, &count) != 0) {
+        return 0;
+    }
+    return count;
+}
+
+int WiFiClient::read() {
+    uint8_t data;
+    return read(&data, 1) == 1 ? data : -1;
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size) {
+    if (!_socket || _socket->fd < 0 || size == 0) {
+        return 0;
+    }
+    ssize_t received = recv(_socket->fd, buffer, size, MSG_DONTWAIT);
+    return received > 0 ? (int) received : 0;
+}
+
+int WiFiClient::peek() {
+    uint8_t data;
+    return peekBytes(&data, 1) == 1 ? data : -1;
+}
+
+size_t WiFiClient::peekBytes(uint8_t *buffer, size_t size) {
+    if (!_socket || _socket->fd < 0 || size == 0) {
+        return 0;
+    }
+    ssize_t received = recv(_socket->fd, buffer, size, MSG_PEEK | MSG_DONTWAIT);
+    return received > 0 ? received : 0;
+}
+
+int WiFiClient::availableForWrite() {
+    if (!_socket || _socket->fd < 0) {
+        return 0;
+    }
+    if (_socket->writeLimit >= 0) {
+        return _socket->writeLimit;
+    }
+    int buffer = 0;
+    socklen_t length = sizeof(buffer);
+    int queued = 0;
+    getsockopt(_socket->fd, SOL_SOCKET, SO_SNDBUF, &buffer, &length);
+    ioctl(_socket->fd, SIOCOUTQ, &queued);
+    // lwIP offers at most one TCP_SND_BUF
+    int free = buffer / 2 - queued;
+    return free < 0 ? 0 : free > 2920 ? 2920 : free;
+}
+
+void WiFiClient::stop() {
+    if (_socket) {
+        _socket->close();
+    }
+}
+
+uint8_t WiFiClient::connected() {
+    if (!_socket || _socket->fd < 0) {
+        return 0;
+    }
+    if (available() > 0) {
+        return 1;
+    }
+    char data;
+    ssize_t received = recv(_socket->fd, &data, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (received == 0) {
+        return 0;
+    }
+    return received > 0 || errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+IPAddress WiFiClient::remoteIP() {
+    return _socket ? _socket->remote : IPAddress();
+}
+
+uint16_t WiFiClient::remotePort() {
+    return _socket ? _socket->remotePort : 0;
+}
+
+IPAddress WiFiClient::localIP() {
+    return WiFi.localIP();
+}
+
+uint16_t WiFiClient::localPort() {
+    return 80;
+}
+
+void WiFiClient::hostSetAvailableForWrite(int bytes) {
+    if (_socket) {
+        _socket->writeLimit = bytes;
+    }
+}
+
+void WiFiClient::hostSetRemoteIP(IPAddress ip) {
+    if (_socket) {
+        _socket->remote = ip;
+    }
+}
+
+int WiFiClient::hostFd() const {
+    return _socket ? _socket->fd : -1;
+}
+
+WiFiServer::~WiFiServer() {
+    close();
+}
+
+void WiFiServer::begin() {
+    close();
+    _fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(_port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(_fd, (sockaddr *) &address, sizeof(address)) != 0 || listen(_fd, 16) != 0) {
+        ::close(_fd);
+        _fd = -1;
+        return;
+    }
+    socklen_t length = sizeof(address);
+    getsockname(_fd, (sockaddr *) &address, &length);
+    _port = ntohs(address.sin_port);
+    fcntl(_fd, F_SETFL, O_NONBLOCK);
+}
+
+bool WiFiServer::hasClient() {
+    if (_pending < 0 && _fd >= 0) {
+        _pending = ::accept(_fd, nullptr, nullptr);
+    }
+    return _pending >= 0;
+}
+
+WiFiClient WiFiServer::available() {
+    if (!hasClient()) {
+        return WiFiClient();
+    }
+    int fd = _pending;
+    _pending = -1;
+    return WiFiClient(hostAdopt(fd));
+}
+
+void WiFiServer::close() {
+    if (_pending >= 0) {
+        ::close(_pending);
+        _pending = -1;
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char *ssid, const char *) {
+    hostSsid = ssid;
+    hostStatus = hostBeginStatus;
+    return hostStatus;
+}
+
+bool ESP8266WiFiClass::softAP(const char *ssid, const char *password) {
+    _apSsid = ssid;
+    _apPassword = password ? password : "";
+    return true;
+}
+
+int8_t ESP8266WiFiClass::scanNetworks(bool async, bool) {
+    hostScans++;
+    _found.clear();
+    _scanState = WIFI_SCAN_RUNNING;
+    if (!async) {
+        hostFinishScan();
+    }
+    return _scanState;
+}
+
+void ESP8266WiFiClass::hostFinishScan() {
+    if (_scanState == WIFI_SCAN_RUNNING) {
+        _found = hostNetworks;
+        _scanState = _found.size();
+    }
+}
+
+void ESP8266WiFiClass::scanDelete() {
+    _found.clear();
+    _scanState = WIFI_SCAN_FAILED;
+}
@@ -0,0 +1,194 @@
+#ifndef HOST_ESP8266WIFI_H
+#define HOST_ESP8266WIFI_H
+
+#include <memory>
+#include <vector>
+#include "Arduino.h"
+#include "Client.h"
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_WRONG_PASSWORD = 6,
+    WL_DISCONNECTED = 7
+} wl_status_t;
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} WiFiMode_t;
+
+typedef enum {
+    WIFI_NONE_SLEEP = 0,
+    WIFI_LIGHT_SLEEP = 1,
+    WIFI_MODEM_SLEEP = 2
+} WiFiSleepType_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+#define ENC_TYPE_NONE 7
+
+struct HostSocket;
+
+/**
+ * TCP connection over a POSIX socket. Copies share the socket, it is closed when
+ * the last copy goes away or stop() is called, like the ClientContext of lwIP.
+ */
+class WiFiClient : public Client {
+    public:
+        WiFiClient() {}
+        explicit WiFiClient(std::shared_ptr<HostSocket> socket) : _socket(socket) {}
+
+        int connect(IPAddress ip, uint16_t port) override;
+        int connect(const char *host, uint16_t port) override;
+        int connect(const String &host, uint16_t port) { return connect(host.c_str(), port); }
+        size_t write(uint8_t data) override { return write(&data, 1); }
+        size_t write(const uint8_t *buffer, size_t size) override;
+        using Print::write;
+        int available() override;
+        int read() override;
+        int read(uint8_t *buffer, size_t size) override;
+        int peek() override;
+        size_t peekBytes(uint8_t *buffer, size_t size);
+        int availableForWrite() override;
+        void flush() override {}
+        void stop() override;
+        uint8_t connected() override;
+        operator bool() override { return _socket != nullptr; }
+        bool operator==(const WiFiClient &client) const { return _socket == client._socket; }
+        bool operator!=(const WiFiClient &client) const { return _socket != client._socket; }
+
+        IPAddress remoteIP();
+        uint16_t remotePort();
+        IPAddress localIP();
+        uint16_t localPort();
+        void setNoDelay(bool) {}
+        bool getNoDelay() const { return true; }
+        uint8_t status() { return connected() ? 4 : 0; }
+
+        // --- host only ---
+        // what availableForWrite() reports, a negative limit reports the socket buffer
+        void hostSetAvailableForWrite(int bytes);
+        void hostSetRemoteIP(IPAddress ip);
+        int hostFd() const;
+    private:
+        std::shared_ptr<HostSocket> _socket;
+};
+
+// A connected pair of sockets, the client for the library and the raw peer
+// descriptor for the test, which has to close it.
+WiFiClient hostSocketPair(int &peer, IPAddress remote = IPAddress(192, 168, 4, 2));
+
+class WiFiServer {
+    public:
+        WiFiServer(uint16_t port) : _port(port) {}
+        WiFiServer(IPAddress, uint16_t port) : _port(port) {}
+        ~WiFiServer();
+        void begin();
+        void begin(uint16_t port) { _port = port; begin(); }
+        bool hasClient();
+        WiFiClient available();
+        WiFiClient accept() { return available(); }
+        void setNoDelay(bool) {}
+        void close();
+        void stop() { close(); }
+        uint8_t status() { return _fd >= 0 ? 1 : 0; }
+
+        // --- host only, the server listens on 127.0.0.1, port 0 picks a free one ---
+        uint16_t hostPort() const { return _port; }
+    private:
+        uint16_t _port;
+        int _fd = -1;
+        int _pending = -1;
+};
+
+struct HostNetwork {
+    String ssid;
+    int32_t rssi;
+    uint8_t encryption;
+    uint8_t channel;
+    bool hidden;
+};
+
+class ESP8266WiFiClass {
+    public:
+        bool mode(WiFiMode_t mode) { _mode = mode; return true; }
+        WiFiMode_t getMode() { return _mode; }
+        wl_status_t begin(const char *ssid, const char *password = nullptr);
+        wl_status_t begin(const String &ssid, const String &password = String()) { return begin(ssid.c_str(), password.c_str()); }
+        wl_status_t status() { return hostStatus; }
+        bool isConnected() { return hostStatus == WL_CONNECTED; }
+        int8_t waitForConnectResult(unsigned long = 60000) { return hostStatus; }
+        bool disconnect(bool = false) { hostStatus = WL_DISCONNECTED; return true; }
+        bool setAutoReconnect(bool) { return true; }
+        bool setAutoConnect(bool) { return true; }
+        void persistent(bool) {}
+        bool hostname(const char *) { return true; }
+        bool hostname(const String &) { return true; }
+
+        IPAddress localIP() { return hostLocalIP; }
+        IPAddress gatewayIP() { return IPAddress(192, 168, 1, 1); }
+        IPAddress dnsIP(uint8_t = 0) { return IPAddress(192, 168, 1, 1); }
+        IPAddress subnetMask() { return IPAddress(255, 255, 255, 0); }
+        String macAddress() { return F("5C:CF:7F:00:00:01"); }
+        String SSID() { return hostSsid; }
+        int32_t RSSI() { return hostRssi; }
+        String BSSIDstr() { return F("00:11:22:33:44:55"); }
+        int32_t channel() { return 6; }
+
+        bool softAP(const char *ssid, const char *password = nullptr);
+        bool softAP(const String &ssid, const String &password) { return softAP(ssid.c_str(), password.c_str()); }
+        bool softAPConfig(IPAddress, IPAddress, IPAddress) { return true; }
+        bool softAPdisconnect(bool = false) { return true; }
+        IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+        String softAPSSID() { return _apSsid; }
+        String softAPPSK() { return _apPassword; }
+        String softAPmacAddress() { return F("5E:CF:7F:00:00:01"); }
+        uint8_t softAPgetStationNum() { return hostStations; }
+
+        int8_t scanNetworks(bool async = false, bool showHidden = false);
+        int8_t scanComplete() { return _scanState; }
+        void scanDelete();
+        String SSID(uint8_t index) { return index < _found.size() ? _found[index].ssid : String(); }
+        int32_t RSSI(uint8_t index) { return index < _found.size() ? _found[index].rssi : 0; }
+        String BSSIDstr(uint8_t) { return F("00:11:22:33:44:55"); }
+        int32_t channel(uint8_t index) { return index < _found.size() ? _found[index].channel : 0; }
+        uint8_t encryptionType(uint8_t index) { return index < _found.size() ? _found[index].encryption : 0; }
+        bool isHidden(uint8_t index) { return index < _found.size() && _found[index].hidden; }
+
+        bool setSleepMode(WiFiSleepType_t type) { hostSleepMode = type; return true; }
+        WiFiSleepType_t getSleepMode() { return hostSleepMode; }
+        bool forceSleepBegin(uint32_t = 0) { return true; }
+        bool forceSleepWake() { return true; }
+        void setOutputPower(float) {}
+
+        // --- host only ---
+        wl_status_t hostStatus = WL_DISCONNECTED;
+        // the status begin() connects with
+        wl_status_t hostBeginStatus = WL_DISCONNECTED;
+        IPAddress hostLocalIP = IPAddress(192, 168, 1, 50);
+        String hostSsid;
+        int32_t hostRssi = -60;
+        uint8_t hostStations = 0;
+        WiFiSleepType_t hostSleepMode = WIFI_NONE_SLEEP;
+        // networks the next scan finds, an async scan completes on hostFinishScan()
+        std::vector<HostNetwork> hostNetworks;
+        uint32_t hostScans = 0;
+        void hostFinishScan();
+    private:
+        WiFiMode_t _mode = WIFI_OFF;
+        String _apSsid;
+        String _apPassword;
+        int8_t _scanState = WIFI_SCAN_FAILED;
+        std::vector<HostNetwork> _found;
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif //HOST_ESP8266WIFI_H
@@ -0,0 +1,24 @@
+#ifndef HOST_ESP8266MDNS_H
+#define HOST_ESP8266MDNS_H
+
+#include "Arduino.h"
+
+// mDNS responder, remembers what was announced
+class MDNSResponder {
+    public:
+        bool begin(const char *hostName) { hostAnnounced = hostName; return hostStarted; }
+        bool begin(const String &hostName) { return begin(hostName.c_str()); }
+        bool addService(const char *, const char *, uint16_t) { hostServices++; return true; }
+        void update() { hostUpdates++; }
+        void end() {}
+
+        // --- host only ---
+        bool hostStarted = true;
+        String hostAnnounced;
+        uint32_t hostServices = 0;
+        uint32_t hostUpdates = 0;
+};
+
+extern MDNSResponder MDNS;
+
+#endif //HOST_ESP8266MDNS_H
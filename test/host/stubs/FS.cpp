@@ -0,0 +1,248 @@
+#include "FS.h"
+#include "LittleFS.h"
+
+fs::FS SPIFFS;
+fs::FS LittleFS;
+
+namespace fs {
+
+size_t File::write(const uint8_t *buffer, size_t size) {
+    if (!*this || !_handle->writable) {
+        return 0;
+    }
+    HostFileData &data = *_handle->data;
+    if (_handle->append) {
+        _handle->position = data.size();
+    }
+
+    // a full file system takes what still fits, like flash does
+    size_t end = _handle->position + size;
+    if (end > data.size()) {
+        size_t used = _handle->fs->hostUsedBytes();
+        size_t free = _handle->fs->_totalBytes > used ? _handle->fs->_totalBytes - used : 0;
+        size_t growth = end - data.size();
+        if (growth > free) {
+            size -= growth - free;
+            end = _handle->position + size;
+        }
+        if (end > data.size()) {
+            data.resize(end);
+        }
+    }
+    memcpy(data.data() + _handle->position, buffer, size);
+    _handle->position += size;
+    return size;
+}
+
+int File::available() {
+    if (!*this || !_handle->readable) {
+        return 0;
+    }
+    return _handle->data->size() - _handle->position;
+}
+
+int File::read() {
+    uint8_t data;
+    return read(&data, 1) == 1 ? data : -1;
+}
+
+int File::peek() {
+    if (available() <= 0) {
+        return -1;
+    }
+    return (*_handle->data)[_handle->position];
+}
+
+int File::read(uint8_t *buffer, size_t size) {
+    int left = available();
+    if (left <= 0) {
+        return 0;
+    }
+    if (size > (size_t) left) {
+        size = left;
+    }
+    memcpy(buffer, _handle->data->data() + _handle->position, size);
+    _handle->position += size;
+    return size;
+}
+
+bool File::seek(uint32_t position, SeekMode mode) {
+    if (!*this) {
+        return false;
+    }
+    size_t base = mode == SeekSet ? 0 : mode == SeekCur ? _handle->position : _handle->data->size();
+    if (base + position > _handle->data->size()) {
+        return false;
+    }
+    _handle->position = base + position;
+    return true;
+}
+
+size_t File::position() const {
+    return *this ? _handle->position : 0;
+}
+
+size_t File::size() const {
+    return *this ? _handle->data->size() : 0;
+}
+
+bool File::truncate(uint32_t size) {
+    if (!*this || !_handle->writable || size > _handle->data->size()) {
+        return false;
+    }
+    _handle->data->resize(size);
+    if (_handle->position > size) {
+        _handle->position = size;
+    }
+    return true;
+}
+
+void File::close() {
+    if (_handle) {
+        _handle->open = false;
+    }
+}
+
+const char *File::name() const {
+    if (!_handle) {
+        return "";
+    }
+    size_t slash = _handle->path.rfind('/');
+    return _handle->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+const char *File::fullName() const {
+    return _handle ? _handle->path.c_str() : "";
+}
+
+// SPIFFS has no directories, a directory lists every file below its prefix
+bool Dir::next() {
+    if (_fs == nullptr) {
+        return false;
+    }
+    auto it = _current.empty() ? _fs->_files.lower_bound(_path) : _fs->_files.upper_bound(_current);
+    if (it == _fs->_files.end() || it->first.compare(0, _path.size(), _path) != 0) {
+        _current.clear();
+        _fs = nullptr;
+        return false;
+    }
+    _current = it->first;
+    return true;
+}
+
+String Dir::fileName() {
+    return String(_current.c_str());
+}
+
+size_t Dir::fileSize() {
+    if (_fs == nullptr || _current.empty()) {
+        return 0;
+    }
+    auto it = _fs->_files.find(_current);
+    return it == _fs->_files.end() ? 0 : it->second->size();
+}
+
+File Dir::openFile(const char *mode) {
+    return _fs == nullptr ? File() : _fs->open(_current.c_str(), mode);
+}
+
+bool Dir::rewind() {
+    _current.clear();
+    return true;
+}
+
+bool FS::format() {
+    _files.clear();
+    return true;
+}
+
+bool FS::info(FSInfo &info) {
+    info.totalBytes = _totalBytes;
+    info.usedBytes = hostUsedBytes();
+    info.blockSize = 8192;
+    info.pageSize = 256;
+    info.maxOpenFiles = 5;
+    info.maxPathLength = 32;
+    return true;
+}
+
+File FS::open(const char *path, const char *mode) {
+    hostCounters.open++;
+    std::string name(path);
+    auto it = _files.find(name);
+    bool plus = strchr(mode, '+') != nullptr;
+
+    std::shared_ptr<HostFileHandle> handle = std::make_shared<HostFileHandle>();
+    handle->fs = this;
+    handle->path = name;
+    if (mode[0] == 'r') {
+        if (it == _files.end()) {
+            return File();
+        }
+        handle->data = it->second;
+        handle->readable = true;
+        handle->writable = plus;
+    } else if (mode[0] == 'w' || mode[0] == 'a') {
+        if (it == _files.end()) {
+            it = _files.emplace(name, std::make_shared<HostFileData>()).first;
+        } else if (mode[0] == 'w') {
+            // a reader still holding the old contents keeps them
+            it->second = std::make_shared<HostFileData>();
+        }
+        handle->data = it->second;
+        handle->writable = true;
+        handle->readable = plus;
+        handle->append = mode[0] == 'a';
+    } else {
+        return File();
+    }
+    return File(handle);
+}
+
+bool FS::exists(const char *path) {
+    hostCounters.exists++;
+    return _files.count(path) > 0;
+}
+
+Dir FS::openDir(const char *path) {
+    return Dir(this, path);
+}
+
+bool FS::remove(const char *path) {
+    hostCounters.remove++;
+    return _files.erase(path) > 0;
+}
+
+bool FS::rename(const char *from, const char *to) {
+    hostCounters.rename++;
+    if (hostFailRenameFrom == from) {
+        return false;
+    }
+    auto it = _files.find(from);
+    if (it == _files.end() || _files.count(to) > 0) {
+        return false;
+    }
+    std::shared_ptr<HostFileData> data = it->second;
+    _files.erase(it);
+    _files[to] = data;
+    return true;
+}
+
+std::string FS::hostRead(const char *path) {
+    auto it = _files.find(path);
+    return it == _files.end() ? std::string() : std::string(it->second->begin(), it->second->end());
+}
+
+void FS::hostWrite(const char *path, const std::string &content) {
+    _files[path] = std::make_shared<HostFileData>(content.begin(), content.end());
+}
+
+size_t FS::hostUsedBytes() const {
+    size_t used = 0;
+    for (const auto &file : _files) {
+        used += file.second->size();
+    }
+    return used;
+}
+
+} // namespace fs
@@ -0,0 +1,151 @@
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+/**
+ * fs::FS of the ESP8266 core over an in-memory backend. File contents are kept
+ * outside of malloc, like flash they do not count as heap. Every instance is an
+ * empty file system of its own, SPIFFS and LittleFS are two of them.
+ */
+namespace fs {
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+struct FSInfo {
+    size_t totalBytes;
+    size_t usedBytes;
+    size_t blockSize;
+    size_t pageSize;
+    size_t maxOpenFiles;
+    size_t maxPathLength;
+};
+
+typedef std::vector<uint8_t> HostFileData;
+
+class FS;
+
+struct HostFileHandle {
+    FS *fs;
+    std::string path;
+    std::shared_ptr<HostFileData> data;
+    size_t position = 0;
+    bool readable = false;
+    bool writable = false;
+    bool append = false;
+    bool open = true;
+};
+
+class File : public Stream {
+    public:
+        File() {}
+        explicit File(std::shared_ptr<HostFileHandle> handle) : _handle(handle) {}
+
+        size_t write(uint8_t data) override { return write(&data, 1); }
+        size_t write(const uint8_t *buffer, size_t size) override;
+        using Print::write;
+        int available() override;
+        int read() override;
+        int peek() override;
+        int read(uint8_t *buffer, size_t size) override;
+        void flush() override {}
+        bool seek(uint32_t position, SeekMode mode = SeekSet);
+        size_t position() const;
+        size_t size() const;
+        bool truncate(uint32_t size);
+        void close();
+        operator bool() const { return _handle && _handle->open; }
+        const char *name() const;
+        const char *fullName() const;
+        bool isFile() const { return (bool) *this; }
+        bool isDirectory() const { return false; }
+    private:
+        std::shared_ptr<HostFileHandle> _handle;
+};
+
+class Dir {
+    public:
+        Dir() {}
+        Dir(FS *fs, const std::string &path) : _fs(fs), _path(path) {}
+        bool next();
+        String fileName();
+        size_t fileSize();
+        File openFile(const char *mode);
+        bool isFile() const { return true; }
+        bool isDirectory() const { return false; }
+        bool rewind();
+    private:
+        FS *_fs = nullptr;
+        std::string _path;
+        std::string _current;
+};
+
+class FS {
+    public:
+        explicit FS(size_t totalBytes = 1 << 20) : _totalBytes(totalBytes) {}
+
+        bool begin() { return true; }
+        void end() {}
+        bool format();
+        bool info(FSInfo &info);
+        File open(const char *path, const char *mode);
+        File open(const String &path, const char *mode) { return open(path.c_str(), mode); }
+        bool exists(const char *path);
+        bool exists(const String &path) { return exists(path.c_str()); }
+        Dir openDir(const char *path);
+        Dir openDir(const String &path) { return openDir(path.c_str()); }
+        bool remove(const char *path);
+        bool remove(const String &path) { return remove(path.c_str()); }
+        bool rename(const char *from, const char *to);
+        bool rename(const String &from, const String &to) { return rename(from.c_str(), to.c_str()); }
+        bool mkdir(const char *) { return true; }
+        bool mkdir(const String &) { return true; }
+        bool rmdir(const char *) { return true; }
+        bool rmdir(const String &) { return true; }
+
+        // --- host only ---
+        struct HostCounters {
+            uint32_t exists = 0;
+            uint32_t open = 0;
+            uint32_t remove = 0;
+            uint32_t rename = 0;
+        };
+        HostCounters hostCounters;
+        // renames of this file fail without touching anything
+        std::string hostFailRenameFrom;
+        // contents of a file, empty when it does not exist
+        std::string hostRead(const char *path);
+        void hostWrite(const char *path, const std::string &content);
+        size_t hostUsedBytes() const;
+        size_t hostFreeBytes() const { return _totalBytes > hostUsedBytes() ? _totalBytes - hostUsedBytes() : 0; }
+        size_t hostFileCount() const { return _files.size(); }
+    private:
+        std::map<std::string, std::shared_ptr<HostFileData>> _files;
+        size_t _totalBytes;
+
+        friend class File;
+        friend class Dir;
+};
+
+} // namespace fs
+
+using fs::FS;
+using fs::File;
+using fs::Dir;
+using fs::FSInfo;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+extern fs::FS SPIFFS;
+
+#endif //HOST_FS_H
@@ -0,0 +1,33 @@
+#ifndef HOST_IPADDRESS_H
+#define HOST_IPADDRESS_H
+
+#include <stdint.h>
+#include "Print.h"
+
+class IPAddress : public Printable {
+    public:
+        IPAddress() {}
+        IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth);
+        IPAddress(uint32_t address) : _address(address) {}
+        IPAddress(const uint8_t *address);
+
+        bool fromString(const char *address);
+        bool fromString(const String &address) { return fromString(address.c_str()); }
+        String toString() const;
+        bool isSet() const { return _address != 0; }
+
+        operator uint32_t() const { return _address; }
+        bool operator==(const IPAddress &address) const { return _address == address._address; }
+        bool operator!=(const IPAddress &address) const { return _address != address._address; }
+        bool operator==(uint32_t address) const { return _address == address; }
+        uint8_t operator[](int index) const { return ((const uint8_t *) &_address)[index]; }
+        uint8_t &operator[](int index) { return ((uint8_t *) &_address)[index]; }
+        IPAddress &operator=(uint32_t address) { _address = address; return *this; }
+
+        size_t printTo(Print &print) const override;
+    private:
+        // network byte order like lwIP keeps it
+        uint32_t _address = 0;
+};
+
+#endif //HOST_IPADDRESS_H
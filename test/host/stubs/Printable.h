@@ -0,0 +1,6 @@
+#ifndef HOST_PRINTABLE_H
+#define HOST_PRINTABLE_H
+
+#include "Print.h"
+
+#endif //HOST_PRINTABLE_H
@@ -0,0 +1,26 @@
+#ifndef HOST_STREAM_H
+#define HOST_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+        virtual int read(uint8_t *buffer, size_t size);
+
+        void setTimeout(unsigned long timeout) { _timeout = timeout; }
+        unsigned long getTimeout() const { return _timeout; }
+        size_t readBytes(char *buffer, size_t length);
+        size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *) buffer, length); }
+        size_t readBytesUntil(char terminator, char *buffer, size_t length);
+        String readString();
+        String readStringUntil(char terminator);
+    protected:
+        unsigned long _timeout = 1000;
+        // read() which waits up to the timeout like the cores do
+        int timedRead();
+};
+
+#endif //HOST_STREAM_H
@@ -0,0 +1,25 @@
+#ifndef HOST_STREAMSTRING_H
+#define HOST_STREAMSTRING_H
+
+#include "Arduino.h"
+
+// String written through Print and read back through Stream
+class StreamString : public String, public Stream {
+    public:
+        size_t write(uint8_t data) override { concat((char) data); return 1; }
+        size_t write(const uint8_t *buffer, size_t size) override { concat((const char *) buffer, size); return size; }
+        using Print::write;
+        int available() override { return length(); }
+        int read() override {
+            if (length() == 0) {
+                return -1;
+            }
+            int data = (uint8_t) c_str()[0];
+            remove(0, 1);
+            return data;
+        }
+        int peek() override { return length() ? (uint8_t) c_str()[0] : -1; }
+        void flush() override {}
+};
+
+#endif //HOST_STREAMSTRING_H
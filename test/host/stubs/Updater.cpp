@@ -0,0 +1,173 @@
+#include "Updater.h"
+
+UpdaterClass Update;
+
+// RFC 1321, small and slow, the images of the tests are a few kilobytes
+static void updaterMd5(const std::vector<uint8_t> &data, uint8_t digest[16]) {
+    static const uint32_t k[64] = {
+        0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+        0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+        0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+        0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+        0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+        0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+        0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+        0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+    };
+    static const uint8_t r[64] = {
+        7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+        5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+        4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+        6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+    };
+
+    std::vector<uint8_t> message(data);
+    uint64_t bits = (uint64_t) data.size() * 8;
+    message.push_back(0x80);
+    while (message.size() % 64 != 56) {
+        message.push_back(0);
+    }
+    for (int i = 0; i < 8; i++) {
+        message.push_back((uint8_t) (bits >> (8 * i)));
+    }
+
+    uint32_t h[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+    for (size_t offset = 0; offset < message.size(); offset += 64) {
+        uint32_t w[16];
+        for (int i = 0; i < 16; i++) {
+            const uint8_t *word = &message[offset + i * 4];
+            w[i] = word[0] | (word[1] << 8) | (word[2] << 16) | ((uint32_t) word[3] << 24);
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3];
+        for (int i = 0; i < 64; i++) {
+            uint32_t f;
+            int g;
+            if (i < 16) {
+                f = (b & c) | (~b & d);
+                g = i;
+            } else if (i < 32) {
+                f = (d & b) | (~d & c);
+                g = (5 * i + 1) % 16;
+            } else if (i < 48) {
+                f = b ^ c ^ d;
+                g = (3 * i + 5) % 16;
+            } else {
+                f = c ^ (b | ~d);
+                g = (7 * i) % 16;
+            }
+            uint32_t rotated = a + f + k[i] + w[g];
+            a = d;
+            d = c;
+            c = b;
+            b += (rotated << r[i]) | (rotated >> (32 - r[i]));
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+    }
+    for (int i = 0; i < 16; i++) {
+        digest[i] = (uint8_t) (h[i / 4] >> (8 * (i % 4)));
+    }
+}
+
+void UpdaterClass::_reset() {
+    _image.clear();
+    _size = 0;
+    _expectedMD5 = "";
+}
+
+bool UpdaterClass::begin(size_t size, int, int, uint8_t) {
+    hostBegins++;
+    _reset();
+    _finished = false;
+    if (size == 0) {
+        _error = UPDATE_ERROR_SIZE;
+        return false;
+    }
+    if (size > ESP.getFreeSketchSpace()) {
+        _error = UPDATE_ERROR_SPACE;
+        return false;
+    }
+    _error = UPDATE_ERROR_OK;
+    _size = size;
+    return true;
+}
+
+bool UpdaterClass::setMD5(const char *expectedMD5) {
+    if (strlen(expectedMD5) != 32) {
+        return false;
+    }
+    _expectedMD5 = expectedMD5;
+    _expectedMD5.toLowerCase();
+    return true;
+}
+
+size_t UpdaterClass::write(uint8_t *data, size_t length) {
+    if (hasError() || !isRunning()) {
+        return 0;
+    }
+    if (length > remaining()) {
+        _error = UPDATE_ERROR_SPACE;
+        return 0;
+    }
+    if (hostFailWriteAt && _image.size() + length > hostFailWriteAt) {
+        _error = UPDATE_ERROR_WRITE;
+        return 0;
+    }
+    _image.insert(_image.end(), data, data + length);
+    return length;
+}
+
+bool UpdaterClass::end(bool evenIfRemaining) {
+    if (hasError() || _size == 0) {
+        _reset();
+        return false;
+    }
+    if (!evenIfRemaining && remaining()) {
+        _error = UPDATE_ERROR_STREAM;
+        _reset();
+        return false;
+    }
+    if (_image.empty()) {
+        _error = UPDATE_ERROR_NO_DATA;
+        _reset();
+        return false;
+    }
+    if (_expectedMD5.length() && md5String() != _expectedMD5) {
+        _error = UPDATE_ERROR_MD5;
+        _reset();
+        return false;
+    }
+    _size = 0;
+    _finished = true;
+    return true;
+}
+
+String UpdaterClass::md5String() {
+    return hostMD5(_image);
+}
+
+String UpdaterClass::hostMD5(const std::vector<uint8_t> &data) {
+    uint8_t digest[16];
+    updaterMd5(data, digest);
+    char text[33];
+    for (int i = 0; i < 16; i++) {
+        snprintf(text + i * 2, 3, "%02x", digest[i]);
+    }
+    return String(text);
+}
+
+void UpdaterClass::printError(Print &out) {
+    out.printf("ERROR[%u]: ", _error);
+    switch (_error) {
+        case UPDATE_ERROR_OK: out.print(F("No Error")); break;
+        case UPDATE_ERROR_WRITE: out.print(F("Flash Write Failed")); break;
+        case UPDATE_ERROR_SPACE: out.print(F("Not Enough Space")); break;
+        case UPDATE_ERROR_SIZE: out.print(F("Bad Size Given")); break;
+        case UPDATE_ERROR_STREAM: out.print(F("Stream Read Timeout")); break;
+        case UPDATE_ERROR_MD5: out.print(F("MD5 Check Failed")); break;
+        case UPDATE_ERROR_NO_DATA: out.print(F("No data supplied")); break;
+        default: out.print(F("UNKNOWN")); break;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef HOST_UPDATER_H
+#define HOST_UPDATER_H
+
+#include <vector>
+#include "Arduino.h"
+
+#define U_FLASH 0
+#define U_FS 100
+
+#define UPDATE_ERROR_OK 0
+#define UPDATE_ERROR_WRITE 1
+#define UPDATE_ERROR_SPACE 4
+#define UPDATE_ERROR_SIZE 5
+#define UPDATE_ERROR_STREAM 6
+#define UPDATE_ERROR_MD5 7
+#define UPDATE_ERROR_NO_DATA 12
+
+/**
+ * Updater of the ESP8266 core, the image goes into a vector instead of the
+ * flash, the MD5 is computed over what was written and checked by end().
+ */
+class UpdaterClass {
+    public:
+        bool begin(size_t size, int command = U_FLASH, int ledPin = -1, uint8_t ledOn = LOW);
+        bool setMD5(const char *expectedMD5);
+        size_t write(uint8_t *data, size_t length);
+        bool end(bool evenIfRemaining = false);
+        void printError(Print &out);
+        bool isRunning() { return _size > 0; }
+        bool isFinished() { return _finished; }
+        bool hasError() { return _error != UPDATE_ERROR_OK; }
+        uint8_t getError() { return _error; }
+        size_t size() { return _size; }
+        size_t progress() { return _image.size(); }
+        size_t remaining() { return _size - _image.size(); }
+        String md5String();
+
+        // --- host only ---
+        static String hostMD5(const std::vector<uint8_t> &data);
+        const std::vector<uint8_t> &hostImage() const { return _image; }
+        // write() fails once this many bytes are in, 0 never fails
+        size_t hostFailWriteAt = 0;
+        uint32_t hostBegins = 0;
+    private:
+        void _reset();
+        std::vector<uint8_t> _image;
+        size_t _size = 0;
+        String _expectedMD5;
+        uint8_t _error = UPDATE_ERROR_OK;
+        bool _finished = false;
+};
+
+extern UpdaterClass Update;
+
+#endif //HOST_UPDATER_H
@@ -0,0 +1,364 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "WString.h"
+
+String::String(const char *value) {
+    if (value != nullptr) {
+        _copy(value, strlen(value));
+    }
+}
+
+String::String(const char *value, size_t length) {
+    _copy(value, length);
+}
+
+String::String(const String &value) {
+    _copy(value.c_str(), value._length);
+}
+
+String::String(String &&value) {
+    _move(value);
+}
+
+String::String(const __FlashStringHelper *value) : String(reinterpret_cast<const char *>(value)) {}
+
+String::String(char value) {
+    _copy(&value, 1);
+}
+
+static void hostFormatUnsigned(String &result, unsigned long long value, unsigned char base) {
+    char digits[66];
+    char *digit = digits + sizeof(digits) - 1;
+    *digit = '\0';
+    if (base < 2 || base > 36) {
+        base = 10;
+    }
+    do {
+        unsigned char remainder = value % base;
+        *--digit = remainder < 10 ? '0' + remainder : 'a' + remainder - 10;
+        value /= base;
+    } while (value);
+    result = digit;
+}
+
+static void hostFormatSigned(String &result, long long value, unsigned char base) {
+    if (value < 0 && base == 10) {
+        hostFormatUnsigned(result, (unsigned long long) -value, base);
+        result = String("-") + result;
+    } else {
+        hostFormatUnsigned(result, (unsigned long long) value, base);
+    }
+}
+
+String::String(unsigned char value, unsigned char base) { hostFormatUnsigned(*this, value, base); }
+String::String(int value, unsigned char base) { hostFormatSigned(*this, value, base); }
+String::String(unsigned int value, unsigned char base) { hostFormatUnsigned(*this, value, base); }
+String::String(long value, unsigned char base) { hostFormatSigned(*this, value, base); }
+String::String(unsigned long value, unsigned char base) { hostFormatUnsigned(*this, value, base); }
+String::String(long long value, unsigned char base) { hostFormatSigned(*this, value, base); }
+String::String(unsigned long long value, unsigned char base) { hostFormatUnsigned(*this, value, base); }
+
+String::String(float value, unsigned char decimals) : String((double) value, decimals) {}
+
+String::String(double value, unsigned char decimals) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    _copy(buffer, strlen(buffer));
+}
+
+String::~String() {
+    free(_buffer);
+}
+
+String &String::operator=(const String &value) {
+    if (this != &value) {
+        _copy(value.c_str(), value._length);
+    }
+    return *this;
+}
+
+String &String::operator=(String &&value) {
+    if (this != &value) {
+        free(_buffer);
+        _move(value);
+    }
+    return *this;
+}
+
+String &String::operator=(const char *value) {
+    if (value == nullptr) {
+        _invalidate();
+    } else {
+        _copy(value, strlen(value));
+    }
+    return *this;
+}
+
+String &String::operator=(const __FlashStringHelper *value) {
+    return *this = reinterpret_cast<const char *>(value);
+}
+
+String &String::operator=(char value) {
+    _copy(&value, 1);
+    return *this;
+}
+
+bool String::reserve(size_t size) {
+    if (_buffer != nullptr && _capacity >= size) {
+        return true;
+    }
+    char *buffer = (char *) realloc(_buffer, size + 1);
+    if (buffer == nullptr) {
+        return false;
+    }
+    if (_buffer == nullptr) {
+        buffer[0] = '\0';
+    }
+    _buffer = buffer;
+    _capacity = size;
+    return true;
+}
+
+bool String::concat(const char *value, size_t length) {
+    if (value == nullptr) {
+        return false;
+    }
+    if (length == 0) {
+        return true;
+    }
+    // the value may point into this string
+    size_t offset = value >= _buffer && value < _buffer + _length ? value - _buffer : (size_t) -1;
+    if (!reserve(_length + length)) {
+        return false;
+    }
+    memmove(_buffer + _length, offset != (size_t) -1 ? _buffer + offset : value, length);
+    _length += length;
+    _buffer[_length] = '\0';
+    return true;
+}
+
+bool String::concat(const char *value) {
+    return value != nullptr && concat(value, strlen(value));
+}
+
+int String::compareTo(const String &value) const {
+    return strcmp(c_str(), value.c_str());
+}
+
+bool String::equals(const String &value) const {
+    return _length == value._length && memcmp(c_str(), value.c_str(), _length) == 0;
+}
+
+bool String::equals(const char *value) const {
+    return strcmp(c_str(), value ? value : "") == 0;
+}
+
+bool String::equalsIgnoreCase(const String &value) const {
+    return _length == value._length && strcasecmp(c_str(), value.c_str()) == 0;
+}
+
+bool String::startsWith(const String &prefix, size_t offset) const {
+    return offset + prefix._length <= _length && memcmp(c_str() + offset, prefix.c_str(), prefix._length) == 0;
+}
+
+bool String::endsWith(const String &suffix) const {
+    return suffix._length <= _length && memcmp(c_str() + _length - suffix._length, suffix.c_str(), suffix._length) == 0;
+}
+
+char &String::operator[](size_t index) {
+    static char dummy;
+    if (index >= _length) {
+        dummy = 0;
+        return dummy;
+    }
+    return _buffer[index];
+}
+
+void String::getBytes(unsigned char *buffer, size_t size, size_t index) const {
+    if (size == 0 || buffer == nullptr) {
+        return;
+    }
+    if (index >= _length) {
+        buffer[0] = 0;
+        return;
+    }
+    size_t length = _length - index < size - 1 ? _length - index : size - 1;
+    memcpy(buffer, c_str() + index, length);
+    buffer[length] = 0;
+}
+
+int String::indexOf(char value, size_t from) const {
+    if (from >= _length) {
+        return -1;
+    }
+    const char *found = (const char *) memchr(c_str() + from, value, _length - from);
+    return found ? found - c_str() : -1;
+}
+
+int String::indexOf(const char *value, size_t from) const {
+    if (from > _length) {
+        return -1;
+    }
+    const char *found = strstr(c_str() + from, value);
+    return found ? found - c_str() : -1;
+}
+
+int String::lastIndexOf(char value) const {
+    const char *found = strrchr(c_str(), value);
+    return found ? found - c_str() : -1;
+}
+
+int String::lastIndexOf(const String &value) const {
+    int found = -1;
+    for (int index = indexOf(value); index >= 0; index = indexOf(value, index + 1)) {
+        found = index;
+    }
+    return found;
+}
+
+String String::substring(size_t from, size_t to) const {
+    if (from > to) {
+        size_t swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from >= _length) {
+        return String();
+    }
+    if (to > _length) {
+        to = _length;
+    }
+    return String(c_str() + from, to - from);
+}
+
+void String::replace(char find, char replace) {
+    for (size_t i = 0; i < _length; i++) {
+        if (_buffer[i] == find) {
+            _buffer[i] = replace;
+        }
+    }
+}
+
+void String::replace(const String &find, const String &replace) {
+    if (find._length == 0) {
+        return;
+    }
+    String result;
+    size_t from = 0;
+    for (int index = indexOf(find); index >= 0; index = indexOf(find, from)) {
+        result.concat(c_str() + from, index - from);
+        result.concat(replace);
+        from = index + find._length;
+    }
+    result.concat(c_str() + from, _length - from);
+    *this = result;
+}
+
+void String::remove(size_t index, size_t count) {
+    if (index >= _length) {
+        return;
+    }
+    if (count > _length - index) {
+        count = _length - index;
+    }
+    memmove(_buffer + index, _buffer + index + count, _length - index - count + 1);
+    _length -= count;
+}
+
+void String::toLowerCase() {
+    for (size_t i = 0; i < _length; i++) {
+        _buffer[i] = tolower((unsigned char) _buffer[i]);
+    }
+}
+
+void String::toUpperCase() {
+    for (size_t i = 0; i < _length; i++) {
+        _buffer[i] = toupper((unsigned char) _buffer[i]);
+    }
+}
+
+void String::trim() {
+    size_t from = 0;
+    while (from < _length && isspace((unsigned char) _buffer[from])) {
+        from++;
+    }
+    size_t to = _length;
+    while (to > from && isspace((unsigned char) _buffer[to - 1])) {
+        to--;
+    }
+    if (from > 0 || to < _length) {
+        memmove(_buffer, _buffer + from, to - from);
+        _length = to - from;
+        _buffer[_length] = '\0';
+    }
+}
+
+long String::toInt() const {
+    return atol(c_str());
+}
+
+float String::toFloat() const {
+    return (float) atof(c_str());
+}
+
+double String::toDouble() const {
+    return atof(c_str());
+}
+
+void String::_copy(const char *value, size_t length) {
+    if (!reserve(length)) {
+        _invalidate();
+        return;
+    }
+    memmove(_buffer, value, length);
+    _length = length;
+    _buffer[_length] = '\0';
+}
+
+void String::_move(String &value) {
+    _buffer = value._buffer;
+    _length = value._length;
+    _capacity = value._capacity;
+    value._buffer = nullptr;
+    value._length = 0;
+    value._capacity = 0;
+}
+
+void String::_invalidate() {
+    free(_buffer);
+    _buffer = nullptr;
+    _length = 0;
+    _capacity = 0;
+}
+
+String operator+(const String &left, const String &right) {
+    String result(left);
+    result.concat(right);
+    return result;
+}
+
+String operator+(const String &left, const char *right) {
+    String result(left);
+    result.concat(right);
+    return result;
+}
+
+String operator+(const char *left, const String &right) {
+    String result(left);
+    result.concat(right);
+    return result;
+}
+
+String operator+(const String &left, const __FlashStringHelper *right) {
+    String result(left);
+    result.concat(right);
+    return result;
+}
+
+String operator+(const String &left, char right) {
+    String result(left);
+    result.concat(right);
+    return result;
+}
@@ -0,0 +1,141 @@
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "pgmspace.h"
+
+/**
+ * String of the Arduino cores. The buffer lives on the heap through malloc,
+ * realloc and free, so the allocation tracer and heap counters see it like
+ * on the device.
+ */
+class String {
+        // a String is true in a condition, like the safe bool of the core
+        typedef void (String::*StringIfHelperType)() const;
+        void StringIfHelper() const {}
+    public:
+        operator StringIfHelperType() const { return &String::StringIfHelper; }
+        String() {}
+        String(const char *value);
+        String(const char *value, size_t length);
+        String(const String &value);
+        String(String &&value);
+        String(const __FlashStringHelper *value);
+        explicit String(char value);
+        explicit String(unsigned char value, unsigned char base = 10);
+        explicit String(int value, unsigned char base = 10);
+        explicit String(unsigned int value, unsigned char base = 10);
+        explicit String(long value, unsigned char base = 10);
+        explicit String(unsigned long value, unsigned char base = 10);
+        explicit String(long long value, unsigned char base = 10);
+        explicit String(unsigned long long value, unsigned char base = 10);
+        explicit String(float value, unsigned char decimals = 2);
+        explicit String(double value, unsigned char decimals = 2);
+        ~String();
+
+        String &operator=(const String &value);
+        String &operator=(String &&value);
+        String &operator=(const char *value);
+        String &operator=(const __FlashStringHelper *value);
+        String &operator=(char value);
+
+        bool reserve(size_t size);
+        size_t length() const { return _length; }
+        bool isEmpty() const { return _length == 0; }
+        const char *c_str() const { return _buffer ? _buffer : ""; }
+        char *begin() { return _buffer; }
+        char *end() { return _buffer + _length; }
+        const char *begin() const { return c_str(); }
+        const char *end() const { return c_str() + _length; }
+
+        bool concat(const char *value, size_t length);
+        bool concat(const char *value);
+        bool concat(const String &value) { return concat(value.c_str(), value.length()); }
+        bool concat(const __FlashStringHelper *value) { return concat(reinterpret_cast<const char *>(value)); }
+        bool concat(char value) { return concat(&value, 1); }
+        bool concat(unsigned char value) { return concat(String(value)); }
+        bool concat(int value) { return concat(String(value)); }
+        bool concat(unsigned int value) { return concat(String(value)); }
+        bool concat(long value) { return concat(String(value)); }
+        bool concat(unsigned long value) { return concat(String(value)); }
+        bool concat(long long value) { return concat(String(value)); }
+        bool concat(unsigned long long value) { return concat(String(value)); }
+        bool concat(float value) { return concat(String(value)); }
+        bool concat(double value) { return concat(String(value)); }
+
+        template <typename T>
+        String &operator+=(const T &value) { concat(value); return *this; }
+        String &operator+=(const char *value) { concat(value); return *this; }
+
+        int compareTo(const String &value) const;
+        bool equals(const String &value) const;
+        bool equals(const char *value) const;
+        bool equalsIgnoreCase(const String &value) const;
+        bool startsWith(const String &prefix) const { return startsWith(prefix, 0); }
+        bool startsWith(const String &prefix, size_t offset) const;
+        bool endsWith(const String &suffix) const;
+
+        bool operator==(const String &value) const { return equals(value); }
+        bool operator==(const char *value) const { return equals(value); }
+        bool operator!=(const String &value) const { return !equals(value); }
+        bool operator!=(const char *value) const { return !equals(value); }
+        bool operator<(const String &value) const { return compareTo(value) < 0; }
+        bool operator>(const String &value) const { return compareTo(value) > 0; }
+
+        char charAt(size_t index) const { return index < _length ? _buffer[index] : 0; }
+        void setCharAt(size_t index, char value) { if (index < _length) _buffer[index] = value; }
+        char operator[](size_t index) const { return charAt(index); }
+        char &operator[](size_t index);
+        void getBytes(unsigned char *buffer, size_t size, size_t index = 0) const;
+        void toCharArray(char *buffer, size_t size, size_t index = 0) const { getBytes((unsigned char *) buffer, size, index); }
+
+        int indexOf(char value, size_t from = 0) const;
+        int indexOf(const char *value, size_t from = 0) const;
+        int indexOf(const String &value, size_t from = 0) const { return indexOf(value.c_str(), from); }
+        int indexOf(const __FlashStringHelper *value, size_t from = 0) const { return indexOf(reinterpret_cast<const char *>(value), from); }
+        int lastIndexOf(char value) const;
+        int lastIndexOf(const String &value) const;
+        String substring(size_t from) const { return substring(from, _length); }
+        String substring(size_t from, size_t to) const;
+
+        void replace(char find, char replace);
+        void replace(const String &find, const String &replace);
+        void remove(size_t index) { remove(index, (size_t) -1); }
+        void remove(size_t index, size_t count);
+        void toLowerCase();
+        void toUpperCase();
+        void trim();
+
+        long toInt() const;
+        float toFloat() const;
+        double toDouble() const;
+    private:
+        char *_buffer = nullptr;
+        size_t _length = 0;
+        size_t _capacity = 0;
+
+        void _copy(const char *value, size_t length);
+        void _move(String &value);
+        void _invalidate();
+};
+
+String operator+(const String &left, const String &right);
+String operator+(const String &left, const char *right);
+String operator+(const char *left, const String &right);
+String operator+(const String &left, const __FlashStringHelper *right);
+String operator+(const String &left, char right);
+// numbers are appended as text, as by the core's StringSumHelper
+inline String operator+(const String &left, unsigned char right) { String sum(left); sum.concat(right); return sum; }
+inline String operator+(const String &left, int right) { String sum(left); sum.concat(right); return sum; }
+inline String operator+(const String &left, unsigned int right) { String sum(left); sum.concat(right); return sum; }
+inline String operator+(const String &left, long right) { String sum(left); sum.concat(right); return sum; }
+inline String operator+(const String &left, unsigned long right) { String sum(left); sum.concat(right); return sum; }
+inline String operator+(const String &left, long long right) { String sum(left); sum.concat(right); return sum; }
+inline String operator+(const String &left, unsigned long long right) { String sum(left); sum.concat(right); return sum; }
+inline String operator+(const String &left, float right) { String sum(left); sum.concat(right); return sum; }
+inline String operator+(const String &left, double right) { String sum(left); sum.concat(right); return sum; }
+inline bool operator==(const char *left, const String &right) { return right.equals(left); }
+inline bool operator!=(const char *left, const String &right) { return !right.equals(left); }
+
+#endif //HOST_WSTRING_H
@@ -0,0 +1,115 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <set>
+#include "WiFiUdp.h"
+
+static std::set<WiFiUDP *> &udpSockets() {
+    static std::set<WiFiUDP *> sockets;
+    return sockets;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+    stop();
+    _fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (_fd < 0) {
+        return 0;
+    }
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (bind(_fd, (sockaddr *) &address, length) != 0 || getsockname(_fd, (sockaddr *) &address, &length) != 0) {
+        ::close(_fd);
+        _fd = -1;
+        return 0;
+    }
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+    _port = ntohs(address.sin_port);
+    udpSockets().insert(this);
+    return 1;
+}
+
+void WiFiUDP::stop() {
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+    _port = 0;
+    _packet.clear();
+    _position = 0;
+    udpSockets().erase(this);
+}
+
+void WiFiUDP::stopAll() {
+    std::set<WiFiUDP *> sockets = udpSockets();
+    for (WiFiUDP *udp : sockets) {
+        udp->stop();
+    }
+}
+
+int WiFiUDP::parsePacket() {
+    _packet.clear();
+    _position = 0;
+    if (_fd < 0) {
+        return 0;
+    }
+    uint8_t buffer[1500];
+    sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    ssize_t size = recvfrom(_fd, buffer, sizeof(buffer), 0, (sockaddr *) &address, &length);
+    if (size <= 0) {
+        return 0;
+    }
+    _packet.assign(buffer, buffer + size);
+    _remoteIP = IPAddress(address.sin_addr.s_addr);
+    _remotePort = ntohs(address.sin_port);
+    return (int) size;
+}
+
+int WiFiUDP::read(uint8_t *buffer, size_t size) {
+    size_t length = std::min(size, _packet.size() - _position);
+    memcpy(buffer, _packet.data() + _position, length);
+    _position += length;
+    return (int) length;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) {
+    _outgoing.clear();
+    _outgoingIP = ip;
+    _outgoingPort = port;
+    _sending = true;
+    return 1;
+}
+
+int WiFiUDP::beginPacket(const char *host, uint16_t port) {
+    IPAddress ip;
+    if (!ip.fromString(host)) {
+        return 0;
+    }
+    return beginPacket(ip, port);
+}
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size) {
+    if (!_sending) {
+        return 0;
+    }
+    _outgoing.insert(_outgoing.end(), buffer, buffer + size);
+    return size;
+}
+
+int WiFiUDP::endPacket() {
+    if (!_sending || _fd < 0) {
+        return 0;
+    }
+    _sending = false;
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(_outgoingPort);
+    address.sin_addr.s_addr = (uint32_t) _outgoingIP;
+    return sendto(_fd, _outgoing.data(), _outgoing.size(), 0, (sockaddr *) &address, sizeof(address)) == (ssize_t) _outgoing.size();
+}
@@ -0,0 +1,55 @@
+#ifndef HOST_WIFIUDP_H
+#define HOST_WIFIUDP_H
+
+#include <vector>
+#include "Arduino.h"
+
+/**
+ * WiFiUDP over a POSIX datagram socket bound to 127.0.0.1, one received
+ * packet is held at a time like the pbuf chain of the core.
+ */
+class WiFiUDP : public Stream {
+    public:
+        WiFiUDP() {}
+        ~WiFiUDP() { stop(); }
+        WiFiUDP(const WiFiUDP &) = delete;
+        WiFiUDP &operator=(const WiFiUDP &) = delete;
+
+        uint8_t begin(uint16_t port);
+        void stop();
+        static void stopAll();
+
+        int parsePacket();
+        int available() override { return (int) (_packet.size() - _position); }
+        int read() override { return _position < _packet.size() ? _packet[_position++] : -1; }
+        int read(uint8_t *buffer, size_t size) override;
+        int read(char *buffer, size_t size) { return read((uint8_t *) buffer, size); }
+        int peek() override { return _position < _packet.size() ? _packet[_position] : -1; }
+        void flush() override { _position = _packet.size(); }
+        IPAddress remoteIP() const { return _remoteIP; }
+        uint16_t remotePort() const { return _remotePort; }
+
+        int beginPacket(IPAddress ip, uint16_t port);
+        int beginPacket(const char *host, uint16_t port);
+        size_t write(uint8_t data) override { return write(&data, 1); }
+        size_t write(const uint8_t *buffer, size_t size) override;
+        using Print::write;
+        int endPacket();
+
+        // --- host only ---
+        // port the socket is bound to, begin(0) picks a free one
+        uint16_t hostPort() const { return _port; }
+    private:
+        int _fd = -1;
+        uint16_t _port = 0;
+        std::vector<uint8_t> _packet;
+        size_t _position = 0;
+        IPAddress _remoteIP;
+        uint16_t _remotePort = 0;
+        std::vector<uint8_t> _outgoing;
+        IPAddress _outgoingIP;
+        uint16_t _outgoingPort = 0;
+        bool _sending = false;
+};
+
+#endif //HOST_WIFIUDP_H
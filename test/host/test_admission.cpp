@@ -0,0 +1,251 @@
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "host_http.h"
+#include "host_server.h"
+#include "utils/http/ONEBIOTAdmission.h"
+#include "utils/http/ONEBIOTHttpServer.h"
+#include "utils/router/ONEBIOTRouter.h"
+
+// ONEBIOTAdmission on the frozen host clock: route costs, refill, the backoff after
+// failed logins, the router in front of the core server (built with ONEBIOT_HTTP_SYNC)
+// and a client hammering the wifi scan, which must not stall the loop
+
+static ONEBIOTHttpServer server(0);
+static std::atomic<bool> serving(true);
+static std::atomic<int> scans(0);
+static std::atomic<long> maxLoopLatency(0);
+
+// a wifi scan keeps the loop busy for this long
+static const int SCAN_US = 20 * 1000;
+
+static int connectServer(const char *from) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    inet_pton(AF_INET, from, &local.sin_addr);
+    CHECK(bind(fd, (sockaddr *) &local, sizeof(local)) == 0);
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(server.hostPort());
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(connect(fd, (sockaddr *) &address, sizeof(address)) == 0);
+    return fd;
+}
+
+static std::string exchange(const char *from, const std::string &request) {
+    int fd = connectServer(from);
+    CHECK_EQUAL(request.size(), write(fd, request.data(), request.size()));
+    std::string response = httpRead(fd, 2000);
+    close(fd);
+    return response;
+}
+
+static void testCosts() {
+    const char *paths[] = {"/cmd/wifi/list", "/cmd/stats/history", "/cmd/data", "/cmd/stats", "/cmd/log", "/cmd/option/client_name", "/"};
+    const uint8_t costs[] = {10, 5, 5, 3, 3, 1, 1};
+    for (size_t i = 0; i < sizeof(costs); i++) {
+        CHECK_EQUAL(costs[i], ONEBIOTAdmission::cost(paths[i], strlen(paths[i])));
+    }
+    // only the parsed length of the path counts
+    CHECK_EQUAL(1, ONEBIOTAdmission::cost("/cmd/wifi/list", 9));
+}
+
+static void testRefill() {
+    ONEBIOTAdmission::reset();
+    IPAddress client(192, 168, 4, 2);
+    IPAddress other(192, 168, 4, 3);
+
+    // the burst pays for two scans, the refill of 5 tokens per second for the next one after 2 s
+    CHECK(ONEBIOTAdmission::admit(client, 10));
+    CHECK(ONEBIOTAdmission::admit(client, 10));
+    CHECK(!ONEBIOTAdmission::admit(client, 1));
+    hostClockAdvance(1999 * 1000UL);
+    CHECK(!ONEBIOTAdmission::admit(client, 10));
+    hostClockAdvance(1000);
+    CHECK(ONEBIOTAdmission::admit(client, 10));
+    // every client has a bucket of its own
+    CHECK(ONEBIOTAdmission::admit(other, 10));
+
+    // a long pause fills the bucket up to the burst only
+    hostClockAdvance(3600 * 1000000UL);
+    CHECK(ONEBIOTAdmission::admit(client, 20));
+    CHECK(!ONEBIOTAdmission::admit(client, 1));
+
+    ONEBIOTAdmissionCounters counters;
+    ONEBIOTAdmission::getCounters(counters);
+    CHECK_EQUAL(5, counters.admitted);
+    CHECK_EQUAL(3, counters.limited);
+    CHECK_EQUAL(2, counters.clients);
+}
+
+static void testBackoff() {
+    ONEBIOTAdmission::reset();
+    IPAddress client(192, 168, 4, 2);
+
+    // the first failures are free, then the backoff doubles with every further one
+    for (int i = 0; i < ONEBIOT_ADMISSION_AUTH_FAILURES; i++) {
+        ONEBIOTAdmission::authResult(client, false);
+    }
+    CHECK(!ONEBIOTAdmission::isBackingOff(client));
+    ONEBIOTAdmission::authResult(client, false);
+    CHECK(ONEBIOTAdmission::isBackingOff(client));
+    CHECK(!ONEBIOTAdmission::admit(client, 1));
+    hostClockAdvance((ONEBIOT_ADMISSION_BACKOFF - 1) * 1000UL);
+    CHECK(ONEBIOTAdmission::isBackingOff(client));
+    hostClockAdvance(1000);
+    CHECK(!ONEBIOTAdmission::isBackingOff(client));
+
+    ONEBIOTAdmission::authResult(client, false);
+    hostClockAdvance((2 * ONEBIOT_ADMISSION_BACKOFF - 1) * 1000UL);
+    CHECK(ONEBIOTAdmission::isBackingOff(client));
+
+    // a full table evicts the clients in good standing, the one backing off keeps its slot
+    for (uint8_t i = 0; i < ONEBIOT_ADMISSION_CLIENTS * 2; i++) {
+        CHECK(ONEBIOTAdmission::admit(IPAddress(10, 0, 0, i + 1), 1));
+    }
+    CHECK(ONEBIOTAdmission::isBackingOff(client));
+
+    // a successful login starts counting from zero again
+    hostClockAdvance(1000);
+    ONEBIOTAdmission::authResult(client, true);
+    ONEBIOTAdmission::authResult(client, false);
+    CHECK(!ONEBIOTAdmission::isBackingOff(client));
+
+    ONEBIOTAdmissionCounters counters;
+    ONEBIOTAdmission::getCounters(counters);
+    CHECK_EQUAL(ONEBIOT_ADMISSION_AUTH_FAILURES + 3, counters.auth_failures);
+    CHECK_EQUAL(1, counters.blocked);
+    CHECK_EQUAL(ONEBIOT_ADMISSION_CLIENTS, counters.clients);
+}
+
+class ScanHandler : public RequestHandler {
+    public:
+        int scans = 0;
+
+        bool canHandle(HTTPMethod, String) override {
+            return true;
+        }
+        bool handle(ESP8266WebServer &server, HTTPMethod, String) override {
+            scans++;
+            server.send(200, "application/json", "{\"success\":true}");
+            return true;
+        }
+};
+
+// ESP32 and -DONEBIOT_HTTP_SYNC builds have no ONEBIOTHttpServer, the router takes the tokens
+static void testSyncRouter() {
+    ONEBIOTAdmission::reset();
+    ScanHandler scan;
+    ONEBIOTRouter router;
+    router.on(PSTR("/cmd/wifi/list"), ONEBIOT_ROUTE(HTTP_GET), &scan);
+    HostServer core;
+    core.addHandler(&router);
+    IPAddress client(192, 168, 4, 2);
+    IPAddress other(192, 168, 4, 3);
+    const std::string request = "GET /cmd/wifi/list HTTP/1.1\r\nHost: device\r\n\r\n";
+
+    // the burst pays for two scans, the third one is refused without running the handler
+    CHECK_EQUAL(200, httpStatus(core.request(request, client)));
+    CHECK_EQUAL(200, httpStatus(core.request(request, client)));
+    std::string response = core.request(request, client);
+    CHECK_EQUAL(429, httpStatus(response));
+    CHECK(httpHeader(response, "Retry-After") == "1");
+    CHECK_EQUAL(2, scan.scans);
+
+    // another client has a bucket of its own, the refill admits the first one again
+    CHECK_EQUAL(200, httpStatus(core.request(request, other)));
+    hostClockAdvance(2000 * 1000UL);
+    CHECK_EQUAL(200, httpStatus(core.request(request, client)));
+    CHECK_EQUAL(4, scan.scans);
+
+    ONEBIOTAdmissionCounters counters;
+    ONEBIOTAdmission::getCounters(counters);
+    CHECK_EQUAL(4, counters.admitted);
+    CHECK_EQUAL(1, counters.limited);
+}
+
+// Four connections hammer the scan while the clock stands still. Only the burst is
+// ever dispatched, every other request is answered by the canned 429 without
+// running the handler, so no loop iteration takes much longer than one scan.
+static void testAbuse() {
+    ONEBIOTAdmission::reset();
+    const int clients = 4;
+    const int requests = 50;
+    std::atomic<int> limited(0);
+    std::atomic<int> errors(0);
+    std::vector<std::thread> threads;
+    for (int client = 0; client < clients; client++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < requests; i++) {
+                std::string response = exchange("127.0.0.1", "GET /cmd/wifi/list HTTP/1.1\r\nHost: device\r\n\r\n");
+                int status = httpStatus(response);
+                if (status == 429) {
+                    limited++;
+                    errors += httpHeader(response, "Retry-After") != "1";
+                } else {
+                    errors += status != 200;
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    // another client is served meanwhile
+    CHECK_EQUAL(200, httpStatus(exchange("127.0.0.2", "GET /ping HTTP/1.1\r\nHost: device\r\n\r\n")));
+
+    int total = clients * requests;
+    int admitted = ONEBIOT_ADMISSION_BURST / ONEBIOTAdmission::cost("/cmd/wifi/list", 14);
+    printf("{\"test\":\"admission_abuse\",\"requests\":%d,\"limited\":%d,\"scans\":%d,\"max_loop_latency_us\":%ld}\n",
+        total, limited.load(), scans.load(), maxLoopLatency.load());
+    CHECK_EQUAL(0, errors.load());
+    CHECK_EQUAL(admitted, scans.load());
+    CHECK_EQUAL(total - admitted, limited.load());
+    // without the buckets the loop would have run every scan, 200 times SCAN_US
+    CHECK(maxLoopLatency.load() < admitted * SCAN_US + 100 * 1000L);
+}
+
+int main() {
+    hostClockFreeze();
+    testCosts();
+    testRefill();
+    testBackoff();
+    testSyncRouter();
+
+    server.on("/cmd/wifi/list", HTTP_GET, []() {
+        scans++;
+        usleep(SCAN_US);
+        server.send(200, "application/json", "{\"success\":true}");
+    });
+    server.on("/ping", HTTP_GET, []() {
+        server.send(200, "text/plain", "pong");
+    });
+    server.begin();
+
+    std::thread loop([]() {
+        while (serving) {
+            auto started = std::chrono::steady_clock::now();
+            server.handleClient();
+            long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+            maxLoopLatency = std::max(maxLoopLatency.load(), elapsed);
+            usleep(100);
+        }
+    });
+
+    testAbuse();
+
+    serving = false;
+    loop.join();
+    CHECK_DONE();
+}
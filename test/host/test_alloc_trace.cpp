@@ -0,0 +1,134 @@
+// Slot table of ONEBIOTAllocTrace, built with ONEBIOT_ALLOC_TRACE_SLOTS 8 so
+// probe chains and the wrap around at the end of the table are easy to force.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "utils/trace/ONEBIOTAllocTrace.h"
+#include "check.h"
+
+static const char TAG_SLOTS[] = "slots";
+static const char TAG_WRAP[] = "wrap";
+
+// same hash as the tracer, fake pointers never reach malloc or free
+static size_t home(uintptr_t ptr) {
+    return (size_t) (((uint32_t) (ptr >> 3) * 2654435761u) % ONEBIOT_ALLOC_TRACE_SLOTS);
+}
+
+static void *pointerAt(size_t slot, size_t skip) {
+    for (uintptr_t ptr = 0x1000;; ptr += 8) {
+        if (home(ptr) == slot && skip-- == 0) {
+            return (void *) ptr;
+        }
+    }
+}
+
+static ONEBIOTAllocTraceCounters counters(const char *tag) {
+    ONEBIOTAllocTraceCounters result;
+    for (size_t i = 0; ONEBIOTAllocTrace::get(i, result); i++) {
+        if (result.tag == tag) {
+            return result;
+        }
+    }
+    return ONEBIOTAllocTraceCounters();
+}
+
+// Freeing the middle of a chain shifts the rest back, everything stays findable.
+static void testChain() {
+    void *a = pointerAt(2, 0);
+    void *b = pointerAt(2, 1);
+    void *c = pointerAt(2, 2);
+    void *d = pointerAt(3, 0);
+
+    ONEBIOTAllocTrace::onAlloc(a, 10);
+    ONEBIOTAllocTrace::onAlloc(b, 20);
+    ONEBIOTAllocTrace::onAlloc(d, 30);
+    ONEBIOTAllocTrace::onAlloc(c, 40);
+    CHECK_EQUAL(100, counters(TAG_SLOTS).live);
+
+    ONEBIOTAllocTrace::onFree(b);
+    CHECK_EQUAL(80, counters(TAG_SLOTS).live);
+    ONEBIOTAllocTrace::onFree(a);
+    CHECK_EQUAL(70, counters(TAG_SLOTS).live);
+    // d sits behind its home, c in front of it has to be moved over it
+    ONEBIOTAllocTrace::onFree(c);
+    ONEBIOTAllocTrace::onFree(d);
+    CHECK_EQUAL(0, counters(TAG_SLOTS).live);
+    CHECK_EQUAL(4, counters(TAG_SLOTS).frees);
+
+    // unknown pointers are ignored
+    ONEBIOTAllocTrace::onFree(a);
+    CHECK_EQUAL(4, counters(TAG_SLOTS).frees);
+}
+
+// A chain running past the last slot continues at 0 and is shifted back over the end.
+static void testWrap() {
+    ONEBIOTAllocTrace::setTag(TAG_WRAP);
+    size_t last = ONEBIOT_ALLOC_TRACE_SLOTS - 1;
+    void *x = pointerAt(last, 0);
+    void *y = pointerAt(last, 1);
+    void *z = pointerAt(0, 0);
+    void *w = pointerAt(1, 0);
+
+    ONEBIOTAllocTrace::onAlloc(x, 1);
+    ONEBIOTAllocTrace::onAlloc(y, 2);
+    ONEBIOTAllocTrace::onAlloc(z, 4);
+    ONEBIOTAllocTrace::onAlloc(w, 8);
+
+    ONEBIOTAllocTrace::onFree(x);
+    CHECK_EQUAL(14, counters(TAG_WRAP).live);
+    ONEBIOTAllocTrace::onFree(w);
+    ONEBIOTAllocTrace::onFree(z);
+    ONEBIOTAllocTrace::onFree(y);
+    CHECK_EQUAL(0, counters(TAG_WRAP).live);
+    CHECK_EQUAL(4, counters(TAG_WRAP).frees);
+    ONEBIOTAllocTrace::setTag(TAG_SLOTS);
+}
+
+// Allocations not fitting into the table are counted, a freed slot is reused.
+static void testFull() {
+    void *pointers[ONEBIOT_ALLOC_TRACE_SLOTS + 1];
+    for (size_t i = 0; i <= ONEBIOT_ALLOC_TRACE_SLOTS; i++) {
+        pointers[i] = pointerAt(i % 3, i / 3);
+        ONEBIOTAllocTrace::onAlloc(pointers[i], 1);
+    }
+    CHECK_EQUAL(1, ONEBIOTAllocTrace::untracked());
+    CHECK_EQUAL(ONEBIOT_ALLOC_TRACE_SLOTS, counters(TAG_SLOTS).live);
+
+    ONEBIOTAllocTrace::onFree(pointers[0]);
+    ONEBIOTAllocTrace::onAlloc(pointers[0], 1);
+    CHECK_EQUAL(1, ONEBIOTAllocTrace::untracked());
+
+    for (size_t i = 0; i <= ONEBIOT_ALLOC_TRACE_SLOTS; i++) {
+        ONEBIOTAllocTrace::onFree(pointers[i]);
+    }
+    CHECK_EQUAL(0, counters(TAG_SLOTS).live);
+}
+
+// malloc and friends reach the tracer through the --wrap link flags.
+static void testWrappers() {
+    ONEBIOTAllocTrace::reset();
+    void *block = malloc(48);
+    CHECK_EQUAL(1, counters(TAG_SLOTS).count);
+    CHECK_EQUAL(48, counters(TAG_SLOTS).live);
+
+    block = realloc(block, 96);
+    CHECK_EQUAL(96, counters(TAG_SLOTS).live);
+    CHECK_EQUAL(96, counters(TAG_SLOTS).peak);
+
+    free(block);
+    void *zeroed = calloc(4, 8);
+    CHECK_EQUAL(32, counters(TAG_SLOTS).live);
+    free(zeroed);
+    CHECK_EQUAL(0, counters(TAG_SLOTS).live);
+    CHECK_EQUAL(3, counters(TAG_SLOTS).frees);
+}
+
+int main() {
+    ONEBIOTAllocTrace::setTag(TAG_SLOTS);
+    testChain();
+    testWrap();
+    testFull();
+    testWrappers();
+    ONEBIOTAllocTrace::setTag(nullptr);
+    CHECK_DONE();
+}
@@ -0,0 +1,86 @@
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "check.h"
+#include "host_server.h"
+#include "ONEBIOT.h"
+#include "utils/request/ONEBIOTCmdRequestHandler.h"
+
+// ONEBIOTResponseCache behind /cmd/dns: the ETag of a stored response, 304 for a
+// matching If-None-Match, and new tags after a config setter or a WiFi state change
+
+static std::string get(HostServer &server, const std::string &target, const std::string &etag = "") {
+    return server.request("GET " + target + " HTTP/1.1\r\nHost: onebiot.local\r\n" + std::string(HOST_AUTHORIZATION)
+        + (etag.empty() ? "" : "If-None-Match: " + etag + "\r\n") + "\r\n");
+}
+
+int main() {
+    FS memory;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", memory);
+    config.setCredentialsUser("admin");
+    config.setCredentialsPassword("secret");
+    config.setDnsName("kitchen");
+    ONEBIOTApp app(config, memory);
+    ONEBIOTResponseCache &cache = app.getCache();
+    ONEBIOTCmdRequestHandler handler(app);
+    HostServer server;
+    server.addHandler(&handler);
+    // the state the cache starts from
+    cache.loop();
+
+    // the first answer is stored and tagged, the second one comes from the cache
+    std::string response = get(server, "/cmd/dns");
+    CHECK_EQUAL(200, httpStatus(response));
+    std::string etag = httpHeader(response, "ETag");
+    CHECK_EQUAL(28, etag.length());
+    CHECK(httpHeader(response, "Cache-Control") == "no-cache");
+    CHECK(httpBody(response).find("\"kitchen\"") != std::string::npos);
+    CHECK_EQUAL(1, cache.getMisses());
+    response = get(server, "/cmd/dns");
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpHeader(response, "ETag") == etag);
+    CHECK(httpBody(response).find("\"kitchen\"") != std::string::npos);
+    CHECK_EQUAL(1, cache.getHits());
+
+    // the client's copy is current, no body
+    response = get(server, "/cmd/dns", etag);
+    CHECK_EQUAL(304, httpStatus(response));
+    CHECK(httpHeader(response, "ETag") == etag);
+    CHECK(httpBody(response).empty());
+    CHECK_EQUAL(304, httpStatus(get(server, "/cmd/dns", etag)));
+    CHECK_EQUAL(200, httpStatus(get(server, "/cmd/dns", "\"other\"")));
+
+    // evicted by other routes, the tag still matches as long as nothing changed
+    for (int i = 0; i < ONEBIOT_CACHE_ENTRIES; i++) {
+        CHECK_EQUAL(200, httpStatus(get(server, "/cmd/dns?page=" + std::to_string(i))));
+    }
+    uint32_t misses = cache.getMisses();
+    response = get(server, "/cmd/dns", etag);
+    CHECK_EQUAL(misses + 1, cache.getMisses());
+    CHECK_EQUAL(304, httpStatus(response));
+    CHECK(httpHeader(response, "ETag") == etag);
+
+    // a config setter changes the response and its tag
+    config.setDnsName("garden");
+    response = get(server, "/cmd/dns", etag);
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpBody(response).find("\"garden\"") != std::string::npos);
+    std::string changed = httpHeader(response, "ETag");
+    CHECK(!changed.empty() && changed != etag);
+    CHECK_EQUAL(304, httpStatus(get(server, "/cmd/dns", changed)));
+
+    // so does a WiFi state change once loop() has seen it
+    WiFi.hostStatus = WL_CONNECTED;
+    CHECK_EQUAL(304, httpStatus(get(server, "/cmd/dns", changed)));
+    cache.loop();
+    response = get(server, "/cmd/dns", changed);
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpHeader(response, "ETag") != changed);
+    CHECK(httpBody(response).find("\"garden\"") != std::string::npos);
+
+    // an explicit invalidation as well
+    std::string current = httpHeader(response, "ETag");
+    cache.invalidate();
+    CHECK_EQUAL(200, httpStatus(get(server, "/cmd/dns", current)));
+    CHECK_DONE();
+}
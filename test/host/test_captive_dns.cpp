@@ -0,0 +1,234 @@
+#include <Arduino.h>
+#include <FS.h>
+#include <WiFiUdp.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <vector>
+#include "check.h"
+#include "host_server.h"
+#include "utils/captive/ONEBIOTCaptivePortal.h"
+#include "utils/router/ONEBIOTRouter.h"
+
+// ONEBIOTCaptiveDNS byte by byte and over a loopback UDP socket, the redirects of
+// the connectivity checks and the routes of the sketch they leave alone once the
+// DNS is stopped, the query rates are printed as one JSON line
+
+typedef std::vector<uint8_t> Packet;
+
+// "example.com" type A class IN, ID 0xBEEF, recursion desired
+static Packet query(uint16_t type = 1, uint8_t flags = 0x01, uint8_t questions = 1) {
+    Packet packet = {0xBE, 0xEF, flags, 0x00, 0x00, questions, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        7, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 3, 'c', 'o', 'm', 0,
+        (uint8_t) (type >> 8), (uint8_t) type, 0x00, 0x01};
+    return packet;
+}
+
+static const size_t QUESTION_END = 29;
+
+class SketchHandler : public RequestHandler {
+    public:
+        bool handle(ESP8266WebServer& server, HTTPMethod, String) override {
+            server.send(200, "text/plain", "sketch");
+            return true;
+        }
+};
+
+static size_t respond(ONEBIOTCaptiveDNS &dns, Packet &packet) {
+    size_t length = packet.size();
+    packet.resize(ONEBIOT_CAPTIVE_DNS_PACKET_SIZE + 16);
+    size_t size = dns.respond(packet.data(), length, packet.size());
+    packet.resize(size);
+    return size;
+}
+
+static void testRespond(ONEBIOTCaptiveDNS &dns) {
+    Packet packet = query();
+    CHECK_EQUAL(QUESTION_END + 16, respond(dns, packet));
+    // ID and RD kept, an authoritative answer to one question
+    const uint8_t header[] = {0xBE, 0xEF, 0x85, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00};
+    CHECK(memcmp(packet.data(), header, sizeof(header)) == 0);
+    // the question stays, the record points back at its name
+    Packet original = query();
+    CHECK(memcmp(packet.data() + 12, original.data() + 12, QUESTION_END - 12) == 0);
+    const uint8_t answer[] = {0xC0, 0x0C, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, ONEBIOT_CAPTIVE_DNS_TTL, 0x00, 0x04, 192, 168, 4, 1};
+    CHECK(memcmp(packet.data() + QUESTION_END, answer, sizeof(answer)) == 0);
+
+    // without RD the answer has none either
+    packet = query(1, 0x00);
+    CHECK_EQUAL(QUESTION_END + 16, respond(dns, packet));
+    CHECK_EQUAL(0x84, packet[2]);
+
+    // the OPT record of EDNS is cut off
+    packet = query();
+    packet[11] = 1;
+    const uint8_t opt[] = {0x00, 0x00, 0x29, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    packet.insert(packet.end(), opt, opt + sizeof(opt));
+    CHECK_EQUAL(QUESTION_END + 16, respond(dns, packet));
+    CHECK_EQUAL(0, packet[11]);
+
+    // AAAA gets no record, only the question back
+    packet = query(28);
+    CHECK_EQUAL(QUESTION_END, respond(dns, packet));
+    CHECK_EQUAL(0, packet[7]);
+    CHECK_EQUAL(0x85, packet[2]);
+
+    // a response, two questions, a compression pointer, a cut question and a bare header are dropped
+    Packet dropped[] = {query(1, 0x81), query(1, 0x01, 2), query(), query(), query()};
+    dropped[2][12] = 0xC0;
+    dropped[3].resize(QUESTION_END - 2);
+    dropped[4].resize(11);
+    for (Packet &packet : dropped) {
+        CHECK_EQUAL(0, respond(dns, packet));
+    }
+
+    const ONEBIOTCaptiveDNSCounters &counters = dns.getCounters();
+    CHECK_EQUAL(3, counters.answered);
+    CHECK_EQUAL(1, counters.empty);
+    CHECK_EQUAL(5, counters.dropped);
+}
+
+static uint16_t freePort() {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    bind(fd, (sockaddr *) &address, length);
+    getsockname(fd, (sockaddr *) &address, &length);
+    close(fd);
+    return ntohs(address.sin_port);
+}
+
+static void sendQuery(int fd, uint16_t port, const Packet &packet) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK_EQUAL(packet.size(), sendto(fd, packet.data(), packet.size(), 0, (sockaddr *) &address, sizeof(address)));
+}
+
+static size_t receiveAnswers(int fd) {
+    size_t answers = 0;
+    uint8_t buffer[512];
+    while (recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT) > 0) {
+        answers++;
+    }
+    return answers;
+}
+
+static void testSocket() {
+    ONEBIOTCaptiveDNS dns;
+    uint16_t port = freePort();
+    CHECK(dns.begin(IPAddress(192, 168, 4, 1), port));
+    CHECK(dns.isRunning());
+    int client = socket(AF_INET, SOCK_DGRAM, 0);
+
+    // one pass answers a bounded number of queries, the rest waits for the next one
+    for (int i = 0; i < ONEBIOT_CAPTIVE_DNS_QUERIES + 2; i++) {
+        sendQuery(client, port, query());
+    }
+    // a packet over the size limit is dropped unread
+    sendQuery(client, port, Packet(ONEBIOT_CAPTIVE_DNS_PACKET_SIZE + 1, 0));
+    CHECK_EQUAL(ONEBIOT_CAPTIVE_DNS_QUERIES, dns.loop());
+    CHECK_EQUAL(2, dns.loop());
+    CHECK_EQUAL(0, dns.loop());
+    CHECK_EQUAL(ONEBIOT_CAPTIVE_DNS_QUERIES + 2, receiveAnswers(client));
+    CHECK_EQUAL(1, dns.getCounters().dropped);
+
+    // the answer on the wire is the one respond() builds
+    sendQuery(client, port, query());
+    CHECK_EQUAL(1, dns.loop());
+    uint8_t buffer[512];
+    ssize_t size = recv(client, buffer, sizeof(buffer), 0);
+    CHECK_EQUAL(QUESTION_END + 16, size);
+    CHECK_EQUAL(0xBE, buffer[0]);
+    CHECK_EQUAL(1, buffer[7]);
+    CHECK(memcmp(buffer + size - 4, "\xC0\xA8\x04\x01", 4) == 0);
+
+    // the rates of this host, respond() alone and whole loop() passes over the socket
+    const int responds = 1000000;
+    Packet packet = query();
+    Packet work(ONEBIOT_CAPTIVE_DNS_PACKET_SIZE + 16);
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < responds; i++) {
+        memcpy(work.data(), packet.data(), packet.size());
+        dns.respond(work.data(), packet.size(), work.size());
+    }
+    double respondSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    const int queries = 2000;
+    int answered = 0;
+    started = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; i += ONEBIOT_CAPTIVE_DNS_QUERIES) {
+        for (int j = 0; j < ONEBIOT_CAPTIVE_DNS_QUERIES; j++) {
+            sendQuery(client, port, packet);
+        }
+        answered += dns.loop();
+        receiveAnswers(client);
+    }
+    double loopSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    CHECK_EQUAL(queries, answered);
+    printf("{\"test\":\"captive_dns\",\"respond_qps\":%.0f,\"loop_qps\":%.0f}\n", responds / respondSeconds, queries / loopSeconds);
+
+    dns.stop();
+    CHECK(!dns.isRunning());
+    CHECK_EQUAL(0, dns.loop());
+    close(client);
+}
+
+static std::string get(HostServer &server, const char *target) {
+    return server.request(std::string("GET ") + target + " HTTP/1.1\r\nHost: connectivitycheck.gstatic.com\r\n\r\n");
+}
+
+static void testPortal() {
+    FS memory;
+    File file = memory.open("/success.txt", "w");
+    file.print("success");
+    file.close();
+
+    ONEBIOTCaptiveDNS dns;
+    CHECK(dns.begin(IPAddress(192, 168, 4, 1), freePort()));
+    ONEBIOTRouter router;
+    ONEBIOTCaptivePortal portal(dns);
+    CHECK(portal.addRoutes(router));
+    // the sketch's own route and files on paths of the checks, added after the portal
+    SketchHandler sketch;
+    CHECK(router.on("/redirect", ONEBIOT_ROUTE(HTTP_GET), &sketch));
+    CHECK(router.serveStatic("/", memory, "/"));
+    HostServer server;
+    server.addHandler(&router);
+
+    const char *checks[] = {"/generate_204", "/gen_204", "/hotspot-detect.html", "/library/test/success.html",
+        "/connecttest.txt", "/ncsi.txt", "/redirect", "/canonical.html", "/success.txt"};
+    for (const char *check : checks) {
+        std::string response = get(server, check);
+        CHECK_EQUAL(302, httpStatus(response));
+        CHECK(httpHeader(response, "Location").compare(0, 7, "http://") == 0);
+        CHECK(httpHeader(response, "Cache-Control") == "no-cache");
+    }
+    CHECK_EQUAL(404, httpStatus(get(server, "/other")));
+
+    // the AP is down, the routes of the portal pass the requests on
+    dns.stop();
+    std::string response = get(server, "/redirect");
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpBody(response) == "sketch");
+    response = get(server, "/success.txt");
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpBody(response) == "success");
+    CHECK_EQUAL(404, httpStatus(get(server, "/canonical.html")));
+    CHECK_EQUAL(404, httpStatus(get(server, "/generate_204")));
+}
+
+int main() {
+    ONEBIOTCaptiveDNS dns;
+    CHECK(dns.begin(IPAddress(192, 168, 4, 1), freePort()));
+    testRespond(dns);
+    dns.stop();
+
+    testSocket();
+    testPortal();
+    CHECK_DONE();
+}
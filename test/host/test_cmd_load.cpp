@@ -0,0 +1,252 @@
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "host_http.h"
+#include "ONEBIOT.h"
+#include "utils/http/ONEBIOTAdmission.h"
+#include "utils/http/ONEBIOTHttpServer.h"
+#include "utils/request/ONEBIOTCmdRequestHandler.h"
+#include "utils/router/ONEBIOTRouter.h"
+#include "utils/trace/ONEBIOTAllocTrace.h"
+
+/**
+ * Load benchmark of the /cmd API: ONEBIOTCmdRequestHandler behind the app's router
+ * and ONEBIOTHttpServer on a loopback socket. Each phase replays the weighted mix
+ * over <concurrency> parallel connections and prints one JSON line:
+ *   {"phase":"auth","concurrency":4,"requests":500,"errors":0,"limited":0,"rps":..,
+ *    "p50_us":..,"p99_us":..,"p999_us":..,"allocs_per_request":..,"peak_heap":..}
+ *
+ *   test_cmd_load [concurrency] [requests per phase]
+ *
+ * A CI job can keep the lines starting with '{' and compare them against a baseline.
+ * The clients run on the loop thread between two handleClient() calls, like the device
+ * serves them, so the tracer sees the allocations of the server alone: every one of
+ * the request path counts in allocs_per_request, peak_heap is the most any /cmd route
+ * held at once. The library is built with a budget no phase runs out of.
+ */
+
+struct LoadRoute {
+    const char *method;
+    const char *path;
+    const char *body;
+    uint8_t weight;
+};
+
+// the PATCH sets the value it already has after the first request
+static const LoadRoute LOAD_ROUTES[] = {
+    {"GET", "/cmd/stats", nullptr, 40},
+    {"GET", "/cmd/option/client_name", nullptr, 25},
+    {"GET", "/cmd/wifi", nullptr, 20},
+    {"PATCH", "/cmd/config", "{\"client_name\":\"bench\"}", 15}
+};
+
+static const long LOAD_TIMEOUT_US = 5000 * 1000L;
+
+struct LoadConnection {
+    int fd = -1;
+    std::chrono::steady_clock::time_point started;
+    std::string response;
+};
+
+struct LoadResult {
+    size_t completed = 0;
+    size_t errors = 0;
+    size_t limited = 0;
+    size_t unauthorized = 0;
+};
+
+static ONEBIOTHttpServer server(0);
+
+static const LoadRoute &pickRoute() {
+    int total = 0;
+    for (const LoadRoute &route : LOAD_ROUTES) {
+        total += route.weight;
+    }
+
+    int ticket = random(total);
+    for (const LoadRoute &route : LOAD_ROUTES) {
+        if (ticket < route.weight) {
+            return route;
+        }
+        ticket -= route.weight;
+    }
+    return LOAD_ROUTES[0];
+}
+
+static bool sendRequest(LoadConnection &connection, bool authenticated) {
+    const LoadRoute &route = pickRoute();
+    std::string request = std::string(route.method) + " " + route.path + " HTTP/1.1\r\nHost: onebiot.local\r\n";
+    if (authenticated) {
+        // admin:secret
+        request += "Authorization: Basic YWRtaW46c2VjcmV0\r\n";
+    }
+    if (route.body != nullptr) {
+        request += "Content-Type: application/json\r\nContent-Length: " + std::to_string(strlen(route.body)) + "\r\n\r\n" + route.body;
+    } else {
+        request += "\r\n";
+    }
+
+    connection.fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(server.hostPort());
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    connection.started = std::chrono::steady_clock::now();
+    connection.response.clear();
+    // the kernel completes a loopback connect from its backlog, the server accepts it later
+    if (connect(connection.fd, (sockaddr *) &address, sizeof(address)) != 0
+        || write(connection.fd, request.data(), request.size()) != (ssize_t) request.size()) {
+        return false;
+    }
+    fcntl(connection.fd, F_SETFL, fcntl(connection.fd, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+static void finish(LoadConnection &connection, LoadResult &result, std::vector<long> &latencies, bool success) {
+    close(connection.fd);
+    connection.fd = -1;
+    int status = httpStatus(connection.response);
+    if (!success || status == 0) {
+        result.errors++;
+        return;
+    }
+    latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - connection.started).count());
+    result.completed++;
+    result.limited += status == 429;
+    result.unauthorized += status == 401;
+}
+
+// Reads what arrived, the response is complete once the server closed the connection.
+static void poll(LoadConnection &connection, LoadResult &result, std::vector<long> &latencies) {
+    char buffer[1024];
+    for (;;) {
+        ssize_t length = read(connection.fd, buffer, sizeof(buffer));
+        if (length > 0) {
+            connection.response.append(buffer, length);
+            continue;
+        }
+        if (length == 0) {
+            finish(connection, result, latencies, true);
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            finish(connection, result, latencies, false);
+        } else if (std::chrono::steady_clock::now() - connection.started > std::chrono::microseconds(LOAD_TIMEOUT_US)) {
+            finish(connection, result, latencies, false);
+        }
+        return;
+    }
+}
+
+static long percentile(const std::vector<long> &sorted, float rank) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[(size_t) (rank * (sorted.size() - 1) + 0.5f)];
+}
+
+// allocations of every tag and the largest peak of a /cmd route since the last reset
+static void readAllocCounters(uint32_t &count, uint32_t &peak) {
+    count = 0;
+    peak = 0;
+    ONEBIOTAllocTraceCounters counters;
+    for (size_t i = 0; ONEBIOTAllocTrace::get(i, counters); i++) {
+        count += counters.count;
+        if (strncmp(counters.tag, "/cmd", 4) == 0) {
+            peak = std::max(peak, counters.peak);
+        }
+    }
+}
+
+static LoadResult runPhase(const char *name, bool authenticated, int concurrency, size_t requests) {
+    std::vector<LoadConnection> connections(concurrency);
+    std::vector<long> latencies;
+    LoadResult result;
+    size_t issued = 0;
+
+    ONEBIOTAllocTrace::reset();
+    auto start = std::chrono::steady_clock::now();
+    while (result.completed < requests && result.errors < requests) {
+        for (LoadConnection &connection : connections) {
+            if (connection.fd >= 0) {
+                poll(connection, result, latencies);
+            } else if (issued < requests + result.errors) {
+                issued++;
+                if (!sendRequest(connection, authenticated)) {
+                    finish(connection, result, latencies, false);
+                }
+            }
+        }
+        server.handleClient();
+    }
+    long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    for (LoadConnection &connection : connections) {
+        if (connection.fd >= 0) {
+            close(connection.fd);
+        }
+    }
+    // the server notices the closed connections and releases their slots
+    for (int i = 0; i < 10; i++) {
+        server.handleClient();
+    }
+
+    uint32_t allocs;
+    uint32_t peak;
+    readAllocCounters(allocs, peak);
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("{\"phase\":\"%s\",\"concurrency\":%d,\"requests\":%u,\"errors\":%u,\"limited\":%u,\"rps\":%.1f,"
+        "\"p50_us\":%ld,\"p99_us\":%ld,\"p999_us\":%ld,\"allocs_per_request\":%.1f,\"peak_heap\":%u}\n",
+        name, concurrency, (unsigned) result.completed, (unsigned) result.errors, (unsigned) result.limited,
+        elapsed ? result.completed * 1000000.0 / elapsed : 0.0,
+        percentile(latencies, 0.5f), percentile(latencies, 0.99f), percentile(latencies, 0.999f),
+        result.completed ? allocs / (float) result.completed : 0.0f, peak);
+    return result;
+}
+
+int main(int argc, char **argv) {
+    int concurrency = argc > 1 ? atoi(argv[1]) : ONEBIOT_HTTP_CONNECTIONS;
+    size_t requests = argc > 2 ? atol(argv[2]) : 500;
+    concurrency = concurrency < 1 ? 1 : concurrency;
+
+    FS memory;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", memory);
+    config.setCredentialsUser("admin");
+    config.setCredentialsPassword("secret");
+    ONEBIOTApp app(config, memory);
+    ONEBIOTCmdRequestHandler handler(app);
+    ONEBIOTRouter router;
+    router.addHandler(&handler);
+
+    static const char *headers[] = {"If-None-Match", "Accept", "Content-Type"};
+    server.collectHeaders(headers, 3);
+    server.addHandler(&router);
+    server.begin();
+    randomSeed(1);
+
+    LoadResult authenticated = runPhase("auth", true, concurrency, requests);
+    CHECK_EQUAL(requests, authenticated.completed);
+    CHECK_EQUAL(0, authenticated.errors);
+    CHECK_EQUAL(0, authenticated.limited);
+    CHECK_EQUAL(0, authenticated.unauthorized);
+    CHECK(config.getClientName() == "bench");
+
+    // the rejection path, every request is answered by 401
+    LoadResult rejected = runPhase("no_auth", false, concurrency, requests);
+    CHECK_EQUAL(requests, rejected.completed);
+    CHECK_EQUAL(0, rejected.errors);
+    CHECK_EQUAL(requests, rejected.unauthorized);
+
+    ONEBIOTAdmissionCounters counters;
+    ONEBIOTAdmission::getCounters(counters);
+    CHECK_EQUAL(0, counters.limited);
+    CHECK_DONE();
+}
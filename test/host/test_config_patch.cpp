@@ -0,0 +1,79 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "check.h"
+#include "host_server.h"
+#include "ONEBIOT.h"
+#include "utils/request/ONEBIOTCmdRequestHandler.h"
+
+// PATCH /cmd/config: every key of the schema passes the filter, unknown keys are
+// skipped, a type error rejects the whole patch and need_restart follows the fields
+
+static DynamicJsonDocument patch(HostServer &server, const std::string &body) {
+    std::string response = server.request("PATCH /cmd/config HTTP/1.1\r\nHost: onebiot.local\r\n"
+        + std::string(HOST_AUTHORIZATION)
+        + "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.length()) + "\r\n\r\n" + body);
+    CHECK_EQUAL(200, httpStatus(response));
+    DynamicJsonDocument result(2048);
+    CHECK(!deserializeJson(result, httpBody(response).c_str()));
+    return result;
+}
+
+int main() {
+    FS memory;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", memory);
+    config.setCredentialsUser("admin");
+    config.setCredentialsPassword("secret");
+    ONEBIOTApp app(config, memory);
+    ONEBIOTCmdRequestHandler handler(app);
+    HostServer server;
+    server.addHandler(&handler);
+
+    // all eleven keys at once, none of them may be lost to the size of the filter
+    DynamicJsonDocument result = patch(server, "{\"credentials_user\":\"admin\",\"credentials_password\":\"secret\","
+        "\"client_name\":\"kitchen\",\"wifi_ssid\":\"home\",\"wifi_password\":\"password1\",\"wifi_establish\":true,"
+        "\"ap_ssid\":\"setup\",\"ap_password\":\"password2\",\"ap_establish\":true,\"dns_name\":\"kitchen\",\"dns_establish\":true}");
+    CHECK(result["success"].as<bool>());
+    CHECK(result["need_restart"].as<bool>());
+    CHECK_EQUAL(9, result["changes"].size());
+    CHECK(result["changes"]["wifi_password"]["to"] != "password1");
+    ONEBIOTConfigAppConfig current = config.getConfig();
+    CHECK(current.client_name == "kitchen");
+    CHECK(current.wifi_password == "password1");
+    CHECK(current.dns_name == "kitchen");
+    CHECK(current.dns_establish);
+    File file = memory.open("/config.json", "r");
+    CHECK(file.readString().indexOf("\"dns_name\":\"kitchen\"") >= 0);
+    file.close();
+
+    // unknown keys are dropped by the filter, the known one next to them still applies
+    result = patch(server, "{\"unknown\":1,\"nested\":{\"client_name\":\"garden\"}}");
+    CHECK(result["success"].as<bool>());
+    CHECK(!result["need_restart"].as<bool>());
+    CHECK_EQUAL(0, result["changes"].size());
+    result = patch(server, "{\"unknown\":1,\"client_name\":\"garden\"}");
+    CHECK(result["success"].as<bool>());
+    CHECK(!result["need_restart"].as<bool>());
+    CHECK_EQUAL(1, result["changes"].size());
+    CHECK(config.getClientName() == "garden");
+
+    // a type error rejects the patch, the valid field in it stays unapplied
+    result = patch(server, "{\"client_name\":\"cellar\",\"wifi_establish\":\"yes\"}");
+    CHECK(!result["success"].as<bool>());
+    CHECK(result["message"] == "wifi_establish has to be a boolean.");
+    CHECK(result["changes"].isNull());
+    result = patch(server, "{\"dns_name\":5}");
+    CHECK(!result["success"].as<bool>());
+    CHECK(result["message"] == "dns_name has to be a string.");
+    CHECK(config.getClientName() == "garden");
+    CHECK(config.getDnsName() == "kitchen");
+
+    // network fields need a restart, the client name does not
+    result = patch(server, "{\"wifi_ssid\":\"office\"}");
+    CHECK(result["success"].as<bool>());
+    CHECK(result["need_restart"].as<bool>());
+    result = patch(server, "{\"wifi_ssid\":\"office\"}");
+    CHECK(!result["need_restart"].as<bool>());
+    CHECK(result["message"] == "Nothing to change.");
+    CHECK_DONE();
+}
@@ -0,0 +1,116 @@
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <sys/socket.h>
+#include "check.h"
+#include "host_http.h"
+#include "utils/events/ONEBIOTEvents.h"
+
+// /cmd/events: snapshot first, then only values past their threshold, slow readers are dropped
+
+static void tick(ONEBIOTEvents &events) {
+    hostClockAdvance(1000 * 1000UL);
+    events.loop();
+}
+
+// the messages since the last call, the response header is skipped
+static std::string received(int peer) {
+    std::string data = httpRead(peer, 10);
+    size_t header = data.find("\r\n\r\n");
+    return header == std::string::npos ? data : data.substr(header + 4);
+}
+
+static void testSnapshotThenDeltas(ONEBIOTEvents &events, ONEBIOTConfig &config) {
+    int peer;
+    CHECK(events.subscribe(hostSocketPair(peer)));
+    tick(events);
+    CHECK(received(peer) == "event: snapshot\ndata: {\"heap\":30000,\"rssi\":-60,\"wifi\":3,\"config\":0}\n\n");
+
+    // below the thresholds nothing is sent
+    hostSetFreeHeap(29700);
+    WiFi.hostRssi = -62;
+    tick(events);
+    CHECK(received(peer).empty());
+
+    // small steps add up against the last value sent
+    hostSetFreeHeap(29400);
+    WiFi.hostRssi = -63;
+    tick(events);
+    CHECK(received(peer) == "event: delta\ndata: {\"heap\":29400,\"rssi\":-63}\n\n");
+
+    config.setClientName("kitchen");
+    WiFi.hostStatus = WL_DISCONNECTED;
+    tick(events);
+    // RSSI reads 0 while disconnected, that moved as well
+    CHECK(received(peer) == "event: delta\ndata: {\"rssi\":0,\"wifi\":7,\"config\":1}\n\n");
+    WiFi.hostStatus = WL_CONNECTED;
+    tick(events);
+    received(peer);
+
+    // an idle channel gets a comment every 15 s
+    for (int i = 0; i < 14; i++) {
+        tick(events);
+    }
+    CHECK(received(peer).empty());
+    tick(events);
+    CHECK(received(peer) == ":\n\n");
+    close(peer);
+    tick(events);
+    CHECK_EQUAL(0, events.size());
+}
+
+static void testSlowSubscriber(ONEBIOTEvents &events) {
+    int slowPeer;
+    int fastPeer;
+    WiFiClient slow = hostSocketPair(slowPeer);
+    CHECK(events.subscribe(slow));
+    CHECK(events.subscribe(hostSocketPair(fastPeer)));
+    tick(events);
+    received(slowPeer);
+    received(fastPeer);
+
+    // no room for the next message, the loop drops the client instead of waiting
+    slow.hostSetAvailableForWrite(10);
+    hostSetFreeHeap(20000);
+    tick(events);
+    CHECK_EQUAL(1, events.size());
+    CHECK(received(fastPeer) == "event: delta\ndata: {\"heap\":20000}\n\n");
+    CHECK(received(slowPeer).empty());
+    char data;
+    CHECK_EQUAL(0, recv(slowPeer, &data, 1, MSG_DONTWAIT));
+    close(slowPeer);
+    close(fastPeer);
+    tick(events);
+    CHECK_EQUAL(0, events.size());
+}
+
+static void testFullTable(ONEBIOTEvents &events) {
+    int peers[ONEBIOT_EVENTS_SUBSCRIBERS + 1];
+    for (size_t i = 0; i < ONEBIOT_EVENTS_SUBSCRIBERS; i++) {
+        CHECK(events.subscribe(hostSocketPair(peers[i])));
+    }
+    CHECK(!events.subscribe(hostSocketPair(peers[ONEBIOT_EVENTS_SUBSCRIBERS])));
+
+    // a closed connection frees its slot
+    close(peers[0]);
+    CHECK(events.subscribe(hostSocketPair(peers[0])));
+    for (size_t i = 0; i <= ONEBIOT_EVENTS_SUBSCRIBERS; i++) {
+        close(peers[i]);
+    }
+}
+
+int main() {
+    hostClockFreeze();
+    hostSetFreeHeap(30000);
+    WiFi.hostStatus = WL_CONNECTED;
+    WiFi.hostRssi = -60;
+
+    FS memory;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", memory);
+    ONEBIOTEvents events(config);
+
+    testSnapshotThenDeltas(events, config);
+    testSlowSubscriber(events);
+    testFullTable(events);
+    CHECK_DONE();
+}
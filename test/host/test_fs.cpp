@@ -0,0 +1,171 @@
+#include <Arduino.h>
+#include <ESP8266WebServer.h>
+#include <chrono>
+#include "check.h"
+#include "host_http.h"
+#include "utils/config/ONEBIOTConfig.h"
+#include "utils/request/ONEBIOTRequestHandler.h"
+
+// config and templates read through the fs::FS handed in, never the default one
+
+String processor(String &key) {
+    return "<" + key + ">";
+}
+
+class TestServer : public ESP8266WebServer {
+    public:
+        void attach(WiFiClient client) {
+            _currentClient = client;
+        }
+};
+
+class TestHandler : public ONEBIOTRequestHandler {
+    public:
+        TestHandler(ONEBIOTConfig config) : ONEBIOTRequestHandler(config) {}
+        bool render(const char *fileName, ESP8266WebServer &server) {
+            return _sendAsTemplate(fileName, "text/html", server);
+        }
+};
+
+static void testConfigRoundTrip() {
+    FS memory;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", memory);
+    CHECK(config.setClientName("kitchen"));
+    CHECK(config.setWiFiSsid("home"));
+    CHECK(config.setWiFiPassword("secret-password"));
+    CHECK(config.save());
+
+    CHECK(memory.hostRead("/config.json").find("\"wifi_ssid\":\"home\"") != std::string::npos);
+    CHECK(memory.hostRead("/config.json.bak").empty());
+    CHECK_EQUAL(0, SPIFFS.hostFileCount());
+
+    ONEBIOTConfigAppConfig loadedConfig;
+    ONEBIOTConfig loaded(loadedConfig, "/config.json", memory);
+    CHECK(loaded.load());
+    CHECK(loaded.getClientName() == "kitchen");
+    CHECK(loaded.getWiFiSsid() == "home");
+    CHECK(loadedConfig.wifi_password == "secret-password");
+
+    // open() and rename() report a missing file, nothing asks exists() first
+    CHECK_EQUAL(0, memory.hostCounters.exists);
+
+    ONEBIOTConfig missing(loadedConfig, "/missing.json", memory);
+    CHECK(!missing.load());
+}
+
+static void testFailedSaveKeepsFile() {
+    FS seed;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", seed);
+    config.setWiFiSsid("home");
+    CHECK(config.save());
+    std::string previous = seed.hostRead("/config.json");
+
+    // the backup takes all the room, the new file ends up short
+    FS full(previous.length() + 16);
+    full.hostWrite("/config.json", previous);
+    config.setFileSystem(full);
+    config.setWiFiSsid("a much longer network name");
+    CHECK(!config.save());
+    CHECK(full.hostRead("/config.json") == previous);
+    CHECK(full.hostRead("/config.json.bak").empty());
+    CHECK_EQUAL(1, full.hostFileCount());
+}
+
+static void testTemplate() {
+    FS memory;
+    memory.hostWrite("/index.html", "Hello %NAME%, see %LINK%.");
+    ONEBIOTConfigAppConfig appConfig;
+    TestHandler handler(ONEBIOTConfig(appConfig, "/config.json", memory));
+    TestServer server;
+    int peer;
+    server.attach(hostSocketPair(peer));
+
+    CHECK(!handler.render("/missing.html", server));
+    CHECK(handler.render("/index.html", server));
+    std::string response = httpRead(peer);
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpBody(response) == "Hello <NAME>, see <LINK>.");
+    CHECK_EQUAL(0, memory.hostCounters.exists);
+    close(peer);
+}
+
+static double microsSince(std::chrono::steady_clock::time_point started, int iterations) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count() / iterations;
+}
+
+// The measurements of the fs_benchmark sketch on the in-memory backend of the host,
+// what is left is the cost of the library around the flash, with the calls it makes
+static void benchmark() {
+    const int iterations = 1000;
+    FS memory;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/onebiot.json", memory);
+    config.setWiFiSsid("benchmark");
+    config.setWiFiPassword("benchmark-password");
+    config.setDnsName("benchmark");
+    CHECK(config.save());
+
+    const char *line = "<p>%client_name% static content line of the benchmark file</p>\n";
+    File file = memory.open("/static.txt", "w");
+    for (int i = 0; i < 64; i++) {
+        file.print(line);
+    }
+    file.close();
+
+    memory.hostCounters = FS::HostCounters();
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        config.load();
+    }
+    double loadUs = microsSince(started, iterations);
+
+    started = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        config.save();
+    }
+    double saveUs = microsSince(started, iterations);
+    // load and save open the config once each, nothing asks exists() first
+    CHECK_EQUAL(2 * iterations, memory.hostCounters.open);
+    CHECK_EQUAL(0, memory.hostCounters.exists);
+
+    uint8_t buffer[256];
+    size_t total = 0;
+    started = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        File file = memory.open("/static.txt", "r");
+        while (file.available()) {
+            total += file.read(buffer, sizeof(buffer));
+        }
+        file.close();
+    }
+    double readUs = microsSince(started, iterations);
+    CHECK_EQUAL(64 * strlen(line), total / iterations);
+
+    size_t keys = 0;
+    started = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        File file = memory.open("/static.txt", "r");
+        int val;
+        while ((val = file.read()) != -1) {
+            if (val == '%') {
+                keys++;
+            }
+        }
+        file.close();
+    }
+    double walkUs = microsSince(started, iterations);
+    CHECK_EQUAL(128, keys / iterations);
+
+    printf("{\"test\":\"fs_benchmark\",\"backend\":\"memory\",\"config_load_us\":%.2f,\"config_save_us\":%.2f,"
+        "\"static_read_us\":%.2f,\"template_walk_us\":%.2f}\n", loadUs, saveUs, readUs, walkUs);
+}
+
+int main() {
+    testConfigRoundTrip();
+    testFailedSaveKeepsFile();
+    testTemplate();
+    benchmark();
+    CHECK_DONE();
+}
@@ -0,0 +1,184 @@
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "host_http.h"
+#include "utils/http/ONEBIOTHttpServer.h"
+
+// ONEBIOTHttpServer over loopback sockets: limits, connection handling and latency
+// next to a stalled client, the load numbers of it and of the plain core server
+// under the same load are printed as one JSON line per backend
+
+static ONEBIOTHttpServer server(0);
+static ESP8266WebServer plain(0);
+static std::atomic<bool> serving(true);
+static size_t uploaded = 0;
+
+static int connectServer(ESP8266WebServer &target = server) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(target.hostPort());
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(connect(fd, (sockaddr *) &address, sizeof(address)) == 0);
+    return fd;
+}
+
+// the whole response, read up to its Content-Length like a browser does, the core
+// server keeps the connection until the client closes it
+static std::string exchange(const std::string &request, ESP8266WebServer &target = server) {
+    int fd = connectServer(target);
+    CHECK_EQUAL(request.size(), write(fd, request.data(), request.size()));
+    std::string response;
+    char buffer[1024];
+    pollfd ready = {fd, POLLIN, 0};
+    // long enough for a request queued behind the stalled client of the core server
+    while (poll(&ready, 1, HTTP_MAX_DATA_WAIT + 2000) > 0) {
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+        response.append(buffer, length);
+        size_t head = response.find("\r\n\r\n");
+        std::string contentLength = httpHeader(response, "Content-Length");
+        if (head != std::string::npos && !contentLength.empty() && response.size() - head - 4 >= strtoul(contentLength.c_str(), nullptr, 10)) {
+            break;
+        }
+    }
+    close(fd);
+    return response;
+}
+
+static void testConnectionClose() {
+    auto started = std::chrono::steady_clock::now();
+    std::string response = exchange("GET /ping HTTP/1.1\r\nHost: device\r\n\r\n");
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpHeader(response, "Connection") == "close");
+    CHECK(httpBody(response) == "pong");
+    // read until the server closed, not until the quiet period ran out
+    CHECK(elapsed < std::chrono::milliseconds(1000));
+}
+
+static void testLimits() {
+    CHECK_EQUAL(431, httpStatus(exchange("GET /ping HTTP/1.1\r\nX-Filler: " + std::string(ONEBIOT_HTTP_HEAD_SIZE, 'x') + "\r\n\r\n")));
+
+    std::string length = String(ONEBIOT_HTTP_REQUEST_SIZE * 2).c_str();
+    CHECK_EQUAL(413, httpStatus(exchange("POST /ping HTTP/1.1\r\nContent-Type: application/json\r\nContent-Length: " + length + "\r\n\r\n")));
+
+    // an upload larger than the request budget goes through to the form parser
+    std::string content(ONEBIOT_HTTP_REQUEST_SIZE * 2, 'u');
+    std::string body = "------onebiot\r\nContent-Disposition: form-data; name=\"file\"; filename=\"a.bin\"\r\n"
+        "Content-Type: application/octet-stream\r\n\r\n" + content + "\r\n------onebiot--\r\n";
+    std::string response = exchange("POST /upload HTTP/1.1\r\nContent-Type: multipart/form-data; boundary=----onebiot\r\n"
+        "Content-Length: " + std::string(String(body.size()).c_str()) + "\r\n\r\n" + body);
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK_EQUAL(content.size(), uploaded);
+}
+
+// the same load for either backend: a stalled client and ONEBIOT_HTTP_CONNECTIONS - 1
+// clients sending /ping, prints the line of the backend and hands back its p99
+static void load(ESP8266WebServer &target, const char *backend, long *p99) {
+    // a client which never finishes its head
+    int stalled = connectServer(target);
+    const char *partial = "GET /ping HTTP/1.1\r\n";
+    CHECK_EQUAL(strlen(partial), write(stalled, partial, strlen(partial)));
+
+    const int clients = ONEBIOT_HTTP_CONNECTIONS - 1;
+    const int requests = 100;
+    std::vector<long> latencies[clients];
+    std::atomic<int> errors(0);
+    std::vector<std::thread> threads;
+    for (int client = 0; client < clients; client++) {
+        threads.emplace_back([&, client]() {
+            for (int i = 0; i < requests; i++) {
+                auto started = std::chrono::steady_clock::now();
+                std::string response = exchange("GET /ping HTTP/1.1\r\nHost: device\r\n\r\n", target);
+                latencies[client].push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count());
+                errors += httpStatus(response) != 200;
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    std::vector<long> all;
+    for (int client = 0; client < clients; client++) {
+        all.insert(all.end(), latencies[client].begin(), latencies[client].end());
+    }
+    std::sort(all.begin(), all.end());
+    *p99 = all[all.size() * 99 / 100];
+    printf("{\"test\":\"http_load\",\"backend\":\"%s\",\"clients\":%d,\"requests\":%u,\"errors\":%d,\"p50_us\":%ld,\"p99_us\":%ld}\n",
+        backend, clients, (unsigned) all.size(), errors.load(), all[all.size() / 2], *p99);
+    CHECK_EQUAL(0, errors.load());
+
+    // the stalled client is served once its head is complete, the core server has
+    // given up on it after HTTP_MAX_DATA_WAIT by then
+    CHECK_EQUAL(2, write(stalled, "\r\n", 2));
+    std::string response = httpRead(stalled, 2000);
+    if (&target == &server) {
+        CHECK_EQUAL(200, httpStatus(response));
+    }
+    close(stalled);
+}
+
+static void testLoad() {
+    long p99;
+    load(server, "ONEBIOTHttpServer", &p99);
+    // a stalled client must not hold up the others
+    CHECK(p99 < 1000 * 1000L);
+
+    // the core server waits up to HTTP_MAX_DATA_WAIT for the stalled client, the requests behind it with it
+    load(plain, "ESP8266WebServer", &p99);
+    CHECK(p99 >= 1000 * 1000L);
+}
+
+int main() {
+    server.on("/ping", HTTP_GET, []() {
+        server.send(200, "text/plain", "pong");
+    });
+    server.on("/upload", HTTP_POST, []() {
+        server.send(200, "text/plain", "done");
+    }, []() {
+        HTTPUpload &upload = server.upload();
+        if (upload.status == UPLOAD_FILE_WRITE) {
+            uploaded += upload.currentSize;
+        }
+    });
+    server.begin();
+    plain.on("/ping", HTTP_GET, []() {
+        plain.send(200, "text/plain", "pong");
+    });
+    plain.begin();
+
+    // one loop per server, the blocking core server must not stall the adapter
+    std::thread loop([]() {
+        while (serving) {
+            server.handleClient();
+            usleep(100);
+        }
+    });
+    std::thread plainLoop([]() {
+        while (serving) {
+            plain.handleClient();
+            usleep(100);
+        }
+    });
+
+    testConnectionClose();
+    testLimits();
+    testLoad();
+
+    serving = false;
+    loop.join();
+    plainLoop.join();
+    CHECK_DONE();
+}
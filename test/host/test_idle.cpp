@@ -0,0 +1,123 @@
+#include <Arduino.h>
+#include <FS.h>
+#include "check.h"
+#include "ONEBIOT.h"
+
+// ONEBIOTIdle on the frozen host clock: the growing sleeps, what ends them, and
+// loop_latency of ONEBIOTStats, which leaves the sleeps out but not the sketch's work
+
+// the newest sample of the history
+static uint32_t lastLatency(ONEBIOTStats &stats) {
+    ONEBIOTStatsSample sample;
+    stats.rewind(sample);
+    for (size_t i = 0; stats.next(i, sample); i++) {
+    }
+    return sample.loop_latency;
+}
+
+// sleeps of one idle pass after the other, the clock only moves in them
+static void testGovernor() {
+    ONEBIOTIdle idle;
+    idle.setMode(ONEBIOT_IDLE_MODEM);
+    CHECK_EQUAL(WIFI_MODEM_SLEEP, WiFi.getSleepMode());
+
+    const unsigned long sleeps[] = {2, 4, 8, 16, 32, 64, 100, 100};
+    for (unsigned long expected : sleeps) {
+        unsigned long before = millis();
+        idle.loop();
+        CHECK_EQUAL(expected, millis() - before);
+    }
+
+    // a busy pass does not sleep and the next idle one starts short again
+    unsigned long before = millis();
+    idle.activity();
+    idle.loop();
+    CHECK_EQUAL(before, millis());
+    idle.loop();
+    CHECK_EQUAL(2, millis() - before);
+
+    // the nearest deadline ends the sleep early
+    idle.deadline(50);
+    idle.deadline(3);
+    before = millis();
+    idle.loop();
+    CHECK_EQUAL(3, millis() - before);
+    // due right away, the pass settles the wake reason without sleeping
+    idle.deadline(0);
+    idle.loop();
+
+    ONEBIOTIdleCounters counters;
+    idle.getCounters(counters);
+    CHECK_EQUAL(12, counters.passes);
+    CHECK_EQUAL(10, counters.sleeps);
+    CHECK_EQUAL(2 + 4 + 8 + 16 + 32 + 64 + 100 + 100 + 2 + 3, counters.slept);
+    CHECK_EQUAL(8, counters.wake_latency);
+    CHECK_EQUAL(1, counters.wake_deadline);
+    // the busy pass came right after a sleep, as if a request had been waiting
+    CHECK_EQUAL(1, counters.wake_network);
+    CHECK_EQUAL(100, idle.getIdleRatio());
+
+    idle.setMode(ONEBIOT_IDLE_OFF);
+    before = millis();
+    idle.loop();
+    CHECK_EQUAL(before, millis());
+}
+
+static void testStats() {
+    ONEBIOTStats stats;
+    stats.setInterval(0);
+    stats.sample();
+
+    stats.loop();
+    hostClockAdvance(3000);
+    stats.loop();
+    hostClockAdvance(50000);
+    stats.excludeSleep(50000);
+    hostClockAdvance(1000);
+    stats.loop();
+    stats.sample();
+    CHECK_EQUAL(3000, lastLatency(stats));
+
+    // a sleep alone adds nothing
+    hostClockAdvance(80000);
+    stats.excludeSleep(80000);
+    stats.loop();
+    stats.sample();
+    CHECK_EQUAL(0, lastLatency(stats));
+}
+
+// The app sleeps longer and longer while nothing happens, up to the latency bound.
+// The sketch works 3 ms around every pass, that is all loop_latency may show.
+static void testApp() {
+    FS memory;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", memory);
+    ONEBIOTApp app(config, memory);
+    app.setStatsInterval(0);
+    app.getIdle().setMode(ONEBIOT_IDLE_MODEM);
+    app.getStats().sample();
+
+    unsigned long started = millis();
+    for (int i = 0; i < 20; i++) {
+        app.loop();
+        hostClockAdvance(3000);
+    }
+    app.getStats().sample();
+
+    ONEBIOTIdleCounters counters;
+    app.getIdle().getCounters(counters);
+    printf("{\"test\":\"idle_app\",\"passes\":%u,\"slept_ms\":%u,\"elapsed_ms\":%lu,\"idle_ratio\":%u,\"loop_latency_us\":%u}\n",
+        counters.passes, counters.slept, millis() - started, app.getIdle().getIdleRatio(), lastLatency(app.getStats()));
+    CHECK(counters.slept >= ONEBIOT_IDLE_LATENCY_BOUND);
+    CHECK_EQUAL(3000, lastLatency(app.getStats()));
+}
+
+int main() {
+    hostClockFreeze();
+    // a latency is only taken once loop() has seen a non-zero micros()
+    hostClockAdvance(1000);
+    testGovernor();
+    testStats();
+    testApp();
+    CHECK_DONE();
+}
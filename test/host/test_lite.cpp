@@ -0,0 +1,96 @@
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "check.h"
+#include "ONEBIOTLite.h"
+
+// ONEBIOTLiteApp: only the selected subsystems take memory and start, built with
+// -DLITE_CALL_UNSELECTED this file has to fail to compile (test_lite_unselected)
+
+static int wifiBegins = 0;
+static int wifiFailures = 0;
+static int apBegins = 0;
+
+void onWiFiBegin() {
+    wifiBegins++;
+}
+
+void onWiFiFailed(String) {
+    wifiFailures++;
+}
+
+void onAPBegin() {
+    apBegins++;
+}
+
+typedef ONEBIOTLiteApp<ONEBIOT_SUBSYSTEMS_SENSOR> SensorApp;
+typedef ONEBIOTLiteApp<ONEBIOT_SUBSYSTEM_AP> APApp;
+typedef ONEBIOTLiteApp<ONEBIOT_SUBSYSTEM_WIFI | ONEBIOT_SUBSYSTEM_AP> FallbackApp;
+typedef ONEBIOTLiteApp<ONEBIOT_SUBSYSTEMS_ALL> FullApp;
+
+// the stats history is the largest member, it is only there when STATS is selected
+static_assert(sizeof(SensorApp) < sizeof(ONEBIOTStats), "SENSOR carries the stats history");
+static_assert(sizeof(APApp) == sizeof(SensorApp), "AP-only carries more than the config and the started bits");
+static_assert(sizeof(FullApp) > sizeof(ONEBIOTStats), "ALL lacks the stats history");
+
+static void testSensor(ONEBIOTConfig &config) {
+    SensorApp app(config);
+
+    // no AP to fall back to, the failed station is all there is
+    config.setWiFiEstablish(true);
+    config.setWiFiSsid("home");
+    app.start(false);
+    CHECK(!app.isStarted(ONEBIOT_SUBSYSTEM_WIFI));
+    CHECK_EQUAL(1, wifiFailures);
+    CHECK_EQUAL(0, apBegins);
+
+    WiFi.hostBeginStatus = WL_CONNECTED;
+    CHECK(app.startWiFi());
+    CHECK(app.isStarted(ONEBIOT_SUBSYSTEM_WIFI));
+    CHECK(!app.isStarted(ONEBIOT_SUBSYSTEM_AP));
+    CHECK(WiFi.SSID() == "home");
+
+    // the loop reconnects a station which dropped
+    WiFi.hostStatus = WL_DISCONNECTED;
+    app.loop();
+    CHECK_EQUAL(WL_CONNECTED, WiFi.status());
+    CHECK_EQUAL(2, wifiBegins);
+    CHECK(app.updateTime() > 0);
+}
+
+static void testAP(ONEBIOTConfig &config) {
+    APApp app(config);
+    config.setApEstablish(true);
+    app.start(false);
+    CHECK(app.isStarted(ONEBIOT_SUBSYSTEM_AP));
+    CHECK(!app.isStarted(ONEBIOT_SUBSYSTEM_WIFI));
+    CHECK(WiFi.softAPSSID() == config.getApSsid());
+    CHECK_EQUAL(1, apBegins);
+
+#ifdef LITE_CALL_UNSELECTED
+    app.startWiFi();
+#endif
+}
+
+static void testFallback(ONEBIOTConfig &config) {
+    FallbackApp app(config);
+    WiFi.hostBeginStatus = WL_DISCONNECTED;
+    app.start(false);
+    CHECK(!app.isStarted(ONEBIOT_SUBSYSTEM_WIFI));
+    CHECK(app.isStarted(ONEBIOT_SUBSYSTEM_AP));
+    CHECK_EQUAL(2, apBegins);
+}
+
+int main() {
+    FS memory;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", memory);
+
+    // object sizes of this host, a 32 bit target halves the pointers
+    printf("{\"test\":\"lite_sizes\",\"sensor\":%u,\"ap\":%u,\"all\":%u,\"stats\":%u}\n",
+        (unsigned) sizeof(SensorApp), (unsigned) sizeof(APApp), (unsigned) sizeof(FullApp), (unsigned) sizeof(ONEBIOTStats));
+
+    testSensor(config);
+    testAP(config);
+    testFallback(config);
+    CHECK_DONE();
+}
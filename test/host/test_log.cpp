@@ -0,0 +1,173 @@
+#include <Arduino.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "utils/log/ONEBIOTLog.h"
+
+// ONEBIOTLog ring: eviction of the oldest entries, the since= cursor of /cmd/log,
+// the records one drain pass writes and the cost of a log call on this host
+
+class LinePrint : public Print {
+    public:
+        std::vector<std::string> lines;
+
+        size_t write(uint8_t data) override {
+            if (data == '\n') {
+                lines.push_back(_line);
+                _line.clear();
+            } else if (data != '\r') {
+                _line += (char) data;
+            }
+            return 1;
+        }
+    private:
+        std::string _line;
+};
+
+class NullPrint : public Print {
+    public:
+        size_t write(uint8_t) override {
+            return 1;
+        }
+        size_t write(const uint8_t *, size_t size) override {
+            return size;
+        }
+};
+
+// [size][sequence][timestamp][format pointer][level][category] and one integer argument
+static const size_t INTEGER_ENTRY_SIZE = 1 + 4 + 4 + sizeof(PGM_P) + 2 + 5;
+static const size_t RETAINED = ONEBIOT_LOG_BUFFER_SIZE / INTEGER_ENTRY_SIZE;
+
+static uint32_t sequenceOf(const std::string &line) {
+    return strtoul(line.c_str(), nullptr, 10);
+}
+
+static void testEviction() {
+    for (int i = 1; i <= 100; i++) {
+        ONEBIOT_LOG_INFO(APP, "record %d", i);
+    }
+    CHECK_EQUAL(100, ONEBIOTLog::getSequence());
+    // without an output nothing counts as dropped, the ring just keeps the newest
+    CHECK_EQUAL(0, ONEBIOTLog::getDropped());
+
+    LinePrint output;
+    CHECK_EQUAL(100, ONEBIOTLog::printSince(0, output));
+    CHECK_EQUAL(RETAINED, output.lines.size());
+    CHECK_EQUAL(100 - RETAINED + 1, sequenceOf(output.lines.front()));
+    CHECK(output.lines.back() == "100 0 I [APP] record 100");
+    for (size_t i = 1; i < output.lines.size(); i++) {
+        CHECK_EQUAL(sequenceOf(output.lines[i - 1]) + 1, sequenceOf(output.lines[i]));
+    }
+}
+
+static void testSince() {
+    // only the records after the cursor, the cursor of the last one comes back
+    LinePrint output;
+    CHECK_EQUAL(100, ONEBIOTLog::printSince(95, output));
+    CHECK_EQUAL(5, output.lines.size());
+    CHECK_EQUAL(96, sequenceOf(output.lines.front()));
+
+    // nothing new keeps the cursor where it was
+    output.lines.clear();
+    CHECK_EQUAL(100, ONEBIOTLog::printSince(100, output));
+    CHECK_EQUAL(0, output.lines.size());
+
+    // a cursor already evicted gets everything that is left
+    output.lines.clear();
+    CHECK_EQUAL(100, ONEBIOTLog::printSince(10, output));
+    CHECK_EQUAL(RETAINED, output.lines.size());
+
+    // a cursor from before a restart is ahead of the sequence, nothing matches
+    output.lines.clear();
+    CHECK_EQUAL(500, ONEBIOTLog::printSince(500, output));
+    CHECK_EQUAL(0, output.lines.size());
+}
+
+static void testDrain() {
+    LinePrint output;
+    ONEBIOTLog::setOutput(&output);
+    // the records from before the output was set are written too
+    CHECK(!ONEBIOTLog::isDrained());
+    ONEBIOTLog::flush();
+    CHECK_EQUAL(RETAINED, output.lines.size());
+    CHECK(ONEBIOTLog::isDrained());
+
+    // one loop() pass writes ONEBIOT_LOG_DRAIN_RECORDS lines
+    output.lines.clear();
+    for (int i = 0; i < 5; i++) {
+        ONEBIOT_LOG_WARN(WFC, "rssi %d", -60 - i);
+    }
+    ONEBIOTLog::loop();
+    CHECK_EQUAL(ONEBIOT_LOG_DRAIN_RECORDS, output.lines.size());
+    CHECK(output.lines.front() == "101 0 W [WFC] rssi -60");
+    ONEBIOTLog::loop();
+    ONEBIOTLog::loop();
+    CHECK_EQUAL(5, output.lines.size());
+    CHECK(ONEBIOTLog::isDrained());
+
+    // records evicted before the drain reached them are counted
+    output.lines.clear();
+    for (size_t i = 0; i < RETAINED + 8; i++) {
+        ONEBIOT_LOG_INFO(APP, "record %d", (int) i);
+    }
+    CHECK_EQUAL(8, ONEBIOTLog::getDropped());
+    ONEBIOTLog::flush();
+    CHECK_EQUAL(RETAINED, output.lines.size());
+    CHECK_EQUAL(ONEBIOTLog::getSequence(), sequenceOf(output.lines.back()));
+    ONEBIOTLog::setOutput(nullptr);
+}
+
+static void testFormat() {
+    LinePrint output;
+    uint32_t since = ONEBIOTLog::getSequence();
+    String name = "kitchen";
+    ONEBIOT_LOG_ERROR(CNF, "%s %5u %x %c %.1f %lld %s%%", name, 42u, 255, 'z', 2.5, -1234567890123LL, F("flash"));
+    ONEBIOT_LOG_INFO(WFC, "IP address: %s missing %d", IPAddress(192, 168, 4, 1));
+    // a string longer than a record is cut to what fits
+    ONEBIOT_LOG_INFO(APP, "%s", std::string(200, 'x').c_str());
+    ONEBIOTLog::printSince(since, output);
+    CHECK_EQUAL(3, output.lines.size());
+    CHECK(output.lines[0].substr(output.lines[0].find('[')) == "[CNF] kitchen    42 ff z 2.5 -1234567890123 flash%");
+    CHECK(output.lines[1].substr(output.lines[1].find('[')) == "[WFC] IP address: 192.168.4.1 missing <?>");
+    CHECK_EQUAL(ONEBIOT_LOG_RECORD_SIZE - 2, output.lines[2].length() - output.lines[2].find("xx"));
+}
+
+// Rates of this host: a log call with two integers, one with a string, and the
+// formatting of the whole ring by /cmd/log, as the log_benchmark sketch does on the ESP
+static void benchmark() {
+    const int calls = 1000000;
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++) {
+        ONEBIOT_LOG_INFO(WFC, "Connecting error: #%d rssi %d", i, -70);
+    }
+    double integerSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    String ssid = "home-network";
+    started = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++) {
+        ONEBIOT_LOG_INFO(WFC, "Connecting to %s", ssid);
+    }
+    double stringSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    const int passes = 10000;
+    NullPrint output;
+    started = std::chrono::steady_clock::now();
+    for (int i = 0; i < passes; i++) {
+        ONEBIOTLog::printSince(0, output);
+    }
+    double formatSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    printf("{\"test\":\"log_benchmark\",\"integer_ns\":%.1f,\"string_ns\":%.1f,\"format_ring_us\":%.1f}\n",
+        integerSeconds * 1e9 / calls, stringSeconds * 1e9 / calls, formatSeconds * 1e6 / passes);
+}
+
+int main() {
+    hostClockFreeze();
+    testEviction();
+    testSince();
+    testDrain();
+    testFormat();
+    benchmark();
+    CHECK_DONE();
+}
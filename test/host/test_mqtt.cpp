@@ -0,0 +1,168 @@
+#include <Arduino.h>
+#include <Client.h>
+#include <FS.h>
+#include <string>
+#include "check.h"
+#include "utils/mqtt/ONEBIOTMqtt.h"
+
+// MQTT publisher against a scripted broker: split packets, and what survives a lost connection
+
+class BrokerClient : public Client {
+    public:
+        std::string input;
+        std::string output;
+        bool up = false;
+        int connects = 0;
+
+        int connect(IPAddress, uint16_t) override { return connect("", 0); }
+        int connect(const char *, uint16_t) override { up = true; connects++; return 1; }
+        size_t write(uint8_t data) override { return write(&data, 1); }
+        size_t write(const uint8_t *buffer, size_t size) override { output.append((const char *) buffer, size); return size; }
+        int available() override { return input.size(); }
+        int read() override {
+            if (input.empty()) {
+                return -1;
+            }
+            int value = (uint8_t) input[0];
+            input.erase(0, 1);
+            return value;
+        }
+        int read(uint8_t *buffer, size_t size) override {
+            size_t length = 0;
+            while (length < size && !input.empty()) {
+                buffer[length++] = read();
+            }
+            return length;
+        }
+        int peek() override { return input.empty() ? -1 : (uint8_t) input[0]; }
+        void flush() override {}
+        void stop() override { up = false; input.clear(); }
+        uint8_t connected() override { return up; }
+        operator bool() override { return up; }
+
+        // topics of the PUBLISH packets written since the last call
+        std::string published() {
+            std::string topics;
+            size_t position = 0;
+            while (position < output.size()) {
+                uint8_t type = (uint8_t) output[position] >> 4;
+                size_t remaining = 0;
+                size_t header = 1;
+                int shift = 0;
+                uint8_t value;
+                do {
+                    value = output[position + header++];
+                    remaining |= (value & 0x7f) << shift;
+                    shift += 7;
+                } while (value & 0x80);
+                if (type == 3) {
+                    size_t topicLength = ((uint8_t) output[position + header] << 8) | (uint8_t) output[position + header + 1];
+                    topics += output.substr(position + header + 2, topicLength) + ";";
+                }
+                position += header + remaining;
+            }
+            output.clear();
+            return topics;
+        }
+};
+
+static const std::string CONNACK("\x20\x02\x00\x00", 4);
+
+static std::string puback(uint16_t packetId) {
+    return std::string("\x40\x02", 2) + (char) (packetId >> 8) + (char) (packetId & 0xff);
+}
+
+static void testSplitPackets(BrokerClient &broker, ONEBIOTMqtt &mqtt) {
+    mqtt.loop(true);
+    CHECK_EQUAL(1, broker.connects);
+
+    // the CONNACK trickles in, nothing is taken for a packet before all of it is there
+    for (size_t i = 0; i < CONNACK.size(); i++) {
+        CHECK(!mqtt.isConnected());
+        broker.input += CONNACK[i];
+        mqtt.loop(true);
+        CHECK(broker.up);
+    }
+    CHECK(mqtt.isConnected());
+    broker.output.clear();
+
+    CHECK(mqtt.publish("a", "1"));
+    mqtt.loop(true);
+    CHECK(broker.published() == "a;");
+
+    std::string ack = puback(1);
+    broker.input = ack.substr(0, 3);
+    mqtt.loop(true);
+    CHECK_EQUAL(1, mqtt.getQueueDepth());
+    broker.input += ack.substr(3);
+    mqtt.loop(true);
+    CHECK_EQUAL(0, mqtt.getQueueDepth());
+    CHECK(mqtt.isConnected());
+}
+
+static void testLostConnection(BrokerClient &broker, ONEBIOTMqtt &mqtt, FS &memory) {
+    // one message waits for its PUBACK, one for the flush, both go to flash with the connection
+    CHECK(mqtt.publish("b", "2"));
+    mqtt.loop(true);
+    CHECK(mqtt.publish("c", "3"));
+    mqtt.setFlushWindow(60000);
+    mqtt.loop(true);
+    CHECK(broker.published() == "b;");
+
+    broker.up = false;
+    mqtt.loop(true);
+    CHECK(!mqtt.isConnected());
+    CHECK_EQUAL(0, mqtt.getQueueDepth());
+    CHECK_EQUAL(2 * (3 + 2), mqtt.getSpoolSize());
+    CHECK(memory.exists("/mqtt.queue"));
+
+    // after reconnecting the file goes first, in order
+    CHECK(mqtt.publish("d", "4"));
+    mqtt.setFlushWindow(0);
+    hostClockAdvance(5000 * 1000UL);
+    mqtt.loop(true);
+    CHECK_EQUAL(2, broker.connects);
+    broker.input = CONNACK;
+    mqtt.loop(true);
+    mqtt.loop(true);
+    CHECK(broker.published() == "b;c;d;");
+    broker.input = puback(5);
+    mqtt.loop(true);
+    CHECK_EQUAL(0, mqtt.getSpoolSize());
+    CHECK_EQUAL(0, mqtt.getQueueDepth());
+    CHECK(!memory.exists("/mqtt.queue"));
+}
+
+static void testPersist(BrokerClient &broker, ONEBIOTMqtt &mqtt, FS &memory) {
+    CHECK(mqtt.publish("e", "5"));
+    mqtt.loop(true);
+    CHECK(broker.published() == "e;");
+
+    // what a restart would lose is on flash before it
+    mqtt.persist();
+    CHECK(!broker.up);
+    CHECK_EQUAL(0, mqtt.getQueueDepth());
+    CHECK(memory.hostRead("/mqtt.queue") == std::string("\x01\x01\x00" "e5", 5));
+
+    // a new start reads the file back
+    BrokerClient restarted;
+    ONEBIOTMqtt next(restarted, memory);
+    next.begin("broker", 1883, "test");
+    next.loop(true);
+    CHECK_EQUAL(5, next.getSpoolSize());
+}
+
+int main() {
+    hostClockFreeze();
+
+    FS memory;
+    BrokerClient broker;
+    ONEBIOTMqtt mqtt(broker, memory);
+    mqtt.begin("broker", 1883, "test");
+    mqtt.setFlushWindow(0);
+
+    testSplitPackets(broker, mqtt);
+    testLostConnection(broker, mqtt, memory);
+    testPersist(broker, mqtt, memory);
+    CHECK_DONE();
+}
@@ -0,0 +1,139 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <chrono>
+#include "check.h"
+#include "host_server.h"
+#include "ONEBIOT.h"
+#include "utils/request/ONEBIOTCmdRequestHandler.h"
+
+// MessagePack of /cmd: Accept negotiates the response format, the document is the
+// same as the JSON one, MessagePack bodies are refused since the core server cuts
+// them at the first zero byte. The bytes and the serialization time of both formats
+// are printed per route as JSON lines.
+
+static std::string request(HostServer &server, const std::string &method, const std::string &target,
+        const std::string &accept, const std::string &contentType = "", const std::string &body = "") {
+    return server.request(method + " " + target + " HTTP/1.1\r\nHost: onebiot.local\r\n" + std::string(HOST_AUTHORIZATION)
+        + (accept.empty() ? "" : "Accept: " + accept + "\r\n")
+        + (contentType.empty() ? "" : "Content-Type: " + contentType + "\r\nContent-Length: " + std::to_string(body.length()) + "\r\n")
+        + "\r\n" + body);
+}
+
+static bool decodeMsgPack(const std::string &response, DynamicJsonDocument &document) {
+    std::string body = httpBody(response);
+    CHECK(httpHeader(response, "Content-Type") == "application/msgpack");
+    CHECK(httpHeader(response, "Vary") == "Accept");
+    CHECK_EQUAL(body.length(), strtoul(httpHeader(response, "Content-Length").c_str(), nullptr, 10));
+    return !deserializeMsgPack(document, body.data(), body.length());
+}
+
+static std::string asJson(const JsonDocument &document) {
+    String json;
+    serializeJson(document, json);
+    return json.c_str();
+}
+
+// the same document either way, the routes are static between the two requests
+static void testNegotiation(HostServer &server) {
+    const char *routes[] = {"/cmd/stats/chip", "/cmd/wifi", "/cmd/ap", "/cmd/dns", "/cmd/option/client_name"};
+    for (const char *route : routes) {
+        std::string json = request(server, "GET", route, "");
+        CHECK_EQUAL(200, httpStatus(json));
+        CHECK(httpHeader(json, "Content-Type") == "application/json");
+
+        std::string packed = request(server, "GET", route, "application/msgpack");
+        CHECK_EQUAL(200, httpStatus(packed));
+        DynamicJsonDocument document(2048);
+        CHECK(decodeMsgPack(packed, document));
+        CHECK(!document["success"].isNull());
+        CHECK(asJson(document) == httpBody(json));
+        // not taken from or put into the JSON cache
+        CHECK(httpHeader(packed, "ETag").empty());
+    }
+
+    // the legacy type and a list of types work as well
+    DynamicJsonDocument document(2048);
+    CHECK(decodeMsgPack(request(server, "GET", "/cmd/dns", "application/x-msgpack"), document));
+    CHECK(decodeMsgPack(request(server, "GET", "/cmd/dns", "application/json;q=0.5, application/msgpack"), document));
+    CHECK(document["data"]["name"] == "kitchen");
+}
+
+// JSON or form bodies in, MessagePack out
+static void testRoundTrip(HostServer &server, ONEBIOTConfig &config) {
+    std::string response = request(server, "POST", "/cmd/dns", "application/msgpack",
+        "application/x-www-form-urlencoded", "dns_name=garden&dns_establish=1");
+    CHECK_EQUAL(200, httpStatus(response));
+    DynamicJsonDocument document(2048);
+    CHECK(decodeMsgPack(response, document));
+    CHECK(document["success"].as<bool>());
+    CHECK(config.getDnsName() == "garden");
+    CHECK(config.getConfig().dns_establish);
+
+    response = request(server, "PATCH", "/cmd/config", "application/msgpack",
+        "application/json", "{\"client_name\":\"cellar\",\"wifi_establish\":true}");
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(decodeMsgPack(response, document));
+    CHECK(document["success"].as<bool>());
+    CHECK(document["need_restart"].as<bool>());
+    CHECK(document["changes"]["client_name"]["to"] == "cellar");
+    CHECK(config.getClientName() == "cellar");
+
+    // the value 0 is a zero byte, the core would hand over only the bytes before it
+    const char packed[] = "\x82\xa8" "dns_name" "\xa5" "attic" "\xad" "dns_establish" "\x00";
+    std::string body(packed, sizeof(packed) - 1);
+    response = request(server, "POST", "/cmd/dns", "", "application/msgpack", body);
+    CHECK_EQUAL(415, httpStatus(response));
+    CHECK(httpBody(response).find("JSON") != std::string::npos);
+    response = request(server, "PATCH", "/cmd/config", "application/msgpack", "application/msgpack", body);
+    CHECK_EQUAL(415, httpStatus(response));
+    CHECK(config.getDnsName() == "garden");
+}
+
+// Sizes of this build's documents, the times are of the ArduinoJson the test is built with
+static void benchmark(HostServer &server) {
+    const char *routes[] = {"/cmd/stats", "/cmd/stats/esp", "/cmd/stats/chip", "/cmd/stats/spiffs", "/cmd/wifi", "/cmd/ap", "/cmd/dns"};
+    const int iterations = 2000;
+    for (const char *route : routes) {
+        DynamicJsonDocument document(4096);
+        CHECK(decodeMsgPack(request(server, "GET", route, "application/msgpack"), document));
+
+        String json;
+        auto started = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            json = "";
+            serializeJson(document, json);
+        }
+        double jsonSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        String packed;
+        started = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            packed = "";
+            serializeMsgPack(document, packed);
+        }
+        double packedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        printf("{\"test\":\"msgpack_benchmark\",\"route\":\"%s\",\"json_bytes\":%u,\"msgpack_bytes\":%u,\"json_us\":%.2f,\"msgpack_us\":%.2f}\n",
+            route, (unsigned) json.length(), (unsigned) packed.length(), jsonSeconds * 1e6 / iterations, packedSeconds * 1e6 / iterations);
+        CHECK(packed.length() < json.length());
+    }
+}
+
+int main() {
+    hostClockFreeze();
+    FS memory;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", memory);
+    config.setCredentialsUser("admin");
+    config.setCredentialsPassword("secret");
+    config.setDnsName("kitchen");
+    ONEBIOTApp app(config, memory);
+    ONEBIOTCmdRequestHandler handler(app);
+    HostServer server;
+    server.addHandler(&handler);
+
+    testNegotiation(server);
+    testRoundTrip(server, config);
+    benchmark(server);
+    CHECK_DONE();
+}
@@ -0,0 +1,108 @@
+#include <Arduino.h>
+#include <Updater.h>
+#include "check.h"
+#include "host_server.h"
+#include "ONEBIOT.h"
+#include "utils/request/ONEBIOTCmdRequestHandler.h"
+
+// POST /cmd/ota through the upload callbacks of the core into the Updater
+
+static size_t progressCalls = 0;
+static size_t progressWritten = 0;
+
+void onOTAProgress(size_t written) {
+    progressCalls++;
+    progressWritten = written;
+}
+
+static std::vector<uint8_t> image(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (uint8_t) (i * 31 + (i >> 8));
+    }
+    return data;
+}
+
+static std::string upload(HostServer &server, const std::vector<uint8_t> &firmware, const std::string &md5, bool authorized = true, IPAddress remote = IPAddress(192, 168, 4, 2)) {
+    std::string target = "/cmd/ota" + (md5.empty() ? std::string() : "?md5=" + md5);
+    return server.request(multipartRequest(target, "firmware.bin", std::string(firmware.begin(), firmware.end()), authorized), remote);
+}
+
+static void testDigest() {
+    const char *abc = "abc";
+    CHECK(UpdaterClass::hostMD5(std::vector<uint8_t>(abc, abc + 3)) == "900150983cd24fb0d6963f7d28e17f72");
+}
+
+static void testVerifiedImage(HostServer &server) {
+    std::vector<uint8_t> firmware = image(10000);
+    int restarts = hostRestartCount;
+    progressCalls = 0;
+
+    std::string response = upload(server, firmware, UpdaterClass::hostMD5(firmware).c_str());
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpBody(response).find("\"success\":true") != std::string::npos);
+    CHECK(httpBody(response).find("\"written\":10000") != std::string::npos);
+    CHECK(Update.hostImage() == firmware);
+    CHECK(Update.isFinished());
+    // the core hands the file over in HTTP_UPLOAD_BUFLEN blocks
+    CHECK_EQUAL(5, progressCalls);
+    CHECK_EQUAL(10000, progressWritten);
+    CHECK_EQUAL(restarts + 1, hostRestartCount);
+}
+
+static void testDigestMismatch(HostServer &server) {
+    std::vector<uint8_t> firmware = image(5000);
+    int restarts = hostRestartCount;
+
+    std::string response = upload(server, firmware, "00000000000000000000000000000000");
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpBody(response).find("\"success\":false") != std::string::npos);
+    CHECK(httpBody(response).find("MD5 Check Failed") != std::string::npos);
+    CHECK(!Update.isFinished());
+    CHECK_EQUAL(restarts, hostRestartCount);
+}
+
+static void testMissingDigest(HostServer &server) {
+    uint32_t begins = Update.hostBegins;
+    std::string response = upload(server, image(100), "");
+    CHECK(httpBody(response).find("Missing MD5 digest") != std::string::npos);
+    CHECK_EQUAL(begins, Update.hostBegins);
+}
+
+static void testFailedWrite(HostServer &server) {
+    std::vector<uint8_t> firmware = image(8000);
+    Update.hostFailWriteAt = 3000;
+    std::string response = upload(server, firmware, UpdaterClass::hostMD5(firmware).c_str());
+    Update.hostFailWriteAt = 0;
+    CHECK(httpBody(response).find("Flash Write Failed") != std::string::npos);
+    CHECK(!Update.isFinished());
+}
+
+static void testUnauthorized(HostServer &server) {
+    std::vector<uint8_t> firmware = image(100);
+    uint32_t begins = Update.hostBegins;
+    std::string response = upload(server, firmware, UpdaterClass::hostMD5(firmware).c_str(), false, IPAddress(192, 168, 4, 9));
+    CHECK_EQUAL(401, httpStatus(response));
+    // nothing touches the flash before the credentials are checked
+    CHECK_EQUAL(begins, Update.hostBegins);
+}
+
+int main() {
+    FS memory;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", memory);
+    config.setCredentialsUser("admin");
+    config.setCredentialsPassword("secret");
+    ONEBIOTApp app(config, memory);
+    ONEBIOTCmdRequestHandler handler(app);
+    HostServer server;
+    server.addHandler(&handler);
+
+    testDigest();
+    testVerifiedImage(server);
+    testDigestMismatch(server);
+    testMissingDigest(server);
+    testFailedWrite(server);
+    testUnauthorized(server);
+    CHECK_DONE();
+}
@@ -0,0 +1,104 @@
+#include <Arduino.h>
+#include <FS.h>
+#include "check.h"
+#include "host_server.h"
+#include "utils/router/ONEBIOTRouter.h"
+
+// static routes of ONEBIOTRouter: one open() per file, the ".gz" fallback,
+// directory routes serving everything below them and a route refused by a full router
+
+class ApiHandler : public RequestHandler {
+    public:
+        bool handle(ESP8266WebServer& server, HTTPMethod, String) override {
+            server.send(200, "text/plain", "api");
+            return true;
+        }
+};
+
+static void writeFile(FS &fs, const char *path, size_t size) {
+    File file = fs.open(path, "w");
+    for (size_t i = 0; i < size; i++) {
+        file.write('x');
+    }
+    file.close();
+}
+
+static std::string get(HostServer &server, const std::string &target) {
+    return server.request("GET " + target + " HTTP/1.1\r\nHost: onebiot.local\r\n\r\n");
+}
+
+int main() {
+    FS memory;
+    writeFile(memory, "/app.js", 10);
+    writeFile(memory, "/style.css.gz", 20);
+    writeFile(memory, "/hello.txt", 30);
+    writeFile(memory, "/www/index.htm", 40);
+    writeFile(memory, "/www/img/logo.svg", 50);
+    writeFile(memory, "/config.json", 60);
+
+    ONEBIOTRouter router;
+    ApiHandler api;
+    CHECK(router.serveStatic("/app.js", memory, "/app.js"));
+    CHECK(router.serveStatic("/style.css", memory, "/style.css"));
+    CHECK(router.serveStatic("/web/", memory, "/www"));
+    CHECK(router.serveStatic("/", memory, "/"));
+    CHECK(router.on("/web/api", ONEBIOT_ROUTE(HTTP_GET), &api));
+    HostServer server;
+    server.addHandler(&router);
+
+    // an exact route opens its file once, exists() is never asked
+    std::string response = get(server, "/app.js");
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpHeader(response, "Content-Type") == "application/javascript");
+    CHECK(httpHeader(response, "Content-Length") == "10");
+    CHECK_EQUAL(1, memory.hostCounters.open - 6);
+    CHECK_EQUAL(0, memory.hostCounters.exists);
+
+    // only the compressed file is there, the type is the one of the uncompressed name
+    response = get(server, "/style.css");
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpHeader(response, "Content-Type") == "text/css");
+    CHECK(httpHeader(response, "Content-Encoding") == "gzip");
+    CHECK(httpHeader(response, "Content-Length") == "20");
+    CHECK_EQUAL(3, memory.hostCounters.open - 6);
+
+    // a directory route maps the rest of the path into its directory
+    response = get(server, "/web/img/logo.svg");
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpHeader(response, "Content-Type") == "image/svg+xml");
+    CHECK(httpHeader(response, "Content-Length") == "50");
+    response = get(server, "/web/");
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpHeader(response, "Content-Length") == "40");
+    CHECK_EQUAL(404, httpStatus(get(server, "/web/missing.txt")));
+    CHECK_EQUAL(404, httpStatus(get(server, "/web/../config.json")));
+
+    // the route of a handler wins over the directory around it
+    response = get(server, "/web/api");
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpBody(response) == "api");
+
+    // the root directory takes whatever no deeper route matches
+    response = get(server, "/hello.txt");
+    CHECK_EQUAL(200, httpStatus(response));
+    CHECK(httpHeader(response, "Content-Length") == "30");
+    CHECK_EQUAL(0, memory.hostCounters.exists);
+
+    // one node left: a route needing two is refused and gives back the one it took
+    static std::string filler;
+    for (int i = router.getNodeCount(); i < ONEBIOT_ROUTER_NODES - 1; i++) {
+        filler += "/n" + std::to_string(i);
+    }
+    CHECK(router.on(filler.c_str(), ONEBIOT_ROUTE(HTTP_GET), &api));
+    CHECK_EQUAL(ONEBIOT_ROUTER_NODES - 1, router.getNodeCount());
+    uint8_t routes = router.getRouteCount();
+    CHECK(!router.serveStatic("/docs/hello.txt", memory, "/hello.txt"));
+    CHECK_EQUAL(ONEBIOT_ROUTER_NODES - 1, router.getNodeCount());
+    CHECK_EQUAL(routes, router.getRouteCount());
+    CHECK_EQUAL(200, httpStatus(get(server, "/hello.txt")));
+    CHECK(router.serveStatic("/notes.txt", memory, "/hello.txt"));
+    CHECK_EQUAL(ONEBIOT_ROUTER_NODES, router.getNodeCount());
+    CHECK_EQUAL(200, httpStatus(get(server, "/notes.txt")));
+    CHECK(httpBody(get(server, filler)) == "api");
+    CHECK_DONE();
+}
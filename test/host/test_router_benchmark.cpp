@@ -0,0 +1,77 @@
+#include <Arduino.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "utils/router/ONEBIOTRouter.h"
+
+// 100 routes dispatched by ONEBIOTRouter against the handler list of the core server,
+// which asks every handler by canHandle() until one accepts, as the router_benchmark
+// sketch does on the ESP. One JSON line is printed per probed uri.
+
+static const int ROUTES = 100;
+static const int ITERATIONS = 100000;
+
+// a handler of one path, as ESP8266WebServer::on() registers them
+class PathHandler : public RequestHandler {
+    public:
+        PathHandler(const char *path) : _path(path) {}
+        bool canHandle(HTTPMethod method, String uri) override {
+            return method == HTTP_GET && uri == _path;
+        }
+        bool handle(ESP8266WebServer&, HTTPMethod, String) override {
+            return true;
+        }
+    private:
+        const char *_path;
+};
+
+int main() {
+    ONEBIOTRouter router;
+    std::vector<PathHandler *> handlers;
+    // patterns are not copied by the router
+    static char patterns[ROUTES][20];
+
+    // ten groups of ten, like the /cmd routes below /cmd/stats
+    for (int i = 0; i < ROUTES; i++) {
+        snprintf(patterns[i], sizeof(patterns[i]), "/api/g%d/r%d", i / 10, i);
+        handlers.push_back(new PathHandler(patterns[i]));
+        CHECK(router.on(patterns[i], ONEBIOT_ROUTE(HTTP_GET), handlers.back()));
+    }
+    CHECK_EQUAL(ROUTES, router.getRouteCount());
+    CHECK_EQUAL(1 + 1 + 10 + ROUTES, router.getNodeCount());
+
+    const char *probes[] = {"/api/g0/r0", "/api/g5/r50", "/api/g9/r99", "/api/g9/missing"};
+    for (const char *probe : probes) {
+        String uri(probe);
+        bool expected = strstr(probe, "missing") == nullptr;
+        int matched = 0;
+        auto started = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; i++) {
+            matched += router.canHandle(HTTP_GET, uri);
+        }
+        double routerSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        CHECK_EQUAL(expected ? ITERATIONS : 0, matched);
+
+        matched = 0;
+        started = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; i++) {
+            for (RequestHandler *handler : handlers) {
+                if (handler->canHandle(HTTP_GET, uri)) {
+                    matched++;
+                    break;
+                }
+            }
+        }
+        double listSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        CHECK_EQUAL(expected ? ITERATIONS : 0, matched);
+
+        printf("{\"test\":\"router_benchmark\",\"uri\":\"%s\",\"routes\":%d,\"router_ns\":%.1f,\"list_ns\":%.1f}\n",
+            probe, ROUTES, routerSeconds * 1e9 / ITERATIONS, listSeconds * 1e9 / ITERATIONS);
+    }
+
+    for (PathHandler *handler : handlers) {
+        delete handler;
+    }
+    CHECK_DONE();
+}
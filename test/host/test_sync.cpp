@@ -0,0 +1,226 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FS.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "utils/sync/ONEBIOTSync.h"
+#include "utils/config/ONEBIOTConfig.h"
+#include "utils/log/ONEBIOTLog.h"
+#include "utils/stats/ONEBIOTStats.h"
+
+// what the ESP32 server task shares with the loop task, driven by host threads
+
+static void testQueue() {
+    const uint32_t items = 200000;
+    ONEBIOTQueue<uint32_t, 8> queue;
+    uint32_t full = 0;
+
+    std::thread producer([&]() {
+        for (uint32_t i = 1; i <= items; i++) {
+            while (!queue.push(i)) {
+                full++;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // every item arrives once and in order
+    uint32_t expected = 1;
+    uint32_t item;
+    while (expected <= items) {
+        if (!queue.pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        CHECK_EQUAL(expected, item);
+        if (item != expected) {
+            break;
+        }
+        expected++;
+    }
+    producer.join();
+    CHECK(!queue.pop(item));
+    CHECK_EQUAL(0, queue.size());
+    printf("queue: %u items, producer found it full %u times\n", (unsigned) items, (unsigned) full);
+}
+
+// SSID and password are always written as a pair, a reader never sees halves of two commits
+static void testCommit(ONEBIOTConfig &config) {
+    const int writers = 4;
+    const int commits = 2000;
+    uint32_t generation = config.getGeneration();
+    std::atomic<bool> writing(true);
+    std::atomic<int> conflicts(0);
+    std::atomic<int> torn(0);
+
+    std::thread reader([&]() {
+        while (writing) {
+            ONEBIOTConfigAppConfig snapshot = config.getConfig();
+            if (snapshot.wifi_ssid != snapshot.wifi_password) {
+                torn++;
+            }
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (int writer = 0; writer < writers; writer++) {
+        threads.emplace_back([&, writer]() {
+            for (int i = 0; i < commits; i++) {
+                String value = String("w") + writer + "-" + i;
+                for (;;) {
+                    ONEBIOTConfigAppConfig staged = config.getConfig();
+                    staged.wifi_ssid = value;
+                    staged.wifi_password = value;
+                    if (config.commit(staged)) {
+                        break;
+                    }
+                    conflicts++;
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    writing = false;
+    reader.join();
+
+    // no commit got lost, a stale copy was always refused
+    CHECK_EQUAL(generation + writers * commits, config.getGeneration());
+    CHECK_EQUAL(0, torn.load());
+    printf("commit: %d commits, %d retried after a conflict\n", writers * commits, conflicts.load());
+}
+
+// a patch applied next to commits of another task either lands whole or reports the conflict
+static void testPatch(ONEBIOTConfig &config) {
+    const int patches = 200;
+    std::atomic<bool> patching(true);
+    int applied = 0;
+    int conflicts = 0;
+
+    std::thread other([&]() {
+        while (patching) {
+            ONEBIOTConfigAppConfig staged = config.getConfig();
+            staged.dns_name = staged.dns_name == "a" ? "b" : "a";
+            config.commit(staged);
+        }
+    });
+
+    for (int i = 0; i < patches; i++) {
+        StaticJsonDocument<128> patch;
+        patch["client_name"] = String("patch-") + i;
+        StaticJsonDocument<256> response;
+        JsonObject changes = response.createNestedObject("changes");
+        bool needRestart;
+        String error;
+        if (config.mergePatch(patch.as<JsonObjectConst>(), changes, needRestart, error)) {
+            applied++;
+            CHECK(changes.containsKey("client_name"));
+        } else {
+            conflicts++;
+            CHECK(error == "Configuration changed meanwhile, try again.");
+            CHECK_EQUAL(0, changes.size());
+        }
+    }
+    patching = false;
+    other.join();
+
+    CHECK_EQUAL(patches, applied + conflicts);
+    CHECK(applied > 0);
+    printf("patch: %d applied, %d refused after a concurrent change\n", applied, conflicts);
+}
+
+// /cmd/stats/history walks a copy while the loop task keeps sampling, the copy always
+// decodes to as many samples as it holds, in time order
+static void testStatsHistory() {
+    ONEBIOTStats stats;
+    std::atomic<bool> sampling(true);
+    std::thread sampler([&]() {
+        while (sampling) {
+            stats.sample();
+        }
+    });
+
+    int broken = 0;
+    int full = 0;
+    while (full < 2000) {
+        ONEBIOTStats copy;
+        stats.snapshot(copy);
+        ONEBIOTStatsSample sample;
+        copy.rewind(sample);
+        uint32_t previous = sample.timestamp;
+        size_t decoded = 0;
+        while (copy.next(decoded, sample)) {
+            broken += sample.timestamp < previous;
+            previous = sample.timestamp;
+            decoded++;
+        }
+        broken += decoded != copy.size();
+        full += decoded == ONEBIOT_STATS_HISTORY_SIZE;
+    }
+    sampling = false;
+    sampler.join();
+    CHECK_EQUAL(0, broken);
+    CHECK_EQUAL(ONEBIOT_STATS_HISTORY_SIZE, stats.size());
+}
+
+class SlowPrint : public Print {
+    public:
+        size_t lines = 0;
+
+        size_t write(uint8_t) override {
+            return 1;
+        }
+        size_t write(const uint8_t *data, size_t size) override {
+            for (size_t i = 0; i < size; i++) {
+                lines += data[i] == '\n';
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            return size;
+        }
+};
+
+// a slow /cmd/log client does not hold up the task which logs meanwhile
+static void testLogClient() {
+    for (int i = 0; i < 100; i++) {
+        ONEBIOT_LOG_INFO(APP, "record %d", i);
+    }
+
+    SlowPrint client;
+    std::atomic<bool> reading(true);
+    std::thread reader([&]() {
+        ONEBIOTLog::printSince(0, client);
+        reading = false;
+    });
+
+    long longest = 0;
+    int calls = 0;
+    while (reading) {
+        auto started = std::chrono::steady_clock::now();
+        ONEBIOT_LOG_INFO(APP, "record %d", calls++);
+        longest = std::max(longest, (long) std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    reader.join();
+    CHECK(client.lines > 0);
+    CHECK(calls > 0);
+    // a lock held over the whole response would keep a call waiting for several 20 ms writes
+    CHECK(longest < 15000);
+    printf("log: %u lines to a slow client, %d calls meanwhile, longest %ld us\n", (unsigned) client.lines, calls, longest);
+}
+
+int main() {
+    FS memory;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", memory);
+
+    testQueue();
+    testCommit(config);
+    testPatch(config);
+    testStatsHistory();
+    testLogClient();
+    CHECK_DONE();
+}
@@ -0,0 +1,211 @@
+#include <Arduino.h>
+#include <FS.h>
+#include <chrono>
+#include "check.h"
+#include "host_server.h"
+#include "utils/request/ONEBIOTDataRequestHandler.h"
+#include "utils/timeseries/ONEBIOTTimeSeries.h"
+
+// range reads over the segment files and the write buffer, repeated timestamps,
+// reclaimed segments, torn tails, the buckets of GET /cmd/data?step= and the rates
+
+static size_t count(ONEBIOTTimeSeries &store, uint32_t from, uint32_t to) {
+    ONEBIOTTimeSeriesCursor cursor;
+    ONEBIOTTimeSeriesRecord record;
+    store.query(cursor, from, to);
+    size_t records = 0;
+    while (store.next(cursor, record)) {
+        CHECK(record.timestamp >= from && record.timestamp <= to);
+        CHECK_EQUAL(record.timestamp, (uint32_t) record.value);
+        records++;
+    }
+    return records;
+}
+
+// the sparse index has to seek to the first of several records sharing a timestamp
+static void testRepeatedTimestamps() {
+    FS memory;
+    // 32 records per segment are indexed every 2nd record
+    ONEBIOTTimeSeries store(memory, "/ts", 32);
+    CHECK(store.begin());
+    const uint32_t timestamps[] = {1, 5, 5, 5, 5, 5, 9};
+    for (uint32_t timestamp : timestamps) {
+        CHECK(store.append(timestamp, timestamp));
+    }
+    CHECK_EQUAL(5, count(store, 5, 5));
+    CHECK_EQUAL(6, count(store, 2, 8) + count(store, 1, 1));
+    CHECK_EQUAL(1, count(store, 6, 9));
+
+    // a run longer than the stride starting in an earlier index entry
+    for (uint32_t i = 0; i < 10; i++) {
+        CHECK(store.append(12, 12));
+    }
+    CHECK(store.append(13, 13));
+    CHECK_EQUAL(10, count(store, 12, 12));
+    CHECK_EQUAL(11, count(store, 10, 20));
+}
+
+// a full ring reuses the oldest segment, the rest stays readable in order
+static void testReclaim() {
+    FS memory;
+    ONEBIOTTimeSeries store(memory, "/ts", ONEBIOT_TS_INDEX_ENTRIES);
+    CHECK(store.begin());
+    const uint32_t capacity = ONEBIOT_TS_SEGMENTS * ONEBIOT_TS_INDEX_ENTRIES;
+    for (uint32_t timestamp = 1; timestamp <= capacity * 2 + 5; timestamp++) {
+        CHECK(store.append(timestamp, timestamp));
+    }
+    CHECK(store.flush());
+
+    // the current segment holds the last 5 records, the one after it went first
+    uint32_t kept = (ONEBIOT_TS_SEGMENTS - 1) * ONEBIOT_TS_INDEX_ENTRIES + 5;
+    CHECK_EQUAL(kept, store.size());
+    CHECK_EQUAL(capacity * 2 + 5 - kept + 1, store.getFirstTimestamp());
+    CHECK_EQUAL(kept, count(store, 0, UINT32_MAX));
+    CHECK_EQUAL(0, count(store, 0, store.getFirstTimestamp() - 1));
+
+    ONEBIOTTimeSeriesCursor cursor;
+    ONEBIOTTimeSeriesRecord record;
+    uint32_t previous = 0;
+    store.query(cursor, 0, UINT32_MAX);
+    while (store.next(cursor, record)) {
+        CHECK_EQUAL(previous == 0 ? store.getFirstTimestamp() : previous + 1, record.timestamp);
+        previous = record.timestamp;
+    }
+    CHECK_EQUAL(capacity * 2 + 5, previous);
+
+    ONEBIOTTimeSeries reopened(memory, "/ts", ONEBIOT_TS_INDEX_ENTRIES);
+    CHECK(reopened.begin());
+    CHECK_EQUAL(kept, reopened.size());
+    CHECK_EQUAL(store.getFirstTimestamp(), reopened.getFirstTimestamp());
+    CHECK_EQUAL(capacity * 2 + 5, reopened.getLastTimestamp());
+    // appending goes on in the segment which was current
+    CHECK(reopened.append(capacity * 2 + 6, capacity * 2 + 6));
+    CHECK(reopened.flush());
+    CHECK_EQUAL(kept + 1, reopened.size());
+}
+
+// a record cut off by a reset is truncated by begin(), later appends stay aligned
+static void testTornTail() {
+    FS memory;
+    ONEBIOTTimeSeries store(memory, "/ts", 32);
+    CHECK(store.begin());
+    for (uint32_t timestamp = 1; timestamp <= 20; timestamp++) {
+        CHECK(store.append(timestamp, timestamp));
+    }
+    CHECK(store.flush());
+    std::string segment = memory.hostRead("/ts/0.seg");
+    memory.hostWrite("/ts/0.seg", segment + std::string(3, '\x7f'));
+
+    ONEBIOTTimeSeries reopened(memory, "/ts", 32);
+    CHECK(reopened.begin());
+    CHECK_EQUAL(20, reopened.size());
+    CHECK(memory.hostRead("/ts/0.seg") == segment);
+    CHECK(reopened.append(21, 21));
+    CHECK(reopened.flush());
+    CHECK_EQUAL(21, count(reopened, 0, UINT32_MAX));
+    CHECK_EQUAL(1, count(reopened, 21, 21));
+}
+
+static std::string data(HostServer &server, const std::string &query) {
+    std::string response = server.request("GET /cmd/data?" + query + " HTTP/1.1\r\nHost: onebiot.local\r\n" + HOST_AUTHORIZATION + "\r\n");
+    CHECK_EQUAL(200, httpStatus(response));
+    return httpBody(response);
+}
+
+static void testDataRequest() {
+    FS memory;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", memory);
+    config.setCredentialsUser("admin");
+    config.setCredentialsPassword("secret");
+    ONEBIOTTimeSeries store(memory, "/ts", 32);
+    CHECK(store.begin());
+    for (uint32_t timestamp = 1000; timestamp < 1010; timestamp++) {
+        CHECK(store.append(timestamp, timestamp));
+    }
+    ONEBIOTDataRequestHandler handler(config, store);
+    HostServer server;
+    server.addHandler(&handler);
+
+    CHECK(data(server, "from=1008&to=1020") == "{\"success\":true,\"step\":0,\"data\":[[1008,1008.000],[1009,1009.000]]}");
+    // buckets of step seconds start at from, [start,avg,min,max,count]
+    CHECK(data(server, "from=1000&to=1009&step=5") == "{\"success\":true,\"step\":5,\"data\":"
+        "[[1000,1002.000,1000.000,1004.000,5],[1005,1007.000,1005.000,1009.000,5]]}");
+    CHECK(data(server, "from=998&step=5") == "{\"success\":true,\"step\":5,\"data\":"
+        "[[998,1001.000,1000.000,1002.000,3],[1003,1005.000,1003.000,1007.000,5],[1008,1008.500,1008.000,1009.000,2]]}");
+    CHECK(data(server, "from=2000&step=5") == "{\"success\":true,\"step\":5,\"data\":[]}");
+}
+
+// Append and query rates of the host FS backend, the timeseries_benchmark sketch
+// measures the same on the flash of the ESP
+static void benchmark() {
+    FS memory(4 << 20);
+    ONEBIOTTimeSeries store(memory, "/ts", 4096);
+    CHECK(store.begin());
+    const uint32_t records = ONEBIOT_TS_SEGMENTS * 4096;
+    auto started = std::chrono::steady_clock::now();
+    for (uint32_t timestamp = 1; timestamp <= records; timestamp++) {
+        store.append(timestamp, timestamp);
+    }
+    store.flush();
+    double appendSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    CHECK_EQUAL(records, store.size());
+
+    started = std::chrono::steady_clock::now();
+    size_t all = count(store, 0, UINT32_MAX);
+    double scanSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    CHECK_EQUAL(records, all);
+
+    // narrow windows, the sparse index skips most of each segment
+    const int windows = 1000;
+    started = std::chrono::steady_clock::now();
+    for (int i = 0; i < windows; i++) {
+        uint32_t from = 1 + (uint32_t) i * (records / windows);
+        CHECK_EQUAL(100, count(store, from, from + 99));
+    }
+    double windowSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    printf("{\"test\":\"timeseries_benchmark\",\"backend\":\"memory\",\"append_per_s\":%.0f,\"scan_per_s\":%.0f,\"window_100_us\":%.1f}\n",
+        records / appendSeconds, all / scanSeconds, windowSeconds * 1e6 / windows);
+}
+
+int main() {
+    FS memory;
+    ONEBIOTTimeSeries store(memory, "/ts", 32);
+    CHECK(store.begin());
+
+    // one full write buffer goes to flash, the rest waits in RAM
+    for (uint32_t timestamp = 100; timestamp < 100 + ONEBIOT_TS_WRITE_BUFFER + 4; timestamp++) {
+        CHECK(store.append(timestamp, timestamp));
+    }
+    size_t written = memory.hostRead("/ts/0.seg").size();
+    CHECK_EQUAL(ONEBIOT_TS_WRITE_BUFFER * sizeof(ONEBIOTTimeSeriesRecord), written);
+
+    // a range older than the buffer is served from flash alone
+    CHECK_EQUAL(10, count(store, 100, 109));
+    CHECK_EQUAL(0, count(store, 0, 50));
+    CHECK_EQUAL(written, memory.hostRead("/ts/0.seg").size());
+
+    // an empty range writes nothing either
+    CHECK_EQUAL(0, count(store, 200, 100));
+    CHECK_EQUAL(written, memory.hostRead("/ts/0.seg").size());
+
+    // a range reaching the buffer writes it first
+    CHECK_EQUAL(6, count(store, 114, 150));
+    CHECK_EQUAL((ONEBIOT_TS_WRITE_BUFFER + 4) * sizeof(ONEBIOTTimeSeriesRecord), memory.hostRead("/ts/0.seg").size());
+    CHECK_EQUAL(ONEBIOT_TS_WRITE_BUFFER + 4, store.size());
+
+    // the index is rebuilt from the files
+    ONEBIOTTimeSeries reopened(memory, "/ts", 32);
+    CHECK(reopened.begin());
+    CHECK_EQUAL(ONEBIOT_TS_WRITE_BUFFER + 4, reopened.size());
+    CHECK_EQUAL(100, reopened.getFirstTimestamp());
+    CHECK_EQUAL(100 + ONEBIOT_TS_WRITE_BUFFER + 3, reopened.getLastTimestamp());
+
+    testRepeatedTimestamps();
+    testReclaim();
+    testTornTail();
+    testDataRequest();
+    benchmark();
+    CHECK_DONE();
+}
@@ -0,0 +1,97 @@
+#include <Arduino.h>
+#include "check.h"
+#include "host_server.h"
+#include "utils/request/ONEBIOTFsRequestHandler.h"
+#include "utils/trace/ONEBIOTAllocTrace.h"
+
+// POST /cmd/fs/upload streams into "<path>.tmp", the previous file survives every failure
+
+static const char TAG_UPLOAD[] = "upload";
+
+static std::string content(size_t size, char seed) {
+    std::string data(size, ' ');
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (char) ('a' + (seed + i) % 26);
+    }
+    return data;
+}
+
+static std::string upload(HostServer &server, const std::string &data) {
+    return server.request(multipartRequest("/cmd/fs/upload?path=/index.html", "index.html", data));
+}
+
+static void testReplace(HostServer &server, FS &memory) {
+    memory.hostWrite("/index.html", "previous");
+    std::string response = upload(server, "current");
+    CHECK(httpBody(response).find("\"success\":true") != std::string::npos);
+    CHECK(memory.hostRead("/index.html") == "current");
+    CHECK_EQUAL(1, memory.hostFileCount());
+}
+
+static void testFailedMove(HostServer &server, FS &memory) {
+    memory.hostWrite("/index.html", "previous");
+    memory.hostFailRenameFrom = "/index.html.tmp";
+    std::string response = upload(server, "current");
+    memory.hostFailRenameFrom = "";
+    CHECK(httpBody(response).find("\"success\":false") != std::string::npos);
+    CHECK(httpBody(response).find("kept as /index.html.tmp") != std::string::npos);
+    // the old file is back in place and the upload is not thrown away
+    CHECK(memory.hostRead("/index.html") == "previous");
+    CHECK(memory.hostRead("/index.html.tmp") == "current");
+    CHECK(memory.hostRead("/index.html.bak").empty());
+    memory.remove("/index.html.tmp");
+}
+
+static void testFull(HostServer &server, FS &memory) {
+    memory.hostWrite("/index.html", "previous");
+    std::string response = upload(server, content(memory.hostFreeBytes() + 1, 0));
+    CHECK(httpBody(response).find("\"success\":false") != std::string::npos);
+    CHECK(memory.hostRead("/index.html") == "previous");
+    CHECK_EQUAL(1, memory.hostFileCount());
+}
+
+static uint32_t uploadPeak(HostServer &server, FS &memory, size_t size) {
+    std::string request = multipartRequest("/cmd/fs/upload?path=/index.html", "index.html", content(size, 3));
+    ONEBIOTAllocTrace::reset();
+    {
+        ONEBIOT_ALLOC_SCOPE(TAG_UPLOAD);
+        server.request(request);
+    }
+    CHECK_EQUAL(size, memory.hostRead("/index.html").length());
+
+    ONEBIOTAllocTraceCounters counters;
+    for (size_t i = 0; ONEBIOTAllocTrace::get(i, counters); i++) {
+        if (counters.tag == TAG_UPLOAD) {
+            return counters.peak;
+        }
+    }
+    return 0;
+}
+
+// the file goes through in HTTP_UPLOAD_BUFLEN blocks, 64 times the size stays within
+// a few String reallocations of the small upload
+static void testPeakHeap(HostServer &server, FS &memory) {
+    uint32_t small = uploadPeak(server, memory, 4 * 1024);
+    uint32_t large = uploadPeak(server, memory, 256 * 1024);
+    printf("peak heap of an upload: %u bytes for 4 kB, %u bytes for 256 kB\n", small, large);
+    CHECK(small > 0);
+    CHECK(large < small + 1024);
+    CHECK_EQUAL(0, ONEBIOTAllocTrace::untracked());
+}
+
+int main() {
+    FS memory(512 * 1024);
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", memory);
+    config.setCredentialsUser("admin");
+    config.setCredentialsPassword("secret");
+    ONEBIOTFsRequestHandler handler(config);
+    HostServer server;
+    server.addHandler(&handler);
+
+    testReplace(server, memory);
+    testFailedMove(server, memory);
+    testFull(server, memory);
+    testPeakHeap(server, memory);
+    CHECK_DONE();
+}
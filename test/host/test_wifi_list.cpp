@@ -0,0 +1,64 @@
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "check.h"
+#include "host_server.h"
+#include "ONEBIOT.h"
+#include "utils/request/ONEBIOTCmdRequestHandler.h"
+
+// GET /cmd/wifi/list: asynchronous scans, started only by clients asking for them
+
+static std::string list(HostServer &server) {
+    std::string response = server.request(std::string("GET /cmd/wifi/list HTTP/1.1\r\n") + HOST_AUTHORIZATION + "\r\n");
+    CHECK_EQUAL(200, httpStatus(response));
+    return httpBody(response);
+}
+
+static bool contains(const std::string &body, const char *text) {
+    return body.find(text) != std::string::npos;
+}
+
+int main() {
+    FS memory;
+    ONEBIOTConfigAppConfig appConfig;
+    ONEBIOTConfig config(appConfig, "/config.json", memory);
+    config.setCredentialsUser("admin");
+    config.setCredentialsPassword("secret");
+    ONEBIOTApp app(config, memory);
+    ONEBIOTCmdRequestHandler handler(app);
+    HostServer server;
+    server.addHandler(&handler);
+
+    HostNetwork home = {"home", -50, 4, 6, false};
+    HostNetwork guest = {"guest", -70, ENC_TYPE_NONE, 11, false};
+    WiFi.hostNetworks = {home, guest};
+
+    // the first request starts the scan, polling while it runs does not start another
+    CHECK(contains(list(server), "Scanning..."));
+    CHECK(contains(list(server), "Scanning..."));
+    CHECK_EQUAL(1, WiFi.hostScans);
+
+    WiFi.hostFinishScan();
+    std::string body = list(server);
+    CHECK(contains(body, "\"success\":true"));
+    CHECK(contains(body, "\"ssid\":\"home\""));
+    CHECK(contains(body, "\"ssid\":\"guest\""));
+    // the radio stays quiet until somebody asks again
+    CHECK_EQUAL(1, WiFi.hostScans);
+    CHECK_EQUAL(WIFI_SCAN_FAILED, WiFi.scanComplete());
+
+    CHECK(contains(list(server), "Scanning..."));
+    CHECK_EQUAL(2, WiFi.hostScans);
+
+    // an empty result is dropped and the scan repeated for the next poll
+    WiFi.hostNetworks.clear();
+    WiFi.hostFinishScan();
+    CHECK(contains(list(server), "No WiFi networks"));
+    CHECK_EQUAL(3, WiFi.hostScans);
+    CHECK_EQUAL(WIFI_SCAN_RUNNING, WiFi.scanComplete());
+
+    WiFi.hostNetworks = {home};
+    WiFi.hostFinishScan();
+    CHECK(contains(list(server), "\"ssid\":\"home\""));
+    CHECK_EQUAL(3, WiFi.hostScans);
+    CHECK_DONE();
+}